@@ -0,0 +1,119 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <algostats.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <pow.h>
+#include <rpc/blockchain.h>
+#include <timedata.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <vector>
+
+CAlgoStatsTable algostats;
+
+CAlgoStatsTable::CAlgoStatsTable()
+{
+    arrWindowWork.fill(arith_uint256());
+    arrWindowBlocks.fill(0);
+    fStale = false;
+}
+
+void CAlgoStatsTable::PushBlock(const CBlockIndex* pindex)
+{
+    // The work of the block's own target, GetBlockProof() mixes in the
+    // other algos after the hardfork
+    window.push_back(pindex);
+    arrWindowWork[pindex->GetAlgo()] += GetBlockProofBase(*pindex);
+    arrWindowBlocks[pindex->GetAlgo()]++;
+    if (window.size() > (size_t)ALGO_STATS_WINDOW) {
+        const CBlockIndex* pindexOld = window.front();
+        arrWindowWork[pindexOld->GetAlgo()] -= GetBlockProofBase(*pindexOld);
+        arrWindowBlocks[pindexOld->GetAlgo()]--;
+        window.pop_front();
+    }
+}
+
+void CAlgoStatsTable::Update()
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs);
+
+    const CBlockIndex* pindexTip = chainActive.Tip();
+    if (!pindexTip || (!window.empty() && window.back() == pindexTip))
+        return;
+
+    // Move the window along when the new tip builds on the old one, refill it
+    // after a reorg or a jump of more than a window.
+    const CBlockIndex* pindexStop = window.empty() ? nullptr : window.back();
+    if (!pindexStop || pindexTip->nHeight <= pindexStop->nHeight ||
+        pindexTip->nHeight - pindexStop->nHeight > ALGO_STATS_WINDOW ||
+        pindexTip->GetAncestor(pindexStop->nHeight) != pindexStop) {
+        window.clear();
+        arrWindowWork.fill(arith_uint256());
+        arrWindowBlocks.fill(0);
+        pindexStop = nullptr;
+    }
+    std::vector<const CBlockIndex*> vConnected;
+    for (const CBlockIndex* pindex = pindexTip; pindex != pindexStop && vConnected.size() < (size_t)ALGO_STATS_WINDOW; pindex = pindex->pprev)
+        vConnected.push_back(pindex);
+    for (auto it = vConnected.rbegin(); it != vConnected.rend(); ++it)
+        PushBlock(*it);
+
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    std::shared_ptr<CAlgoStatsSnapshot> snapshot = std::make_shared<CAlgoStatsSnapshot>();
+    snapshot->hashTip = pindexTip->GetBlockHash();
+    snapshot->nHeight = pindexTip->nHeight;
+    snapshot->nHeaders = pindexBestHeader ? pindexBestHeader->nHeight : -1;
+    snapshot->nTipAlgo = pindexTip->GetAlgo();
+    snapshot->nWindowBlocks = window.size();
+
+    const int64_t nTimeSpan = window.back()->GetBlockTime() - window.front()->GetBlockTime();
+    // The target asked of a block mined now, as CreateNewBlock would set it
+    CBlockHeader header;
+    header.nTime = std::max(pindexTip->GetMedianTimePast() + 1, GetAdjustedTime());
+
+    for (uint8_t algo = 0; algo < (uint8_t)NUM_ALGOS; algo++) {
+        CAlgoStats& stats = snapshot->algos[algo];
+        const CBlockIndex* pindexAlgo = GetLastBlockIndexForAlgo(pindexTip, algo);
+        stats.nLastBlock = pindexAlgo ? pindexAlgo->nHeight : -1;
+        stats.dDifficulty = GetDifficulty(pindexAlgo, algo);
+        stats.nNextBits = GetNextWorkRequired(pindexTip, &header, consensusParams, algo);
+        stats.nWindowBlocks = arrWindowBlocks[algo];
+        stats.dHashRate = nTimeSpan > 0 ? arrWindowWork[algo].getdouble() / nTimeSpan : 0;
+        stats.nLastDiffRet = CalculateDiffRetargetingBlock(pindexTip, RETARGETING_LAST, algo, consensusParams);
+        stats.nNextDiffRet = CalculateDiffRetargetingBlock(pindexTip, RETARGETING_NEXT, algo, consensusParams);
+    }
+
+    std::atomic_store(&pSnapshot, algo_stats_ptr_t(snapshot));
+}
+
+algo_stats_ptr_t CAlgoStatsTable::Get()
+{
+    algo_stats_ptr_t snapshot = std::atomic_load(&pSnapshot);
+    if (snapshot && !fStale)
+        return snapshot;
+
+    // Nothing published yet, or tips of the initial download were skipped
+    LOCK2(cs_main, cs);
+    fStale = false;
+    Update();
+    return std::atomic_load(&pSnapshot);
+}
+
+void CAlgoStatsTable::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    // Not worth holding up the initial download for, the next Get() catches up
+    if (fInitialDownload) {
+        fStale = true;
+        return;
+    }
+
+    // Notifications are queued, use whatever the tip is by now
+    LOCK2(cs_main, cs);
+    Update();
+}
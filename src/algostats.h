@@ -0,0 +1,86 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HUNTCOIN_ALGOSTATS_H
+#define HUNTCOIN_ALGOSTATS_H
+
+#include <arith_uint256.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+
+class CBlockIndex;
+
+/** Number of most recent blocks the hashrates and block shares are taken over */
+static const int ALGO_STATS_WINDOW = 1440;
+
+/** Mining statistics of one algo as of a given tip */
+struct CAlgoStats
+{
+    //! height of the last block mined with the algo, -1 if none
+    int nLastBlock;
+    //! difficulty of that block
+    double dDifficulty;
+    //! target required from the next block of the algo
+    uint32_t nNextBits;
+    //! blocks of the algo among the last ALGO_STATS_WINDOW blocks
+    int nWindowBlocks;
+    //! hashes per second of the algo over those blocks
+    double dHashRate;
+    int nLastDiffRet;
+    int nNextDiffRet;
+};
+
+/** Statistics of all algos at one tip, as published by CAlgoStatsTable */
+struct CAlgoStatsSnapshot
+{
+    uint256 hashTip;
+    int nHeight;
+    int nHeaders;
+    uint8_t nTipAlgo;
+    //! number of blocks the window holds, fewer than ALGO_STATS_WINDOW on a short chain
+    int nWindowBlocks;
+    std::array<CAlgoStats, NUM_ALGOS> algos;
+};
+
+typedef std::shared_ptr<const CAlgoStatsSnapshot> algo_stats_ptr_t;
+
+/**
+ * Per-algo statistics for getalgoinfo, updated when the tip changes instead
+ * of on every call. The work of the last ALGO_STATS_WINDOW blocks is kept per
+ * algo and moved along with the tip; a reorg refills the window.
+ */
+class CAlgoStatsTable : public CValidationInterface
+{
+private:
+    CCriticalSection cs;
+    //! the blocks in the window, oldest first
+    std::deque<const CBlockIndex*> window;
+    std::array<arith_uint256, NUM_ALGOS> arrWindowWork;
+    std::array<int, NUM_ALGOS> arrWindowBlocks;
+    algo_stats_ptr_t pSnapshot;
+    //! a tip of the initial download went by without an update
+    std::atomic<bool> fStale;
+
+    void PushBlock(const CBlockIndex* pindex);
+    void Update();
+
+public:
+    CAlgoStatsTable();
+
+    /** The statistics as of the current tip, nullptr before there is a chain */
+    algo_stats_ptr_t Get();
+
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+};
+
+extern CAlgoStatsTable algostats;
+
+#endif // HUNTCOIN_ALGOSTATS_H
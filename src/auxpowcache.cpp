@@ -0,0 +1,88 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <auxpowcache.h>
+
+#include <memusage.h>
+#include <serialize.h>
+#include <version.h>
+
+CAuxPowCache auxpowcache;
+
+CAuxPowCache::CAuxPowCache(size_t nMaxUsageIn) : nUsage(0), nMaxUsage(nMaxUsageIn), nHits(0), nMisses(0)
+{
+}
+
+size_t CAuxPowCache::EntryUsage(const CAuxPow& auxpow)
+{
+    // The serialized size is a close enough estimate of the heap data behind
+    // the coinbase tx, merkle branches and parent header.
+    return memusage::MallocUsage(sizeof(CAuxPow)) + ::GetSerializeSize(auxpow, SER_NETWORK, PROTOCOL_VERSION) +
+           memusage::MallocUsage(sizeof(list_type::value_type) + 2 * sizeof(void*)) +
+           memusage::MallocUsage(sizeof(std::pair<const uint256, list_type::iterator>) + sizeof(void*));
+}
+
+void CAuxPowCache::Evict()
+{
+    while (nUsage > nMaxUsage && !lruList.empty()) {
+        const entry_type& entry = lruList.back();
+        nUsage -= EntryUsage(*entry.second);
+        mapEntries.erase(entry.first);
+        lruList.pop_back();
+    }
+}
+
+void CAuxPowCache::SetMaxUsage(size_t nMaxUsageIn)
+{
+    LOCK(cs);
+    nMaxUsage = nMaxUsageIn;
+    Evict();
+}
+
+bool CAuxPowCache::Get(const uint256& hash, boost::shared_ptr<CAuxPow>& auxpow)
+{
+    LOCK(cs);
+    auto it = mapEntries.find(hash);
+    if (it == mapEntries.end()) {
+        nMisses++;
+        return false;
+    }
+    nHits++;
+    lruList.splice(lruList.begin(), lruList, it->second);
+    auxpow = it->second->second;
+    return true;
+}
+
+void CAuxPowCache::Insert(const uint256& hash, const boost::shared_ptr<CAuxPow>& auxpow)
+{
+    assert(auxpow);
+    LOCK(cs);
+    size_t nEntryUsage = EntryUsage(*auxpow);
+    if (nEntryUsage > nMaxUsage || mapEntries.count(hash))
+        return;
+    lruList.emplace_front(hash, auxpow);
+    mapEntries.emplace(hash, lruList.begin());
+    nUsage += nEntryUsage;
+    Evict();
+}
+
+void CAuxPowCache::Clear()
+{
+    LOCK(cs);
+    lruList.clear();
+    mapEntries.clear();
+    nUsage = 0;
+}
+
+CAuxPowCache::Stats CAuxPowCache::GetStats() const
+{
+    LOCK(cs);
+    Stats stats;
+    stats.entries = mapEntries.size();
+    stats.usage = nUsage;
+    stats.limit = nMaxUsage;
+    stats.hits = nHits;
+    stats.misses = nMisses;
+    return stats;
+}
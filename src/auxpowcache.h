@@ -0,0 +1,75 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HUNTCOIN_AUXPOWCACHE_H
+#define HUNTCOIN_AUXPOWCACHE_H
+
+#include <auxpow.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+
+//! -auxpowcache default (MiB)
+static const int64_t DEFAULT_AUXPOW_CACHE = 32;
+//! max. -auxpowcache (MiB)
+static const int64_t MAX_AUXPOW_CACHE = 4096;
+
+/**
+ * Bounded LRU cache of the auxpow of stored block headers, keyed by block hash.
+ * CBlockIndex does not keep the auxpow, so without this every GetBlockHeader()
+ * of a merge-mined block reads and re-checks the header from the block files.
+ */
+class CAuxPowCache
+{
+public:
+    struct Stats
+    {
+        size_t entries;  //!< number of cached auxpows
+        size_t usage;    //!< estimated memory used by the cache
+        size_t limit;    //!< memory budget of the cache
+        uint64_t hits;   //!< lookups served from the cache
+        uint64_t misses; //!< lookups that had to go to disk
+    };
+
+    explicit CAuxPowCache(size_t nMaxUsageIn = DEFAULT_AUXPOW_CACHE << 20);
+
+    /** Change the memory budget, evicting entries as needed. Zero disables the cache. */
+    void SetMaxUsage(size_t nMaxUsageIn);
+    /** Look up the auxpow of a block and mark it most recently used. */
+    bool Get(const uint256& hash, boost::shared_ptr<CAuxPow>& auxpow);
+    /** Add the auxpow of a block, evicting the least recently used entries. */
+    void Insert(const uint256& hash, const boost::shared_ptr<CAuxPow>& auxpow);
+    void Clear();
+    Stats GetStats() const;
+
+private:
+    typedef std::pair<uint256, boost::shared_ptr<CAuxPow> > entry_type;
+    typedef std::list<entry_type> list_type;
+
+    struct Hasher
+    {
+        size_t operator()(const uint256& hash) const { return hash.GetCheapHash(); }
+    };
+
+    static size_t EntryUsage(const CAuxPow& auxpow);
+    void Evict();
+
+    mutable CCriticalSection cs;
+    //! most recently used entry first
+    list_type lruList;
+    std::unordered_map<uint256, list_type::iterator, Hasher> mapEntries;
+    size_t nUsage;
+    size_t nMaxUsage;
+    uint64_t nHits;
+    uint64_t nMisses;
+};
+
+extern CAuxPowCache auxpowcache;
+
+#endif // HUNTCOIN_AUXPOWCACHE_H
@@ -0,0 +1,132 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <auxworkcache.h>
+
+#include <core_memusage.h>
+#include <memusage.h>
+
+#include <boost/thread/locks.hpp>
+
+CAuxWorkCache auxworkcache;
+
+static const size_t TX_REF_USAGE = memusage::MallocUsage(sizeof(std::pair<const CTransaction* const, int>) + sizeof(void*));
+
+CAuxWorkCache::CAuxWorkCache(size_t nMaxUsageIn) : nUsage(0), nMaxUsage(nMaxUsageIn), nEvicted(0), nClock(0)
+{
+}
+
+void CAuxWorkCache::Erase(entry_map::iterator it)
+{
+    const CBlock& block = *it->second.block;
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        auto ref = mapTxRefs.find(block.vtx[i].get());
+        if (--ref->second == 0) {
+            nUsage -= RecursiveDynamicUsage(*block.vtx[i]) + TX_REF_USAGE;
+            mapTxRefs.erase(ref);
+        }
+    }
+    nUsage -= it->second.nUsage;
+    mapBlocks.erase(it);
+}
+
+void CAuxWorkCache::Evict()
+{
+    while (nUsage > nMaxUsage) {
+        // The cache holds a handful of blocks, a scan is cheap enough
+        entry_map::iterator itOldest = mapBlocks.end();
+        for (entry_map::iterator it = mapBlocks.begin(); it != mapBlocks.end(); ++it) {
+            const auto itCurrent = mapCurrent.find(it->second.block->GetAlgo());
+            if (itCurrent != mapCurrent.end() && itCurrent->second == it->first)
+                continue;
+            if (itOldest == mapBlocks.end() || it->second.nLastUsed < itOldest->second.nLastUsed)
+                itOldest = it;
+        }
+        if (itOldest == mapBlocks.end())
+            break;
+        Erase(itOldest);
+        nEvicted++;
+    }
+}
+
+void CAuxWorkCache::SetMaxUsage(size_t nMaxUsageIn)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs);
+    nMaxUsage = nMaxUsageIn;
+    Evict();
+}
+
+std::shared_ptr<const CBlock> CAuxWorkCache::GetCurrent(uint8_t algo) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs);
+    auto itCurrent = mapCurrent.find(algo);
+    if (itCurrent == mapCurrent.end())
+        return nullptr;
+    auto it = mapBlocks.find(itCurrent->second);
+    if (it == mapBlocks.end())
+        return nullptr;
+    it->second.nLastUsed = ++nClock;
+    return it->second.block;
+}
+
+std::shared_ptr<const CBlock> CAuxWorkCache::Get(const uint256& hash) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs);
+    auto it = mapBlocks.find(hash);
+    if (it == mapBlocks.end())
+        return nullptr;
+    it->second.nLastUsed = ++nClock;
+    return it->second.block;
+}
+
+void CAuxWorkCache::Add(const std::shared_ptr<const CBlock>& block)
+{
+    assert(block && !block->vtx.empty());
+    const uint256 hash = block->GetHash();
+
+    boost::unique_lock<boost::shared_mutex> lock(cs);
+    auto it = mapBlocks.find(hash);
+    if (it == mapBlocks.end()) {
+        size_t nEntryUsage = memusage::MallocUsage(sizeof(CBlock)) + memusage::DynamicUsage(block->vtx) +
+                             RecursiveDynamicUsage(*block->vtx[0]) +
+                             memusage::MallocUsage(sizeof(entry_map::value_type) + sizeof(void*));
+        for (size_t i = 1; i < block->vtx.size(); i++) {
+            if (mapTxRefs[block->vtx[i].get()]++ == 0)
+                nUsage += RecursiveDynamicUsage(*block->vtx[i]) + TX_REF_USAGE;
+        }
+        nUsage += nEntryUsage;
+        mapBlocks.emplace(std::piecewise_construct, std::forward_as_tuple(hash),
+                          std::forward_as_tuple(block, nEntryUsage, ++nClock));
+    }
+    mapCurrent[block->GetAlgo()] = hash;
+    Evict();
+}
+
+void CAuxWorkCache::ResetCurrent()
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs);
+    mapCurrent.clear();
+    Evict();
+}
+
+void CAuxWorkCache::Clear()
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs);
+    mapBlocks.clear();
+    mapCurrent.clear();
+    mapTxRefs.clear();
+    nUsage = 0;
+}
+
+CAuxWorkCache::Stats CAuxWorkCache::GetStats() const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs);
+    Stats stats;
+    stats.entries = mapBlocks.size();
+    stats.current = mapCurrent.size();
+    stats.usage = nUsage;
+    stats.limit = nMaxUsage;
+    stats.evicted = nEvicted;
+    return stats;
+}
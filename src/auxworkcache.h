@@ -0,0 +1,97 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HUNTCOIN_AUXWORKCACHE_H
+#define HUNTCOIN_AUXWORKCACHE_H
+
+#include <primitives/block.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include <boost/thread/shared_mutex.hpp>
+
+//! -auxworkcache default (MiB)
+static const int64_t DEFAULT_AUXWORK_CACHE = 32;
+//! max. -auxworkcache (MiB)
+static const int64_t MAX_AUXWORK_CACHE = 4096;
+
+/**
+ * The blocks handed out by createauxblock, kept until they are submitted or
+ * evicted, keyed by block hash and, for the block currently handed out, by
+ * algo. Blocks built from the same template share their transactions, which
+ * are accounted for once. Besides the current block of each algo, least
+ * recently used blocks are evicted to stay within the memory budget.
+ *
+ * Lookups take a shared lock, so concurrent createauxblock and
+ * submitauxblock calls only wait for each other while a block is added.
+ */
+class CAuxWorkCache
+{
+public:
+    struct Stats
+    {
+        size_t entries;   //!< number of cached blocks
+        size_t current;   //!< number of algos with a current block
+        size_t usage;     //!< estimated memory used by the cache
+        size_t limit;     //!< memory budget of the cache
+        uint64_t evicted; //!< blocks dropped before they were submitted
+    };
+
+    explicit CAuxWorkCache(size_t nMaxUsageIn = DEFAULT_AUXWORK_CACHE << 20);
+
+    /** Change the memory budget, evicting blocks as needed. */
+    void SetMaxUsage(size_t nMaxUsageIn);
+    /** The block currently handed out for algo, nullptr if there is none. */
+    std::shared_ptr<const CBlock> GetCurrent(uint8_t algo) const;
+    /** Look up a block that was handed out by its hash. */
+    std::shared_ptr<const CBlock> Get(const uint256& hash) const;
+    /** Add a block and make it the current one for its algo. */
+    void Add(const std::shared_ptr<const CBlock>& block);
+    /** Stop handing out the current blocks. They can still be submitted until evicted. */
+    void ResetCurrent();
+    /** Drop all blocks, e.g. once the tip they build on changed. */
+    void Clear();
+    Stats GetStats() const;
+
+private:
+    struct Hasher
+    {
+        size_t operator()(const uint256& hash) const { return hash.GetCheapHash(); }
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<const CBlock> block;
+        //! memory used by the block apart from the shared transactions
+        size_t nUsage;
+        //! value of nClock when the block was last looked up
+        mutable std::atomic<uint64_t> nLastUsed;
+
+        Entry(const std::shared_ptr<const CBlock>& blockIn, size_t nUsageIn, uint64_t nLastUsedIn) :
+            block(blockIn), nUsage(nUsageIn), nLastUsed(nLastUsedIn) {}
+    };
+
+    typedef std::unordered_map<uint256, Entry, Hasher> entry_map;
+
+    void Erase(entry_map::iterator it);
+    void Evict();
+
+    mutable boost::shared_mutex cs;
+    entry_map mapBlocks;
+    std::map<uint8_t, uint256> mapCurrent;
+    //! number of cached blocks referencing each non-coinbase transaction
+    std::unordered_map<const CTransaction*, int> mapTxRefs;
+    size_t nUsage;
+    size_t nMaxUsage;
+    uint64_t nEvicted;
+    mutable std::atomic<uint64_t> nClock;
+};
+
+extern CAuxWorkCache auxworkcache;
+
+#endif // HUNTCOIN_AUXWORKCACHE_H
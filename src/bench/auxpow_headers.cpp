@@ -0,0 +1,59 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <auxpowcache.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <version.h>
+
+#include <vector>
+
+// Build a full headers reply (MAX_HEADERS_RESULTS entries) where every other
+// header is merge-mined and its auxpow comes from the auxpow cache.
+static void AuxpowHeadersBatch(benchmark::State& state)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const unsigned int nHeaders = 2000;
+    std::vector<CBlockIndex> vBlocks(nHeaders);
+    std::vector<uint256> vHashes(nHeaders);
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.resize(1);
+    boost::shared_ptr<CAuxPow> pauxpow(new CAuxPow(MakeTransactionRef(std::move(coinbase))));
+    pauxpow->vChainMerkleBranch.resize(4);
+
+    for (unsigned int i = 0; i < nHeaders; i++) {
+        CBlockHeader header;
+        header.SetBaseVersion(4, params.nAuxpowChainId);
+        header.SetAuxpowVersion(i % 2 == 0);
+        vHashes[i] = ArithToUint256(arith_uint256(i + 1));
+        vBlocks[i].phashBlock = &vHashes[i];
+        vBlocks[i].pprev = (i == 0) ? nullptr : &vBlocks[i - 1];
+        vBlocks[i].nHeight = i;
+        vBlocks[i].nVersion = header.nVersion;
+        vBlocks[i].nTime = 1500000000 + 60 * i;
+        if (header.IsAuxpow())
+            auxpowcache.Insert(vHashes[i], pauxpow);
+    }
+
+    while (state.KeepRunning()) {
+        std::vector<CBlockHeader> vHeaders;
+        vHeaders.reserve(nHeaders);
+        for (const CBlockIndex& index : vBlocks)
+            vHeaders.push_back(index.GetBlockHeader(params));
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << vHeaders;
+    }
+    auxpowcache.Clear();
+}
+
+BENCHMARK(AuxpowHeadersBatch, 50);
@@ -17,33 +17,85 @@ void benchmark::ConsolePrinter::header()
     std::cout << "# Benchmark, evals, iterations, total, min, max, median" << std::endl;
 }
 
-void benchmark::ConsolePrinter::result(const State& state)
+namespace {
+struct ResultStats {
+    double total = 0;
+    double min = 0;
+    double max = 0;
+    double median = 0;
+};
+
+ResultStats GetResultStats(const benchmark::State& state)
 {
     auto results = state.m_elapsed_results;
     std::sort(results.begin(), results.end());
 
-    double total = state.m_num_iters * std::accumulate(results.begin(), results.end(), 0.0);
-
-    double front = 0;
-    double back = 0;
-    double median = 0;
+    ResultStats stats;
+    stats.total = state.m_num_iters * std::accumulate(results.begin(), results.end(), 0.0);
 
     if (!results.empty()) {
-        front = results.front();
-        back = results.back();
+        stats.min = results.front();
+        stats.max = results.back();
 
         size_t mid = results.size() / 2;
-        median = results[mid];
+        stats.median = results[mid];
         if (0 == results.size() % 2) {
-            median = (results[mid] + results[mid + 1]) / 2;
+            stats.median = (results[mid - 1] + results[mid]) / 2;
         }
     }
+    return stats;
+}
+} // namespace
+
+void benchmark::ConsolePrinter::result(const State& state)
+{
+    ResultStats stats = GetResultStats(state);
 
     std::cout << std::setprecision(6);
-    std::cout << state.m_name << ", " << state.m_num_evals << ", " << state.m_num_iters << ", " << total << ", " << front << ", " << back << ", " << median << std::endl;
+    std::cout << state.m_name << ", " << state.m_num_evals << ", " << state.m_num_iters << ", " << stats.total << ", " << stats.min << ", " << stats.max << ", " << stats.median << std::endl;
 }
 
 void benchmark::ConsolePrinter::footer() {}
+
+void benchmark::CsvPrinter::header()
+{
+    std::cout << "name,evals,iterations,total,min,max,median,per_second" << std::endl;
+}
+
+void benchmark::CsvPrinter::result(const State& state)
+{
+    ResultStats stats = GetResultStats(state);
+    double per_second = stats.median > 0 ? 1.0 / stats.median : 0;
+
+    std::cout << std::setprecision(6);
+    std::cout << state.m_name << "," << state.m_num_evals << "," << state.m_num_iters << "," << stats.total << "," << stats.min << "," << stats.max << "," << stats.median << "," << per_second << std::endl;
+}
+
+void benchmark::CsvPrinter::footer() {}
+
+void benchmark::JsonPrinter::header()
+{
+    std::cout << "[";
+}
+
+void benchmark::JsonPrinter::result(const State& state)
+{
+    ResultStats stats = GetResultStats(state);
+    double per_second = stats.median > 0 ? 1.0 / stats.median : 0;
+
+    std::cout << std::setprecision(6);
+    std::cout << (m_first ? "" : ",") << std::endl
+              << "  {\"name\": \"" << state.m_name << "\", \"evals\": " << state.m_num_evals << ", \"iterations\": " << state.m_num_iters
+              << ", \"total\": " << stats.total << ", \"min\": " << stats.min << ", \"max\": " << stats.max
+              << ", \"median\": " << stats.median << ", \"per_second\": " << per_second << "}";
+    m_first = false;
+}
+
+void benchmark::JsonPrinter::footer()
+{
+    std::cout << std::endl << "]" << std::endl;
+}
+
 benchmark::PlotlyPrinter::PlotlyPrinter(std::string plotly_url, int64_t width, int64_t height)
     : m_plotly_url(plotly_url), m_width(width), m_height(height)
 {
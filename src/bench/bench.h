@@ -116,6 +116,29 @@ public:
     void footer();
 };
 
+// machine-readable CSV with a header row; adds the per-iteration throughput
+// (median based) so release-to-release diffs don't need post-processing.
+class CsvPrinter : public Printer
+{
+public:
+    void header();
+    void result(const State& state);
+    void footer();
+};
+
+// machine-readable JSON array, one object per benchmark, same fields as csv.
+class JsonPrinter : public Printer
+{
+public:
+    JsonPrinter() : m_first(true) {}
+    void header();
+    void result(const State& state);
+    void footer();
+
+private:
+    bool m_first;
+};
+
 // creates box plot with plotly.js
 class PlotlyPrinter : public Printer
 {
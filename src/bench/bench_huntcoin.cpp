@@ -4,6 +4,8 @@
 
 #include <bench/bench.h>
 
+#include <chainparams.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
 #include <crypto/sha256.h>
 #include <key.h>
 #include <validation.h>
@@ -34,7 +36,7 @@ main(int argc, char** argv)
                   << HelpMessageOpt("-evals=<n>", strprintf(_("Number of measurement evaluations to perform. (default: %u)"), DEFAULT_BENCH_EVALUATIONS))
                   << HelpMessageOpt("-filter=<regex>", strprintf(_("Regular expression filter to select benchmark by name (default: %s)"), DEFAULT_BENCH_FILTER))
                   << HelpMessageOpt("-scaling=<n>", strprintf(_("Scaling factor for benchmark's runtime (default: %u)"), DEFAULT_BENCH_SCALING))
-                  << HelpMessageOpt("-printer=(console|plot)", strprintf(_("Choose printer format. console: print data to console. plot: Print results as HTML graph (default: %s)"), DEFAULT_BENCH_PRINTER))
+                  << HelpMessageOpt("-printer=(console|plot|csv|json)", strprintf(_("Choose printer format. console: print data to console. plot: Print results as HTML graph. csv, json: print machine-readable results including per-second throughput (default: %s)"), DEFAULT_BENCH_PRINTER))
                   << HelpMessageOpt("-plot-plotlyurl=<uri>", strprintf(_("URL to use for plotly.js (default: %s)"), DEFAULT_PLOT_PLOTLYURL))
                   << HelpMessageOpt("-plot-width=<x>", strprintf(_("Plot width in pixel (default: %u)"), DEFAULT_PLOT_WIDTH))
                   << HelpMessageOpt("-plot-height=<x>", strprintf(_("Plot height in pixel (default: %u)"), DEFAULT_PLOT_HEIGHT));
@@ -43,9 +45,11 @@ main(int argc, char** argv)
     }
 
     SHA256AutoDetect();
+    MultihashAutoDetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
+    SelectParams(CBaseChainParams::MAIN);
     fPrintToDebugLog = false; // don't want to write to debug.log file
 
     int64_t evaluations = gArgs.GetArg("-evals", DEFAULT_BENCH_EVALUATIONS);
@@ -63,6 +67,10 @@ main(int argc, char** argv)
             gArgs.GetArg("-plot-plotlyurl", DEFAULT_PLOT_PLOTLYURL),
             gArgs.GetArg("-plot-width", DEFAULT_PLOT_WIDTH),
             gArgs.GetArg("-plot-height", DEFAULT_PLOT_HEIGHT)));
+    } else if ("csv" == printer_arg) {
+        printer.reset(new benchmark::CsvPrinter());
+    } else if ("json" == printer_arg) {
+        printer.reset(new benchmark::JsonPrinter());
     }
 
     benchmark::BenchRunner::RunAll(*printer, evaluations, scaling_factor, regex_filter, is_list_only);
@@ -0,0 +1,197 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <miner.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+static const int ASSEMBLE_MEMPOOL_SIZE = 2000;
+static const int ASSEMBLE_MINED_PER_BLOCK = 10;
+
+// A regtest chain of only the genesis block, with ASSEMBLE_MEMPOOL_SIZE
+// independent transactions in the mempool spending coins of the tip.
+class AssembleSetup
+{
+private:
+    CCoinsView viewEmpty;
+    CBlockIndex indexGenesis;
+    uint256 hashGenesis;
+    // The blocks connected on top of the genesis block, and their hashes
+    std::deque<CBlockIndex> vIndex;
+    std::deque<uint256> vHash;
+
+    static void AddTx(const CTransaction& tx, const CAmount& nFee)
+    {
+        LockPoints lp;
+        mempool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(
+                                               MakeTransactionRef(tx), nFee, 0, 1,
+                                               false, 4, lp));
+    }
+
+    // A transaction spending a new coin of the tip, with a fee depending on i
+    static CMutableTransaction AddCoinAndTx(int i)
+    {
+        COutPoint prevout(GetRandHash(), 0);
+        pcoinsTip->AddCoin(prevout, Coin(CTxOut(COIN, CScript() << OP_TRUE), 0, false), false);
+
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = prevout;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        tx.vout[0].nValue = COIN - (i % 100 + 1) * 1000;
+        AddTx(tx, COIN - tx.vout[0].nValue);
+        return tx;
+    }
+
+public:
+    std::vector<CMutableTransaction> vTx;
+
+    AssembleSetup()
+    {
+        SelectParams(CBaseChainParams::REGTEST);
+        InitSignatureCache();
+        InitScriptExecutionCache();
+
+        LOCK(cs_main);
+        indexGenesis = CBlockIndex(Params().GenesisBlock());
+        hashGenesis = Params().GenesisBlock().GetHash();
+        indexGenesis.phashBlock = &hashGenesis;
+        chainActive.SetTip(&indexGenesis);
+        pcoinsTip.reset(new CCoinsViewCache(&viewEmpty));
+        pcoinsTip->SetBestBlock(hashGenesis);
+
+        for (int i = 0; i < ASSEMBLE_MEMPOOL_SIZE; i++)
+            vTx.push_back(AddCoinAndTx(i));
+    }
+
+    ~AssembleSetup()
+    {
+        LOCK(cs_main);
+        mempool.clear();
+        chainActive.SetTip(nullptr);
+        pcoinsTip.reset();
+        SelectParams(CBaseChainParams::MAIN);
+    }
+
+    // Replace transaction i by one paying a slightly higher fee, as the
+    // mempool changes between two getblocktemplate calls.
+    void Replace(size_t i, CBlockTemplateSelection* pselection)
+    {
+        CTransactionRef ptxOld = MakeTransactionRef(vTx[i]);
+        mempool.removeRecursive(*ptxOld);
+        vTx[i].vout[0].nValue--;
+        CTransactionRef ptxNew = MakeTransactionRef(vTx[i]);
+        AddTx(*ptxNew, COIN - vTx[i].vout[0].nValue);
+        if (pselection) {
+            pselection->TransactionRemovedFromMempool(ptxOld);
+            pselection->TransactionAddedToMempool(ptxNew);
+        }
+    }
+
+    // Connect a block mining ASSEMBLE_MINED_PER_BLOCK transactions from i on,
+    // and replace them in the mempool by as many new ones.
+    void ConnectTip(size_t i, CBlockTemplateSelection* pselection)
+    {
+        LOCK(cs_main);
+        CBlockIndex* pindexPrev = chainActive.Tip();
+        auto block = std::make_shared<CBlock>();
+        for (int n = 0; n < ASSEMBLE_MINED_PER_BLOCK; n++) {
+            CMutableTransaction& tx = vTx[(i + n) % vTx.size()];
+            block->vtx.push_back(MakeTransactionRef(tx));
+            pcoinsTip->SpendCoin(tx.vin[0].prevout);
+            tx = AddCoinAndTx(i + n);
+        }
+        mempool.removeForBlock(block->vtx, pindexPrev->nHeight + 1);
+
+        vHash.push_back(GetRandHash());
+        vIndex.push_back(CBlockIndex(Params().GenesisBlock()));
+        CBlockIndex& index = vIndex.back();
+        index.phashBlock = &vHash.back();
+        index.pprev = pindexPrev;
+        index.nHeight = pindexPrev->nHeight + 1;
+        index.nTime = pindexPrev->nTime + 1;
+        chainActive.SetTip(&index);
+        pcoinsTip->SetBestBlock(vHash.back());
+
+        if (pselection) {
+            pselection->BlockConnected(block, &index, {});
+            for (int n = 0; n < ASSEMBLE_MINED_PER_BLOCK; n++)
+                pselection->TransactionAddedToMempool(MakeTransactionRef(vTx[(i + n) % vTx.size()]));
+        }
+    }
+};
+
+// A template after one mempool change, selected from the whole mempool and
+// checked with TestBlockValidity...
+static void AssembleBlockFull(benchmark::State& state)
+{
+    AssembleSetup setup;
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        setup.Replace(i++ % setup.vTx.size(), nullptr);
+        BlockAssembler(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D);
+    }
+}
+
+// ...and updated from the selection of the previous template.
+static void AssembleBlockIncremental(benchmark::State& state)
+{
+    AssembleSetup setup;
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    CBlockTemplateSelection selection;
+    BlockAssembler(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D, true, &selection);
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        setup.Replace(i++ % setup.vTx.size(), &selection);
+        BlockAssembler(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D, true, &selection);
+    }
+}
+
+// A template for a new tip that mined some of the mempool, selected from the
+// whole mempool...
+static void AssembleBlockNewTipFull(benchmark::State& state)
+{
+    AssembleSetup setup;
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        setup.ConnectTip(i, nullptr);
+        i += ASSEMBLE_MINED_PER_BLOCK;
+        BlockAssembler(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D);
+    }
+}
+
+// ...and updated from the selection for the previous tip. Both are checked
+// with TestBlockValidity, so this only saves the selection.
+static void AssembleBlockNewTipIncremental(benchmark::State& state)
+{
+    AssembleSetup setup;
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    CBlockTemplateSelection selection;
+    BlockAssembler(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D, true, &selection);
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        setup.ConnectTip(i, &selection);
+        i += ASSEMBLE_MINED_PER_BLOCK;
+        BlockAssembler(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D, true, &selection);
+    }
+}
+
+BENCHMARK(AssembleBlockFull, 20);
+BENCHMARK(AssembleBlockIncremental, 200);
+BENCHMARK(AssembleBlockNewTipFull, 20);
+BENCHMARK(AssembleBlockNewTipIncremental, 20);
@@ -0,0 +1,66 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <instantx.h>
+#include <random.h>
+#include <sync.h>
+#include <validation.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <vector>
+
+static const int VOTE_POOL_SIZE = 4096;
+static const int VOTE_THREADS = 4;
+
+// Votes for lock requests that have not arrived yet, as seen during a vote
+// burst: each one goes down the orphan path of AddVerifiedTxLockVote, which
+// keeps the state of the bench bounded while every call still takes the
+// InstantSend lock.
+static std::vector<CTxLockVote> PendingVotes()
+{
+    std::vector<CTxLockVote> vecVotes;
+    for (int i = 0; i < VOTE_POOL_SIZE; i++) {
+        vecVotes.emplace_back(GetRandHash(), COutPoint(GetRandHash(), 0), COutPoint(GetRandHash(), 0));
+    }
+    return vecVotes;
+}
+
+// Latency of taking cs_main, as block validation and RPC do, while
+// VOTE_THREADS threads commit verified votes. fHoldMain makes the vote
+// threads hold cs_main around each vote like the message handler used to.
+static void InstantSendVotesMainLock(benchmark::State& state, bool fHoldMain)
+{
+    CInstantSend instantsend;
+    const std::vector<CTxLockVote> vecVotes = PendingVotes();
+    std::atomic<bool> fStop(false);
+
+    boost::thread_group tg;
+    for (int t = 0; t < VOTE_THREADS; t++) {
+        tg.create_thread([&, t]{
+            for (size_t i = t; !fStop; i = (i + VOTE_THREADS) % vecVotes.size()) {
+                if (fHoldMain) {
+                    LOCK(cs_main);
+                    instantsend.AddVerifiedTxLockVote(vecVotes[i]);
+                } else {
+                    instantsend.AddVerifiedTxLockVote(vecVotes[i]);
+                }
+            }
+        });
+    }
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+    }
+    fStop = true;
+    tg.join_all();
+}
+
+static void InstantSendVotesHoldingMain(benchmark::State& state) { InstantSendVotesMainLock(state, true); }
+static void InstantSendVotesWithoutMain(benchmark::State& state) { InstantSendVotesMainLock(state, false); }
+
+BENCHMARK(InstantSendVotesHoldingMain, 100 * 1000);
+BENCHMARK(InstantSendVotesWithoutMain, 100 * 1000);
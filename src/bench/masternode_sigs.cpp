@@ -0,0 +1,86 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <checkqueue.h>
+#include <key.h>
+#include <masternode.h>
+#include <util.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+static const int MASTERNODE_LIST_SIZE = 1000;
+static const unsigned int QUEUE_BATCH_SIZE = 128;
+
+// A full masternode list as received during masternode sync: one signed
+// broadcast per masternode, each carrying a signed ping.
+static std::vector<CMasternodeBroadcast> SignedMasternodeList()
+{
+    std::vector<CMasternodeBroadcast> vecMnb;
+    for (int i = 0; i < MASTERNODE_LIST_SIZE; i++) {
+        CKey keyCollateral, keyMasternode;
+        keyCollateral.MakeNewKey(true);
+        keyMasternode.MakeNewKey(true);
+
+        COutPoint outpoint(GetRandHash(), 0);
+        CMasternodeBroadcast mnb(CService(CNetAddr(), 9000 + i), outpoint, keyCollateral.GetPubKey(), keyMasternode.GetPubKey(), PROTOCOL_VERSION);
+        mnb.lastPing.masternodeOutpoint = outpoint;
+        mnb.lastPing.blockHash = GetRandHash();
+        bool fSigned = mnb.lastPing.Sign(keyMasternode, mnb.pubKeyMasternode) && mnb.Sign(keyCollateral);
+        assert(fSigned);
+        vecMnb.push_back(mnb);
+    }
+    return vecMnb;
+}
+
+// Signature checks of a full list ingest, one message after the other as
+// the message handler used to do them.
+static void MasternodeListIngestSerial(benchmark::State& state)
+{
+    const std::vector<CMasternodeBroadcast> vecMnb = SignedMasternodeList();
+    while (state.KeepRunning()) {
+        for (const CMasternodeBroadcast& mnb : vecMnb) {
+            int nDos;
+            bool fValid = mnb.CheckSignature(nDos) && mnb.lastPing.CheckSignature(mnb.pubKeyMasternode, nDos);
+            assert(fValid);
+        }
+    }
+}
+
+// The same list through CMasternodeMan::ProcessPendingMessages: keys are
+// recovered in parallel batches first, then the messages are checked in order.
+static void MasternodeListIngestBatched(benchmark::State& state)
+{
+    const std::vector<CMasternodeBroadcast> vecMnb = SignedMasternodeList();
+    CCheckQueue<CRecoverSigKeyCheck> queue {QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    for (int i = 0; i < GetNumCores() - 1; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+    while (state.KeepRunning()) {
+        std::vector<CMasternodeBroadcast> vecPending(vecMnb);
+        std::vector<CRecoverSigKeyCheck> vChecks;
+        for (CMasternodeBroadcast& mnb : vecPending) {
+            vChecks.push_back(mnb.PrepareSigKeyRecovery());
+            vChecks.push_back(mnb.lastPing.PrepareSigKeyRecovery());
+        }
+        CCheckQueueControl<CRecoverSigKeyCheck> control(&queue);
+        control.Add(vChecks);
+        control.Wait();
+
+        for (const CMasternodeBroadcast& mnb : vecPending) {
+            int nDos;
+            bool fValid = mnb.CheckSignature(nDos) && mnb.lastPing.CheckSignature(mnb.pubKeyMasternode, nDos);
+            assert(fValid);
+        }
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(MasternodeListIngestSerial, 5);
+BENCHMARK(MasternodeListIngestBatched, 20);
@@ -0,0 +1,199 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <auxpow.h>
+#include <chainparams.h>
+#include <crypto/algos/equihash/equihash.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <version.h>
+
+#include <sodium.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <vector>
+
+// PoW hash of every algo as dispatched by CBlockHeader::GetPoWHash, i.e. the
+// path header validation takes. Each iteration hashes one header with a new
+// nonce, so the numbers read directly as hashes per second.
+static void PowHash(benchmark::State& state, uint8_t algo)
+{
+    CBlockHeader header;
+    header.SetNull();
+    header.nTime = 1500000000;
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        header.GetPoWHash(algo);
+    }
+}
+
+static void PowHashSha256d(benchmark::State& state) { PowHash(state, ALGO_SHA256D); }
+static void PowHashScrypt(benchmark::State& state) { PowHash(state, ALGO_SCRYPT); }
+static void PowHashX11(benchmark::State& state) { PowHash(state, ALGO_X11); }
+static void PowHashNeoscrypt(benchmark::State& state) { PowHash(state, ALGO_NEOSCRYPT); }
+static void PowHashEquihash(benchmark::State& state) { PowHash(state, ALGO_EQUIHASH); }
+static void PowHashYescrypt(benchmark::State& state) { PowHash(state, ALGO_YESCRYPT); }
+static void PowHashHmq1725(benchmark::State& state) { PowHash(state, ALGO_HMQ1725); }
+static void PowHashXevan(benchmark::State& state) { PowHash(state, ALGO_XEVAN); }
+static void PowHashNist5(benchmark::State& state) { PowHash(state, ALGO_NIST5); }
+static void PowHashTimeTravel10(benchmark::State& state) { PowHash(state, ALGO_TIMETRAVEL10); }
+static void PowHashPawelHash(benchmark::State& state) { PowHash(state, ALGO_PAWELHASH); }
+static void PowHashX13(benchmark::State& state) { PowHash(state, ALGO_X13); }
+static void PowHashX14(benchmark::State& state) { PowHash(state, ALGO_X14); }
+static void PowHashX15(benchmark::State& state) { PowHash(state, ALGO_X15); }
+static void PowHashX17(benchmark::State& state) { PowHash(state, ALGO_X17); }
+static void PowHashLyra2RE(benchmark::State& state) { PowHash(state, ALGO_LYRA2RE); }
+static void PowHashBlake2S(benchmark::State& state) { PowHash(state, ALGO_BLAKE2S); }
+static void PowHashBlake2B(benchmark::State& state) { PowHash(state, ALGO_BLAKE2B); }
+static void PowHashAstralHash(benchmark::State& state) { PowHash(state, ALGO_ASTRALHASH); }
+static void PowHashPadiHash(benchmark::State& state) { PowHash(state, ALGO_PADIHASH); }
+static void PowHashJeongHash(benchmark::State& state) { PowHash(state, ALGO_JEONGHASH); }
+static void PowHashKeccak(benchmark::State& state) { PowHash(state, ALGO_KECCAK); }
+static void PowHashZhash(benchmark::State& state) { PowHash(state, ALGO_ZHASH); }
+static void PowHashGlobalHash(benchmark::State& state) { PowHash(state, ALGO_GLOBALHASH); }
+static void PowHashSkein(benchmark::State& state) { PowHash(state, ALGO_SKEIN); }
+static void PowHashGroestl(benchmark::State& state) { PowHash(state, ALGO_GROESTL); }
+static void PowHashQubit(benchmark::State& state) { PowHash(state, ALGO_QUBIT); }
+static void PowHashSkunkHash(benchmark::State& state) { PowHash(state, ALGO_SKUNKHASH); }
+static void PowHashQuark(benchmark::State& state) { PowHash(state, ALGO_QUARK); }
+static void PowHashX16R(benchmark::State& state) { PowHash(state, ALGO_X16R); }
+
+// The same algos through the multi-lane batch path that header verification
+// and generateBlocks take; each iteration hashes MULTIHASH_LANES headers.
+static void PowHashBatch(benchmark::State& state, uint8_t algo)
+{
+    CDefaultBlockHeader headers[MULTIHASH_LANES];
+    uint256 hashes[MULTIHASH_LANES];
+    for (size_t i = 0; i < MULTIHASH_LANES; i++) {
+        headers[i].nTime = 1500000000;
+        headers[i].nNonce = i;
+    }
+    while (state.KeepRunning()) {
+        for (CDefaultBlockHeader& header : headers)
+            header.nNonce += MULTIHASH_LANES;
+        CDefaultBlockHeader::GetPoWHashBatch(algo, headers, hashes, MULTIHASH_LANES);
+    }
+}
+
+static void PowHashBatchX11(benchmark::State& state) { PowHashBatch(state, ALGO_X11); }
+static void PowHashBatchX17(benchmark::State& state) { PowHashBatch(state, ALGO_X17); }
+
+// Initial block download: every algo retargets to an equal share of the
+// blocks (nPowTargetSpacingV2 is NUM_ALGOS times the block spacing), so a
+// synced chain is an even mix of all algos in no particular order. Replay a
+// fixed shuffled round of headers so the branch pattern and cache footprint
+// match what header validation sees during IBD.
+static void PowHashIbdMix(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers;
+    for (int round = 0; round < 4; round++) {
+        for (uint8_t algo = 0; algo < NUM_ALGOS; algo++) {
+            CBlockHeader header;
+            header.SetNull();
+            header.SetAlgo(algo);
+            header.nTime = 1560000000 + 60 * (uint32_t)headers.size();
+            header.nNonce = (uint32_t)headers.size();
+            headers.push_back(header);
+        }
+    }
+    // Deterministic shuffle, the same for every run.
+    for (size_t i = headers.size() - 1; i > 0; i--) {
+        std::swap(headers[i], headers[(i * 2654435761u) % (i + 1)]);
+    }
+
+    size_t n = 0;
+    while (state.KeepRunning()) {
+        const CBlockHeader& header = headers[n++ % headers.size()];
+        header.GetPoWHash(header.GetAlgo());
+    }
+}
+
+// Find a valid Equihash solution for the regtest parameters. The mainnet
+// parameters are too expensive to solve at startup, but validation cost
+// scales with 2^k, so the regtest numbers still track regressions in the
+// validator itself.
+static CEquihashBlockHeader SolvedEquihashHeader(unsigned int n, unsigned int k, const std::string& personalization)
+{
+    CEquihashBlockHeader header;
+    header.nTime = 1560000000;
+    std::vector<unsigned char> solution;
+    while (solution.empty()) {
+        header.nNonce = ArithToUint256(UintToArith256(header.nNonce) + 1);
+
+        crypto_generichash_blake2b_state eh_state;
+        EhInitialiseState(n, k, eh_state, personalization);
+        CEquihashInput I{header};
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << I;
+        ss << header.nNonce;
+        crypto_generichash_blake2b_update(&eh_state, (unsigned char*)&ss[0], ss.size());
+
+        EhOptimisedSolveUncancellable(n, k, eh_state,
+            [&solution](std::vector<unsigned char> soln) {
+                solution = soln;
+                return true;
+            });
+    }
+    header.nSolution = solution;
+    return header;
+}
+
+static void EquihashSolution(benchmark::State& state, bool fZhash)
+{
+    const auto params = CreateChainParams(CBaseChainParams::REGTEST);
+    const std::string& personalization = fZhash ? DEFAULT_ZHASH_PERSONALIZE : DEFAULT_EQUIHASH_PERSONALIZE;
+    const CEquihashBlockHeader header = SolvedEquihashHeader(
+        fZhash ? params->ZhashN() : params->EquihashN(),
+        fZhash ? params->ZhashK() : params->EquihashK(), personalization);
+
+    while (state.KeepRunning()) {
+        bool valid = CheckEquihashSolution(&header, *params, fZhash, personalization);
+        assert(valid);
+    }
+}
+
+static void EquihashIsValidSolution(benchmark::State& state) { EquihashSolution(state, false); }
+static void ZhashIsValidSolution(benchmark::State& state) { EquihashSolution(state, true); }
+
+BENCHMARK(PowHashSha256d, 500 * 1000);
+BENCHMARK(PowHashScrypt, 500);
+BENCHMARK(PowHashX11, 20 * 1000);
+BENCHMARK(PowHashNeoscrypt, 500);
+BENCHMARK(PowHashEquihash, 300 * 1000);
+BENCHMARK(PowHashYescrypt, 100);
+BENCHMARK(PowHashHmq1725, 5000);
+BENCHMARK(PowHashXevan, 5000);
+BENCHMARK(PowHashNist5, 50 * 1000);
+BENCHMARK(PowHashTimeTravel10, 20 * 1000);
+BENCHMARK(PowHashPawelHash, 10 * 1000);
+BENCHMARK(PowHashX13, 20 * 1000);
+BENCHMARK(PowHashX14, 20 * 1000);
+BENCHMARK(PowHashX15, 10 * 1000);
+BENCHMARK(PowHashX17, 10 * 1000);
+BENCHMARK(PowHashLyra2RE, 5000);
+BENCHMARK(PowHashBlake2S, 500 * 1000);
+BENCHMARK(PowHashBlake2B, 500 * 1000);
+BENCHMARK(PowHashAstralHash, 10 * 1000);
+BENCHMARK(PowHashPadiHash, 10 * 1000);
+BENCHMARK(PowHashJeongHash, 10 * 1000);
+BENCHMARK(PowHashKeccak, 500 * 1000);
+BENCHMARK(PowHashZhash, 300 * 1000);
+BENCHMARK(PowHashGlobalHash, 10 * 1000);
+BENCHMARK(PowHashSkein, 200 * 1000);
+BENCHMARK(PowHashGroestl, 50 * 1000);
+BENCHMARK(PowHashQubit, 50 * 1000);
+BENCHMARK(PowHashSkunkHash, 20 * 1000);
+BENCHMARK(PowHashQuark, 50 * 1000);
+BENCHMARK(PowHashX16R, 10 * 1000);
+BENCHMARK(PowHashBatchX11, 5000);
+BENCHMARK(PowHashBatchX17, 2500);
+BENCHMARK(PowHashIbdMix, 2000);
+BENCHMARK(EquihashIsValidSolution, 20 * 1000);
+BENCHMARK(ZhashIsValidSolution, 5000);
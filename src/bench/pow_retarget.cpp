@@ -0,0 +1,48 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <huntcoin/hardfork.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <validation.h>
+
+#include <vector>
+
+// Next work required for every algo on top of a chain where algo n is mined
+// about once every 2^(n+1) blocks, so the high algo ids are hardly ever seen.
+static void PowRetargetAllAlgos(benchmark::State& state)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    std::vector<CBlockIndex> vBlocks(20000);
+    for (unsigned int i = 0; i < vBlocks.size(); i++) {
+        uint8_t algo = __builtin_ctz((i + 1) | (1u << (NUM_ALGOS - 1)));
+        vBlocks[i].nHeight = i;
+        vBlocks[i].pprev = (i == 0) ? nullptr : &vBlocks[i - 1];
+        vBlocks[i].nTime = params.HardforkTime + 60 * i;
+        vBlocks[i].nBits = GetAlgoPowLimit(algo).GetCompact();
+        vBlocks[i].nVersion = (algo + 1) << 9;
+        vBlocks[i].BuildSkip();
+        vBlocks[i].BuildSameAlgo();
+    }
+
+    LOCK(cs_main);
+    chainActive.SetTip(&vBlocks.back());
+    const CBlockIndex* pindexLast = chainActive.Tip();
+
+    CBlockHeader header;
+    header.nTime = pindexLast->nTime + 60;
+    while (state.KeepRunning()) {
+        for (uint8_t algo = 0; algo < NUM_ALGOS; algo++) {
+            header.nVersion = (algo + 1) << 9;
+            GetNextWorkRequired(pindexLast, &header, params, algo);
+        }
+    }
+    chainActive.SetTip(nullptr);
+}
+
+BENCHMARK(PowRetargetAllAlgos, 5000);
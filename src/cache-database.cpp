@@ -0,0 +1,20 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cache-database.h>
+
+#include <masternode-payments.h>
+#include <masternodeman.h>
+#include <netfulfilledman.h>
+
+std::unique_ptr<CCacheDB<CMasternodeMan> > pmncachedb;
+std::unique_ptr<CCacheDB<CMasternodePayments> > pmnpaymentsdb;
+std::unique_ptr<CCacheDB<CNetFulfilledRequestManager> > pnetfulfilleddb;
+
+void FlushMasternodeCaches()
+{
+    if (pmncachedb) pmncachedb->Flush(mnodeman);
+    if (pmnpaymentsdb) pmnpaymentsdb->Flush(mnpayments);
+    if (pnetfulfilleddb) pnetfulfilleddb->Flush(netfulfilledman);
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CACHE_DATABASE_H
+#define CACHE_DATABASE_H
+
+#include <clientversion.h>
+#include <dbwrapper.h>
+#include <hash.h>
+#include <streams.h>
+#include <sync.h>
+#include <util.h>
+
+#include <map>
+#include <memory>
+
+class CMasternodeMan;
+class CMasternodePayments;
+class CNetFulfilledRequestManager;
+
+/**
+*   LevelDB-backed storage for the masternode caches
+*   ------------------------------------------------
+*
+*   Each map an object hands to the visitor of its VisitCacheMaps method is
+*   stored one entry per key, the key prefixed with the tag of its map.
+*   Flush only writes the entries that changed since the previous flush and
+*   erases the ones that were removed, all in one synced batch, so a crash
+*   leaves either the old or the new state on disk. Load streams the entries
+*   back into the maps.
+*/
+
+template<typename T>
+class CCacheDB
+{
+private:
+    typedef std::pair<char, std::vector<unsigned char> > entry_key_t;
+
+    static const size_t DB_CACHE_SIZE = 2 << 20;
+
+    CCriticalSection cs;
+    CDBWrapper db;
+    std::string strName;
+    std::string strMagicMessage;
+    // hash of the value stored under every key, as of the last Load or Flush
+    std::map<entry_key_t, uint256> mapStored;
+
+    static const std::string& MagicKey()
+    {
+        static const std::string strKey = "magic";
+        return strKey;
+    }
+
+    static entry_key_t EntryKey(char tag, const CDataStream& ssKey)
+    {
+        return std::make_pair(tag, std::vector<unsigned char>(ssKey.begin(), ssKey.end()));
+    }
+
+    class Writer
+    {
+    private:
+        const std::map<entry_key_t, uint256>& mapStored;
+        CDBBatch& batch;
+
+    public:
+        std::map<entry_key_t, uint256> mapWritten;
+        size_t nUpdated;
+
+        Writer(const std::map<entry_key_t, uint256>& mapStoredIn, CDBBatch& batchIn) :
+            mapStored(mapStoredIn), batch(batchIn), nUpdated(0) {}
+
+        bool ForRead() const { return false; }
+
+        template<typename K, typename V>
+        void operator()(char tag, const std::map<K, V>& mapIn)
+        {
+            for (const auto& entry : mapIn) {
+                CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+                ssKey << entry.first;
+                CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+                ssValue << entry.second;
+
+                entry_key_t key = EntryKey(tag, ssKey);
+                uint256 hash = Hash(ssValue.begin(), ssValue.end());
+                auto it = mapStored.find(key);
+                if (it == mapStored.end() || it->second != hash) {
+                    batch.Write(key, std::vector<unsigned char>(ssValue.begin(), ssValue.end()));
+                    nUpdated++;
+                }
+                mapWritten.emplace(std::move(key), hash);
+            }
+        }
+    };
+
+    class Reader
+    {
+    private:
+        CDBWrapper& db;
+        std::map<entry_key_t, uint256>& mapStored;
+
+    public:
+        explicit Reader(CDBWrapper& dbIn, std::map<entry_key_t, uint256>& mapStoredIn) :
+            db(dbIn), mapStored(mapStoredIn) {}
+
+        bool ForRead() const { return true; }
+
+        template<typename K, typename V>
+        void operator()(char tag, std::map<K, V>& mapOut)
+        {
+            std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+            pcursor->Seek(std::make_pair(tag, std::vector<unsigned char>()));
+            for (; pcursor->Valid(); pcursor->Next()) {
+                entry_key_t key;
+                if (!pcursor->GetKey(key) || key.first != tag)
+                    break;
+                std::vector<unsigned char> vchValue;
+                if (!pcursor->GetValue(vchValue))
+                    throw std::runtime_error("failed to read value");
+
+                CDataStream ssKey(key.second, SER_DISK, CLIENT_VERSION);
+                CDataStream ssValue(vchValue, SER_DISK, CLIENT_VERSION);
+                K k;
+                V v;
+                ssKey >> k;
+                ssValue >> v;
+                mapOut.emplace(std::move(k), std::move(v));
+                mapStored.emplace(std::move(key), Hash(vchValue.begin(), vchValue.end()));
+            }
+        }
+    };
+
+public:
+    CCacheDB(const std::string& strNameIn, const std::string& strMagicMessageIn) :
+        db(GetDataDir() / strNameIn, DB_CACHE_SIZE),
+        strName(strNameIn),
+        strMagicMessage(strMagicMessageIn)
+    {}
+
+    /** Remove every entry, e.g. after a format change. */
+    void Wipe()
+    {
+        LOCK(cs);
+        CDBBatch batch(db);
+        std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+        for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+            entry_key_t key;
+            if (pcursor->GetKey(key))
+                batch.Erase(key);
+        }
+        batch.Erase(MagicKey());
+        db.WriteBatch(batch, true);
+        mapStored.clear();
+    }
+
+    bool Load(T& objToLoad)
+    {
+        LOCK(cs);
+
+        int64_t nStart = GetTimeMillis();
+        LogPrintf("Reading info from %s...\n", strName);
+
+        std::string strMagicMessageTmp;
+        if (!db.Read(MagicKey(), strMagicMessageTmp)) {
+            LogPrintf("Missing %s, will try to recreate\n", strName);
+            Wipe();
+            return true;
+        }
+        if (strMagicMessageTmp != strMagicMessage) {
+            LogPrintf("%s: Invalid magic message in %s, will try to recreate\n", __func__, strName);
+            Wipe();
+            return true;
+        }
+
+        try {
+            Reader reader(db, mapStored);
+            objToLoad.VisitCacheMaps(reader);
+        }
+        catch (const std::exception& e) {
+            objToLoad.Clear();
+            LogPrintf("%s: Deserialize or I/O error in %s - %s, will try to recreate\n", __func__, strName, e.what());
+            Wipe();
+            return true;
+        }
+
+        LogPrintf("Loaded info from %s  %dms\n", strName, GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToLoad.ToString());
+        LogPrintf("%s: Cleaning....\n", __func__);
+        objToLoad.CheckAndRemove();
+        LogPrintf("     %s\n", objToLoad.ToString());
+
+        return true;
+    }
+
+    bool Flush(T& objToSave)
+    {
+        LOCK(cs);
+
+        int64_t nStart = GetTimeMillis();
+
+        CDBBatch batch(db);
+        Writer writer(mapStored, batch);
+        objToSave.VisitCacheMaps(writer);
+
+        size_t nErased = 0;
+        for (const auto& stored : mapStored) {
+            if (!writer.mapWritten.count(stored.first)) {
+                batch.Erase(stored.first);
+                nErased++;
+            }
+        }
+        batch.Write(MagicKey(), strMagicMessage);
+
+        if (!db.WriteBatch(batch, true))
+            return error("%s: Failed to write %s", __func__, strName);
+        mapStored.swap(writer.mapWritten);
+
+        LogPrintf("Written info to %s: %d entries updated, %d erased  %dms\n", strName, writer.nUpdated, nErased, GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToSave.ToString());
+
+        return true;
+    }
+};
+
+extern std::unique_ptr<CCacheDB<CMasternodeMan> > pmncachedb;
+extern std::unique_ptr<CCacheDB<CMasternodePayments> > pmnpaymentsdb;
+extern std::unique_ptr<CCacheDB<CNetFulfilledRequestManager> > pnetfulfilleddb;
+
+/** Write the changes to the masternode caches that are open. */
+void FlushMasternodeCaches();
+
+#endif
@@ -4,8 +4,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chain.h>
+#include <auxpowcache.h>
 #include <bignum.h>
 #include <huntcoin/hardfork.h>
+#include <txdb.h>
+#include <util.h>
 #include <validation.h>
 
 CBlockHeader CBlockIndex::GetBlockHeader(const Consensus::Params& consensusParams) const
@@ -13,22 +16,35 @@ CBlockHeader CBlockIndex::GetBlockHeader(const Consensus::Params& consensusParam
     CBlockHeader block;
     block.nVersion       = nVersion;
     /* The CBlockIndex object's block header is missing the auxpow.
-       So if this is an auxpow block, read it from disk instead.  We only
-       have to read the actual *header*, not the full block.  */
-    if (block.IsAuxpow())
+       So if this is an auxpow block, take it from the auxpow cache or
+       read it from disk instead.  We only have to read the actual *header*,
+       not the full block.  */
+    boost::shared_ptr<CAuxPow> pauxpow;
+    if (block.IsAuxpow() && !auxpowcache.Get(GetBlockHash(), pauxpow))
     {
-        ReadBlockHeaderFromDisk(block, this, consensusParams);
+        if (ReadBlockHeaderFromDisk(block, this, consensusParams) && block.auxpow)
+            auxpowcache.Insert(GetBlockHash(), block.auxpow);
         return block;
     }
     if (pprev)
         block.hashPrevBlock = pprev->GetBlockHash();
     block.hashMerkleRoot = hashMerkleRoot;
-    block.hashReserved   = hashReserved;
     block.nTime          = nTime;
     block.nBits          = nBits;
     block.nNonce         = nNonce;
-    block.nBigNonce      = nBigNonce;
-    block.nSolution      = nSolution;
+    /* The Equihash fields are not kept in memory, fetch them from the block tree DB. */
+    if (HasSolution())
+    {
+        CBlockSolution solution;
+        if (pblocktree && pblocktree->ReadBlockSolution(GetBlockHash(), solution)) {
+            block.hashReserved = solution.hashReserved;
+            block.nBigNonce    = solution.nBigNonce;
+            block.nSolution    = solution.nSolution;
+        } else {
+            error("%s: failed to read %s solution of %s", __func__, GetAlgoName(GetAlgo()), GetBlockHash().ToString());
+        }
+    }
+    block.auxpow = pauxpow;
     return block;
 }
 
@@ -38,13 +54,32 @@ CBlockHeader CBlockIndex::GetBlockHeader(const Consensus::Params& consensusParam
 void CChain::SetTip(CBlockIndex *pindex) {
     if (pindex == nullptr) {
         vChain.clear();
+        for (std::vector<int>& vHeights : vAlgoHeights)
+            vHeights.clear();
+        vPreHardforkHeights.clear();
         return;
     }
+    int nForkHeight = pindex->nHeight + 1;
     vChain.resize(pindex->nHeight + 1);
     while (pindex && vChain[pindex->nHeight] != pindex) {
         vChain[pindex->nHeight] = pindex;
+        nForkHeight = pindex->nHeight;
         pindex = pindex->pprev;
     }
+
+    // Drop the per-algo entries past the fork and append the new blocks.
+    for (std::vector<int>& vHeights : vAlgoHeights) {
+        while (!vHeights.empty() && vHeights.back() >= nForkHeight)
+            vHeights.pop_back();
+    }
+    while (!vPreHardforkHeights.empty() && vPreHardforkHeights.back() >= nForkHeight)
+        vPreHardforkHeights.pop_back();
+    for (int nHeight = nForkHeight; nHeight < (int)vChain.size(); nHeight++) {
+        const CBlockIndex* pindexNew = vChain[nHeight];
+        vAlgoHeights[pindexNew->GetAlgo()].push_back(nHeight);
+        if (!IsHardForkActivated(pindexNew->nTime))
+            vPreHardforkHeights.push_back(nHeight);
+    }
 }
 
 CBlockLocator CChain::GetLocator(const CBlockIndex *pindex) const {
@@ -93,6 +128,41 @@ CBlockIndex* CChain::FindEarliestAtLeast(int64_t nTime) const
     return (lower == vChain.end() ? nullptr : *lower);
 }
 
+const CBlockIndex* CChain::FindLastForAlgo(const CBlockIndex* pindex, uint8_t algo) const
+{
+    assert(Contains(pindex));
+    if (algo >= NUM_ALGOS)
+        return nullptr;
+
+    const std::vector<int>& vHeights = vAlgoHeights[algo];
+    std::vector<int>::const_iterator it = std::upper_bound(vHeights.begin(), vHeights.end(), pindex->nHeight);
+    if (it == vHeights.begin())
+        return nullptr;
+    int nHeight = *(--it);
+
+    // Walking back, any block from before the hardfork ends the search for non-SHA256D algos.
+    if (algo != ALGO_SHA256D) {
+        std::vector<int>::const_iterator itFork = std::upper_bound(vPreHardforkHeights.begin(), vPreHardforkHeights.end(), pindex->nHeight);
+        if (itFork != vPreHardforkHeights.begin() && *(--itFork) >= nHeight)
+            return nullptr;
+    }
+    return vChain[nHeight];
+}
+
+CBlockIndex* CChain::FindNextForAlgo(const CBlockIndex* pindex, uint8_t algo) const
+{
+    if (pindex == nullptr || algo >= NUM_ALGOS)
+        return nullptr;
+    if (!Contains(pindex))
+        return pindex->GetAlgo() == algo ? const_cast<CBlockIndex*>(pindex) : nullptr;
+
+    const std::vector<int>& vHeights = vAlgoHeights[algo];
+    std::vector<int>::const_iterator it = std::lower_bound(vHeights.begin(), vHeights.end(), pindex->nHeight);
+    if (it == vHeights.end())
+        return nullptr;
+    return vChain[*it];
+}
+
 /** Turn the lowest '1' bit in the binary representation of a number into a '0'. */
 int static inline InvertLowestOne(int n) { return n & (n - 1); }
 
@@ -139,6 +209,23 @@ CBlockIndex* CBlockIndex::GetAncestor(int height)
     return const_cast<CBlockIndex*>(static_cast<const CBlockIndex*>(this)->GetAncestor(height));
 }
 
+void CBlockIndex::BuildSameAlgo()
+{
+    // Same walk as GetLastBlockIndexForAlgo(pprev, GetAlgo()). It is bounded by
+    // the distance to the previous block of this algo, which is O(NUM_ALGOS)
+    // while all algos are mined, and done once per block index.
+    const uint8_t algo = GetAlgo();
+    pprevSameAlgo = nullptr;
+    for (const CBlockIndex* pindex = pprev; pindex; pindex = pindex->pprev) {
+        if (!IsHardForkActivated(pindex->nTime) && algo != ALGO_SHA256D)
+            break;
+        if (pindex->GetAlgo() == algo) {
+            pprevSameAlgo = pindex;
+            break;
+        }
+    }
+}
+
 void CBlockIndex::BuildSkip()
 {
     if (pprev)
@@ -162,6 +162,16 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_POW_VERIFIED       =   256, //!< header proof of work (and Equihash solution) was verified when accepted
+};
+
+/** The Equihash/Zhash header fields, which CBlockIndex leaves in the block tree DB. */
+struct CBlockSolution
+{
+    uint256 hashReserved;
+    uint256 nBigNonce;
+    std::vector<unsigned char> nSolution;
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -181,6 +191,9 @@ public:
     //! pointer to the index of some further predecessor of this block
     CBlockIndex* pskip;
 
+    //! pointer to the index of the closest predecessor mined with the same algo (see GetLastBlockIndexForAlgo)
+    const CBlockIndex* pprevSameAlgo;
+
     //! height of the entry in the chain. The genesis block has height 0
     int nHeight;
 
@@ -209,14 +222,13 @@ public:
     uint32_t nStatus;
 
     //! block header
+    //! The Equihash/Zhash fields (hashReserved, nBigNonce, nSolution) are not kept
+    //! in memory, GetBlockHeader() loads them from the block tree DB when needed.
     int32_t nVersion;
     uint256 hashMerkleRoot;
-	uint256 hashReserved;
     uint32_t nTime;
     uint32_t nBits;
     uint32_t nNonce;
-    uint256 nBigNonce;
-	std::vector<unsigned char> nSolution;
 
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     int32_t nSequenceId;
@@ -229,6 +241,7 @@ public:
         phashBlock = nullptr;
         pprev = nullptr;
         pskip = nullptr;
+        pprevSameAlgo = nullptr;
         nHeight = 0;
         nFile = 0;
         nDataPos = 0;
@@ -242,12 +255,9 @@ public:
 
         nVersion       = 0;
         hashMerkleRoot = uint256();
-		hashReserved   = uint256();
         nTime          = 0;
         nBits          = 0;
         nNonce         = 0;
-        nBigNonce      = uint256();
-		nSolution.clear();
     }
 
     CBlockIndex()
@@ -261,12 +271,9 @@ public:
 
         nVersion       = block.nVersion;
         hashMerkleRoot = block.hashMerkleRoot;
-		hashReserved   = block.hashReserved;
         nTime          = block.nTime;
         nBits          = block.nBits;
         nNonce         = block.nNonce;
-        nBigNonce      = block.nBigNonce;
-		nSolution      = block.nSolution;
     }
 
     CDiskBlockPos GetBlockPos() const {
@@ -300,6 +307,12 @@ public:
         return block.GetPoWHash();
     }
 
+    //! Whether the header has the Equihash fields that are stored outside of the index entry.
+    bool HasSolution() const
+    {
+        return IsEquihashAlgo(GetAlgo());
+    }
+
     uint8_t GetAlgo() const
     {
         /* create a dummy blockheader and set the nVersion known from CBlockIndex into the block version.
@@ -379,11 +392,16 @@ public:
     //! Build the skiplist pointer for this entry.
     void BuildSkip();
 
+    //! Build the same-algo predecessor pointer for this entry.
+    void BuildSameAlgo();
+
     //! Efficiently find an ancestor of this block.
     CBlockIndex* GetAncestor(int height);
     const CBlockIndex* GetAncestor(int height) const;
 };
 
+/** The work implied by the target of the block alone. */
+arith_uint256 GetBlockProofBase(const CBlockIndex& block);
 arith_uint256 GetBlockProof(const CBlockIndex& block);
 /** Return the time it would take to redo the work difference between from and to, assuming the current hashrate corresponds to the difficulty at tip, in seconds. */
 int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& from, const CBlockIndex& tip, const Consensus::Params&);
@@ -396,11 +414,15 @@ class CDiskBlockIndex : public CBlockIndex
 {
 public:
     uint256 hashPrev;
+    uint256 hashReserved;
+    uint256 nBigNonce;
+    std::vector<unsigned char> nSolution;
 
     CDiskBlockIndex() {
         hashPrev = uint256();
     }
 
+    //! The Equihash fields are not part of pindex, set them with SetSolution().
     explicit CDiskBlockIndex(const CBlockIndex* pindex) : CBlockIndex(*pindex) {
         hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
     }
@@ -425,25 +447,43 @@ public:
 
         // block header
         READWRITE(this->nVersion);
+        const bool fEquihash = IsEquihashAlgo(GetAlgo());
         READWRITE(hashPrev);
         READWRITE(hashMerkleRoot);
-        if (GetAlgo() == ALGO_EQUIHASH || GetAlgo() == ALGO_ZHASH) {
+        if (fEquihash) {
             READWRITE(hashReserved);
         }
         READWRITE(nTime);
         READWRITE(nBits);
-        if (GetAlgo() == ALGO_EQUIHASH || GetAlgo() == ALGO_ZHASH)
+        if (fEquihash)
         {
             READWRITE(nBigNonce);
             READWRITE(nSolution);
         }
-        if(!(GetAlgo() == ALGO_EQUIHASH || GetAlgo() == ALGO_ZHASH))
+        if(!fEquihash)
         {
             READWRITE(nNonce);
         }
     }
 
-    uint256 GetBlockHash() const
+    void SetSolution(const CBlockSolution& solution)
+    {
+        hashReserved = solution.hashReserved;
+        nBigNonce    = solution.nBigNonce;
+        nSolution    = solution.nSolution;
+    }
+
+    CBlockSolution GetSolution() const
+    {
+        CBlockSolution solution;
+        solution.hashReserved = hashReserved;
+        solution.nBigNonce    = nBigNonce;
+        solution.nSolution    = nSolution;
+        return solution;
+    }
+
+    //! The stored header, without auxpow.
+    CBlockHeader GetHeader() const
     {
         CBlockHeader block;
         block.nVersion        = nVersion;
@@ -455,7 +495,12 @@ public:
         block.nNonce          = nNonce;
         block.nBigNonce       = nBigNonce;
 		block.nSolution       = nSolution;
-        return block.GetHash();
+        return block;
+    }
+
+    uint256 GetBlockHash() const
+    {
+        return GetHeader().GetHash();
     }
 
 
@@ -474,6 +519,10 @@ public:
 class CChain {
 private:
     std::vector<CBlockIndex*> vChain;
+    //! heights of the blocks mined with each algo, in ascending order
+    std::vector<int> vAlgoHeights[NUM_ALGOS];
+    //! heights of the blocks timestamped before the hardfork, in ascending order
+    std::vector<int> vPreHardforkHeights;
 
 public:
     /** Returns the index entry for the genesis block of this chain, or nullptr if none. */
@@ -528,6 +577,20 @@ public:
 
     /** Find the earliest block with timestamp equal or greater than the given. */
     CBlockIndex* FindEarliestAtLeast(int64_t nTime) const;
+
+    /** Returns the index entry of the last block mined with algo in this chain, or nullptr if none. */
+    const CBlockIndex* TipForAlgo(uint8_t algo) const {
+        return Tip() ? FindLastForAlgo(Tip(), algo) : nullptr;
+    }
+
+    /**
+     * Find the last block mined with algo at or before pindex, which must be in this chain.
+     * Same result as walking pprev in GetLastBlockIndexForAlgo, without the walk.
+     */
+    const CBlockIndex* FindLastForAlgo(const CBlockIndex* pindex, uint8_t algo) const;
+
+    /** Find the first block mined with algo at or after pindex, or nullptr if pindex is not in this chain. */
+    CBlockIndex* FindNextForAlgo(const CBlockIndex* pindex, uint8_t algo) const;
 };
 
 #endif // HUNTCOIN_CHAIN_H
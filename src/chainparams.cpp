@@ -12,6 +12,7 @@
 #include <base58.h> // For CTxDestination
 #include <chainparams.h>
 #include <consensus/merkle.h>
+#include <huntcoin/hardfork.h>
 #include <primitives/mining_block.h>
 
 #include <tinyformat.h>
@@ -137,6 +138,7 @@ public:
         consensus.powLimit_SKUNKHASH = uint256S("00000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.powLimit_QUARK = uint256S("00000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.powLimit_X16R = uint256S("00000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+        InitAlgoPowLimits(consensus);
         consensus.nTargetSpacing = 60; // 1 minute
         consensus.nTargetTimespan =  60; // 5 minutes
         consensus.nPowTargetTimespan = 10 * 60; // ten minutes
@@ -347,6 +349,7 @@ public:
         consensus.powLimit_SKUNKHASH = uint256S("0000ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.powLimit_QUARK = uint256S("0000ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.powLimit_X16R = uint256S("00000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+        InitAlgoPowLimits(consensus);
         consensus.nTargetSpacing = 60; // 1 minute
         consensus.nTargetTimespan =  60; // 5 minutes
         consensus.nPowTargetTimespan = 10 * 60; // ten minutes
@@ -542,6 +545,7 @@ public:
         consensus.powLimit_SKUNKHASH = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.powLimit_QUARK = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.powLimit_X16R = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+        InitAlgoPowLimits(consensus);
         consensus.nPowTargetTimespan = 10 * 60; // ten minutes
         consensus.nPowTargetSpacing = 60;
         consensus.fPowAllowMinDifficultyBlocks = true;
@@ -8,10 +8,12 @@
 #ifndef HUNTCOIN_CONSENSUS_PARAMS_H
 #define HUNTCOIN_CONSENSUS_PARAMS_H
 
+#include <arith_uint256.h>
 #include <uint256.h>
 #include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace Consensus {
 
@@ -111,6 +113,8 @@ struct Params {
     uint256 powLimit_SKUNKHASH;
     uint256 powLimit_QUARK;
     uint256 powLimit_X16R;
+    /** The powLimit_* above as arith_uint256, indexed by algo (see InitAlgoPowLimits) */
+    std::vector<arith_uint256> vAlgoPowLimit;
     bool fPowAllowMinDifficultyBlocks;
     bool fPowNoRetargeting;
     int64_t nTargetTimespan;
@@ -23,6 +23,7 @@
 #include <time.h>
 #include "Lyra2.h"
 #include "Sponge.h"
+#include "../scratch.h"
 
 /**
  * Executes Lyra2 based on the G function from Blake2b. This version supports salts and passwords
@@ -63,18 +64,17 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
     const int64_t ROW_LEN_BYTES = ROW_LEN_INT64 * 8;
 
-    i = (int64_t) ((int64_t) nRows * (int64_t) ROW_LEN_BYTES);
-    uint64_t *wholeMatrix = malloc(i);
-    if (wholeMatrix == NULL) {
+    //The matrix, the row pointers and the sponge state share one per-thread scratch buffer
+    const int64_t MATRIX_BYTES = (int64_t) nRows * (int64_t) ROW_LEN_BYTES;
+    byte *scratch = pow_scratch(POW_SCRATCH_LYRA2, MATRIX_BYTES + nRows * sizeof (uint64_t*) + 16 * sizeof (uint64_t));
+    if (scratch == NULL) {
       return -1;
     }
-	memset(wholeMatrix, 0, i);
+    uint64_t *wholeMatrix = (uint64_t*) scratch;
+	memset(wholeMatrix, 0, MATRIX_BYTES);
 
-    //Allocates pointers to each row of the matrix
-    uint64_t **memMatrix = malloc(nRows * sizeof (uint64_t*));
-    if (memMatrix == NULL) {
-      return -1;
-    }
+    //Pointers to each row of the matrix
+    uint64_t **memMatrix = (uint64_t**) (scratch + MATRIX_BYTES);
     //Places the pointers in the correct positions
     uint64_t *ptrWord = wholeMatrix;
     for (i = 0; i < nRows; i++) {
@@ -123,10 +123,7 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
 
     //======================= Initializing the Sponge State ====================//
     //Sponge state: 16 uint64_t, BLOCK_LEN_INT64 words of them for the bitrate (b) and the remainder for the capacity (c)
-    uint64_t *state = malloc(16 * sizeof (uint64_t));
-    if (state == NULL) {
-      return -1;
-    }
+    uint64_t *state = (uint64_t*) (scratch + MATRIX_BYTES + nRows * sizeof (uint64_t*));
     initState(state);
     //==========================================================================/
 
@@ -200,13 +197,9 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     squeeze(state, K, kLen);
     //==========================================================================/
 
-    //========================= Freeing the memory =============================//
-    free(memMatrix);
-    free(wholeMatrix);
-
-    //Wiping out the sponge's internal state before freeing it
+    //========================= Wiping the memory ==============================//
+    //The scratch buffer is reused by the next call, only wipe the sponge's internal state
     memset(state, 0, 16 * sizeof (uint64_t));
-    free(state);
     //==========================================================================/
 
     return 0;
@@ -232,18 +225,17 @@ int LYRA2_old(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const vo
     const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
     const int64_t ROW_LEN_BYTES = ROW_LEN_INT64 * 8;
 
-    i = (int64_t) ((int64_t) nRows * (int64_t) ROW_LEN_BYTES);
-    uint64_t *wholeMatrix = malloc(i);
-    if (wholeMatrix == NULL) {
+    //The matrix, the row pointers and the sponge state share one per-thread scratch buffer
+    const int64_t MATRIX_BYTES = (int64_t) nRows * (int64_t) ROW_LEN_BYTES;
+    byte *scratch = pow_scratch(POW_SCRATCH_LYRA2, MATRIX_BYTES + nRows * sizeof (uint64_t*) + 16 * sizeof (uint64_t));
+    if (scratch == NULL) {
       return -1;
     }
-	memset(wholeMatrix, 0, i);
+    uint64_t *wholeMatrix = (uint64_t*) scratch;
+	memset(wholeMatrix, 0, MATRIX_BYTES);
 
-    //Allocates pointers to each row of the matrix
-    uint64_t **memMatrix = malloc(nRows * sizeof (uint64_t*));
-    if (memMatrix == NULL) {
-      return -1;
-    }
+    //Pointers to each row of the matrix
+    uint64_t **memMatrix = (uint64_t**) (scratch + MATRIX_BYTES);
     //Places the pointers in the correct positions
     uint64_t *ptrWord = wholeMatrix;
     for (i = 0; i < nRows; i++) {
@@ -292,10 +284,7 @@ int LYRA2_old(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const vo
 
     //======================= Initializing the Sponge State ====================//
     //Sponge state: 16 uint64_t, BLOCK_LEN_INT64 words of them for the bitrate (b) and the remainder for the capacity (c)
-    uint64_t *state = malloc(16 * sizeof (uint64_t));
-    if (state == NULL) {
-      return -1;
-    }
+    uint64_t *state = (uint64_t*) (scratch + MATRIX_BYTES + nRows * sizeof (uint64_t*));
     initState(state);
     //==========================================================================/
 
@@ -369,13 +358,9 @@ int LYRA2_old(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const vo
     squeeze(state, K, kLen);
     //==========================================================================/
 
-    //========================= Freeing the memory =============================//
-    free(memMatrix);
-    free(wholeMatrix);
-
-    //Wiping out the sponge's internal state before freeing it
+    //========================= Wiping the memory ==============================//
+    //The scratch buffer is reused by the next call, only wipe the sponge's internal state
     memset(state, 0, 16 * sizeof (uint64_t));
-    free(state);
     //==========================================================================/
 
     return 0;
@@ -36,6 +36,8 @@
 #include <crypto/algos/blake/blake2.h>
 #include <openssl/sha.h>
 
+#include <algorithm>
+
 #ifdef GLOBALDEFINED
 #define GLOBAL
 #else
@@ -0,0 +1,272 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/algos/hashlib/multihash_batch.h>
+
+#include <crypto/algos/hashlib/multihash.h>
+#include <crypto/common.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#define HAVE_MULTIHASH_VECTOR 1
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+#include <cpuid.h>
+#define HAVE_MULTIHASH_AVX2 1
+#endif
+#endif
+
+// Internal implementation code.
+namespace
+{
+/// Reference kernels: one sph_* call per lane, exactly what the scalar chains do.
+namespace multihash_scalar
+{
+void Blake512_80(const unsigned char* const in[MULTIHASH_LANES], unsigned char (*out)[64])
+{
+    sph_blake512_context ctx;
+    for (size_t j = 0; j < MULTIHASH_LANES; j++) {
+        sph_blake512_init(&ctx);
+        sph_blake512(&ctx, in[j], 80);
+        sph_blake512_close(&ctx, out[j]);
+    }
+}
+
+void Bmw512_64(unsigned char (*data)[64])
+{
+    sph_bmw512_context ctx;
+    for (size_t j = 0; j < MULTIHASH_LANES; j++) {
+        sph_bmw512_init(&ctx);
+        sph_bmw512(&ctx, data[j], 64);
+        sph_bmw512_close(&ctx, data[j]);
+    }
+}
+
+void Skein512_64(unsigned char (*data)[64])
+{
+    sph_skein512_context ctx;
+    for (size_t j = 0; j < MULTIHASH_LANES; j++) {
+        sph_skein512_init(&ctx);
+        sph_skein512(&ctx, data[j], 64);
+        sph_skein512_close(&ctx, data[j]);
+    }
+}
+
+void Keccak512_64(unsigned char (*data)[64])
+{
+    sph_keccak512_context ctx;
+    for (size_t j = 0; j < MULTIHASH_LANES; j++) {
+        sph_keccak512_init(&ctx);
+        sph_keccak512(&ctx, data[j], 64);
+        sph_keccak512_close(&ctx, data[j]);
+    }
+}
+} // namespace multihash_scalar
+
+#if defined(HAVE_MULTIHASH_VECTOR)
+/// Portable vector kernels; plain SSE2 on x86_64.
+namespace multihash_vector
+{
+#define MULTIHASH_TARGET
+#include <crypto/algos/hashlib/multihash_batch_impl.h>
+#undef MULTIHASH_TARGET
+} // namespace multihash_vector
+#endif
+
+#if defined(HAVE_MULTIHASH_AVX2)
+/// The same kernels compiled for AVX2, one lane per 64-bit element of a ymm register.
+namespace multihash_avx2
+{
+#define MULTIHASH_TARGET __attribute__((target("avx2")))
+#include <crypto/algos/hashlib/multihash_batch_impl.h>
+#undef MULTIHASH_TARGET
+} // namespace multihash_avx2
+#endif
+
+/** The stages of the chains that have multi-lane kernels. */
+struct Kernels
+{
+    void (*Blake512_80)(const unsigned char* const in[MULTIHASH_LANES], unsigned char (*out)[64]);
+    void (*Bmw512_64)(unsigned char (*data)[64]);
+    void (*Skein512_64)(unsigned char (*data)[64]);
+    void (*Keccak512_64)(unsigned char (*data)[64]);
+};
+
+#define MULTIHASH_KERNELS(ns) {ns::Blake512_80, ns::Bmw512_64, ns::Skein512_64, ns::Keccak512_64}
+
+const Kernels SCALAR_KERNELS = MULTIHASH_KERNELS(multihash_scalar);
+#if defined(HAVE_MULTIHASH_VECTOR)
+const Kernels VECTOR_KERNELS = MULTIHASH_KERNELS(multihash_vector);
+#endif
+#if defined(HAVE_MULTIHASH_AVX2)
+const Kernels AVX2_KERNELS = MULTIHASH_KERNELS(multihash_avx2);
+#endif
+
+#undef MULTIHASH_KERNELS
+
+/** Run the vectorised prefix of the chains through tr and through the sph reference. */
+bool SelfTest(const Kernels& tr)
+{
+    unsigned char in[MULTIHASH_LANES][80];
+    const unsigned char* lanes[MULTIHASH_LANES];
+    for (size_t j = 0; j < MULTIHASH_LANES; j++) {
+        for (size_t i = 0; i < 80; i++) {
+            in[j][i] = (unsigned char)(i * 7 + j * 101 + 1);
+        }
+        lanes[j] = in[j];
+    }
+
+    unsigned char expected[MULTIHASH_LANES][64], hash[MULTIHASH_LANES][64];
+    SCALAR_KERNELS.Blake512_80(lanes, expected);
+    tr.Blake512_80(lanes, hash);
+    if (memcmp(hash, expected, sizeof(hash))) return false;
+    SCALAR_KERNELS.Bmw512_64(expected);
+    tr.Bmw512_64(hash);
+    if (memcmp(hash, expected, sizeof(hash))) return false;
+    SCALAR_KERNELS.Skein512_64(expected);
+    tr.Skein512_64(hash);
+    if (memcmp(hash, expected, sizeof(hash))) return false;
+    SCALAR_KERNELS.Keccak512_64(expected);
+    tr.Keccak512_64(hash);
+    if (memcmp(hash, expected, sizeof(hash))) return false;
+    return true;
+}
+
+#if defined(HAVE_MULTIHASH_VECTOR)
+const Kernels* kernels = &VECTOR_KERNELS;
+#else
+const Kernels* kernels = &SCALAR_KERNELS;
+#endif
+
+/** One 64-byte chain stage through its sph implementation; in and out may alias. */
+typedef void (*StageFunc)(const unsigned char* in, unsigned char* out);
+
+template<typename Context, void (*Init)(void*), void (*Update)(void*, const void*, size_t), void (*Close)(void*, void*)>
+void Stage(const unsigned char* in, unsigned char* out)
+{
+    Context ctx;
+    Init(&ctx);
+    Update(&ctx, in, 64);
+    Close(&ctx, out);
+}
+
+constexpr StageFunc Groestl512 = Stage<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>;
+constexpr StageFunc Jh512 = Stage<sph_jh512_context, sph_jh512_init, sph_jh512, sph_jh512_close>;
+constexpr StageFunc Luffa512 = Stage<sph_luffa512_context, sph_luffa512_init, sph_luffa512, sph_luffa512_close>;
+constexpr StageFunc CubeHash512 = Stage<sph_cubehash512_context, sph_cubehash512_init, sph_cubehash512, sph_cubehash512_close>;
+constexpr StageFunc Shavite512 = Stage<sph_shavite512_context, sph_shavite512_init, sph_shavite512, sph_shavite512_close>;
+constexpr StageFunc Simd512 = Stage<sph_simd512_context, sph_simd512_init, sph_simd512, sph_simd512_close>;
+constexpr StageFunc Echo512 = Stage<sph_echo512_context, sph_echo512_init, sph_echo512, sph_echo512_close>;
+constexpr StageFunc Hamsi512 = Stage<sph_hamsi512_context, sph_hamsi512_init, sph_hamsi512, sph_hamsi512_close>;
+constexpr StageFunc Fugue512 = Stage<sph_fugue512_context, sph_fugue512_init, sph_fugue512, sph_fugue512_close>;
+constexpr StageFunc Shabal512 = Stage<sph_shabal512_context, sph_shabal512_init, sph_shabal512, sph_shabal512_close>;
+constexpr StageFunc Whirlpool = Stage<sph_whirlpool_context, sph_whirlpool_init, sph_whirlpool, sph_whirlpool_close>;
+constexpr StageFunc Sha512 = Stage<sph_sha512_context, sph_sha512_init, sph_sha512, sph_sha512_close>;
+// HAVAL-256/5 only writes the low 32 bytes, which is all the result keeps.
+constexpr StageFunc Haval256_5 = Stage<sph_haval256_5_context, sph_haval256_5_init, sph_haval256_5, sph_haval256_5_close>;
+
+/** The stages after keccak, per chain, as in multihash.h. */
+const StageFunc X11_TAIL[] = {Luffa512, CubeHash512, Shavite512, Simd512, Echo512};
+const StageFunc X13_TAIL[] = {Luffa512, CubeHash512, Shavite512, Simd512, Echo512, Hamsi512, Fugue512};
+const StageFunc X14_TAIL[] = {Luffa512, CubeHash512, Shavite512, Simd512, Echo512, Hamsi512, Fugue512, Shabal512};
+const StageFunc X15_TAIL[] = {Luffa512, CubeHash512, Shavite512, Simd512, Echo512, Hamsi512, Fugue512, Shabal512, Whirlpool};
+const StageFunc X17_TAIL[] = {Luffa512, CubeHash512, Shavite512, Simd512, Echo512, Hamsi512, Fugue512, Shabal512, Whirlpool,
+    Sha512, Haval256_5};
+
+/**
+ * Every X-family chain starts blake, bmw, groestl, skein, jh, keccak and then
+ * diverges. Run that shared prefix across the lanes, with groestl and jh per
+ * lane, and finish each lane through its own tail.
+ */
+void HashXBatch(const unsigned char* const in[], uint256 out[], size_t n, const StageFunc* tail, size_t tail_len)
+{
+    alignas(32) unsigned char hash[MULTIHASH_LANES][64];
+    const unsigned char* lanes[MULTIHASH_LANES];
+    for (size_t i = 0; i < n; i += MULTIHASH_LANES) {
+        const size_t used = std::min(n - i, MULTIHASH_LANES);
+        // A short final batch repeats its last header in the spare lanes.
+        for (size_t j = 0; j < MULTIHASH_LANES; j++) {
+            lanes[j] = in[i + std::min(j, used - 1)];
+        }
+        kernels->Blake512_80(lanes, hash);
+        kernels->Bmw512_64(hash);
+        for (size_t j = 0; j < used; j++) {
+            Groestl512(hash[j], hash[j]);
+        }
+        kernels->Skein512_64(hash);
+        for (size_t j = 0; j < used; j++) {
+            Jh512(hash[j], hash[j]);
+        }
+        kernels->Keccak512_64(hash);
+        for (size_t j = 0; j < used; j++) {
+            for (size_t k = 0; k < tail_len; k++) {
+                tail[k](hash[j], hash[j]);
+            }
+            memcpy(out[i + j].begin(), hash[j], 32);
+        }
+    }
+}
+
+} // namespace
+
+std::string MultihashAutoDetect()
+{
+#if defined(HAVE_MULTIHASH_AVX2)
+    uint32_t eax, ebx, ecx, edx;
+    // AVX2 needs the CPU flag and an OS that saves the ymm registers.
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx >> 27) & 1) {
+        uint32_t xcr0_lo, xcr0_hi;
+        __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        if ((xcr0_lo & 6) == 6 && __get_cpuid_max(0, nullptr) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            if ((ebx >> 5) & 1) {
+                kernels = &AVX2_KERNELS;
+                assert(SelfTest(*kernels));
+                return "avx2";
+            }
+        }
+    }
+#endif
+
+#if defined(HAVE_MULTIHASH_VECTOR)
+    kernels = &VECTOR_KERNELS;
+    assert(SelfTest(*kernels));
+#if defined(__x86_64__) || defined(__amd64__)
+    return "sse2";
+#else
+    return "vector";
+#endif
+#else
+    kernels = &SCALAR_KERNELS;
+    assert(SelfTest(*kernels));
+    return "standard";
+#endif
+}
+
+void HashX11Batch(const unsigned char* const in[], uint256 out[], size_t n)
+{
+    HashXBatch(in, out, n, X11_TAIL, sizeof(X11_TAIL) / sizeof(X11_TAIL[0]));
+}
+
+void HashX13Batch(const unsigned char* const in[], uint256 out[], size_t n)
+{
+    HashXBatch(in, out, n, X13_TAIL, sizeof(X13_TAIL) / sizeof(X13_TAIL[0]));
+}
+
+void HashX14Batch(const unsigned char* const in[], uint256 out[], size_t n)
+{
+    HashXBatch(in, out, n, X14_TAIL, sizeof(X14_TAIL) / sizeof(X14_TAIL[0]));
+}
+
+void HashX15Batch(const unsigned char* const in[], uint256 out[], size_t n)
+{
+    HashXBatch(in, out, n, X15_TAIL, sizeof(X15_TAIL) / sizeof(X15_TAIL[0]));
+}
+
+void HashX17Batch(const unsigned char* const in[], uint256 out[], size_t n)
+{
+    HashXBatch(in, out, n, X17_TAIL, sizeof(X17_TAIL) / sizeof(X17_TAIL[0]));
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HUNTCOIN_CRYPTO_ALGOS_HASHLIB_MULTIHASH_BATCH_H
+#define HUNTCOIN_CRYPTO_ALGOS_HASHLIB_MULTIHASH_BATCH_H
+
+#include <uint256.h>
+
+#include <stddef.h>
+#include <string>
+
+/** Number of headers the multi-lane kernels hash side by side. */
+static const size_t MULTIHASH_LANES = 4;
+
+/** Autodetect the best available multi-lane kernels for the batch hashes
+ *  below. Returns the name of the implementation.
+ */
+std::string MultihashAutoDetect();
+
+/** Batch versions of the X-family chains in multihash.h for 80-byte block
+ *  headers: out[i] is bit for bit the scalar chain applied to in[i]. The
+ *  BLAKE, BMW, Skein and Keccak stages run MULTIHASH_LANES headers at a time;
+ *  any n is accepted, but multiples of MULTIHASH_LANES waste no lanes.
+ */
+void HashX11Batch(const unsigned char* const in[], uint256 out[], size_t n);
+void HashX13Batch(const unsigned char* const in[], uint256 out[], size_t n);
+void HashX14Batch(const unsigned char* const in[], uint256 out[], size_t n);
+void HashX15Batch(const unsigned char* const in[], uint256 out[], size_t n);
+void HashX17Batch(const unsigned char* const in[], uint256 out[], size_t n);
+
+#endif // HUNTCOIN_CRYPTO_ALGOS_HASHLIB_MULTIHASH_BATCH_H
@@ -0,0 +1,435 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Multi-lane kernels for the fixed-length stages of the X-family chains.
+//
+// This file has no include guard on purpose: multihash_batch.cpp includes it
+// once per instruction set, inside a namespace and with MULTIHASH_TARGET set
+// to the matching function attribute. Every kernel processes
+// MULTIHASH_LANES independent messages, one per element of a GCC vector, and
+// reproduces the sph_* reference implementation for exactly the input length
+// it is named after (80-byte header or 64-byte chain state), so the padding
+// and length encoding are folded into constants.
+//
+// Helpers take vectors by pointer, so no vector ever crosses a call boundary
+// by value in the baseline build.
+
+typedef uint64_t lanes_t __attribute__((vector_size(8 * MULTIHASH_LANES)));
+
+#define LANES_SET1(c) (lanes_t{} + (uint64_t)(c))
+#define LANES_ROTL(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+#define LANES_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static inline MULTIHASH_TARGET void LoadLE(lanes_t* w, unsigned char (*data)[64])
+{
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < (int)MULTIHASH_LANES; j++) {
+            w[i][j] = ReadLE64(data[j] + 8 * i);
+        }
+    }
+}
+
+static inline MULTIHASH_TARGET void StoreLE(unsigned char (*data)[64], const lanes_t* w)
+{
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < (int)MULTIHASH_LANES; j++) {
+            WriteLE64(data[j] + 8 * i, w[i][j]);
+        }
+    }
+}
+
+////// BLAKE-512
+
+static const uint64_t BLAKE512_IV[8] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+static const uint64_t BLAKE512_C[16] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL
+};
+
+static const unsigned char BLAKE512_SIGMA[10][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+};
+
+#define BLAKE512_G(s, i, a, b, c, d) do { \
+        a = a + b + (m[s[2 * i]] ^ BLAKE512_C[s[2 * i + 1]]); \
+        d = LANES_ROTR(d ^ a, 32); \
+        c = c + d; \
+        b = LANES_ROTR(b ^ c, 25); \
+        a = a + b + (m[s[2 * i + 1]] ^ BLAKE512_C[s[2 * i]]); \
+        d = LANES_ROTR(d ^ a, 16); \
+        c = c + d; \
+        b = LANES_ROTR(b ^ c, 11); \
+    } while (0)
+
+/** BLAKE-512 of an 80-byte message: a single, final compression. */
+MULTIHASH_TARGET void Blake512_80(const unsigned char* const in[MULTIHASH_LANES], unsigned char (*out)[64])
+{
+    lanes_t m[16], v[16];
+    for (int i = 0; i < 10; i++) {
+        for (int j = 0; j < (int)MULTIHASH_LANES; j++) {
+            m[i][j] = ReadBE64(in[j] + 8 * i);
+        }
+    }
+    // Padding bit, the "digest is 512 bits" marker and the 640-bit length.
+    m[10] = LANES_SET1(0x8000000000000000ULL);
+    m[11] = LANES_SET1(0);
+    m[12] = LANES_SET1(0);
+    m[13] = LANES_SET1(1);
+    m[14] = LANES_SET1(0);
+    m[15] = LANES_SET1(640);
+
+    for (int i = 0; i < 8; i++) {
+        v[i] = LANES_SET1(BLAKE512_IV[i]);
+        v[i + 8] = LANES_SET1(BLAKE512_C[i]);
+    }
+    // Counter is 640 bits in the low word, zero in the high word.
+    v[12] ^= 640;
+    v[13] ^= 640;
+
+    for (int r = 0; r < 16; r++) {
+        const unsigned char* s = BLAKE512_SIGMA[r % 10];
+        BLAKE512_G(s, 0, v[0], v[4], v[8], v[12]);
+        BLAKE512_G(s, 1, v[1], v[5], v[9], v[13]);
+        BLAKE512_G(s, 2, v[2], v[6], v[10], v[14]);
+        BLAKE512_G(s, 3, v[3], v[7], v[11], v[15]);
+        BLAKE512_G(s, 4, v[0], v[5], v[10], v[15]);
+        BLAKE512_G(s, 5, v[1], v[6], v[11], v[12]);
+        BLAKE512_G(s, 6, v[2], v[7], v[8], v[13]);
+        BLAKE512_G(s, 7, v[3], v[4], v[9], v[14]);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        const lanes_t h = v[i] ^ v[i + 8] ^ BLAKE512_IV[i];
+        for (int j = 0; j < (int)MULTIHASH_LANES; j++) {
+            WriteBE64(out[j] + 8 * i, h[j]);
+        }
+    }
+}
+
+#undef BLAKE512_G
+
+////// BMW-512
+
+static const uint64_t BMW512_IV[16] = {
+    0x8081828384858687ULL, 0x88898A8B8C8D8E8FULL, 0x9091929394959697ULL, 0x98999A9B9C9D9E9FULL,
+    0xA0A1A2A3A4A5A6A7ULL, 0xA8A9AAABACADAEAFULL, 0xB0B1B2B3B4B5B6B7ULL, 0xB8B9BABBBCBDBEBFULL,
+    0xC0C1C2C3C4C5C6C7ULL, 0xC8C9CACBCCCDCECFULL, 0xD0D1D2D3D4D5D6D7ULL, 0xD8D9DADBDCDDDEDFULL,
+    0xE0E1E2E3E4E5E6E7ULL, 0xE8E9EAEBECEDEEEFULL, 0xF0F1F2F3F4F5F6F7ULL, 0xF8F9FAFBFCFDFEFFULL
+};
+
+static const uint64_t BMW512_FINAL[16] = {
+    0xaaaaaaaaaaaaaaa0ULL, 0xaaaaaaaaaaaaaaa1ULL, 0xaaaaaaaaaaaaaaa2ULL, 0xaaaaaaaaaaaaaaa3ULL,
+    0xaaaaaaaaaaaaaaa4ULL, 0xaaaaaaaaaaaaaaa5ULL, 0xaaaaaaaaaaaaaaa6ULL, 0xaaaaaaaaaaaaaaa7ULL,
+    0xaaaaaaaaaaaaaaa8ULL, 0xaaaaaaaaaaaaaaa9ULL, 0xaaaaaaaaaaaaaaaaULL, 0xaaaaaaaaaaaaaaabULL,
+    0xaaaaaaaaaaaaaaacULL, 0xaaaaaaaaaaaaaaadULL, 0xaaaaaaaaaaaaaaaeULL, 0xaaaaaaaaaaaaaaafULL
+};
+
+#define BMW_S0(x) (((x) >> 1) ^ ((x) << 3) ^ LANES_ROTL(x, 4) ^ LANES_ROTL(x, 37))
+#define BMW_S1(x) (((x) >> 1) ^ ((x) << 2) ^ LANES_ROTL(x, 13) ^ LANES_ROTL(x, 43))
+#define BMW_S2(x) (((x) >> 2) ^ ((x) << 1) ^ LANES_ROTL(x, 19) ^ LANES_ROTL(x, 53))
+#define BMW_S3(x) (((x) >> 2) ^ ((x) << 2) ^ LANES_ROTL(x, 28) ^ LANES_ROTL(x, 59))
+#define BMW_S4(x) (((x) >> 1) ^ (x))
+#define BMW_S5(x) (((x) >> 2) ^ (x))
+
+/** One BMW-512 compression of message m under chaining value h into dh. */
+static inline MULTIHASH_TARGET void Bmw512Compress(const lanes_t* m, const lanes_t* h, lanes_t* dh)
+{
+    lanes_t x[16], w[16], q[32];
+    for (int i = 0; i < 16; i++) {
+        x[i] = m[i] ^ h[i];
+    }
+    w[0] = x[5] - x[7] + x[10] + x[13] + x[14];
+    w[1] = x[6] - x[8] + x[11] + x[14] - x[15];
+    w[2] = x[0] + x[7] + x[9] - x[12] + x[15];
+    w[3] = x[0] - x[1] + x[8] - x[10] + x[13];
+    w[4] = x[1] + x[2] + x[9] - x[11] - x[14];
+    w[5] = x[3] - x[2] + x[10] - x[12] + x[15];
+    w[6] = x[4] - x[0] - x[3] - x[11] + x[13];
+    w[7] = x[1] - x[4] - x[5] - x[12] - x[14];
+    w[8] = x[2] - x[5] - x[6] + x[13] - x[15];
+    w[9] = x[0] - x[3] + x[6] - x[7] + x[14];
+    w[10] = x[8] - x[1] - x[4] - x[7] + x[15];
+    w[11] = x[8] - x[0] - x[2] - x[5] + x[9];
+    w[12] = x[1] + x[3] - x[6] - x[9] + x[10];
+    w[13] = x[2] + x[4] + x[7] + x[10] + x[11];
+    w[14] = x[3] - x[5] + x[8] - x[11] - x[12];
+    w[15] = x[12] - x[4] - x[6] - x[9] + x[13];
+    for (int i = 0; i < 16; i++) {
+        switch (i % 5) {
+        case 0: q[i] = BMW_S0(w[i]); break;
+        case 1: q[i] = BMW_S1(w[i]); break;
+        case 2: q[i] = BMW_S2(w[i]); break;
+        case 3: q[i] = BMW_S3(w[i]); break;
+        default: q[i] = BMW_S4(w[i]); break;
+        }
+        q[i] += h[(i + 1) & 15];
+    }
+
+    for (int i = 16; i < 32; i++) {
+        const int j = i - 16;
+        lanes_t e = LANES_ROTL(m[j & 15], (j & 15) + 1) + LANES_ROTL(m[(j + 3) & 15], ((j + 3) & 15) + 1) -
+            LANES_ROTL(m[(j + 10) & 15], ((j + 10) & 15) + 1);
+        e = (e + (uint64_t)i * 0x0555555555555555ULL) ^ h[(j + 7) & 15];
+        if (i < 18) {
+            for (int k = 0; k < 16; k += 4) {
+                e += BMW_S1(q[j + k]) + BMW_S2(q[j + k + 1]) + BMW_S3(q[j + k + 2]) + BMW_S0(q[j + k + 3]);
+            }
+        } else {
+            e += q[j] + LANES_ROTL(q[j + 1], 5) + q[j + 2] + LANES_ROTL(q[j + 3], 11) +
+                q[j + 4] + LANES_ROTL(q[j + 5], 27) + q[j + 6] + LANES_ROTL(q[j + 7], 32) +
+                q[j + 8] + LANES_ROTL(q[j + 9], 37) + q[j + 10] + LANES_ROTL(q[j + 11], 43) +
+                q[j + 12] + LANES_ROTL(q[j + 13], 53) + BMW_S4(q[j + 14]) + BMW_S5(q[j + 15]);
+        }
+        q[i] = e;
+    }
+
+    const lanes_t xl = q[16] ^ q[17] ^ q[18] ^ q[19] ^ q[20] ^ q[21] ^ q[22] ^ q[23];
+    const lanes_t xh = xl ^ q[24] ^ q[25] ^ q[26] ^ q[27] ^ q[28] ^ q[29] ^ q[30] ^ q[31];
+    dh[0] = ((xh << 5) ^ (q[16] >> 5) ^ m[0]) + (xl ^ q[24] ^ q[0]);
+    dh[1] = ((xh >> 7) ^ (q[17] << 8) ^ m[1]) + (xl ^ q[25] ^ q[1]);
+    dh[2] = ((xh >> 5) ^ (q[18] << 5) ^ m[2]) + (xl ^ q[26] ^ q[2]);
+    dh[3] = ((xh >> 1) ^ (q[19] << 5) ^ m[3]) + (xl ^ q[27] ^ q[3]);
+    dh[4] = ((xh >> 3) ^ q[20] ^ m[4]) + (xl ^ q[28] ^ q[4]);
+    dh[5] = ((xh << 6) ^ (q[21] >> 6) ^ m[5]) + (xl ^ q[29] ^ q[5]);
+    dh[6] = ((xh >> 4) ^ (q[22] << 6) ^ m[6]) + (xl ^ q[30] ^ q[6]);
+    dh[7] = ((xh >> 11) ^ (q[23] << 2) ^ m[7]) + (xl ^ q[31] ^ q[7]);
+    dh[8] = LANES_ROTL(dh[4], 9) + (xh ^ q[24] ^ m[8]) + ((xl << 8) ^ q[23] ^ q[8]);
+    dh[9] = LANES_ROTL(dh[5], 10) + (xh ^ q[25] ^ m[9]) + ((xl >> 6) ^ q[16] ^ q[9]);
+    dh[10] = LANES_ROTL(dh[6], 11) + (xh ^ q[26] ^ m[10]) + ((xl << 6) ^ q[17] ^ q[10]);
+    dh[11] = LANES_ROTL(dh[7], 12) + (xh ^ q[27] ^ m[11]) + ((xl << 4) ^ q[18] ^ q[11]);
+    dh[12] = LANES_ROTL(dh[0], 13) + (xh ^ q[28] ^ m[12]) + ((xl >> 3) ^ q[19] ^ q[12]);
+    dh[13] = LANES_ROTL(dh[1], 14) + (xh ^ q[29] ^ m[13]) + ((xl >> 4) ^ q[20] ^ q[13]);
+    dh[14] = LANES_ROTL(dh[2], 15) + (xh ^ q[30] ^ m[14]) + ((xl >> 7) ^ q[21] ^ q[14]);
+    dh[15] = LANES_ROTL(dh[3], 16) + (xh ^ q[31] ^ m[15]) + ((xl >> 2) ^ q[22] ^ q[15]);
+}
+
+#undef BMW_S0
+#undef BMW_S1
+#undef BMW_S2
+#undef BMW_S3
+#undef BMW_S4
+#undef BMW_S5
+
+/** BMW-512 of a 64-byte message, in place: one padded block plus the final compression. */
+MULTIHASH_TARGET void Bmw512_64(unsigned char (*data)[64])
+{
+    lanes_t m[16], h[16], h2[16];
+    LoadLE(m, data);
+    m[8] = LANES_SET1(0x80);
+    for (int i = 9; i < 15; i++) {
+        m[i] = LANES_SET1(0);
+    }
+    m[15] = LANES_SET1(512);
+    for (int i = 0; i < 16; i++) {
+        h[i] = LANES_SET1(BMW512_IV[i]);
+    }
+    Bmw512Compress(m, h, h2);
+    for (int i = 0; i < 16; i++) {
+        h[i] = LANES_SET1(BMW512_FINAL[i]);
+    }
+    Bmw512Compress(h2, h, m);
+    StoreLE(data, m + 8);
+}
+
+////// Skein-512
+
+static const uint64_t SKEIN512_IV[8] = {
+    0x4903ADFF749C51CEULL, 0x0D95DE399746DF03ULL, 0x8FD1934127C79BCEULL, 0x9A255629FF352CB1ULL,
+    0x5DB62599DF6CA7B0ULL, 0xEABE394CA9D5C3F4ULL, 0x991112C71A75B523ULL, 0xAE18A40B660FCC33ULL
+};
+
+#define SKEIN_MIX(x0, x1, rc) do { \
+        x0 = x0 + x1; \
+        x1 = LANES_ROTL(x1, rc) ^ x0; \
+    } while (0)
+
+#define SKEIN_MIX8(w0, w1, w2, w3, w4, w5, w6, w7, rc0, rc1, rc2, rc3) do { \
+        SKEIN_MIX(w0, w1, rc0); \
+        SKEIN_MIX(w2, w3, rc1); \
+        SKEIN_MIX(w4, w5, rc2); \
+        SKEIN_MIX(w6, w7, rc3); \
+    } while (0)
+
+#define SKEIN_ADDKEY(s) do { \
+        p[0] += k[((s) + 0) % 9]; \
+        p[1] += k[((s) + 1) % 9]; \
+        p[2] += k[((s) + 2) % 9]; \
+        p[3] += k[((s) + 3) % 9]; \
+        p[4] += k[((s) + 4) % 9]; \
+        p[5] += k[((s) + 5) % 9] + t[(s) % 3]; \
+        p[6] += k[((s) + 6) % 9] + t[((s) + 1) % 3]; \
+        p[7] += k[((s) + 7) % 9] + (uint64_t)(s); \
+    } while (0)
+
+// Eight rounds with the subkeys s and s + 1, as TFBIG_4e/TFBIG_4o in skein.c.
+#define SKEIN_8ROUNDS(s) do { \
+        SKEIN_ADDKEY(s); \
+        SKEIN_MIX8(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], 46, 36, 19, 37); \
+        SKEIN_MIX8(p[2], p[1], p[4], p[7], p[6], p[5], p[0], p[3], 33, 27, 14, 42); \
+        SKEIN_MIX8(p[4], p[1], p[6], p[3], p[0], p[5], p[2], p[7], 17, 49, 36, 39); \
+        SKEIN_MIX8(p[6], p[1], p[0], p[7], p[2], p[5], p[4], p[3], 44, 9, 54, 56); \
+        SKEIN_ADDKEY((s) + 1); \
+        SKEIN_MIX8(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], 39, 30, 34, 24); \
+        SKEIN_MIX8(p[2], p[1], p[4], p[7], p[6], p[5], p[0], p[3], 13, 50, 10, 17); \
+        SKEIN_MIX8(p[4], p[1], p[6], p[3], p[0], p[5], p[2], p[7], 25, 29, 39, 43); \
+        SKEIN_MIX8(p[6], p[1], p[0], p[7], p[2], p[5], p[4], p[3], 8, 35, 56, 22); \
+    } while (0)
+
+/** Threefish-512 encryption of m under key h and tweak (t0, t1), UBI style: returns p ^ m in h. */
+static inline MULTIHASH_TARGET void Skein512Ubi(lanes_t* h, const lanes_t* m, uint64_t t0, uint64_t t1)
+{
+    lanes_t k[9], p[8];
+    const uint64_t t[3] = {t0, t1, t0 ^ t1};
+    k[8] = LANES_SET1(0x1BD11BDAA9FC1A22ULL);
+    for (int i = 0; i < 8; i++) {
+        k[i] = h[i];
+        k[8] ^= h[i];
+        p[i] = m[i];
+    }
+    SKEIN_8ROUNDS(0);
+    SKEIN_8ROUNDS(2);
+    SKEIN_8ROUNDS(4);
+    SKEIN_8ROUNDS(6);
+    SKEIN_8ROUNDS(8);
+    SKEIN_8ROUNDS(10);
+    SKEIN_8ROUNDS(12);
+    SKEIN_8ROUNDS(14);
+    SKEIN_8ROUNDS(16);
+    SKEIN_ADDKEY(18);
+    for (int i = 0; i < 8; i++) {
+        h[i] = m[i] ^ p[i];
+    }
+}
+
+#undef SKEIN_MIX
+#undef SKEIN_MIX8
+#undef SKEIN_ADDKEY
+#undef SKEIN_8ROUNDS
+
+/** Skein-512-512 of a 64-byte message, in place: message block, then output block. */
+MULTIHASH_TARGET void Skein512_64(unsigned char (*data)[64])
+{
+    lanes_t h[8], m[8];
+    LoadLE(m, data);
+    for (int i = 0; i < 8; i++) {
+        h[i] = LANES_SET1(SKEIN512_IV[i]);
+    }
+    // First and final message block of 64 bytes.
+    Skein512Ubi(h, m, 64, 480ULL << 55);
+    for (int i = 0; i < 8; i++) {
+        m[i] = LANES_SET1(0);
+    }
+    // Output block: counter 0 encoded on 8 bytes.
+    Skein512Ubi(h, m, 8, 510ULL << 55);
+    StoreLE(data, h);
+}
+
+////// Keccak-512
+
+static const uint64_t KECCAK_RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/** Keccak-512 (original padding, as sph_keccak512) of a 64-byte message, in place. */
+MULTIHASH_TARGET void Keccak512_64(unsigned char (*data)[64])
+{
+    lanes_t a[25], b[25], c[5], d[5];
+    LoadLE(a, data);
+    // Pad byte 0x01 right after the message, 0x80 in the last byte of the 72-byte rate.
+    a[8] = LANES_SET1(0x8000000000000001ULL);
+    for (int i = 9; i < 25; i++) {
+        a[i] = LANES_SET1(0);
+    }
+
+    // Theta, rho and pi fused, then chi, with every lane index a constant
+    // so the state stays in registers.
+    for (int r = 0; r < 24; r++) {
+        c[0] = a[0] ^ a[5] ^ a[10] ^ a[15] ^ a[20];
+        c[1] = a[1] ^ a[6] ^ a[11] ^ a[16] ^ a[21];
+        c[2] = a[2] ^ a[7] ^ a[12] ^ a[17] ^ a[22];
+        c[3] = a[3] ^ a[8] ^ a[13] ^ a[18] ^ a[23];
+        c[4] = a[4] ^ a[9] ^ a[14] ^ a[19] ^ a[24];
+        d[0] = c[4] ^ LANES_ROTL(c[1], 1);
+        d[1] = c[0] ^ LANES_ROTL(c[2], 1);
+        d[2] = c[1] ^ LANES_ROTL(c[3], 1);
+        d[3] = c[2] ^ LANES_ROTL(c[4], 1);
+        d[4] = c[3] ^ LANES_ROTL(c[0], 1);
+        b[0] = a[0] ^ d[0];
+        b[10] = LANES_ROTL(a[1] ^ d[1], 1);
+        b[20] = LANES_ROTL(a[2] ^ d[2], 62);
+        b[5] = LANES_ROTL(a[3] ^ d[3], 28);
+        b[15] = LANES_ROTL(a[4] ^ d[4], 27);
+        b[16] = LANES_ROTL(a[5] ^ d[0], 36);
+        b[1] = LANES_ROTL(a[6] ^ d[1], 44);
+        b[11] = LANES_ROTL(a[7] ^ d[2], 6);
+        b[21] = LANES_ROTL(a[8] ^ d[3], 55);
+        b[6] = LANES_ROTL(a[9] ^ d[4], 20);
+        b[7] = LANES_ROTL(a[10] ^ d[0], 3);
+        b[17] = LANES_ROTL(a[11] ^ d[1], 10);
+        b[2] = LANES_ROTL(a[12] ^ d[2], 43);
+        b[12] = LANES_ROTL(a[13] ^ d[3], 25);
+        b[22] = LANES_ROTL(a[14] ^ d[4], 39);
+        b[23] = LANES_ROTL(a[15] ^ d[0], 41);
+        b[8] = LANES_ROTL(a[16] ^ d[1], 45);
+        b[18] = LANES_ROTL(a[17] ^ d[2], 15);
+        b[3] = LANES_ROTL(a[18] ^ d[3], 21);
+        b[13] = LANES_ROTL(a[19] ^ d[4], 8);
+        b[14] = LANES_ROTL(a[20] ^ d[0], 18);
+        b[24] = LANES_ROTL(a[21] ^ d[1], 2);
+        b[9] = LANES_ROTL(a[22] ^ d[2], 61);
+        b[19] = LANES_ROTL(a[23] ^ d[3], 56);
+        b[4] = LANES_ROTL(a[24] ^ d[4], 14);
+        a[0] = b[0] ^ (~b[1] & b[2]);
+        a[1] = b[1] ^ (~b[2] & b[3]);
+        a[2] = b[2] ^ (~b[3] & b[4]);
+        a[3] = b[3] ^ (~b[4] & b[0]);
+        a[4] = b[4] ^ (~b[0] & b[1]);
+        a[5] = b[5] ^ (~b[6] & b[7]);
+        a[6] = b[6] ^ (~b[7] & b[8]);
+        a[7] = b[7] ^ (~b[8] & b[9]);
+        a[8] = b[8] ^ (~b[9] & b[5]);
+        a[9] = b[9] ^ (~b[5] & b[6]);
+        a[10] = b[10] ^ (~b[11] & b[12]);
+        a[11] = b[11] ^ (~b[12] & b[13]);
+        a[12] = b[12] ^ (~b[13] & b[14]);
+        a[13] = b[13] ^ (~b[14] & b[10]);
+        a[14] = b[14] ^ (~b[10] & b[11]);
+        a[15] = b[15] ^ (~b[16] & b[17]);
+        a[16] = b[16] ^ (~b[17] & b[18]);
+        a[17] = b[17] ^ (~b[18] & b[19]);
+        a[18] = b[18] ^ (~b[19] & b[15]);
+        a[19] = b[19] ^ (~b[15] & b[16]);
+        a[20] = b[20] ^ (~b[21] & b[22]);
+        a[21] = b[21] ^ (~b[22] & b[23]);
+        a[22] = b[22] ^ (~b[23] & b[24]);
+        a[23] = b[23] ^ (~b[24] & b[20]);
+        a[24] = b[24] ^ (~b[20] & b[21]);
+        a[0] ^= KECCAK_RC[r];
+    }
+    StoreLE(data, a);
+}
+
+#undef LANES_SET1
+#undef LANES_ROTL
+#undef LANES_ROTR
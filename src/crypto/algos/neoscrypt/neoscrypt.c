@@ -33,6 +33,7 @@
 #include <string.h>
 
 #include "neoscrypt.h"
+#include "../scratch.h"
 
 
 #ifdef SHA256
@@ -2579,7 +2580,6 @@ static void neoscrypt_blkmix(uint *X, uint *Y, uint r, uint mixmode) {
  *     11110 = N of 2147483648;
  *   profile bits 30 to 13 are reserved */
 void neoscrypt(const uchar *password, uchar *output, uint profile) {
-    const size_t stack_align = 0x40;
     uint N = 128, r = 2, dblmix = 1, mixmode = 0x14;
     uint kdf, i, j;
     uint *X, *Y, *Z, *V;
@@ -2596,9 +2596,15 @@ void neoscrypt(const uchar *password, uchar *output, uint profile) {
         r = (1 << ((profile >> 5) & 0x7));
     }
 
-    uchar stack[(N + 3) * r * 2 * BLOCK_SIZE + stack_align];
+    /* The working memory comes from the per-thread scratch buffer, already 64 byte aligned */
+    uchar *scratch = (uchar *) pow_scratch(POW_SCRATCH_NEOSCRYPT, (N + 3) * r * 2 * BLOCK_SIZE);
+    if(scratch == NULL) {
+        /* An all ones hash never meets a target */
+        memset(output, 0xFF, 32);
+        return;
+    }
     /* X = r * 2 * BLOCK_SIZE */
-    X = (uint *) (((size_t)stack & ~(stack_align - 1)) + stack_align);
+    X = (uint *) scratch;
     /* Z is a copy of X for ChaCha */
     Z = &X[32 * r];
     /* Y is an X sized temporal space */
@@ -0,0 +1,76 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "scratch.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct pow_scratch_region {
+    void *base;
+    void *aligned;
+    size_t size;
+};
+
+/* The regions of a thread are freed by the key destructor when the thread
+ * exits, miner threads come and go with the templates they work on. */
+static pthread_key_t regions_key;
+static pthread_once_t regions_once = PTHREAD_ONCE_INIT;
+static int regions_key_valid;
+
+static void regions_free(void *p)
+{
+    struct pow_scratch_region *regions = p;
+    int slot;
+    for (slot = 0; slot < POW_SCRATCH_SLOTS; slot++)
+        free(regions[slot].base);
+    free(regions);
+}
+
+static void regions_key_create(void)
+{
+    regions_key_valid = pthread_key_create(&regions_key, regions_free) == 0;
+}
+
+static struct pow_scratch_region *thread_regions(void)
+{
+    struct pow_scratch_region *regions;
+
+    pthread_once(&regions_once, regions_key_create);
+    if (!regions_key_valid)
+        return NULL;
+    regions = pthread_getspecific(regions_key);
+    if (regions == NULL) {
+        if ((regions = calloc(POW_SCRATCH_SLOTS, sizeof(*regions))) == NULL)
+            return NULL;
+        if (pthread_setspecific(regions_key, regions) != 0) {
+            free(regions);
+            return NULL;
+        }
+    }
+    return regions;
+}
+
+void *pow_scratch(enum pow_scratch_slot slot, size_t size)
+{
+    struct pow_scratch_region *regions = thread_regions();
+    struct pow_scratch_region *region;
+    if (regions == NULL)
+        return NULL;
+    region = &regions[slot];
+    if (region->size >= size)
+        return region->aligned;
+
+    free(region->base);
+    region->base = region->aligned = NULL;
+    region->size = 0;
+    if (size + 63 < size)
+        return NULL;
+    if ((region->base = malloc(size + 63)) == NULL)
+        return NULL;
+    region->aligned = (void *)(((uintptr_t)region->base + 63) & ~(uintptr_t)63);
+    region->size = size;
+    return region->aligned;
+}
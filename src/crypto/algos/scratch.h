@@ -0,0 +1,35 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HUNTCOIN_CRYPTO_ALGOS_SCRATCH_H
+#define HUNTCOIN_CRYPTO_ALGOS_SCRATCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Users of the per-thread scratch memory, each one gets its own buffer. */
+enum pow_scratch_slot {
+    POW_SCRATCH_LYRA2 = 0,
+    POW_SCRATCH_SCRYPT,
+    POW_SCRATCH_NEOSCRYPT,
+    POW_SCRATCH_SLOTS
+};
+
+/**
+ * Return a 64-byte aligned buffer of at least size bytes, owned by the calling
+ * thread. The buffer of a slot only ever grows, so once a thread has hashed
+ * with an algo no further allocation happens for it. The contents are not
+ * preserved or cleared between calls. The buffers are freed when the thread
+ * exits. Returns NULL if the allocation failed.
+ */
+void *pow_scratch(enum pow_scratch_slot slot, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HUNTCOIN_CRYPTO_ALGOS_SCRATCH_H
@@ -28,10 +28,12 @@
  */
 
 #include "crypto/algos/scrypt/scrypt.h"
+#include "crypto/algos/scratch.h"
 //#include "util.h"
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <new>
 #include <openssl/sha.h>
 
 #if defined(USE_SSE2) && !defined(USE_SSE2_ALWAYS)
@@ -327,6 +329,9 @@ std::string scrypt_detect_sse2()
 
 void scrypt_1024_1_1_256(const char *input, char *output)
 {
-	char scratchpad[SCRYPT_SCRATCHPAD_SIZE];
+    // The 128 KiB scratchpad comes from the per-thread scratch memory instead of the stack.
+    char *scratchpad = (char *)pow_scratch(POW_SCRATCH_SCRYPT, SCRYPT_SCRATCHPAD_SIZE);
+    if (scratchpad == nullptr)
+        throw std::bad_alloc();
     scrypt_1024_1_1_256_sp(input, output, scratchpad);
 }
@@ -12,70 +12,57 @@
 #include <sstream>
 #include <string>
 
+/** powLimit_* member of each algo, indexed by algo id (same order as ALGO_TABLE). */
+static const uint256 Consensus::Params::* const ALGO_POW_LIMITS[] = {
+    &Consensus::Params::powLimit_SHA256,
+    &Consensus::Params::powLimit_SCRYPT,
+    &Consensus::Params::powLimit_X11,
+    &Consensus::Params::powLimit_NEOSCRYPT,
+    &Consensus::Params::powLimit_EQUIHASH,
+    &Consensus::Params::powLimit_YESCRYPT,
+    &Consensus::Params::powLimit_HMQ1725,
+    &Consensus::Params::powLimit_XEVAN,
+    &Consensus::Params::powLimit_NIST5,
+    &Consensus::Params::powLimit_TIMETRAVEL10,
+    &Consensus::Params::powLimit_PAWELHASH,
+    &Consensus::Params::powLimit_X13,
+    &Consensus::Params::powLimit_X14,
+    &Consensus::Params::powLimit_X15,
+    &Consensus::Params::powLimit_X17,
+    &Consensus::Params::powLimit_LYRA2RE,
+    &Consensus::Params::powLimit_BLAKE2S,
+    &Consensus::Params::powLimit_BLAKE2B,
+    &Consensus::Params::powLimit_ASTRALHASH,
+    &Consensus::Params::powLimit_PADIHASH,
+    &Consensus::Params::powLimit_JEONGHASH,
+    &Consensus::Params::powLimit_KECCAK,
+    &Consensus::Params::powLimit_ZHASH,
+    &Consensus::Params::powLimit_GLOBALHASH,
+    &Consensus::Params::powLimit_SKEIN,
+    &Consensus::Params::powLimit_GROESTL,
+    &Consensus::Params::powLimit_QUBIT,
+    &Consensus::Params::powLimit_SKUNKHASH,
+    &Consensus::Params::powLimit_QUARK,
+    &Consensus::Params::powLimit_X16R,
+};
+
+static_assert(sizeof(ALGO_POW_LIMITS) / sizeof(ALGO_POW_LIMITS[0]) == NUM_ALGOS, "ALGO_POW_LIMITS needs one entry per algo");
+
+void InitAlgoPowLimits(Consensus::Params& consensusParams)
+{
+    consensusParams.vAlgoPowLimit.clear();
+    for (uint8_t algo = 0; algo < NUM_ALGOS; algo++)
+        consensusParams.vAlgoPowLimit.push_back(UintToArith256(consensusParams.*ALGO_POW_LIMITS[algo]));
+}
+
 arith_uint256 GetAlgoPowLimit(uint8_t algo, const Consensus::Params& consensusParams)
 {
-	if (algo == ALGO_SHA256D)
-		return UintToArith256(consensusParams.powLimit_SHA256);
-	else if (algo == ALGO_SCRYPT)
-		return UintToArith256(consensusParams.powLimit_SCRYPT);
-	else if (algo == ALGO_X11)
-		return UintToArith256(consensusParams.powLimit_X11);
-	else if (algo == ALGO_NEOSCRYPT)
-		return UintToArith256(consensusParams.powLimit_NEOSCRYPT);
-	else if (algo == ALGO_EQUIHASH)
-		return UintToArith256(consensusParams.powLimit_EQUIHASH);
-	else if (algo == ALGO_YESCRYPT)
-		return UintToArith256(consensusParams.powLimit_YESCRYPT);
-	else if (algo == ALGO_HMQ1725)
-		return UintToArith256(consensusParams.powLimit_HMQ1725);
-	else if (algo == ALGO_XEVAN)
-		return UintToArith256(consensusParams.powLimit_XEVAN);
-	else if (algo == ALGO_NIST5)
-		return UintToArith256(consensusParams.powLimit_NIST5);
-    else if (algo == ALGO_TIMETRAVEL10)
-		return UintToArith256(consensusParams.powLimit_TIMETRAVEL10);
-    else if (algo == ALGO_PAWELHASH)
-		return UintToArith256(consensusParams.powLimit_PAWELHASH);
-    else if (algo == ALGO_X13)
-		return UintToArith256(consensusParams.powLimit_X13);
-    else if (algo == ALGO_X14)
-		return UintToArith256(consensusParams.powLimit_X14);
-    else if (algo == ALGO_X15)
-		return UintToArith256(consensusParams.powLimit_X15);
-    else if (algo == ALGO_X17)
-		return UintToArith256(consensusParams.powLimit_X17);
-    else if (algo == ALGO_LYRA2RE)
-        return UintToArith256(consensusParams.powLimit_LYRA2RE);
-    else if (algo == ALGO_BLAKE2S)
-        return UintToArith256(consensusParams.powLimit_BLAKE2S);
-    else if (algo == ALGO_BLAKE2B)
-        return UintToArith256(consensusParams.powLimit_BLAKE2B);
-    else if (algo == ALGO_ASTRALHASH)
-        return UintToArith256(consensusParams.powLimit_ASTRALHASH);
-    else if (algo == ALGO_PADIHASH)
-        return UintToArith256(consensusParams.powLimit_PADIHASH);
-    else if (algo == ALGO_JEONGHASH)
-        return UintToArith256(consensusParams.powLimit_JEONGHASH);
-    else if (algo == ALGO_ZHASH)
-        return UintToArith256(consensusParams.powLimit_ZHASH);
-    else if (algo == ALGO_KECCAK)
-        return UintToArith256(consensusParams.powLimit_KECCAK);
-    else if (algo == ALGO_GLOBALHASH)
-        return UintToArith256(consensusParams.powLimit_GLOBALHASH);
-    else if (algo == ALGO_QUBIT)
-        return UintToArith256(consensusParams.powLimit_QUBIT);
-    else if (algo == ALGO_SKEIN)
-        return UintToArith256(consensusParams.powLimit_SKEIN);
-    else if (algo == ALGO_GROESTL)
-        return UintToArith256(consensusParams.powLimit_GROESTL);
-    else if (algo == ALGO_SKUNKHASH)
-        return UintToArith256(consensusParams.powLimit_SKUNKHASH);
-    else if (algo == ALGO_QUARK)
-        return UintToArith256(consensusParams.powLimit_QUARK);
-    else if (algo == ALGO_X16R)
-        return UintToArith256(consensusParams.powLimit_X16R);
-	else
-		return UintToArith256(consensusParams.powLimit_SHA256);
+    if (algo >= NUM_ALGOS)
+        algo = ALGO_SHA256D;
+    // Chain params are converted once at construction, hand built params are not.
+    if (consensusParams.vAlgoPowLimit.size() == NUM_ALGOS)
+        return consensusParams.vAlgoPowLimit[algo];
+    return UintToArith256(consensusParams.*ALGO_POW_LIMITS[algo]);
 }
 
 arith_uint256 GetAlgoPowLimit(uint8_t algo)
@@ -18,6 +18,7 @@ enum {
     DIVIDEDPAYMENTS_AUXPOW_WARNING
 };
 
+void InitAlgoPowLimits(Consensus::Params& consensusParams);
 arith_uint256 GetAlgoPowLimit(uint8_t algo, const Consensus::Params& consensusParams);
 arith_uint256 GetAlgoPowLimit(uint8_t algo);
 bool IsHardForkActivated(uint32_t blocktime, const Consensus::Params& consensusParams);
@@ -6,6 +6,8 @@
 #include <chainparams.h>
 #include <huntnotificationinterface.h>
 #include <instantx.h>
+#include <masternode-collateral.h>
+#include <masternode-helper.h>
 #include <masternodeman.h>
 #include <masternode-payments.h>
 #include <masternode-sync.h>
@@ -42,6 +44,8 @@ void CHUNTNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, c
     mnodeman.UpdatedBlockTip(pindexNew);
     instantsend.UpdatedBlockTip(pindexNew);
     mnpayments.UpdatedBlockTip(pindexNew, connman);
+
+    RequestMasternodeCleanup();
 }
 
 void CHUNTNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx)
@@ -57,10 +61,12 @@ void CHUNTNotificationInterface::BlockConnected(const std::shared_ptr<const CBlo
     for (size_t i = 0; i < pblock->vtx.size(); i++) {
         instantsend.SyncTransaction(pblock->vtx[i], pindex, i);
     }
+    collateralwatch.BlockConnected(*pblock, pindex->nHeight);
 }
 
 void CHUNTNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
     for (const CTransactionRef& ptx : pblock->vtx) {
         instantsend.SyncTransaction(ptx);
     }
+    collateralwatch.BlockDisconnected(*pblock);
 }
\ No newline at end of file
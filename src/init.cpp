@@ -13,13 +13,18 @@
 #include <init.h>
 
 #include <addrman.h>
+#include <algostats.h>
 #include <amount.h>
+#include <auxpowcache.h>
+#include <auxworkcache.h>
 #include <base58.h>
+#include <cache-database.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
@@ -36,9 +41,11 @@
 #include <rpc/register.h>
 #include <rpc/safemode.h>
 #include <rpc/blockchain.h>
+#include <rpc/mining.h>
 #include <script/standard.h>
 #include <script/sigcache.h>
 #include <scheduler.h>
+#include <stratum.h>
 #include <timedata.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -54,7 +61,6 @@
 
 #include <activemasternode.h>
 #include <huntnotificationinterface.h>
-#include <flat-database.h>
 #include <instantx.h>
 #include <masternode-helper.h>
 #include <masternode-payments.h>
@@ -190,6 +196,7 @@ void Interrupt()
     InterruptRPC();
     InterruptREST();
     InterruptTorControl();
+    InterruptStratumServer();
     InterruptMapPort();
     if (g_connman)
         g_connman->Interrupt();
@@ -214,6 +221,7 @@ void Shutdown()
     StopREST();
     StopRPC();
     StopHTTPServer();
+    StopMinerThreads();
 #ifdef ENABLE_WALLET
     FlushWallets();
 #endif
@@ -226,17 +234,11 @@ void Shutdown()
     peerLogic.reset();
     g_connman.reset();
     
-    // STORE DATA CACHES INTO SERIALIZED DAT FILES
-    if (!fLiteMode) {
-        CFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
-        flatdb1.Dump(mnodeman);
-        CFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
-        flatdb2.Dump(mnpayments);
-        CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
-        flatdb4.Dump(netfulfilledman);
-    }
+    // WRITE OUTSTANDING CHANGES TO THE DATA CACHES
+    FlushMasternodeCaches();
 
     StopTorControl();
+    StopStratumServer();
 
     // After everything has been shut down, but before things get flushed, stop the
     // CScheduler/checkqueue threadGroup
@@ -284,6 +286,9 @@ void Shutdown()
         pcoinsdbview.reset();
         pblocktree.reset();
     }
+    pmncachedb.reset();
+    pmnpaymentsdb.reset();
+    pnetfulfilleddb.reset();
 #ifdef ENABLE_WALLET
     StopWallets();
 #endif
@@ -296,6 +301,10 @@ void Shutdown()
     }
 #endif
 
+    UnregisterValidationInterface(&templateselection);
+    UnregisterValidationInterface(&algostats);
+    templateselection.Invalidate();
+
     if (phuntNotificationInterface) {
         UnregisterValidationInterface(phuntNotificationInterface);
         delete phuntNotificationInterface;
@@ -374,6 +383,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
     strUsage +=HelpMessageOpt("-assumevalid=<hex>", strprintf(_("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)"), defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()));
+    strUsage += HelpMessageOpt("-auxpowcache=<n>", strprintf(_("Keep the auxpow of up to <n> megabytes of merge-mined block headers in memory, 0 to disable (default: %d)"), DEFAULT_AUXPOW_CACHE));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
     if (showDebug)
@@ -402,6 +412,8 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
+    strUsage += HelpMessageOpt("-powverifythreads=<n>", strprintf(_("Set the number of threads checking the proof of work of received headers (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
+        -GetNumCores(), MAX_POWCHECK_THREADS, DEFAULT_POWCHECK_THREADS));
     strUsage += HelpMessageOpt("-persistmempool", strprintf(_("Whether to save the mempool on shutdown and load on restart (default: %u)"), DEFAULT_PERSIST_MEMPOOL));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)"), HUNTCOIN_PID_FILENAME));
@@ -477,6 +489,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-checklevel=<n>", strprintf(_("How thorough the block verification of -checkblocks is (0-4, default: %u)"), DEFAULT_CHECKLEVEL));
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
+        strUsage += HelpMessageOpt("-checkpowonload=<mode>", strprintf("How much of the stored block index gets its proof of work re-checked at startup: none, sample or all (default: %s)", DEFAULT_CHECKPOWONLOAD));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
         strUsage += HelpMessageOpt("-disablesafemode", strprintf("Disable safemode, override a real safe mode event (default: %u)", DEFAULT_DISABLE_SAFEMODE));
         strUsage += HelpMessageOpt("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used");
@@ -529,6 +542,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageGroup(_("InstantSend options:"));
     strUsage += HelpMessageOpt("-enableinstantsend=<n>", strprintf(_("Enable InstantSend, show confirmations for locked transactions (0-1, default: %u)"), 1));
     strUsage += HelpMessageOpt("-instantsenddepth=<n>", strprintf(_("Show N confirmations for a successfully locked transaction (%u-%u, default: %u)"), MIN_INSTANTSEND_DEPTH, MAX_INSTANTSEND_DEPTH, DEFAULT_INSTANTSEND_DEPTH));
+    strUsage += HelpMessageOpt("-instantsendmemory=<n>", strprintf(_("Keep up to <n> megabytes of InstantSend lock requests and votes in memory, refuse new ones above that (default: %u)"), DEFAULT_INSTANTSEND_MEMORY));
     strUsage += HelpMessageOpt("-instantsendnotify=<cmd>", _("Execute command when a wallet InstantSend transaction is successfully locked (%s in cmd is replaced by TxID)"));
 
     strUsage += HelpMessageGroup(_("Node relay options:"));
@@ -549,6 +563,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageGroup(_("Block creation options:"));
     strUsage += HelpMessageOpt("-acceptdividedcoinbase", strprintf(_("You must pay the founders reward and masternode reward from coinbase. If you enable this argument then you accept to pay this fee. (default: %u)"), false));
     strUsage += HelpMessageOpt("-algo=<algo>", _("Mining algorithms: astralhash, blake2b, blake2s, equihash, globalhash, groestl, hmq1725, jeonghash, keccak, lyra2re, neoscrypt, nist5, padihash, pawelhash, quark, qubit, scrypt, sha256d, skein, skunkhash, timetravel10, x11, x13, x14, x15, x16r, x17, xevan, yescrypt, zhash"));
+    strUsage += HelpMessageOpt("-auxworkcache=<n>", strprintf(_("Keep up to <n> megabytes of blocks handed out by createauxblock for submission, besides the current one of each algo (default: %d)"), DEFAULT_AUXWORK_CACHE));
     if (showDebug)
         strUsage += HelpMessageOpt("-blockmaxsize=<n>", "Set maximum BIP141 block weight to this * 4. Deprecated, use blockmaxweight");
     strUsage += HelpMessageOpt("-blockmaxweight=<n>", strprintf(_("Set maximum BIP141 block weight (default: %d)"), DefaultMaxBlockWeight(true)));
@@ -558,7 +573,14 @@ std::string HelpMessage(HelpMessageMode mode)
 		
     strUsage += HelpMessageOpt("-coinbasetxnaddress=<address>", _("If you mine with getblocktemplate coinbasetxn, you need to paste an address here. It will be used to generate the coinbasetxn"));
     strUsage += HelpMessageOpt("-enableequihash", _("Activate equihash to mine blocks with this algorithm solo in this wallet. (default: disabled)"));
+    strUsage += HelpMessageOpt("-genproclimit=<n>", strprintf(_("Set the number of threads generate and generatetoaddress mine with (<= 0 = all cores, default: %d)"), DEFAULT_GENERATE_THREADS));
     strUsage += HelpMessageOpt("-enablezhash", _("Activate zhash to mine blocks with this algorithm solo in this wallet. (default: disabled)"));
+
+    strUsage += HelpMessageGroup(_("Stratum server options:"));
+    strUsage += HelpMessageOpt("-stratumallowip=<ip>", _("Allow Stratum connections from specified source, besides localhost. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times"));
+    strUsage += HelpMessageOpt("-stratumbind=<addr>[:port]", _("Run a Stratum server for miners on the given address. Use [host]:port notation for IPv6. This option can be specified multiple times (default: disabled)"));
+    strUsage += HelpMessageOpt("-stratumdifficulty=<n>", strprintf(_("Share difficulty of Stratum miners that do not ask for one with a d=<n> password option (default: %s)"), DEFAULT_STRATUM_DIFFICULTY));
+    strUsage += HelpMessageOpt("-stratumport=<port>", strprintf(_("Listen for Stratum connections on <port> unless -stratumbind gives one (default: %u)"), DEFAULT_STRATUM_PORT));
     strUsage += HelpMessageGroup(_("RPC server options:"));
     strUsage += HelpMessageOpt("-rest", strprintf(_("Accept public REST requests (default: %u)"), DEFAULT_REST_ENABLE));
     strUsage += HelpMessageOpt("-rpcallowip=<ip>", _("Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times"));
@@ -1066,6 +1088,8 @@ bool AppInitParameterInteraction()
     }
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    if (!ParsePowLoadCheck(gArgs.GetArg("-checkpowonload", DEFAULT_CHECKPOWONLOAD), nPowLoadCheck))
+        return InitError(strprintf(_("Unknown -checkpowonload mode '%s'"), gArgs.GetArg("-checkpowonload", DEFAULT_CHECKPOWONLOAD)));
 
     hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1111,6 +1135,15 @@ bool AppInitParameterInteraction()
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+    // -powverifythreads=0 means autodetect, but nPowCheckThreads==0 means no concurrency
+    nPowCheckThreads = gArgs.GetArg("-powverifythreads", DEFAULT_POWCHECK_THREADS);
+    if (nPowCheckThreads <= 0)
+        nPowCheckThreads += GetNumCores();
+    if (nPowCheckThreads <= 1)
+        nPowCheckThreads = 0;
+    else if (nPowCheckThreads > MAX_POWCHECK_THREADS)
+        nPowCheckThreads = MAX_POWCHECK_THREADS;
+
     // block pruning; get the amount of disk space (in MiB) to allot for block & undo files
     int64_t nPruneArg = gArgs.GetArg("-prune", 0);
     if (nPruneArg < 0) {
@@ -1255,6 +1288,8 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string multihash_algo = MultihashAutoDetect();
+    LogPrintf("Using the '%s' multi-lane X-family hash implementation\n", multihash_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1325,6 +1360,18 @@ bool AppInitMain()
             threadGroup.create_thread(&ThreadScriptCheck);
     }
 
+    if (nScriptCheckThreads) {
+        LogPrintf("Using %u threads for masternode signature verification\n", nScriptCheckThreads);
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadMasternodeSigCheck);
+    }
+
+    LogPrintf("Using %u threads for header proof of work verification\n", nPowCheckThreads);
+    if (nPowCheckThreads) {
+        for (int i=0; i<nPowCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadPowCheck);
+    }
+
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
@@ -1453,67 +1500,7 @@ bool AppInitMain()
     // Algo
     std::string strAlgo = gArgs.GetArg("-algo", "sha256d");
     transform(strAlgo.begin(),strAlgo.end(),strAlgo.begin(),::tolower);
-    if (strAlgo == "sha" || strAlgo == "sha256" || strAlgo == "sha256d")
-        currentAlgo = ALGO_SHA256D;
-    else if (strAlgo == "scrypt")
-        currentAlgo = ALGO_SCRYPT;
-    else if (strAlgo == "neoscrypt")
-        currentAlgo = ALGO_NEOSCRYPT;
-    else if (strAlgo == "equihash")
-        currentAlgo = ALGO_EQUIHASH;
-    else if (strAlgo == "yescrypt")
-        currentAlgo = ALGO_YESCRYPT;
-    else if (strAlgo == "hmq1725")
-        currentAlgo = ALGO_HMQ1725;
-    else if (strAlgo == "xevan")
-        currentAlgo = ALGO_XEVAN;
-    else if (strAlgo == "nist5")
-        currentAlgo = ALGO_NIST5;
-    else if (strAlgo == "timetravel" || strAlgo == "timetravel10")
-        currentAlgo = ALGO_TIMETRAVEL10;
-    else if (strAlgo == "pawelhash")
-        currentAlgo = ALGO_PAWELHASH;
-    else if (strAlgo == "x11")
-        currentAlgo = ALGO_X11;
-    else if (strAlgo == "x13")
-        currentAlgo = ALGO_X13;
-    else if (strAlgo == "x14")
-        currentAlgo = ALGO_X14;
-    else if (strAlgo == "x15")
-        currentAlgo = ALGO_X15;
-    else if (strAlgo == "x16r")
-        currentAlgo = ALGO_X16R;
-    else if (strAlgo == "x17")
-        currentAlgo = ALGO_X17;
-    else if (strAlgo == "lyra" || strAlgo == "lyra2re" || strAlgo == "lyra2" || strAlgo == "lyra2rev2")
-        currentAlgo = ALGO_LYRA2RE;
-    else if (strAlgo == "blake2s")
-        currentAlgo = ALGO_BLAKE2S;
-    else if (strAlgo == "blake2b" || strAlgo == "sia")
-        currentAlgo = ALGO_BLAKE2B;
-    else if (strAlgo == "astralhash")
-        currentAlgo = ALGO_ASTRALHASH;
-    else if (strAlgo == "padihash")
-        currentAlgo = ALGO_PADIHASH;
-    else if (strAlgo == "jeonghash")
-        currentAlgo = ALGO_JEONGHASH;
-    else if (strAlgo == "keccak")
-        currentAlgo = ALGO_KECCAK;
-    else if (strAlgo == "zhash" || strAlgo == "equihash1445" || strAlgo == "equihash144.5")
-        currentAlgo = ALGO_ZHASH;
-    else if (strAlgo == "globalhash")
-        currentAlgo = ALGO_GLOBALHASH;
-    else if (strAlgo == "groestl" || strAlgo == "groestlsha2")
-        currentAlgo = ALGO_GROESTL;
-    else if (strAlgo == "skein" || strAlgo == "skeinsha2")
-        currentAlgo = ALGO_SKEIN;
-    else if (strAlgo == "q2c" || strAlgo == "qubit")
-        currentAlgo = ALGO_QUBIT;
-    else if (strAlgo == "skunk" || strAlgo == "skunkhash")
-        currentAlgo = ALGO_SKUNKHASH;
-    else if (strAlgo == "quark")
-        currentAlgo = ALGO_QUARK;
-    else
+    if (!GetAlgoByName(strAlgo, currentAlgo))
     {
         currentAlgo = ALGO_SHA256D;
         LogPrintf("Unknown mining algorithm: (%s) ~ Auto choosing (%s) instead\n", strAlgo, GetAlgoName(currentAlgo));
@@ -1545,6 +1532,9 @@ bool AppInitMain()
     phuntNotificationInterface = new CHUNTNotificationInterface(connman);
     RegisterValidationInterface(phuntNotificationInterface);
 
+    RegisterValidationInterface(&templateselection);
+    RegisterValidationInterface(&algostats);
+
     uint64_t nMaxOutboundLimit = 0; //unlimited unless -maxuploadtarget is set
     uint64_t nMaxOutboundTimeframe = MAX_UPLOAD_TIMEFRAME;
 
@@ -1573,6 +1563,11 @@ bool AppInitMain()
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    int64_t nAuxpowCache = std::max<int64_t>(0, std::min(gArgs.GetArg("-auxpowcache", DEFAULT_AUXPOW_CACHE), MAX_AUXPOW_CACHE)) << 20;
+    auxpowcache.SetMaxUsage(nAuxpowCache);
+    int64_t nAuxworkCache = std::max<int64_t>(0, std::min(gArgs.GetArg("-auxworkcache", DEFAULT_AUXWORK_CACHE), MAX_AUXWORK_CACHE)) << 20;
+    auxworkcache.SetMaxUsage(nAuxworkCache);
+    LogPrintf("* Using %.1fMiB for auxpow header cache\n", nAuxpowCache * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     while (!fLoaded && !fRequestShutdown) {
@@ -1897,41 +1892,43 @@ bool AppInitMain()
     fEnableInstantSend = gArgs.GetBoolArg("-enableinstantsend", 1);
     nInstantSendDepth = gArgs.GetArg("-instantsenddepth", DEFAULT_INSTANTSEND_DEPTH);
     nInstantSendDepth = std::min(std::max(nInstantSendDepth, MIN_INSTANTSEND_DEPTH), MAX_INSTANTSEND_DEPTH);
+    instantsend.SetMaxUsage(std::max<int64_t>(1, std::min(gArgs.GetArg("-instantsendmemory", DEFAULT_INSTANTSEND_MEMORY), MAX_INSTANTSEND_MEMORY)) << 20);
 
     LogPrintf("fLiteMode %d\n", fLiteMode);
     LogPrintf("nInstantSendDepth %d\n", nInstantSendDepth);
 
     // ********************************************************* Step 11b: Load cache data
 
-    // LOAD SERIALIZED DAT FILES INTO DATA CACHES FOR INTERNAL USE
+    // LOAD CACHE DATABASES INTO DATA CACHES FOR INTERNAL USE
 
     if (!fLiteMode) {
         boost::filesystem::path pathDB = GetDataDir();
         std::string strDBName;
 
-        strDBName = "mncache.dat";
+        strDBName = "mncache";
         uiInterface.InitMessage(_("Loading masternode cache..."));
-        CFlatDB<CMasternodeMan> flatdb1(strDBName, "magicMasternodeCache");
-        if(!flatdb1.Load(mnodeman)) {
+        pmncachedb.reset(new CCacheDB<CMasternodeMan>(strDBName, "magicMasternodeCache" + CMasternodeMan::SERIALIZATION_VERSION_STRING));
+        if(!pmncachedb->Load(mnodeman)) {
             return InitError(_("Failed to load masternode cache from") + "\n" + (pathDB / strDBName).string());
         }
 
+        strDBName = "mnpayments";
+        pmnpaymentsdb.reset(new CCacheDB<CMasternodePayments>(strDBName, "magicMasternodePaymentsCache"));
         if(mnodeman.size()) {
-            strDBName = "mnpayments.dat";
             uiInterface.InitMessage(_("Loading masternode payment cache..."));
-            CFlatDB<CMasternodePayments> flatdb2(strDBName, "magicMasternodePaymentsCache");
-            if(!flatdb2.Load(mnpayments)) {
+            if(!pmnpaymentsdb->Load(mnpayments)) {
                 return InitError(_("Failed to load masternode payments cache from") + "\n" + (pathDB / strDBName).string());
             }
 
         } else {
             uiInterface.InitMessage(_("Masternode cache is empty, skipping payments cache..."));
+            pmnpaymentsdb->Wipe();
         }
 
-        strDBName = "netfulfilled.dat";
+        strDBName = "netfulfilled";
         uiInterface.InitMessage(_("Loading fulfilled requests cache..."));
-        CFlatDB<CNetFulfilledRequestManager> flatdb4(strDBName, "magicFulfilledCache");
-        if(!flatdb4.Load(netfulfilledman)) {
+        pnetfulfilleddb.reset(new CCacheDB<CNetFulfilledRequestManager>(strDBName, "magicFulfilledCache"));
+        if(!pnetfulfilleddb->Load(netfulfilledman)) {
             return InitError(_("Failed to load fulfilled requests cache from") + "\n" + (pathDB / strDBName).string());
         }
     }
@@ -1944,9 +1941,9 @@ bool AppInitMain()
     // GetMainSignals().UpdatedBlockTip(chainActive.Tip());
     phuntNotificationInterface->InitializeCurrentBlockTip();
     
-    // ********************************************************* Step 11d: start huntcoin-helper threads
+    // ********************************************************* Step 11d: schedule huntcoin-helper tasks
 
-    threadGroup.create_thread(boost::bind(&ThreadCheckMasternodes, boost::ref(*g_connman)));
+    StartMasternodeMaintenance(scheduler, *g_connman);
 
     // ********************************************************* Step 12: start node
 
@@ -1963,6 +1960,9 @@ bool AppInitMain()
     if (gArgs.GetBoolArg("-listenonion", DEFAULT_LISTEN_ONION))
         StartTorControl();
 
+    if (gArgs.IsArgSet("-stratumbind") && !StartStratumServer())
+        return InitError(_("Unable to start the Stratum server. See debug log for details."));
+
     Discover();
 
     // Map ports with UPnP
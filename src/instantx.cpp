@@ -10,6 +10,7 @@
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
+#include <memusage.h>
 #include <messagesigner.h>
 #include <net.h>
 #include <netmessagemaker.h>
@@ -26,6 +27,7 @@
 #endif // ENABLE_WALLET
 
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/optional.hpp>
 #include <boost/thread.hpp>
 
 extern CTxMemPool mempool;
@@ -36,6 +38,29 @@ int nCompleteTXLocks;
 
 CInstantSend instantsend;
 
+/** LOCK(cs) counting whether cs was held by another thread, and how long we waited for it */
+class SCOPED_LOCKABLE CCountedLock
+{
+private:
+    boost::optional<CCriticalBlock> lock;
+
+public:
+    CCountedLock(CCriticalSection& cs, const char* pszName, const char* pszFile, int nLine, std::atomic<uint64_t>& nContended, std::atomic<int64_t>& nWaitMicros) EXCLUSIVE_LOCK_FUNCTION(cs)
+    {
+        lock.emplace(cs, pszName, pszFile, nLine, true);
+        if(*lock) return;
+
+        nContended++;
+        int64_t nWaitStart = GetTimeMicros();
+        lock.emplace(cs, pszName, pszFile, nLine);
+        nWaitMicros += GetTimeMicros() - nWaitStart;
+    }
+
+    ~CCountedLock() UNLOCK_FUNCTION() {}
+};
+
+#define LOCK_COUNTED(cs) CCountedLock PASTE2(countedlock, __COUNTER__)(cs, #cs, __FILE__, __LINE__, nLockContended, nLockWaitMicros)
+
 // Transaction Locks
 //
 // step 1) Some node announces intention to lock transaction inputs via "txlockrequest" message (ix)
@@ -47,6 +72,16 @@ CInstantSend instantsend;
 // CInstantSend
 //
 
+CInstantSend::CInstantSend() :
+    nCachedBlockHeight(0),
+    nMasternodeOrphanVoteTimeTotal(0),
+    nMaxUsage(DEFAULT_INSTANTSEND_MEMORY << 20),
+    nVotesVerified(0),
+    nLockCandidatesFinalized(0),
+    nLockContended(0),
+    nLockWaitMicros(0)
+{}
+
 void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
 {
     if(fLiteMode) return; // disable all Huntcoin specific functionality
@@ -76,8 +111,12 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
 
         {
             LOCK(cs_instantsend);
-            auto ret = mapTxLockVotes.emplace(nVoteHash, vote);
-            if (!ret.second) return;
+            if (mapTxLockVotes.count(nVoteHash)) return;
+            if (IsMemoryLimitReached()) {
+                LogPrint(BCLog::INSTANTSEND, "TXLOCKVOTE -- memory limit reached, dropping vote %s, peer=%d\n", nVoteHash.ToString(), pfrom->GetId());
+                return;
+            }
+            AddTxLockVote(nVoteHash, vote);
         }
 
         ProcessNewTxLockVote(pfrom, vote, connman);
@@ -88,19 +127,28 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
 
 bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CConnman& connman)
 {
-    LOCK(cs_main);
-            
-#ifdef ENABLE_WALLET
-    for (CWalletRef pwallet : vpwallets) {
-        LOCK(pwallet->cs_wallet);
-#endif
-        LOCK2(mempool.cs, cs_instantsend);
+    uint256 txHash = txLockRequest.GetHash();
 
-        uint256 txHash = txLockRequest.GetHash();
+    // Pre-check, needs the UTXO set but none of our own state
+    {
+        LOCK(cs_main);
+        if(!txLockRequest.IsValid()) {
+            LogPrintf("CInstantSend::ProcessTxLockRequest -- invalid Transaction Lock Request, txid=%s\n", txHash.ToString());
+            return false;
+        }
+    }
+
+    {
+        LOCK_COUNTED(cs_instantsend);
+
+        if(!mapTxLockCandidates.count(txHash) && IsMemoryLimitReached()) {
+            LogPrintf("CInstantSend::ProcessTxLockRequest -- memory limit reached, txid=%s\n", txHash.ToString());
+            return false;
+        }
 
         // Check to see if we conflict with existing completed lock
         for (const auto& txin : txLockRequest.tx->vin) {
-            std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(txin.prevout);
+            auto it = mapLockedOutpoints.find(txin.prevout);
             if(it != mapLockedOutpoints.end() && it->second != txLockRequest.GetHash()) {
                 // Conflicting with complete lock, proceed to see if we should cancel them both
                 LogPrintf("CInstantSend::ProcessTxLockRequest -- WARNING: Found conflicting completed Transaction Lock, txid=%s, completed lock txid=%s\n",
@@ -111,7 +159,7 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
         // Check to see if there are votes for conflicting request,
         // if so - do not fail, just warn user
         for (const auto& txin : txLockRequest.tx->vin) {
-            std::map<COutPoint, std::set<uint256> >::iterator it = mapVotedOutpoints.find(txin.prevout);
+            auto it = mapVotedOutpoints.find(txin.prevout);
             if(it != mapVotedOutpoints.end()) {
                 for (const auto& hash : it->second) {
                     if(hash != txLockRequest.GetHash()) {
@@ -133,12 +181,27 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
         // Masternodes will sometimes propagate votes before the transaction is known to the client.
         // If this just happened - process orphan votes, lock inputs, resolve conflicting locks,
         // update transaction status forcing external script/zmq notifications.
+        ProcessOrphanTxLockVotes(txHash);
+    }
+
+    FinalizeTxLockCandidate(txHash);
+    return true;
+}
+
+void CInstantSend::FinalizeTxLockCandidate(const uint256& txHash)
+{
+    LOCK_COUNTED(cs_main);
 #ifdef ENABLE_WALLET
-        ProcessOrphanTxLockVotes(pwallet);
-#else
-        ProcessOrphanTxLockVotes();
+    // wallets only need to hear about the lock, finalize once without one if there are none
+    std::vector<CWallet*> vecWallets(vpwallets.begin(), vpwallets.end());
+    if(vecWallets.empty()) vecWallets.push_back(nullptr);
+    for (CWallet* pwallet : vecWallets) {
+        LOCK(pwallet ? &pwallet->cs_wallet : nullptr);
 #endif
-        std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+        LOCK2(mempool.cs, cs_instantsend);
+
+        auto itLockCandidate = mapTxLockCandidates.find(txHash);
+        if(itLockCandidate == mapTxLockCandidates.end() || !itLockCandidate->second.txLockRequest) return;
 #ifdef ENABLE_WALLET
         TryToFinalizeLockCandidate(itLockCandidate->second, pwallet);
 #else
@@ -147,18 +210,15 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
 #ifdef ENABLE_WALLET
     }
 #endif
-    return true;
 }
 
 bool CInstantSend::CreateTxLockCandidate(const CTxLockRequest& txLockRequest)
 {
-    if(!txLockRequest.IsValid()) return false;
-
-    LOCK(cs_instantsend);
+    AssertLockHeld(cs_instantsend);
 
     uint256 txHash = txLockRequest.GetHash();
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate == mapTxLockCandidates.end()) {
         LogPrintf("CInstantSend::CreateTxLockCandidate -- new, txid=%s\n", txHash.ToString());
 
@@ -241,7 +301,7 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
     if(mapLockRequestAccepted.find(txHash) == mapLockRequestAccepted.end()) return;
     // check if we need to vote on this candidate's outpoints,
     // it's possible that we need to vote for several of them
-    std::map<COutPoint, COutPointLock>::iterator itOutpointLock = txLockCandidate.mapOutPointLocks.begin();
+    auto itOutpointLock = txLockCandidate.mapOutPointLocks.begin();
     while(itOutpointLock != txLockCandidate.mapOutPointLocks.end()) {
 
         int nPrevoutHeight = GetUTXOHeight(itOutpointLock->first);
@@ -269,14 +329,14 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::Vote -- In the top %d (%d)\n", nSignaturesTotal, nRank);
 
-        std::map<COutPoint, std::set<uint256> >::iterator itVoted = mapVotedOutpoints.find(itOutpointLock->first);
+        auto itVoted = mapVotedOutpoints.find(itOutpointLock->first);
 
         // Check to see if we already voted for this outpoint,
         // refuse to vote twice or to include the same outpoint in another tx
         bool fAlreadyVoted = false;
         if(itVoted != mapVotedOutpoints.end()) {
             for (const auto& hash : itVoted->second) {
-                std::map<uint256, CTxLockCandidate>::iterator it2 = mapTxLockCandidates.find(hash);
+                auto it2 = mapTxLockCandidates.find(hash);
                 if(it2->second.HasMasternodeVoted(itOutpointLock->first, activeMasternode.outpoint)) {
                     // we already voted for this outpoint to be included either in the same tx or in a competing one,
                     // skip it anyway
@@ -306,7 +366,9 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         // vote constructed sucessfully, let's store and relay it
         uint256 nVoteHash = vote.GetHash();
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        if(!mapTxLockVotes.count(nVoteHash)) {
+            AddTxLockVote(nVoteHash, vote);
+        }
         if(itOutpointLock->second.AddVote(vote)) {
             LogPrintf("CInstantSend::Vote -- Vote created successfully, relaying: txHash=%s, outpoint=%s, vote=%s\n",
                     txHash.ToString(), itOutpointLock->first.ToStringShort(), nVoteHash.ToString());
@@ -334,8 +396,10 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, CConnman& connman)
 {
     uint256 txHash = vote.GetTxHash();
-    uint256 nVoteHash = vote.GetHash();
 
+    // Pre-check without cs_main or cs_instantsend held for the whole time: the
+    // masternode rank comes from the cached rank tables of mnodeman and the
+    // signature only needs the masternode's key
     if(!vote.IsValid(pfrom, connman)) {
         // could be because of missing MN
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- Vote is invalid, txid=%s\n", __func__, txHash.ToString());
@@ -345,24 +409,33 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
     // relay valid vote asap
     vote.Relay(connman);
 
-    LOCK(cs_main);
-#ifdef ENABLE_WALLET
-    for (CWalletRef pwallet : vpwallets) {
-        LOCK(pwallet->cs_wallet);
-#endif
-        LOCK2(mempool.cs, cs_instantsend);
+    return AddVerifiedTxLockVote(vote);
+}
+
+bool CInstantSend::AddVerifiedTxLockVote(const CTxLockVote& vote)
+{
+    uint256 txHash = vote.GetTxHash();
+    uint256 nVoteHash = vote.GetHash();
+
+    nVotesVerified++;
+
+    {
+        LOCK_COUNTED(cs_instantsend);
 
         // Masternodes will sometimes propagate votes before the transaction is known to the client,
         // will actually process only after the lock request itself has arrived
 
-        std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+        auto it = mapTxLockCandidates.find(txHash);
         if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) {
             // no or empty tx lock candidate
             if(it == mapTxLockCandidates.end()) {
                 // start timeout countdown after the very first vote
                 CreateEmptyTxLockCandidate(txHash);
             }
-            bool fInserted = mapTxLockVotesOrphan.emplace(nVoteHash, vote).second;
+            bool fInserted = !mapTxLockVotesOrphan.count(nVoteHash);
+            if(fInserted) {
+                AddOrphanTxLockVote(nVoteHash, vote);
+            }
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- Orphan vote: txid=%s  masternode=%s %s\n",
                     __func__, txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort(), fInserted ? "new" : "seen");
 
@@ -373,6 +446,7 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
             auto itMnOV = mapMasternodeOrphanVotes.find(vote.GetMasternodeOutpoint());
             if(itMnOV == mapMasternodeOrphanVotes.end()) {
                 mapMasternodeOrphanVotes.emplace(vote.GetMasternodeOutpoint(), nMasternodeOrphanExpireTime);
+                nMasternodeOrphanVoteTimeTotal += nMasternodeOrphanExpireTime;
             } else {
                 if(itMnOV->second > GetTime() && itMnOV->second > GetAverageMasternodeOrphanVoteTime()) {
                     LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- masternode is spamming orphan Transaction Lock Votes: txid=%s  masternode=%s\n",
@@ -381,6 +455,7 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
                     return false;
                 }
                 // not spamming, refresh
+                nMasternodeOrphanVoteTimeTotal += nMasternodeOrphanExpireTime - itMnOV->second;
                 itMnOV->second = nMasternodeOrphanExpireTime;
             }
 
@@ -409,35 +484,24 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- Transaction Lock signatures count: %d/%d, vote hash=%s\n", __func__,
                 nSignatures, nSignaturesMax, nVoteHash.ToString());
 
-#ifdef ENABLE_WALLET
-        TryToFinalizeLockCandidate(txLockCandidate, pwallet);
-#else
-        TryToFinalizeLockCandidate(txLockCandidate);
-#endif
-#ifdef ENABLE_WALLET
+        // only the vote that completes the lock needs cs_main and the mempool
+        if(!txLockCandidate.IsAllOutPointsReady() || IsLockedInstantSendTransaction(txHash)) {
+            return true;
+        }
     }
-#endif
+
+    FinalizeTxLockCandidate(txHash);
     return true;
 }
 
-#ifdef ENABLE_WALLET
-bool CInstantSend::ProcessOrphanTxLockVote(const CTxLockVote& vote, CWallet *wallet)
-#else
 bool CInstantSend::ProcessOrphanTxLockVote(const CTxLockVote& vote)
-#endif
 {
-    // cs_main, cs_wallet and cs_instantsend should be already locked
-    AssertLockHeld(cs_main);
-#ifdef ENABLE_WALLET
-    if(wallet)
-        AssertLockHeld(wallet->cs_wallet);
-#endif
     AssertLockHeld(cs_instantsend);
 
     uint256 txHash = vote.GetTxHash();
 
     // We shouldn't process orphan votes without a valid tx lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest)
         return false; // this shouldn never happen
 
@@ -471,14 +535,14 @@ void CInstantSend::UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidat
 
     uint256 txHash = vote.GetTxHash();
 
-    std::map<COutPoint, std::set<uint256> >::iterator it1 = mapVotedOutpoints.find(vote.GetOutpoint());
+    auto it1 = mapVotedOutpoints.find(vote.GetOutpoint());
     if(it1 != mapVotedOutpoints.end()) {
         for (const auto& hash : it1->second) {
             if(hash != txHash) {
                 // same outpoint was already voted to be locked by another tx lock request,
                 // let's see if it was the same masternode who voted on this outpoint
                 // for another tx lock request
-                std::map<uint256, CTxLockCandidate>::iterator it2 = mapTxLockCandidates.find(hash);
+                auto it2 = mapTxLockCandidates.find(hash);
                 if(it2 !=mapTxLockCandidates.end() && it2->second.HasMasternodeVoted(vote.GetOutpoint(), vote.GetMasternodeOutpoint())) {
                     // yes, it was the same masternode
                     LogPrintf("CInstantSend::%s -- masternode sent conflicting votes! %s\n", __func__, vote.GetMasternodeOutpoint().ToStringShort());
@@ -502,25 +566,21 @@ void CInstantSend::UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidat
     }
 }
 
-#ifdef ENABLE_WALLET
-void CInstantSend::ProcessOrphanTxLockVotes(CWallet *wallet)
-#else
-void CInstantSend::ProcessOrphanTxLockVotes()
-#endif
+void CInstantSend::ProcessOrphanTxLockVotes(const uint256& txHash)
 {
-    AssertLockHeld(cs_main);
     AssertLockHeld(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
-    while(it != mapTxLockVotesOrphan.end()) {
-#ifdef ENABLE_WALLET
-        if(ProcessOrphanTxLockVote(it->second, wallet)) {
-#else
+    // only the lock request for txHash can have turned its orphans into regular votes
+    std::vector<uint256> vecVoteHashes;
+    auto range = mapTxLockVotesOrphanByTx.equal_range(txHash);
+    for (auto it = range.first; it != range.second; ++it) {
+        vecVoteHashes.push_back(it->second);
+    }
+
+    for (const auto& nVoteHash : vecVoteHashes) {
+        auto it = mapTxLockVotesOrphan.find(nVoteHash);
         if(ProcessOrphanTxLockVote(it->second)) {
-#endif
-            mapTxLockVotesOrphan.erase(it++);
-        } else {
-            ++it;
+            EraseOrphanTxLockVote(it);
         }
     }
 }
@@ -547,6 +607,7 @@ void CInstantSend::TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCand
 #else
             UpdateLockedTransaction(txLockCandidate);
 #endif
+            nLockCandidatesFinalized++;
         }
     }
 }
@@ -609,7 +670,7 @@ void CInstantSend::LockTransactionInputs(const CTxLockCandidate& txLockCandidate
 
     if(!txLockCandidate.IsAllOutPointsReady()) return;
 
-    std::map<COutPoint, COutPointLock>::const_iterator it = txLockCandidate.mapOutPointLocks.begin();
+    auto it = txLockCandidate.mapOutPointLocks.begin();
 
     while(it != txLockCandidate.mapOutPointLocks.end()) {
         mapLockedOutpoints.insert(std::make_pair(it->first, txHash));
@@ -621,7 +682,7 @@ void CInstantSend::LockTransactionInputs(const CTxLockCandidate& txLockCandidate
 bool CInstantSend::GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet)
 {
     LOCK(cs_instantsend);
-    std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(outpoint);
+    auto it = mapLockedOutpoints.find(outpoint);
     if(it == mapLockedOutpoints.end()) return false;
     hashRet = it->second;
     return true;
@@ -644,8 +705,8 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
         if(GetLockedOutPointTxHash(txin.prevout, hashConflicting) && txHash != hashConflicting) {
             // completed lock which conflicts with another completed one?
             // this means that majority of MNs in the quorum for this specific tx input are malicious!
-            std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
-            std::map<uint256, CTxLockCandidate>::iterator itLockCandidateConflicting = mapTxLockCandidates.find(hashConflicting);
+            auto itLockCandidate = mapTxLockCandidates.find(txHash);
+            auto itLockCandidateConflicting = mapTxLockCandidates.find(hashConflicting);
             if(itLockCandidate == mapTxLockCandidates.end() || itLockCandidateConflicting == mapTxLockCandidates.end()) {
                 // safety check, should never really happen
                 LogPrintf("CInstantSend::ResolveConflicts -- ERROR: Found conflicting completed Transaction Lock, but one of txLockCandidate-s is missing, txid=%s, conflicting txid=%s\n",
@@ -656,8 +717,8 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
                     txHash.ToString(), hashConflicting.ToString());
             CTxLockRequest txLockRequest = itLockCandidate->second.txLockRequest;
             CTxLockRequest txLockRequestConflicting = itLockCandidateConflicting->second.txLockRequest;
-            itLockCandidate->second.SetConfirmedHeight(0); // expired
-            itLockCandidateConflicting->second.SetConfirmedHeight(0); // expired
+            SetTxLockCandidateConfirmedHeight(itLockCandidate->second, 0); // expired
+            SetTxLockCandidateConfirmedHeight(itLockCandidateConflicting->second, 0); // expired
             CheckAndRemove(); // clean up
             // AlreadyHave should still return "true" for both of them
             mapLockRequestRejected.insert(std::make_pair(txHash, txLockRequest));
@@ -709,15 +770,148 @@ int64_t CInstantSend::GetAverageMasternodeOrphanVoteTime()
     // NOTE: should never actually call this function when mapMasternodeOrphanVotes is empty
     if(mapMasternodeOrphanVotes.empty()) return 0;
 
-    std::map<COutPoint, int64_t>::iterator it = mapMasternodeOrphanVotes.begin();
-    int64_t total = 0;
+    return nMasternodeOrphanVoteTimeTotal / (int64_t)mapMasternodeOrphanVotes.size();
+}
 
-    while(it != mapMasternodeOrphanVotes.end()) {
-        total+= it->second;
-        ++it;
+void CInstantSend::AddTxLockVote(const uint256& nVoteHash, const CTxLockVote& vote)
+{
+    AssertLockHeld(cs_instantsend);
+    mapTxLockVotes.emplace(nVoteHash, vote);
+    setTxLockVotesByTime.emplace(vote.GetTimeCreated(), nVoteHash);
+    if(vote.GetConfirmedHeight() != -1) {
+        setTxLockVotesByHeight.emplace(vote.GetConfirmedHeight(), nVoteHash);
+    }
+}
+
+void CInstantSend::EraseTxLockVote(lock_vote_map_t::iterator it)
+{
+    AssertLockHeld(cs_instantsend);
+    setTxLockVotesByTime.erase(std::make_pair(it->second.GetTimeCreated(), it->first));
+    setTxLockVotesByHeight.erase(std::make_pair(it->second.GetConfirmedHeight(), it->first));
+    mapTxLockVotes.erase(it);
+}
+
+void CInstantSend::SetTxLockVoteConfirmedHeight(lock_vote_map_t::iterator it, int nHeight)
+{
+    AssertLockHeld(cs_instantsend);
+    setTxLockVotesByHeight.erase(std::make_pair(it->second.GetConfirmedHeight(), it->first));
+    it->second.SetConfirmedHeight(nHeight);
+    if(nHeight != -1) {
+        setTxLockVotesByHeight.emplace(nHeight, it->first);
+    }
+}
+
+void CInstantSend::AddOrphanTxLockVote(const uint256& nVoteHash, const CTxLockVote& vote)
+{
+    AssertLockHeld(cs_instantsend);
+    mapTxLockVotesOrphan.emplace(nVoteHash, vote);
+    mapTxLockVotesOrphanByTx.emplace(vote.GetTxHash(), nVoteHash);
+    setTxLockVotesOrphanByTime.emplace(vote.GetTimeCreated(), nVoteHash);
+}
+
+void CInstantSend::EraseOrphanTxLockVote(lock_vote_map_t::iterator it)
+{
+    AssertLockHeld(cs_instantsend);
+    auto range = mapTxLockVotesOrphanByTx.equal_range(it->second.GetTxHash());
+    for (auto itByTx = range.first; itByTx != range.second; ++itByTx) {
+        if(itByTx->second == it->first) {
+            mapTxLockVotesOrphanByTx.erase(itByTx);
+            break;
+        }
+    }
+    setTxLockVotesOrphanByTime.erase(std::make_pair(it->second.GetTimeCreated(), it->first));
+    mapTxLockVotesOrphan.erase(it);
+}
+
+void CInstantSend::EraseTxLockCandidate(lock_candidate_map_t::iterator it)
+{
+    AssertLockHeld(cs_instantsend);
+    setTxLockCandidatesByHeight.erase(std::make_pair(it->second.GetConfirmedHeight(), it->first));
+    // Votes of a locked candidate are only indexed by height, which a candidate
+    // dropped before it was confirmed (e.g. by ResolveConflicts) never gets
+    for (const auto& outpointLock : it->second.mapOutPointLocks) {
+        for (const auto& vote : outpointLock.second.GetVotes()) {
+            auto itVote = mapTxLockVotes.find(vote.GetHash());
+            if(itVote != mapTxLockVotes.end()) {
+                EraseTxLockVote(itVote);
+            }
+        }
+    }
+    mapTxLockCandidates.erase(it);
+}
+
+void CInstantSend::SetTxLockCandidateConfirmedHeight(CTxLockCandidate& txLockCandidate, int nHeight)
+{
+    AssertLockHeld(cs_instantsend);
+    uint256 txHash = txLockCandidate.GetHash();
+    setTxLockCandidatesByHeight.erase(std::make_pair(txLockCandidate.GetConfirmedHeight(), txHash));
+    txLockCandidate.SetConfirmedHeight(nHeight);
+    if(nHeight != -1) {
+        setTxLockCandidatesByHeight.emplace(nHeight, txHash);
+    }
+}
+
+size_t CInstantSend::DynamicMemoryUsage()
+{
+    AssertLockHeld(cs_instantsend);
+    // Container overhead plus the signature every vote keeps on the heap. Votes
+    // that made it into a candidate are stored there a second time, lock
+    // requests share their transaction with the mempool and are not counted.
+    size_t nVoteUsage = memusage::MallocUsage(CPubKey::COMPACT_SIGNATURE_SIZE);
+    size_t nCandidateVoteUsage = memusage::MallocUsage(sizeof(std::pair<const COutPoint, CTxLockVote>) + 4 * sizeof(void*)) + nVoteUsage;
+    size_t nCandidateVotes = mapTxLockVotes.size() > mapTxLockVotesOrphan.size() ? mapTxLockVotes.size() - mapTxLockVotesOrphan.size() : 0;
+    return memusage::DynamicUsage(mapLockRequestAccepted) +
+           memusage::DynamicUsage(mapLockRequestRejected) +
+           memusage::DynamicUsage(mapTxLockVotes) + mapTxLockVotes.size() * nVoteUsage +
+           memusage::DynamicUsage(mapTxLockVotesOrphan) + mapTxLockVotesOrphan.size() * nVoteUsage +
+           memusage::MallocUsage(sizeof(memusage::unordered_node<std::pair<const uint256, uint256> >)) * mapTxLockVotesOrphanByTx.size() +
+           memusage::MallocUsage(sizeof(void*) * mapTxLockVotesOrphanByTx.bucket_count()) +
+           memusage::DynamicUsage(mapTxLockCandidates) + nCandidateVotes * nCandidateVoteUsage +
+           memusage::DynamicUsage(mapVotedOutpoints) +
+           memusage::DynamicUsage(mapLockedOutpoints) +
+           memusage::DynamicUsage(mapMasternodeOrphanVotes) +
+           memusage::DynamicUsage(setTxLockCandidatesByHeight) +
+           memusage::DynamicUsage(setTxLockVotesByHeight) +
+           memusage::DynamicUsage(setTxLockVotesByTime) +
+           memusage::DynamicUsage(setTxLockVotesOrphanByTime);
+}
+
+bool CInstantSend::IsMemoryLimitReached()
+{
+    AssertLockHeld(cs_instantsend);
+    // orphan votes are the cheapest to lose, they are asked for again if their lock request shows up
+    while(DynamicMemoryUsage() > nMaxUsage && !setTxLockVotesOrphanByTime.empty()) {
+        uint256 nVoteHash = setTxLockVotesOrphanByTime.begin()->second;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::%s -- Evicting orphan vote %s\n", __func__, nVoteHash.ToString());
+        auto itVote = mapTxLockVotes.find(nVoteHash);
+        if(itVote != mapTxLockVotes.end()) {
+            EraseTxLockVote(itVote);
+        }
+        EraseOrphanTxLockVote(mapTxLockVotesOrphan.find(nVoteHash));
     }
+    return DynamicMemoryUsage() > nMaxUsage;
+}
 
-    return total / mapMasternodeOrphanVotes.size();
+void CInstantSend::SetMaxUsage(size_t nMaxUsageIn)
+{
+    LOCK(cs_instantsend);
+    nMaxUsage = nMaxUsageIn;
+}
+
+CInstantSend::Stats CInstantSend::GetStats()
+{
+    LOCK(cs_instantsend);
+    Stats stats;
+    stats.candidates = mapTxLockCandidates.size();
+    stats.votes = mapTxLockVotes.size();
+    stats.orphans = mapTxLockVotesOrphan.size();
+    stats.usage = DynamicMemoryUsage();
+    stats.limit = nMaxUsage;
+    stats.verified = nVotesVerified;
+    stats.finalized = nLockCandidatesFinalized;
+    stats.contended = nLockContended;
+    stats.waited = nLockWaitMicros;
+    return stats;
 }
 
 void CInstantSend::CheckAndRemove()
@@ -726,72 +920,67 @@ void CInstantSend::CheckAndRemove()
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.begin();
+    // Everything below is visited in expiry order, so each loop stops at the
+    // first entry that is still alive instead of walking the whole map.
+    // Locks and votes expire nInstantSendKeepLock blocks after the block corresponding tx was included into.
+    int nExpiredHeight = nCachedBlockHeight - Params().GetConsensus().nInstantSendKeepLock;
+    int64_t nTime = GetTime();
 
     // remove expired candidates
-    while(itLockCandidate != mapTxLockCandidates.end()) {
-        CTxLockCandidate &txLockCandidate = itLockCandidate->second;
-        uint256 txHash = txLockCandidate.GetHash();
-        if(txLockCandidate.IsExpired(nCachedBlockHeight)) {
-            LogPrintf("CInstantSend::CheckAndRemove -- Removing expired Transaction Lock Candidate: txid=%s\n", txHash.ToString());
-            std::map<COutPoint, COutPointLock>::iterator itOutpointLock = txLockCandidate.mapOutPointLocks.begin();
-            while(itOutpointLock != txLockCandidate.mapOutPointLocks.end()) {
-                mapLockedOutpoints.erase(itOutpointLock->first);
-                mapVotedOutpoints.erase(itOutpointLock->first);
-                ++itOutpointLock;
-            }
-            mapLockRequestAccepted.erase(txHash);
-            mapLockRequestRejected.erase(txHash);
-            mapTxLockCandidates.erase(itLockCandidate++);
-        } else {
-            ++itLockCandidate;
+    while(!setTxLockCandidatesByHeight.empty() && setTxLockCandidatesByHeight.begin()->first < nExpiredHeight) {
+        uint256 txHash = setTxLockCandidatesByHeight.begin()->second;
+        auto itLockCandidate = mapTxLockCandidates.find(txHash);
+        LogPrintf("CInstantSend::CheckAndRemove -- Removing expired Transaction Lock Candidate: txid=%s\n", txHash.ToString());
+        for (const auto& outpointLock : itLockCandidate->second.mapOutPointLocks) {
+            mapLockedOutpoints.erase(outpointLock.first);
+            mapVotedOutpoints.erase(outpointLock.first);
         }
+        mapLockRequestAccepted.erase(txHash);
+        mapLockRequestRejected.erase(txHash);
+        EraseTxLockCandidate(itLockCandidate);
     }
 
     // remove expired votes
-    std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsExpired(nCachedBlockHeight)) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
-        }
+    while(!setTxLockVotesByHeight.empty() && setTxLockVotesByHeight.begin()->first < nExpiredHeight) {
+        auto itVote = mapTxLockVotes.find(setTxLockVotesByHeight.begin()->second);
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
+                itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
+        EraseTxLockVote(itVote);
     }
 
     // remove timed out orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.IsTimedOut()) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
-                    itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itOrphanVote->first);
-            mapTxLockVotesOrphan.erase(itOrphanVote++);
-        } else {
-            ++itOrphanVote;
+    while(!setTxLockVotesOrphanByTime.empty() && setTxLockVotesOrphanByTime.begin()->first < nTime - INSTANTSEND_LOCK_TIMEOUT_SECONDS) {
+        auto itOrphanVote = mapTxLockVotesOrphan.find(setTxLockVotesOrphanByTime.begin()->second);
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
+                itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToStringShort());
+        auto itVote = mapTxLockVotes.find(itOrphanVote->first);
+        if(itVote != mapTxLockVotes.end()) {
+            EraseTxLockVote(itVote);
         }
+        EraseOrphanTxLockVote(itOrphanVote);
     }
 
-    // remove invalid votes and votes for failed lock attempts
-    itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsFailed()) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
+    // remove invalid votes and votes for failed lock attempts,
+    // votes of locked transactions stay until they expire by height
+    while(!setTxLockVotesByTime.empty() && setTxLockVotesByTime.begin()->first < nTime - INSTANTSEND_FAILED_TIMEOUT_SECONDS) {
+        auto itVote = mapTxLockVotes.find(setTxLockVotesByTime.begin()->second);
+        if(IsLockedInstantSendTransaction(itVote->second.GetTxHash())) {
+            setTxLockVotesByTime.erase(setTxLockVotesByTime.begin());
+            continue;
         }
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
+                itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
+        EraseTxLockVote(itVote);
     }
 
-    // remove timed out masternode orphan votes (DOS protection)
-    std::map<COutPoint, int64_t>::iterator itMasternodeOrphan = mapMasternodeOrphanVotes.begin();
+    // remove timed out masternode orphan votes (DOS protection), at most one entry per masternode
+    auto itMasternodeOrphan = mapMasternodeOrphanVotes.begin();
     while(itMasternodeOrphan != mapMasternodeOrphanVotes.end()) {
-        if(itMasternodeOrphan->second < GetTime()) {
+        if(itMasternodeOrphan->second < nTime) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan masternode vote: masternode=%s\n",
                     itMasternodeOrphan->first.ToStringShort());
-            mapMasternodeOrphanVotes.erase(itMasternodeOrphan++);
+            nMasternodeOrphanVoteTimeTotal -= itMasternodeOrphan->second;
+            itMasternodeOrphan = mapMasternodeOrphanVotes.erase(itMasternodeOrphan);
         } else {
             ++itMasternodeOrphan;
         }
@@ -829,7 +1018,7 @@ bool CInstantSend::GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLoc
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) return false;
     txLockRequestRet = it->second.txLockRequest;
 
@@ -840,7 +1029,7 @@ bool CInstantSend::GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotes.find(hash);
+    auto it = mapTxLockVotes.find(hash);
     if(it == mapTxLockVotes.end()) return false;
     txLockVoteRet = it->second;
 
@@ -855,7 +1044,7 @@ bool CInstantSend::IsInstantSendReadyToLock(const uint256& txHash)
     LOCK(cs_instantsend);
     // There must be a successfully verified lock request
     // and all outputs must be locked (i.e. have enough signatures)
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     return it != mapTxLockCandidates.end() && it->second.IsAllOutPointsReady();
 }
 
@@ -867,14 +1056,14 @@ bool CInstantSend::IsLockedInstantSendTransaction(const uint256& txHash)
     LOCK(cs_instantsend);
 
     // there must be a lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate == mapTxLockCandidates.end()) return false;
 
     // which should have outpoints
     if(itLockCandidate->second.mapOutPointLocks.empty()) return false;
 
     // and all of these outputs must be included in mapLockedOutpoints with correct hash
-    std::map<COutPoint, COutPointLock>::iterator itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
+    auto itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
     while(itOutpointLock != itLockCandidate->second.mapOutPointLocks.end()) {
         uint256 hashLocked;
         if(!GetLockedOutPointTxHash(itOutpointLock->first, hashLocked) || hashLocked != txHash) return false;
@@ -892,7 +1081,7 @@ int CInstantSend::GetTransactionLockSignatures(const uint256& txHash)
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate != mapTxLockCandidates.end()) {
         return itLockCandidate->second.CountVotes();
     }
@@ -913,7 +1102,7 @@ bool CInstantSend::IsTxLockCandidateTimedOut(const uint256& txHash)
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if (itLockCandidate != mapTxLockCandidates.end()) {
         return !itLockCandidate->second.IsAllOutPointsReady() &&
                 itLockCandidate->second.IsTimedOut();
@@ -926,7 +1115,7 @@ void CInstantSend::Relay(const uint256& txHash, CConnman& connman)
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::const_iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if (itLockCandidate != mapTxLockCandidates.end()) {
         itLockCandidate->second.Relay(connman);
     }
@@ -957,25 +1146,24 @@ void CInstantSend::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex
     LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d\n", txHash.ToString(), nHeightNew);
 
     // Check lock candidates
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate != mapTxLockCandidates.end()) {
         LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d lock candidate updated\n",
                 txHash.ToString(), nHeightNew);
-        itLockCandidate->second.SetConfirmedHeight(nHeightNew);
+        SetTxLockCandidateConfirmedHeight(itLockCandidate->second, nHeightNew);
         // Loop through outpoint locks
-        std::map<COutPoint, COutPointLock>::iterator itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
+        auto itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
         while(itOutpointLock != itLockCandidate->second.mapOutPointLocks.end()) {
             // Check corresponding lock votes
             std::vector<CTxLockVote> vVotes = itOutpointLock->second.GetVotes();
             std::vector<CTxLockVote>::iterator itVote = vVotes.begin();
-            std::map<uint256, CTxLockVote>::iterator it;
             while(itVote != vVotes.end()) {
                 uint256 nVoteHash = itVote->GetHash();
                 LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
                         txHash.ToString(), nHeightNew, nVoteHash.ToString());
-                it = mapTxLockVotes.find(nVoteHash);
+                auto it = mapTxLockVotes.find(nVoteHash);
                 if(it != mapTxLockVotes.end()) {
-                    it->second.SetConfirmedHeight(nHeightNew);
+                    SetTxLockVoteConfirmedHeight(it, nHeightNew);
                 }
                 ++itVote;
             }
@@ -984,14 +1172,14 @@ void CInstantSend::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex
     }
 
     // check orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.GetTxHash() == txHash) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
-                    txHash.ToString(), nHeightNew, itOrphanVote->first.ToString());
-            mapTxLockVotes[itOrphanVote->first].SetConfirmedHeight(nHeightNew);
+    auto range = mapTxLockVotesOrphanByTx.equal_range(txHash);
+    for (auto itOrphanVote = range.first; itOrphanVote != range.second; ++itOrphanVote) {
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
+                txHash.ToString(), nHeightNew, itOrphanVote->second.ToString());
+        auto it = mapTxLockVotes.find(itOrphanVote->second);
+        if(it != mapTxLockVotes.end()) {
+            SetTxLockVoteConfirmedHeight(it, nHeightNew);
         }
-        ++itOrphanVote;
     }
 }
 
@@ -5,8 +5,14 @@
 #define INSTANTX_H
 
 #include <chain.h>
+#include <coins.h>
 #include <net.h>
 #include <primitives/transaction.h>
+#include <txmempool.h>
+
+#include <atomic>
+#include <set>
+#include <unordered_map>
 
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
@@ -47,6 +53,11 @@ static const int INSTANTSEND_LOCK_TIMEOUT_SECONDS   = 15;
 /// must be greater than INSTANTSEND_LOCK_TIMEOUT_SECONDS
 static const int INSTANTSEND_FAILED_TIMEOUT_SECONDS = 60;
 
+//! -instantsendmemory default (MiB)
+static const int64_t DEFAULT_INSTANTSEND_MEMORY     = 32;
+//! max. -instantsendmemory (MiB)
+static const int64_t MAX_INSTANTSEND_MEMORY         = 1024;
+
 extern bool fEnableInstantSend;
 extern int nInstantSendDepth;
 extern int nCompleteTXLocks;
@@ -56,23 +67,72 @@ extern int nCompleteTXLocks;
  */
 class CInstantSend
 {
+public:
+    struct Stats
+    {
+        size_t candidates;  //!< number of lock candidates
+        size_t votes;       //!< number of known votes, orphans included
+        size_t orphans;     //!< number of votes waiting for their lock request
+        size_t usage;       //!< estimated memory used
+        size_t limit;       //!< memory budget, new lock requests and votes are refused above it
+        uint64_t verified;  //!< votes that passed the pre-check
+        uint64_t finalized; //!< locks completed
+        uint64_t contended; //!< times cs_main or cs_instantsend was held by another thread when we wanted it
+        int64_t waited;     //!< microseconds spent waiting for them
+    };
+
 private:
+    typedef std::unordered_map<uint256, CTxLockRequest, SaltedTxidHasher> lock_request_map_t;
+    typedef std::unordered_map<uint256, CTxLockVote, SaltedTxidHasher> lock_vote_map_t;
+    typedef std::unordered_map<uint256, CTxLockCandidate, SaltedTxidHasher> lock_candidate_map_t;
+    /// (height or time, hash) pairs, so cleanup only has to look at the front
+    typedef std::set<std::pair<int, uint256> > height_index_t;
+    typedef std::set<std::pair<int64_t, uint256> > time_index_t;
+
     // Keep track of current block height
     int nCachedBlockHeight;
 
     // maps for AlreadyHave
-    std::map<uint256, CTxLockRequest> mapLockRequestAccepted; ///< Tx hash - Tx
-    std::map<uint256, CTxLockRequest> mapLockRequestRejected; ///< Tx hash - Tx
-    std::map<uint256, CTxLockVote> mapTxLockVotes; ///< Vote hash - Vote
-    std::map<uint256, CTxLockVote> mapTxLockVotesOrphan; ///< Vote hash - Vote
+    lock_request_map_t mapLockRequestAccepted; ///< Tx hash - Tx
+    lock_request_map_t mapLockRequestRejected; ///< Tx hash - Tx
+    lock_vote_map_t mapTxLockVotes; ///< Vote hash - Vote
+    lock_vote_map_t mapTxLockVotesOrphan; ///< Vote hash - Vote
+    std::unordered_multimap<uint256, uint256, SaltedTxidHasher> mapTxLockVotesOrphanByTx; ///< Tx hash - Vote hash
 
-    std::map<uint256, CTxLockCandidate> mapTxLockCandidates; ///< Tx hash - Lock candidate
+    lock_candidate_map_t mapTxLockCandidates; ///< Tx hash - Lock candidate
 
-    std::map<COutPoint, std::set<uint256> > mapVotedOutpoints; ///< UTXO - Tx hash set
-    std::map<COutPoint, uint256> mapLockedOutpoints; ///< UTXO - Tx hash
+    std::unordered_map<COutPoint, std::set<uint256>, SaltedOutpointHasher> mapVotedOutpoints; ///< UTXO - Tx hash set
+    std::unordered_map<COutPoint, uint256, SaltedOutpointHasher> mapLockedOutpoints; ///< UTXO - Tx hash
 
     /// Track masternodes who voted with no txlockrequest (for DOS protection)
-    std::map<COutPoint, int64_t> mapMasternodeOrphanVotes; ///< MN outpoint - Time
+    std::unordered_map<COutPoint, int64_t, SaltedOutpointHasher> mapMasternodeOrphanVotes; ///< MN outpoint - Time
+    int64_t nMasternodeOrphanVoteTimeTotal;
+
+    // expiry order of the maps above
+    height_index_t setTxLockCandidatesByHeight; ///< Confirmed height - Tx hash, confirmed candidates only
+    height_index_t setTxLockVotesByHeight; ///< Confirmed height - Vote hash, confirmed votes only
+    time_index_t setTxLockVotesByTime; ///< Time created - Vote hash, votes that may still fail
+    time_index_t setTxLockVotesOrphanByTime; ///< Time created - Vote hash
+
+    size_t nMaxUsage;
+
+    // lock contention counters, see Stats
+    std::atomic<uint64_t> nVotesVerified;
+    std::atomic<uint64_t> nLockCandidatesFinalized;
+    std::atomic<uint64_t> nLockContended;
+    std::atomic<int64_t> nLockWaitMicros;
+
+    void AddTxLockVote(const uint256& nVoteHash, const CTxLockVote& vote);
+    void EraseTxLockVote(lock_vote_map_t::iterator it);
+    void SetTxLockVoteConfirmedHeight(lock_vote_map_t::iterator it, int nHeight);
+    void AddOrphanTxLockVote(const uint256& nVoteHash, const CTxLockVote& vote);
+    void EraseOrphanTxLockVote(lock_vote_map_t::iterator it);
+    void EraseTxLockCandidate(lock_candidate_map_t::iterator it);
+    void SetTxLockCandidateConfirmedHeight(CTxLockCandidate& txLockCandidate, int nHeight);
+
+    size_t DynamicMemoryUsage();
+    /// Drop the oldest orphan votes while over the memory budget, true if that was not enough
+    bool IsMemoryLimitReached();
 
     bool CreateTxLockCandidate(const CTxLockRequest& txLockRequest);
     void CreateEmptyTxLockCandidate(const uint256& txHash);
@@ -80,15 +140,12 @@ private:
 
     /// Process consensus vote message
     bool ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, CConnman& connman);
+    /// Take cs_main, the wallets and the mempool and try to complete the lock of txHash
+    void FinalizeTxLockCandidate(const uint256& txHash);
 
     void UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidate& txLockCandidate);
-#ifdef ENABLE_WALLET
-    bool ProcessOrphanTxLockVote(const CTxLockVote& vote, CWallet *wallet);
-    void ProcessOrphanTxLockVotes(CWallet *wallet);
-#else
     bool ProcessOrphanTxLockVote(const CTxLockVote& vote);
-    void ProcessOrphanTxLockVotes();
-#endif
+    void ProcessOrphanTxLockVotes(const uint256& txHash);
     int64_t GetAverageMasternodeOrphanVoteTime();
 
 #ifdef ENABLE_WALLET
@@ -110,9 +167,13 @@ private:
 public:
     CCriticalSection cs_instantsend;
 
+    CInstantSend();
+
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
     bool ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CConnman& connman);
+    /// Commit phase of a vote that passed CTxLockVote::IsValid, takes cs_main only if the vote completes a lock
+    bool AddVerifiedTxLockVote(const CTxLockVote& vote);
     void Vote(const uint256& txHash, CConnman& connman);
 
     bool AlreadyHave(const uint256& hash);
@@ -143,7 +204,13 @@ public:
     void UpdatedBlockTip(const CBlockIndex *pindex);
     void SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pindex = nullptr, int posInBlock = 0);
 
+    /** Change the memory budget, see IsMemoryLimitReached. */
+    void SetMaxUsage(size_t nMaxUsageIn);
+    Stats GetStats();
+
     std::string ToString();
+
+    friend struct CInstantSendTest;
 };
 
 /**
@@ -254,8 +321,10 @@ public:
     uint256 GetTxHash() const { return txHash; }
     COutPoint GetOutpoint() const { return outpoint; }
     COutPoint GetMasternodeOutpoint() const { return outpointMasternode; }
+    int64_t GetTimeCreated() const { return nTimeCreated; }
 
     bool IsValid(CNode* pnode, CConnman& connman) const;
+    int GetConfirmedHeight() const { return nConfirmedHeight; }
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
@@ -328,6 +397,7 @@ public:
     bool HasMasternodeVoted(const COutPoint& outpointIn, const COutPoint& outpointMasternodeIn);
     int CountVotes() const;
 
+    int GetConfirmedHeight() const { return nConfirmedHeight; }
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
@@ -0,0 +1,112 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-collateral.h>
+
+#include <primitives/block.h>
+#include <validation.h>
+
+CCollateralWatch collateralwatch;
+
+int CCollateralWatch::GetHeight(const COutPoint& outpoint)
+{
+    while (true) {
+        uint64_t nBlocksNotifiedRead;
+        {
+            LOCK(cs);
+            auto it = mapCollaterals.find(outpoint);
+            if (it != mapCollaterals.end() && (it->second.fSpent || it->second.fHeightKnown)) {
+                return it->second.fSpent ? -1 : it->second.nHeight;
+            }
+            nBlocksNotifiedRead = nBlocksNotified;
+        }
+
+        // GetUTXOCoin takes cs_main so don't hold cs
+        Coin coin;
+        const bool fUnspent = GetUTXOCoin(outpoint, coin);
+
+        LOCK(cs);
+        // a block notified meanwhile may be newer than what was read, read again
+        if (nBlocksNotified != nBlocksNotifiedRead) continue;
+        CCollateralState& state = mapCollaterals[outpoint];
+        state.nHeight = fUnspent ? (int)coin.nHeight : -1;
+        state.fHeightKnown = fUnspent;
+        state.fSpent = !fUnspent;
+        return state.nHeight;
+    }
+}
+
+void CCollateralWatch::Unwatch(const COutPoint& outpoint)
+{
+    LOCK(cs);
+    mapCollaterals.erase(outpoint);
+}
+
+void CCollateralWatch::Clear()
+{
+    LOCK(cs);
+    mapCollaterals.clear();
+}
+
+size_t CCollateralWatch::size() const
+{
+    LOCK(cs);
+    return mapCollaterals.size();
+}
+
+void CCollateralWatch::BlockConnected(const CBlock& block, int nHeight)
+{
+    LOCK(cs);
+    nBlocksNotified++;
+    if (mapCollaterals.empty()) return;
+
+    for (const CTransactionRef& ptx : block.vtx) {
+        if (!ptx->IsCoinBase()) {
+            for (const CTxIn& txin : ptx->vin) {
+                auto it = mapCollaterals.find(txin.prevout);
+                if (it != mapCollaterals.end()) {
+                    it->second.fSpent = true;
+                }
+            }
+        }
+        // a collateral that came back into the chain after a reorg
+        const uint256& hash = ptx->GetHash();
+        for (uint32_t i = 0; i < ptx->vout.size(); i++) {
+            auto it = mapCollaterals.find(COutPoint(hash, i));
+            if (it != mapCollaterals.end()) {
+                it->second.nHeight = nHeight;
+                it->second.fHeightKnown = true;
+                it->second.fSpent = false;
+            }
+        }
+    }
+}
+
+void CCollateralWatch::BlockDisconnected(const CBlock& block)
+{
+    LOCK(cs);
+    nBlocksNotified++;
+    if (mapCollaterals.empty()) return;
+
+    // undo in reverse order, a coin created and spent in the same block ends up out of the chain
+    for (auto itTx = block.vtx.rbegin(); itTx != block.vtx.rend(); ++itTx) {
+        const CTransactionRef& ptx = *itTx;
+        const uint256& hash = ptx->GetHash();
+        for (uint32_t i = 0; i < ptx->vout.size(); i++) {
+            auto it = mapCollaterals.find(COutPoint(hash, i));
+            if (it != mapCollaterals.end()) {
+                it->second.nHeight = -1;
+                it->second.fHeightKnown = true;
+            }
+        }
+        if (ptx->IsCoinBase()) continue;
+        // the coin is back, if it was first seen spent GetHeight reads its height again
+        for (const CTxIn& txin : ptx->vin) {
+            auto it = mapCollaterals.find(txin.prevout);
+            if (it != mapCollaterals.end()) {
+                it->second.fSpent = false;
+            }
+        }
+    }
+}
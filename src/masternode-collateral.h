@@ -0,0 +1,62 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MASTERNODE_COLLATERAL_H
+#define MASTERNODE_COLLATERAL_H
+
+#include <coins.h>
+#include <sync.h>
+
+#include <unordered_map>
+
+class CBlock;
+class CCollateralWatch;
+
+extern CCollateralWatch collateralwatch;
+
+/**
+ * Chain state of the masternode collaterals, kept up to date from the blocks
+ * CHUNTNotificationInterface sees connected and disconnected, so that checking
+ * a masternode doesn't have to look its collateral up in pcoinsTip.
+ *
+ * A collateral is watched from the first time it is asked for, when the UTXO
+ * set is read for it. It is only read again if a spend is undone before the
+ * height of the coin is known. Block notifications are delivered
+ * asynchronously, so the watch may lag the tip by the blocks that are still
+ * queued; reading them again is harmless, as each only sets the state the
+ * block leaves the collateral in.
+ */
+class CCollateralWatch
+{
+private:
+    struct CCollateralState
+    {
+        // height of the block that created the coin, -1 while it isn't in the chain
+        int nHeight;
+        // false if the coin was already spent or not yet in the chain when first read
+        bool fHeightKnown;
+        // spent, or not in the UTXO set when it was read
+        bool fSpent;
+    };
+
+    mutable CCriticalSection cs;
+    std::unordered_map<COutPoint, CCollateralState, SaltedOutpointHasher> mapCollaterals;
+    // block notifications so far, to tell whether one raced a read of the UTXO set
+    uint64_t nBlocksNotified;
+
+public:
+    CCollateralWatch() : nBlocksNotified(0) {}
+
+    /// Height of the unspent coin at outpoint, -1 if it is spent or not in the chain; starts watching outpoint
+    int GetHeight(const COutPoint& outpoint);
+    /// Stop watching outpoint, e.g. because its masternode was removed
+    void Unwatch(const COutPoint& outpoint);
+    void Clear();
+    size_t size() const;
+
+    void BlockConnected(const CBlock& block, int nHeight);
+    void BlockDisconnected(const CBlock& block);
+};
+
+#endif // MASTERNODE_COLLATERAL_H
@@ -6,59 +6,108 @@
 #include <masternode-helper.h>
 
 #include <activemasternode.h>
+#include <cache-database.h>
 #include <init.h>
 #include <instantx.h>
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <netfulfilledman.h>
+#include <scheduler.h>
 
-void ThreadCheckMasternodes(CConnman& connman)
+#include <atomic>
+
+static CScheduler* pscheduler = nullptr;
+static CConnman* pconnman = nullptr;
+
+// set while a cleanup is queued on the scheduler, so that a burst of events queues only one
+static std::atomic<bool> fCleanupQueued(false);
+static std::atomic<int64_t> nLastCleanupTime(0);
+
+static bool IsMaintenanceActive()
 {
-    if(fLiteMode) return; // disable all Huntcoin specific functionality
+    return masternodeSync.IsBlockchainSynced() && !ShutdownRequested();
+}
 
-    static bool fOneThread;
-    if(fOneThread) return;
-    fOneThread = true;
+static void MasternodeTick()
+{
+    // try to sync from all available nodes, one step at a time
+    masternodeSync.ProcessTick(*pconnman);
 
-    // Make this thread recognisable as the MasternodeCheck thread
-    RenameThread("huntcoin-mncheck");
+    if(!IsMaintenanceActive()) return;
 
-    unsigned int nTick = 0;
+    // only visits the masternodes whose MASTERNODE_CHECK_SECONDS have passed
+    mnodeman.CheckDue();
 
-    while (true)
-    {
-        MilliSleep(1000);
+    mnodeman.ProcessPendingMessages(*pconnman);
+    mnodeman.ProcessPendingMnbRequests(*pconnman);
+    mnodeman.ProcessPendingMnvRequests(*pconnman);
+}
 
-        // try to sync from all available nodes, one step at a time
-        masternodeSync.ProcessTick(connman);
+static void MasternodeCleanup()
+{
+    // events that come in while this runs queue the next cleanup
+    nLastCleanupTime = GetTime();
+    fCleanupQueued = false;
 
-        if(masternodeSync.IsBlockchainSynced() && !ShutdownRequested()) {
+    if(!IsMaintenanceActive()) return;
 
-            nTick++;
+    netfulfilledman.CheckAndRemove();
+    mnodeman.ProcessMasternodeConnections(*pconnman);
+    mnodeman.CheckAndRemove(*pconnman);
+    mnodeman.WarnMasternodeDaemonUpdates();
+    mnpayments.CheckAndRemove();
+    instantsend.CheckAndRemove();
+}
+
+void RequestMasternodeCleanup()
+{
+    if(!pscheduler || fCleanupQueued.exchange(true)) return;
+
+    int64_t nDelay = std::max<int64_t>(0, nLastCleanupTime + MASTERNODE_CLEANUP_SECONDS - GetTime());
+    pscheduler->scheduleFromNow(&MasternodeCleanup, nDelay * 1000);
+}
+
+static void ManageActiveMasternode()
+{
+    if(IsMaintenanceActive()) {
+        activeMasternode.ManageState(*pconnman);
+    }
+}
+
+static void MasternodeVerificationStep()
+{
+    if(IsMaintenanceActive()) {
+        mnodeman.DoFullVerificationStep(*pconnman);
+    }
+}
+
+static void FlushMasternodeCachesIfSynced()
+{
+    // only the changes since the last flush are written, so a crash loses at most this much
+    if(IsMaintenanceActive()) {
+        FlushMasternodeCaches();
+    }
+}
+
+void StartMasternodeMaintenance(CScheduler& scheduler, CConnman& connman)
+{
+    if(fLiteMode) return; // disable all Huntcoin specific functionality
 
-            // make sure to check all masternodes first
-            mnodeman.Check();
+    pscheduler = &scheduler;
+    pconnman = &connman;
 
-            mnodeman.ProcessPendingMnbRequests(connman);
-            mnodeman.ProcessPendingMnvRequests(connman);
+    scheduler.scheduleEvery(&MasternodeTick, 1000);
 
-            // check if we should activate or ping every few minutes,
-            // slightly postpone first run to give net thread a chance to connect to some peers
-            if(nTick % MASTERNODE_MIN_MNP_SECONDS == 15)
-                activeMasternode.ManageState(connman);
+    // check if we should activate or ping every few minutes,
+    // slightly postpone first run to give net thread a chance to connect to some peers
+    scheduler.scheduleFromNow([&scheduler] {
+        ManageActiveMasternode();
+        scheduler.scheduleEvery(&ManageActiveMasternode, MASTERNODE_MIN_MNP_SECONDS * 1000);
+    }, 15 * 1000);
 
-            if(nTick % 60 == 0) {
-                netfulfilledman.CheckAndRemove();
-                mnodeman.ProcessMasternodeConnections(connman);
-                mnodeman.CheckAndRemove(connman);
-                mnodeman.WarnMasternodeDaemonUpdates();
-                mnpayments.CheckAndRemove();
-                instantsend.CheckAndRemove();
-            }
-            if(fMasternodeMode && (nTick % (60 * 5) == 0)) {
-                mnodeman.DoFullVerificationStep(connman);
-            }
-        }
+    if(fMasternodeMode) {
+        scheduler.scheduleEvery(&MasternodeVerificationStep, 60 * 5 * 1000);
     }
-}
\ No newline at end of file
+    scheduler.scheduleEvery(&FlushMasternodeCachesIfSynced, 60 * 10 * 1000);
+}
@@ -7,7 +7,19 @@
 #define MASTERNODE_HELPER_H
 
 class CConnman;
+class CScheduler;
 
-void ThreadCheckMasternodes(CConnman& connman);
+/** Minimum number of seconds between two runs of the masternode cleanup */
+static const int MASTERNODE_CLEANUP_SECONDS = 60;
 
-#endif // MASTERNODE_HELPER_H
\ No newline at end of file
+/** Schedule the periodic masternode tasks (sync, checks, pings, verification, cache flushes) on scheduler */
+void StartMasternodeMaintenance(CScheduler& scheduler, CConnman& connman);
+
+/**
+ * Ask for the CheckAndRemove pass over the masternode, payment, InstantSend and
+ * fulfilled request caches, e.g. because a block or masternode message came in.
+ * Runs on the scheduler at most once every MASTERNODE_CLEANUP_SECONDS.
+ */
+void RequestMasternodeCleanup();
+
+#endif // MASTERNODE_HELPER_H
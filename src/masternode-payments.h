@@ -28,7 +28,7 @@ static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION_2 = 80001;
 
 extern CCriticalSection cs_vecPayees;
 extern CCriticalSection cs_mapMasternodeBlocks;
-extern CCriticalSection cs_mapMasternodePayeeVotes;
+extern CCriticalSection cs_mapMasternodePaymentVotes;
 
 extern CMasternodePayments mnpayments;
 
@@ -201,6 +201,14 @@ public:
         READWRITE(mapMasternodeBlocks);
     }
 
+    /// Hand every map that makes up the cache to visitor, see CCacheDB
+    template <typename Visitor>
+    void VisitCacheMaps(Visitor& visitor) {
+        LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+        visitor('v', mapMasternodePaymentVotes);
+        visitor('k', mapMasternodeBlocks);
+    }
+
     void Clear();
 
     bool AddOrUpdatePaymentVote(const CMasternodePaymentVote& vote);
@@ -215,6 +223,8 @@ public:
     bool GetBlockPayee(int nBlockHeight, CScript& payeeRet) const;
     bool IsTransactionValid(const CTransaction& txNew, int nBlockHeight) const;
     bool IsScheduled(const masternode_info_t& mnInfo, int nNotBlockHeight) const;
+    /// The payees IsScheduled compares against, to check many masternodes at once
+    void GetScheduledPayees(int nNotBlockHeight, std::set<CScript>& setPayeesRet) const;
 
     bool UpdateLastVote(const CMasternodePaymentVote& vote);
 
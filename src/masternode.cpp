@@ -9,6 +9,7 @@
 #include <init.h>
 #include <netbase.h>
 #include <masternode.h>
+#include <masternode-collateral.h>
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
@@ -142,8 +143,7 @@ void CMasternode::Check(bool fForce)
 
     int nHeight = 0;
     if(!fUnitTest) {
-        Coin coin;
-        if(!GetUTXOCoin(outpoint, coin)) {
+        if(collateralwatch.GetHeight(outpoint) < 0) {
             nActiveState = MASTERNODE_OUTPOINT_SPENT;
             LogPrint(BCLog::MASTERNODE, "CMasternode::Check -- Failed to find Masternode UTXO, masternode=%s\n", outpoint.ToStringShort());
             return;
@@ -592,6 +592,21 @@ uint256 CMasternodeBroadcast::GetSignatureHash() const
     return ss.GetHash();
 }
 
+std::string CMasternodeBroadcast::GetSignatureMessage() const
+{
+    return addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
+            pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
+            boost::lexical_cast<std::string>(nProtocolVersion);
+}
+
+CRecoverSigKeyCheck CMasternodeBroadcast::PrepareSigKeyRecovery()
+{
+    recoveredSigKey.hash = sporkManager.IsSporkActive(SPORK_4_NEW_SIGS) ?
+            GetSignatureHash() : CMessageSigner::GetMessageHash(GetSignatureMessage());
+    recoveredSigKey.vchSig = vchSig;
+    return CRecoverSigKeyCheck(recoveredSigKey);
+}
+
 bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 {
     std::string strError;
@@ -611,9 +626,7 @@ bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
             return false;
         }
     } else {
-        std::string strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                        pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                        boost::lexical_cast<std::string>(nProtocolVersion);
+        std::string strMessage = GetSignatureMessage();
 
         if (!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress)) {
             LogPrintf("CMasternodeBroadcast::Sign -- SignMessage() failed\n");
@@ -637,13 +650,11 @@ bool CMasternodeBroadcast::CheckSignature(int& nDos) const
     if (sporkManager.IsSporkActive(SPORK_4_NEW_SIGS)) {
         uint256 hash = GetSignatureHash();
 
-        if (!CHashSigner::VerifyHash(hash, pubKeyCollateralAddress, vchSig, strError)) {
+        if (!CHashSigner::VerifyHash(hash, pubKeyCollateralAddress, vchSig, strError, &recoveredSigKey)) {
             // maybe it's in old format
-            std::string strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                            pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                            boost::lexical_cast<std::string>(nProtocolVersion);
+            std::string strMessage = GetSignatureMessage();
 
-            if (!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)){
+            if (!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError, &recoveredSigKey)){
                 // nope, not in old format either
                 LogPrintf("CMasternodeBroadcast::CheckSignature -- Got bad Masternode announce signature, error: %s\n", strError);
                 nDos = 100;
@@ -651,11 +662,9 @@ bool CMasternodeBroadcast::CheckSignature(int& nDos) const
             }
         }
     } else {
-        std::string strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                        pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                        boost::lexical_cast<std::string>(nProtocolVersion);
+        std::string strMessage = GetSignatureMessage();
 
-        if (!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)){
+        if (!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError, &recoveredSigKey)){
             LogPrintf("CMasternodeBroadcast::CheckSignature -- Got bad Masternode announce signature, error: %s\n", strError);
             nDos = 100;
             return false;
@@ -700,6 +709,20 @@ uint256 CMasternodePing::GetSignatureHash() const
     return GetHash();
 }
 
+std::string CMasternodePing::GetSignatureMessage() const
+{
+    return CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() +
+            boost::lexical_cast<std::string>(sigTime);
+}
+
+CRecoverSigKeyCheck CMasternodePing::PrepareSigKeyRecovery()
+{
+    recoveredSigKey.hash = sporkManager.IsSporkActive(SPORK_4_NEW_SIGS) ?
+            GetSignatureHash() : CMessageSigner::GetMessageHash(GetSignatureMessage());
+    recoveredSigKey.vchSig = vchSig;
+    return CRecoverSigKeyCheck(recoveredSigKey);
+}
+
 CMasternodePing::CMasternodePing(const COutPoint& outpoint)
 {
     LOCK(cs_main);
@@ -730,8 +753,7 @@ bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMaste
             return false;
         }
     } else {
-        std::string strMessage = CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() +
-                    boost::lexical_cast<std::string>(sigTime);
+        std::string strMessage = GetSignatureMessage();
 
         if (!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
             LogPrintf("CMasternodePing::Sign -- SignMessage() failed\n");
@@ -755,21 +777,19 @@ bool CMasternodePing::CheckSignature(const CPubKey& pubKeyMasternode, int &nDos)
     if (sporkManager.IsSporkActive(SPORK_4_NEW_SIGS)) {
         uint256 hash = GetSignatureHash();
 
-        if (!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
-            std::string strMessage = CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() +
-                        boost::lexical_cast<std::string>(sigTime);
+        if (!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError, &recoveredSigKey)) {
+            std::string strMessage = GetSignatureMessage();
 
-            if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+            if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError, &recoveredSigKey)) {
                 LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", masternodeOutpoint.ToStringShort(), strError);
                 nDos = 33;
                 return false;
             }
         }
     } else {
-        std::string strMessage = CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() +
-                    boost::lexical_cast<std::string>(sigTime);
+        std::string strMessage = GetSignatureMessage();
 
-        if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+        if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError, &recoveredSigKey)) {
             LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", masternodeOutpoint.ToStringShort(), strError);
             nDos = 33;
             return false;
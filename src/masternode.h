@@ -6,6 +6,7 @@
 #define MASTERNODE_H
 
 #include <key.h>
+#include <messagesigner.h>
 #include <validation.h>
 #include <spork.h>
 
@@ -37,6 +38,8 @@ public:
     std::vector<unsigned char> vchSig{};
     // MSB is always 0, other 3 bits corresponds to x.x.x version scheme
     uint32_t nDaemonVersion{DEFAULT_DAEMON_VERSION};
+    // signing key recovered ahead of time, not serialized
+    CRecoveredSigKey recoveredSigKey{};
 
     CMasternodePing() = default;
 
@@ -83,6 +86,10 @@ public:
 
     uint256 GetHash() const;
     uint256 GetSignatureHash() const;
+    /// Message signed in the old (pre SPORK_4_NEW_SIGS) format
+    std::string GetSignatureMessage() const;
+    /// Check recovering the signing key into recoveredSigKey for the hash CheckSignature verifies
+    CRecoverSigKeyCheck PrepareSigKeyRecovery();
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > MASTERNODE_NEW_START_REQUIRED_SECONDS; }
 
@@ -318,6 +325,8 @@ class CMasternodeBroadcast : public CMasternode
 public:
 
     bool fRecovery;
+    // signing key recovered ahead of time, not serialized
+    CRecoveredSigKey recoveredSigKey{};
 
     CMasternodeBroadcast() : CMasternode(), fRecovery(false) {}
     CMasternodeBroadcast(const CMasternode& mn) : CMasternode(mn), fRecovery(false) {}
@@ -358,6 +367,10 @@ public:
 
     uint256 GetHash() const;
     uint256 GetSignatureHash() const;
+    /// Message signed in the old (pre SPORK_4_NEW_SIGS) format
+    std::string GetSignatureMessage() const;
+    /// Check recovering the signing key into recoveredSigKey for the hash CheckSignature verifies
+    CRecoverSigKeyCheck PrepareSigKeyRecovery();
 
     /// Create Masternode broadcast, needs to be relayed manually after that
     static bool Create(const COutPoint& outpoint, const CService& service, const CKey& keyCollateralAddressNew, const CPubKey& pubKeyCollateralAddressNew, const CKey& keyMasternodeNew, const CPubKey& pubKeyMasternodeNew, std::string &strErrorRet, CMasternodeBroadcast &mnbRet);
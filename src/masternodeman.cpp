@@ -5,7 +5,10 @@
 
 #include <activemasternode.h>
 #include <addrman.h>
+#include <checkqueue.h>
 #include <clientversion.h>
+#include <consensus/consensus.h>
+#include <masternode-collateral.h>
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
@@ -24,15 +27,6 @@ const std::string CMasternodeMan::SERIALIZATION_VERSION_STRING = "CMasternodeMan
 const int CMasternodeMan::LAST_PAID_SCAN_BLOCKS = 100;
 const int CMasternodeMan::MAX_POSE_CONNECTIONS = 10;
 
-struct CompareLastPaidBlock
-{
-    bool operator()(const std::pair<int, const CMasternode*>& t1,
-                    const std::pair<int, const CMasternode*>& t2) const
-    {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->outpoint < t2.second->outpoint);
-    }
-};
-
 struct CompareScoreMN
 {
     bool operator()(const std::pair<arith_uint256, const CMasternode*>& t1,
@@ -42,6 +36,26 @@ struct CompareScoreMN
     }
 };
 
+int CMasternodeListSnapshot::CountMasternodes(int nProtocolVersion) const
+{
+    int nCount = 0;
+    for (const auto& pmn : vecMasternodes) {
+        if(pmn->nProtocolVersion < nProtocolVersion) continue;
+        nCount++;
+    }
+    return nCount;
+}
+
+int CMasternodeListSnapshot::CountEnabled(int nProtocolVersion) const
+{
+    int nCount = 0;
+    for (const auto& pmn : vecMasternodes) {
+        if(pmn->nProtocolVersion < nProtocolVersion || !pmn->IsEnabled()) continue;
+        nCount++;
+    }
+    return nCount;
+}
+
 struct CompareByAddr
 
 {
@@ -62,12 +76,24 @@ CMasternodeMan::CMasternodeMan():
     mMnbRecoveryRequests(),
     mMnbRecoveryGoodReplies(),
     listScheduledMnbRequestConnections(),
+    mapRankTables(),
+    listRankTableKeys(),
+    nRankTableHits(0),
+    nRankTableMisses(0),
+    pSnapshot(std::make_shared<const CMasternodeListSnapshot>()),
     fMasternodesAdded(false),
     fMasternodesRemoved(false),
     mapSeenMasternodeBroadcast(),
     mapSeenMasternodePing()
 {}
 
+static CCheckQueue<CRecoverSigKeyCheck> sigkeycheckqueue(128);
+
+void ThreadMasternodeSigCheck() {
+    RenameThread("huntcoin-mnsigchk");
+    sigkeycheckqueue.Thread();
+}
+
 bool CMasternodeMan::Add(CMasternode &mn)
 {
     LOCK(cs);
@@ -77,6 +103,9 @@ bool CMasternodeMan::Add(CMasternode &mn)
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.outpoint] = mn;
     fMasternodesAdded = true;
+    InvalidateRankTables();
+    UpdatePaymentQueue(mn);
+    ScheduleCheck(mn);
     return true;
 }
 
@@ -138,6 +167,63 @@ void CMasternodeMan::Check()
         // since the last time, so expect some MNs to skip this
         mnpair.second.Check();
     }
+
+    PublishSnapshot();
+}
+
+void CMasternodeMan::CheckDue()
+{
+    int64_t nNow = GetTime();
+    {
+        // don't take cs_main just to find out that nothing is due
+        LOCK(cs);
+        if (heapCheckDeadlines.empty() || heapCheckDeadlines.top().first > nNow) return;
+    }
+
+    LOCK2(cs_main, cs);
+
+    bool fChecked = false;
+    while (!heapCheckDeadlines.empty() && heapCheckDeadlines.top().first <= nNow) {
+        check_deadline_t deadline = heapCheckDeadlines.top();
+        heapCheckDeadlines.pop();
+
+        auto it = mapCheckDeadlines.find(deadline.second);
+        if (it == mapCheckDeadlines.end() || it->second != deadline.first) continue;
+        CMasternode* pmn = Find(deadline.second);
+        if (!pmn) {
+            mapCheckDeadlines.erase(it);
+            continue;
+        }
+
+        // NOTE: skips the masternode if something else checked it in the meantime,
+        // it is then rescheduled for MASTERNODE_CHECK_SECONDS after that check
+        pmn->Check();
+        fChecked = true;
+        ScheduleCheck(*pmn);
+    }
+
+    if (fChecked) {
+        PublishSnapshot();
+    }
+}
+
+void CMasternodeMan::ScheduleCheck(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    // never in the past, Check doesn't move nTimeLastChecked during shutdown
+    int64_t nDeadline = std::max(mn.nTimeLastChecked + MASTERNODE_CHECK_SECONDS, GetTime() + 1);
+    mapCheckDeadlines[mn.outpoint] = nDeadline;
+    heapCheckDeadlines.emplace(nDeadline, mn.outpoint);
+}
+
+void CMasternodeMan::RebuildCheckDeadlines()
+{
+    AssertLockHeld(cs);
+    heapCheckDeadlines = decltype(heapCheckDeadlines)();
+    mapCheckDeadlines.clear();
+    for (const auto& mnpair : mapMasternodes) {
+        ScheduleCheck(mnpair.second);
+    }
 }
 
 void CMasternodeMan::CheckAndRemove(CConnman& connman)
@@ -170,8 +256,12 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                 mWeAskedForMasternodeListEntry.erase(it->first);
 
                 // and finally remove it from the list
+                RemoveFromPaymentQueue(it->first);
+                mapCheckDeadlines.erase(it->first);
+                collateralwatch.Unwatch(it->first);
                 mapMasternodes.erase(it++);
                 fMasternodesRemoved = true;
+                InvalidateRankTables();
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
                             masternodeSync.IsSynced() &&
@@ -315,6 +405,8 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
             }
         }
 
+        PublishSnapshot();
+
         LogPrintf("CMasternodeMan::CheckAndRemove -- %s\n", ToString());
     }
 
@@ -327,11 +419,18 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    InvalidateRankTables();
+    setPaymentQueue.clear();
+    mapPaymentQueue.clear();
+    heapCheckDeadlines = decltype(heapCheckDeadlines)();
+    mapCheckDeadlines.clear();
+    collateralwatch.Clear();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
     mapSeenMasternodeBroadcast.clear();
     mapSeenMasternodePing.clear();
+    PublishSnapshot();
 }
 
 int CMasternodeMan::CountMasternodes(int nProtocolVersion)
@@ -489,41 +588,63 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
     // Need LOCK2 here to ensure consistent locking order because the GetBlockHash call below locks cs_main
     LOCK2(cs_main,cs);
 
-    std::vector<std::pair<int, const CMasternode*> > vecMasternodeLastPaid;
+    int nMnCount = CountMasternodes();
+    int nMinProtocol = mnpayments.GetMinMasternodePaymentsProto();
+    int64_t nAdjustedTime = GetAdjustedTime();
+    std::set<CScript> setScheduledPayees;
+    mnpayments.GetScheduledPayees(nBlockHeight, setScheduledPayees);
 
     /*
-        Make a vector with all of the last paid times
+        Walk the payment queue from the longest unpaid masternode on, it is
+        already sorted by last paid block. Only the oldest tenth of the network
+        is kept for scoring below, the rest is just counted.
     */
 
-    int nMnCount = CountMasternodes();
+    int nTenthNetwork = nMnCount/10;
+    std::vector<const CMasternode*> vecOldestMasternodes;
+
+    bool fQueueStale = mapPaymentQueue.size() != mapMasternodes.size();
+    for (auto itQueued = setPaymentQueue.begin(); !fQueueStale && itQueued != setPaymentQueue.end(); ++itQueued) {
+        const payment_queue_key_t& queued = *itQueued;
+        auto itMn = mapMasternodes.find(queued.second);
+        auto itEntry = mapPaymentQueue.find(queued.second);
+        if (itMn == mapMasternodes.end() || itEntry == mapPaymentQueue.end()) {
+            fQueueStale = true;
+            break;
+        }
+        const CMasternode& mn = itMn->second;
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(!mnpair.second.IsValidForPayment()) continue;
+        if(!mn.IsValidForPayment()) continue;
 
         //check protocol version
-        if(mnpair.second.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
-
-        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if(mnpayments.IsScheduled(mnpair.second, nBlockHeight)) continue;
+        if(mn.nProtocolVersion < nMinProtocol) continue;
 
         //it's too new, wait for a cycle
-        if(fFilterSigTime && mnpair.second.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
+        if(fFilterSigTime && mn.sigTime + (nMnCount*2.6*60) > nAdjustedTime) continue;
+
+        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
+        if(!setScheduledPayees.empty() && setScheduledPayees.count(GetScriptForDestination(mn.pubKeyCollateralAddress.GetID()))) continue;
 
         //make sure it has at least as many confirmations as there are masternodes
-        if(GetUTXOConfirmations(mnpair.first) < nMnCount) continue;
+        if(GetCollateralConfirmations(queued.second, itEntry->second) < nMnCount) continue;
 
-        vecMasternodeLastPaid.push_back(std::make_pair(mnpair.second.GetLastPaidBlock(), &mnpair.second));
+        if(nCountRet == 0 || nCountRet < nTenthNetwork) {
+            vecOldestMasternodes.push_back(&mn);
+        }
+        nCountRet++;
     }
 
-    nCountRet = (int)vecMasternodeLastPaid.size();
+    if (fQueueStale) {
+        // should never happen, every change to mapMasternodes updates the queue
+        LogPrintf("CMasternodeMan::GetNextMasternodeInQueueForPayment -- ERROR: payment queue out of step with the masternode list, rebuilding\n");
+        RebuildPaymentQueue();
+        return GetNextMasternodeInQueueForPayment(nBlockHeight, fFilterSigTime, nCountRet, mnInfoRet);
+    }
 
     //when the network is in the process of upgrading, don't penalize nodes that recently restarted
     if(fFilterSigTime && nCountRet < nMnCount/3)
         return GetNextMasternodeInQueueForPayment(nBlockHeight, false, nCountRet, mnInfoRet);
 
-    // Sort them low to high
-    sort(vecMasternodeLastPaid.begin(), vecMasternodeLastPaid.end(), CompareLastPaidBlock());
-
     uint256 blockHash;
     if(!GetBlockHash(blockHash, nBlockHeight - 101)) {
         LogPrintf("CMasternode::GetNextMasternodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight - 101);
@@ -533,18 +654,14 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
     //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
     //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
     //  -- (chance per block * chances before IsScheduled will fire)
-    int nTenthNetwork = nMnCount/10;
-    int nCountTenth = 0;
     arith_uint256 nHighest = 0;
     const CMasternode *pBestMasternode = nullptr;
-    for (const auto& s : vecMasternodeLastPaid) {
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+    for (const auto pmn : vecOldestMasternodes) {
+        arith_uint256 nScore = pmn->CalculateScore(blockHash);
         if(nScore > nHighest){
             nHighest = nScore;
-            pBestMasternode = s.second;
+            pBestMasternode = pmn;
         }
-        nCountTenth++;
-        if(nCountTenth >= nTenthNetwork) break;
     }
     if (pBestMasternode) {
         mnInfoRet = pBestMasternode->GetInfo();
@@ -554,11 +671,12 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
 
 masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion)
 {
-    LOCK(cs);
+    // works on the published snapshot, doesn't need cs
+    masternode_snapshot_ptr_t snapshot = GetMasternodeListSnapshot();
 
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinMasternodePaymentsProto() : nProtocolVersion;
 
-    int nCountEnabled = CountEnabled(nProtocolVersion);
+    int nCountEnabled = snapshot->CountEnabled(nProtocolVersion);
     int nCountNotExcluded = nCountEnabled - vecToExclude.size();
 
     LogPrintf("CMasternodeMan::FindRandomNotInVec -- %d enabled masternodes, %d masternodes to choose from\n", nCountEnabled, nCountNotExcluded);
@@ -566,8 +684,8 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
 
     // fill a vector of pointers
     std::vector<const CMasternode*> vpMasternodesShuffled;
-    for (const auto& mnpair : mapMasternodes) {
-        vpMasternodesShuffled.push_back(&mnpair.second);
+    for (const auto& pmn : snapshot->vecMasternodes) {
+        vpMasternodesShuffled.push_back(pmn.get());
     }
 
     FastRandomContext insecure_rand;
@@ -618,6 +736,150 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     return !vecMasternodeScoresRet.empty();
 }
 
+const CMasternodeMan::CRankTable* CMasternodeMan::GetRankTable(const uint256& nBlockHash, int nMinProtocol)
+{
+    AssertLockHeld(cs);
+
+    const rank_table_key_t key = std::make_pair(nBlockHash, nMinProtocol);
+    auto it = mapRankTables.find(key);
+    if (it != mapRankTables.end()) {
+        nRankTableHits++;
+        return &it->second;
+    }
+    nRankTableMisses++;
+
+    score_pair_vec_t vecMasternodeScores;
+    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+        return nullptr;
+
+    if (mapRankTables.size() >= MAX_RANK_TABLES) {
+        mapRankTables.erase(listRankTableKeys.front());
+        listRankTableKeys.pop_front();
+    }
+    CRankTable& table = mapRankTables[key];
+    listRankTableKeys.push_back(key);
+
+    table.vecOutpoints.reserve(vecMasternodeScores.size());
+    table.mapRanks.reserve(vecMasternodeScores.size());
+    for (const auto& scorePair : vecMasternodeScores) {
+        table.vecOutpoints.push_back(scorePair.second->outpoint);
+        table.mapRanks.emplace(scorePair.second->outpoint, (int)table.vecOutpoints.size());
+    }
+    return &table;
+}
+
+void CMasternodeMan::InvalidateRankTables()
+{
+    AssertLockHeld(cs);
+    mapRankTables.clear();
+    listRankTableKeys.clear();
+}
+
+void CMasternodeMan::UpdatePaymentQueue(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    int nBlockLastPaid = mn.GetLastPaidBlock();
+    auto it = mapPaymentQueue.find(mn.outpoint);
+    if (it == mapPaymentQueue.end()) {
+        mapPaymentQueue.emplace(mn.outpoint, CPaymentQueueEntry{nBlockLastPaid, -1});
+    } else if (it->second.nBlockLastPaid != nBlockLastPaid) {
+        setPaymentQueue.erase(std::make_pair(it->second.nBlockLastPaid, mn.outpoint));
+        it->second.nBlockLastPaid = nBlockLastPaid;
+    } else {
+        return;
+    }
+    setPaymentQueue.emplace(nBlockLastPaid, mn.outpoint);
+}
+
+void CMasternodeMan::RemoveFromPaymentQueue(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs);
+    auto it = mapPaymentQueue.find(outpoint);
+    if (it == mapPaymentQueue.end()) return;
+    setPaymentQueue.erase(std::make_pair(it->second.nBlockLastPaid, outpoint));
+    mapPaymentQueue.erase(it);
+}
+
+void CMasternodeMan::RebuildPaymentQueue()
+{
+    AssertLockHeld(cs);
+    setPaymentQueue.clear();
+    mapPaymentQueue.clear();
+    for (const auto& mnpair : mapMasternodes) {
+        UpdatePaymentQueue(mnpair.second);
+    }
+}
+
+int CMasternodeMan::GetCollateralConfirmations(const COutPoint& outpoint, CPaymentQueueEntry& entry)
+{
+    AssertLockHeld(cs_main);
+    if (!chainActive.Tip()) return -1;
+
+    if (entry.nCollateralHeight < 0) {
+        // -1 means UTXO is yet unknown or already spent
+        int nPrevoutHeight = collateralwatch.GetHeight(outpoint);
+        if (nPrevoutHeight < 0) return -1;
+        // only remember heights that a reorg can no longer change, a spent
+        // collateral takes the masternode out of IsValidForPayment anyway
+        if (chainActive.Height() - nPrevoutHeight + 1 < COINBASE_MATURITY) {
+            return chainActive.Height() - nPrevoutHeight + 1;
+        }
+        entry.nCollateralHeight = nPrevoutHeight;
+    }
+    return chainActive.Height() - entry.nCollateralHeight + 1;
+}
+
+/**
+ * Whether the snapshot copy of a masternode still shows what mn shows.
+ * Keys and collateral only change with a new broadcast, which moves sigTime;
+ * nTimeLastChecked is left out on purpose, Check moves it every time.
+ */
+static bool IsSnapshotCurrent(const CMasternode& mnSnapshot, const CMasternode& mn)
+{
+    return mnSnapshot.sigTime == mn.sigTime &&
+           mnSnapshot.nActiveState == mn.nActiveState &&
+           mnSnapshot.nProtocolVersion == mn.nProtocolVersion &&
+           mnSnapshot.addr == mn.addr &&
+           mnSnapshot.lastPing.sigTime == mn.lastPing.sigTime &&
+           mnSnapshot.lastPing.nDaemonVersion == mn.lastPing.nDaemonVersion &&
+           mnSnapshot.nTimeLastPaid == mn.nTimeLastPaid &&
+           mnSnapshot.nBlockLastPaid == mn.nBlockLastPaid &&
+           mnSnapshot.nPoSeBanScore == mn.nPoSeBanScore &&
+           mnSnapshot.nPoSeBanHeight == mn.nPoSeBanHeight;
+}
+
+void CMasternodeMan::PublishSnapshot()
+{
+    AssertLockHeld(cs);
+
+    masternode_snapshot_ptr_t snapshotPrev = std::atomic_load(&pSnapshot);
+    auto snapshot = std::make_shared<CMasternodeListSnapshot>();
+    snapshot->vecMasternodes.reserve(mapMasternodes.size());
+
+    // both are ordered by outpoint, walk them side by side
+    auto itPrev = snapshotPrev->vecMasternodes.begin();
+    for (const auto& mnpair : mapMasternodes) {
+        while (itPrev != snapshotPrev->vecMasternodes.end() && (*itPrev)->outpoint < mnpair.first) {
+            ++itPrev;
+        }
+        if (itPrev != snapshotPrev->vecMasternodes.end() && (*itPrev)->outpoint == mnpair.first && IsSnapshotCurrent(**itPrev, mnpair.second)) {
+            snapshot->vecMasternodes.push_back(*itPrev);
+        } else {
+            snapshot->vecMasternodes.push_back(std::make_shared<const CMasternode>(mnpair.second));
+        }
+    }
+
+    std::atomic_store(&pSnapshot, masternode_snapshot_ptr_t(std::move(snapshot)));
+}
+
+void CMasternodeMan::GetRankTableStats(size_t& nTablesRet, uint64_t& nHitsRet, uint64_t& nMissesRet)
+{
+    LOCK(cs);
+    nTablesRet = mapRankTables.size();
+    nHitsRet = nRankTableHits;
+    nMissesRet = nRankTableMisses;
+}
+
 bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
 {
     nRankRet = -1;
@@ -634,20 +896,16 @@ bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    const CRankTable* pTable = GetRankTable(nBlockHash, nMinProtocol);
+    if (!pTable)
         return false;
 
-    int nRank = 0;
-    for (const auto& scorePair : vecMasternodeScores) {
-        nRank++;
-        if(scorePair.second->outpoint == outpoint) {
-            nRankRet = nRank;
-            return true;
-        }
-    }
+    auto it = pTable->mapRanks.find(outpoint);
+    if (it == pTable->mapRanks.end())
+        return false;
 
-    return false;
+    nRankRet = it->second;
+    return true;
 }
 
 bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight, int nMinProtocol)
@@ -666,14 +924,14 @@ bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMast
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    const CRankTable* pTable = GetRankTable(nBlockHash, nMinProtocol);
+    if (!pTable)
         return false;
 
     int nRank = 0;
-    for (const auto& scorePair : vecMasternodeScores) {
+    for (const auto& outpoint : pTable->vecOutpoints) {
         nRank++;
-        vecMasternodeRanksRet.push_back(std::make_pair(nRank, *scorePair.second));
+        vecMasternodeRanksRet.push_back(std::make_pair(nRank, mapMasternodes.at(outpoint)));
     }
 
     return true;
@@ -762,6 +1020,120 @@ void CMasternodeMan::ProcessPendingMnbRequests(CConnman& connman)
     LogPrint(BCLog::MASTERNODE, "%s -- mapPendingMNB size: %d\n", __func__, mapPendingMNB.size());
 }
 
+void CMasternodeMan::ProcessMnb(CNode* pfrom, const CMasternodeBroadcast& mnb, CConnman& connman)
+{
+    int nDos = 0;
+
+    if (CheckMnbAndUpdateMasternodeList(pfrom, mnb, nDos, connman)) {
+        // use announced Masternode as a peer
+        connman.AddNewAddress(CAddress(mnb.addr, NODE_NETWORK), pfrom->addr, 2*60*60);
+    } else if(nDos > 0) {
+        LOCK(cs_main);
+        Misbehaving(pfrom->GetId(), nDos);
+    }
+
+    if(fMasternodesAdded) {
+        NotifyMasternodeUpdates(connman);
+    }
+}
+
+void CMasternodeMan::ProcessMnp(CNode* pfrom, CMasternodePing& mnp, CConnman& connman)
+{
+    uint256 nHash = mnp.GetHash();
+
+    // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
+    LOCK2(cs_main, cs);
+
+    if(mapSeenMasternodePing.count(nHash)) return; //seen
+    mapSeenMasternodePing.insert(std::make_pair(nHash, mnp));
+
+    LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s new\n", mnp.masternodeOutpoint.ToStringShort());
+
+    // see if we have this Masternode
+    CMasternode* pmn = Find(mnp.masternodeOutpoint);
+
+    // too late, new MNANNOUNCE is required
+    if(pmn && pmn->IsNewStartRequired()) return;
+
+    int nDos = 0;
+    if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+
+    if(nDos > 0) {
+        // if anything significant failed, mark that node
+        Misbehaving(pfrom->GetId(), nDos);
+    } else if(pmn != nullptr) {
+        // nothing significant failed, mn is a known one too
+        return;
+    }
+
+    // something significant is broken or mn is unknown,
+    // we might have to ask for a masternode entry once
+    AskForMN(pfrom, mnp.masternodeOutpoint, connman);
+}
+
+void CMasternodeMan::QueuePendingMessage(CNode* pfrom, const CMasternodeBroadcast* pmnb, const CMasternodePing* pmnp, CConnman& connman)
+{
+    bool fFull;
+    {
+        LOCK(cs_vecPendingMessages);
+        pfrom->AddRef();
+        vecPendingMessages.emplace_back();
+        CPendingMessage& msg = vecPendingMessages.back();
+        msg.pfrom = pfrom;
+        msg.fPing = pmnp != nullptr;
+        if (pmnb) msg.mnb = *pmnb;
+        if (pmnp) msg.mnp = *pmnp;
+        fFull = vecPendingMessages.size() >= PENDING_MESSAGES_BATCH_SIZE;
+    }
+    if (fFull) {
+        ProcessPendingMessages(connman);
+    }
+}
+
+void CMasternodeMan::ProcessPendingMessages(CConnman& connman)
+{
+    // one batch at a time so messages are processed in the order they were received
+    LOCK(cs_ProcessPendingMessages);
+
+    std::vector<CPendingMessage> vecMessages;
+    {
+        LOCK(cs_vecPendingMessages);
+        vecMessages.swap(vecPendingMessages);
+    }
+    if (vecMessages.empty()) return;
+
+    // recover all signing keys in parallel, this is the expensive part of checking them
+    std::vector<CRecoverSigKeyCheck> vChecks;
+    vChecks.reserve(2 * vecMessages.size());
+    for (auto& msg : vecMessages) {
+        if (msg.fPing) {
+            vChecks.push_back(msg.mnp.PrepareSigKeyRecovery());
+        } else {
+            vChecks.push_back(msg.mnb.PrepareSigKeyRecovery());
+            if (msg.mnb.lastPing) {
+                vChecks.push_back(msg.mnb.lastPing.PrepareSigKeyRecovery());
+            }
+        }
+    }
+    {
+        CCheckQueueControl<CRecoverSigKeyCheck> control(&sigkeycheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    // then process them in order
+    for (auto& msg : vecMessages) {
+        if (msg.fPing) {
+            ProcessMnp(msg.pfrom, msg.mnp, connman);
+        } else {
+            ProcessMnb(msg.pfrom, msg.mnb, connman);
+        }
+        msg.pfrom->Release();
+    }
+
+    LogPrint(BCLog::MASTERNODE, "CMasternodeMan::%s -- processed %d messages\n", __func__, vecMessages.size());
+}
+
 void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
 {
     if(fLiteMode) return; // disable all Dash specific functionality
@@ -777,60 +1149,20 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
 
         LogPrint(BCLog::MASTERNODE, "MNANNOUNCE -- Masternode announce, masternode=%s\n", mnb.outpoint.ToStringShort());
 
-        int nDos = 0;
+        QueuePendingMessage(pfrom, &mnb, nullptr, connman);
 
-        if (CheckMnbAndUpdateMasternodeList(pfrom, mnb, nDos, connman)) {
-            // use announced Masternode as a peer
-            connman.AddNewAddress(CAddress(mnb.addr, NODE_NETWORK), pfrom->addr, 2*60*60);
-        } else if(nDos > 0) {
-            LOCK(cs_main);
-            Misbehaving(pfrom->GetId(), nDos);
-        }
-
-        if(fMasternodesAdded) {
-            NotifyMasternodeUpdates(connman);
-        }
     } else if (strCommand == NetMsgType::MNPING) { //Masternode Ping
 
         CMasternodePing mnp;
         vRecv >> mnp;
 
-        uint256 nHash = mnp.GetHash();
-
-        pfrom->setAskFor.erase(nHash);
+        pfrom->setAskFor.erase(mnp.GetHash());
 
         if(!masternodeSync.IsBlockchainSynced()) return;
 
         LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s\n", mnp.masternodeOutpoint.ToStringShort());
 
-        // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
-        LOCK2(cs_main, cs);
-
-        if(mapSeenMasternodePing.count(nHash)) return; //seen
-        mapSeenMasternodePing.insert(std::make_pair(nHash, mnp));
-
-        LogPrint(BCLog::MASTERNODE, "MNPING -- Masternode ping, masternode=%s new\n", mnp.masternodeOutpoint.ToStringShort());
-
-        // see if we have this Masternode
-        CMasternode* pmn = Find(mnp.masternodeOutpoint);
-
-        // too late, new MNANNOUNCE is required
-        if(pmn && pmn->IsNewStartRequired()) return;
-
-        int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
-
-        if(nDos > 0) {
-            // if anything significant failed, mark that node
-            Misbehaving(pfrom->GetId(), nDos);
-        } else if(pmn != nullptr) {
-            // nothing significant failed, mn is a known one too
-            return;
-        }
-
-        // something significant is broken or mn is unknown,
-        // we might have to ask for a masternode entry once
-        AskForMN(pfrom, mnp.masternodeOutpoint, connman);
+        QueuePendingMessage(pfrom, nullptr, &mnp, connman);
 
     } else if (strCommand == NetMsgType::DSEG) { //Get Masternode list or specific entry
         // Ignore such requests until we are fully synced.
@@ -1515,10 +1847,15 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.outpoint);
         if(pmn) {
             CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
+            int nProtocolVersionOld = pmn->nProtocolVersion;
             if(!mnb.Update(pmn, nDos, connman)) {
                 LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.outpoint.ToStringShort());
                 return false;
             }
+            if(pmn->nProtocolVersion != nProtocolVersionOld) {
+                // rank tables filter by protocol version
+                InvalidateRankTables();
+            }
             if(hash != mnbOld.GetHash()) {
                 mapSeenMasternodeBroadcast.erase(mnbOld.GetHash());
             }
@@ -1570,7 +1907,9 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
 
     for (auto& mnpair : mapMasternodes) {
         mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        UpdatePaymentQueue(mnpair.second);
     }
+    PublishSnapshot();
 
     nLastRunBlockHeight = nCachedBlockHeight;
 }
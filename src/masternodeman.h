@@ -8,11 +8,34 @@
 #include <masternode.h>
 #include <sync.h>
 
+#include <memory>
+#include <queue>
+
 class CMasternodeMan;
 class CConnman;
 
 extern CMasternodeMan mnodeman;
 
+/**
+ * Immutable view of the masternode list as of the last CMasternodeMan::Check
+ * or CheckAndRemove, ordered by outpoint. Entries that did not change since
+ * the previous snapshot are shared with it, so publishing one only copies the
+ * masternodes that changed and holding one never blocks CMasternodeMan.
+ */
+struct CMasternodeListSnapshot
+{
+    std::vector<std::shared_ptr<const CMasternode> > vecMasternodes;
+
+    /// Count Masternodes filtered by nProtocolVersion, like CMasternodeMan::CountMasternodes
+    int CountMasternodes(int nProtocolVersion) const;
+    /// Count enabled Masternodes filtered by nProtocolVersion, like CMasternodeMan::CountEnabled
+    int CountEnabled(int nProtocolVersion) const;
+};
+typedef std::shared_ptr<const CMasternodeListSnapshot> masternode_snapshot_ptr_t;
+
+/** Run instances of this in background threads to recover masternode message signing keys in parallel. */
+void ThreadMasternodeSigCheck();
+
 class CMasternodeMan
 {
 public:
@@ -21,9 +44,11 @@ public:
     typedef std::pair<int, const CMasternode> rank_pair_t;
     typedef std::vector<rank_pair_t> rank_pair_vec_t;
 
-private:
+public:
     static const std::string SERIALIZATION_VERSION_STRING;
 
+private:
+
     static const int DSEG_UPDATE_SECONDS        = 3 * 60 * 60;
 
     static const int LAST_PAID_SCAN_BLOCKS;
@@ -39,6 +64,37 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    static const size_t MAX_RANK_TABLES         = 16;
+
+    static const size_t PENDING_MESSAGES_BATCH_SIZE = 128;
+
+    /// mnb or mnp waiting for its signature to be checked, holds a reference to pfrom
+    struct CPendingMessage
+    {
+        CNode* pfrom;
+        bool fPing;
+        CMasternodeBroadcast mnb;
+        CMasternodePing mnp;
+    };
+
+    /// Masternodes ordered by score for one (block hash, min protocol) pair, see GetRankTable
+    struct CRankTable
+    {
+        std::vector<COutPoint> vecOutpoints;
+        std::unordered_map<COutPoint, int, SaltedOutpointHasher> mapRanks;
+    };
+    typedef std::pair<uint256, int> rank_table_key_t;
+
+    /// Position of one masternode in the payment queue, see GetNextMasternodeInQueueForPayment
+    struct CPaymentQueueEntry
+    {
+        int nBlockLastPaid;
+        // height of the collateral once it is buried too deep to be reorged, -1 until then
+        int nCollateralHeight;
+    };
+    typedef std::pair<int, COutPoint> payment_queue_key_t;
+
+    typedef std::pair<int64_t, COutPoint> check_deadline_t;
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -65,6 +121,32 @@ private:
     std::map<CService, std::pair<int64_t, std::set<uint256> > > mapPendingMNB;
     std::map<CService, std::pair<int64_t, CMasternodeVerification> > mapPendingMNV;
     CCriticalSection cs_mapPendingMNV;
+    // incoming mnb/mnp, their signatures are checked in parallel batches by ProcessPendingMessages
+    std::vector<CPendingMessage> vecPendingMessages;
+    CCriticalSection cs_vecPendingMessages;
+    CCriticalSection cs_ProcessPendingMessages;
+
+    // rank tables computed so far, oldest first in listRankTableKeys; only valid
+    // for the current set of masternodes and their protocol versions
+    std::map<rank_table_key_t, CRankTable> mapRankTables;
+    std::list<rank_table_key_t> listRankTableKeys;
+    uint64_t nRankTableHits;
+    uint64_t nRankTableMisses;
+
+    // masternodes ordered by last paid block and then outpoint, the order in
+    // which they qualify for payment; kept in step with mapMasternodes
+    std::set<payment_queue_key_t> setPaymentQueue;
+    std::map<COutPoint, CPaymentQueueEntry> mapPaymentQueue;
+
+    // when each masternode is next due for CMasternode::Check, see CheckDue; a
+    // min-heap with lazy deletion, entries that don't match mapCheckDeadlines
+    // are stale and skipped when they come up
+    std::priority_queue<check_deadline_t, std::vector<check_deadline_t>, std::greater<check_deadline_t> > heapCheckDeadlines;
+    std::map<COutPoint, int64_t> mapCheckDeadlines;
+
+    // the masternode list as last published by PublishSnapshot, only accessed
+    // through std::atomic_load and std::atomic_store
+    masternode_snapshot_ptr_t pSnapshot;
 
     /// Set when masternodes are added, cleared when CGovernanceManager is notified
     bool fMasternodesAdded;
@@ -73,16 +155,39 @@ private:
     bool fMasternodesRemoved;
 
     friend class CMasternodeSync;
+    friend struct CMasternodeManTest;
     /// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
+    /// Ranking for nBlockHash and nMinProtocol, computed on first use and cached until the list changes
+    const CRankTable* GetRankTable(const uint256& nBlockHash, int nMinProtocol);
+    /// Drop all cached rank tables, must be called whenever masternodes are added or removed or change protocol version
+    void InvalidateRankTables();
+
+    /// Insert mn into the payment queue or move it to its current last paid block
+    void UpdatePaymentQueue(const CMasternode& mn);
+    void RemoveFromPaymentQueue(const COutPoint& outpoint);
+    void RebuildPaymentQueue();
+    /// Confirmations of the collateral behind entry, -1 if it is unknown or spent
+    int GetCollateralConfirmations(const COutPoint& outpoint, CPaymentQueueEntry& entry);
+
+    /// Make mn due for CMasternode::Check once its MASTERNODE_CHECK_SECONDS have passed
+    void ScheduleCheck(const CMasternode& mn);
+    void RebuildCheckDeadlines();
+
+    /// Publish mapMasternodes as the new snapshot, reusing the unchanged entries of the current one
+    void PublishSnapshot();
 
     void SyncSingle(CNode* pnode, const COutPoint& outpoint, CConnman& connman);
     void SyncAll(CNode* pnode, CConnman& connman);
 
     void PushDsegInvs(CNode* pnode, const CMasternode& mn);
 
+    void QueuePendingMessage(CNode* pfrom, const CMasternodeBroadcast* pmnb, const CMasternodePing* pmnp, CConnman& connman);
+    void ProcessMnb(CNode* pfrom, const CMasternodeBroadcast& mnb, CConnman& connman);
+    void ProcessMnp(CNode* pfrom, CMasternodePing& mnp, CConnman& connman);
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, std::pair<int64_t, CMasternodeBroadcast> > mapSeenMasternodeBroadcast;
@@ -115,8 +220,34 @@ public:
 
         READWRITE(mapSeenMasternodeBroadcast);
         READWRITE(mapSeenMasternodePing);
-        if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
-            Clear();
+        if(ser_action.ForRead()) {
+            InvalidateRankTables();
+            RebuildPaymentQueue();
+            RebuildCheckDeadlines();
+            if(strVersion != SERIALIZATION_VERSION_STRING) {
+                Clear();
+            }
+            PublishSnapshot();
+        }
+    }
+
+    /// Hand every map that makes up the cache to visitor, see CCacheDB
+    template <typename Visitor>
+    void VisitCacheMaps(Visitor& visitor) {
+        LOCK(cs);
+        visitor('m', mapMasternodes);
+        visitor('a', mAskedUsForMasternodeList);
+        visitor('w', mWeAskedForMasternodeList);
+        visitor('e', mWeAskedForMasternodeListEntry);
+        visitor('r', mMnbRecoveryRequests);
+        visitor('g', mMnbRecoveryGoodReplies);
+        visitor('b', mapSeenMasternodeBroadcast);
+        visitor('p', mapSeenMasternodePing);
+        if(visitor.ForRead()) {
+            InvalidateRankTables();
+            RebuildPaymentQueue();
+            RebuildCheckDeadlines();
+            PublishSnapshot();
         }
     }
 
@@ -133,6 +264,8 @@ public:
 
     /// Check all Masternodes
     void Check();
+    /// Check only the Masternodes whose MASTERNODE_CHECK_SECONDS have passed since their last check
+    void CheckDue();
 
     /// Check all Masternodes and remove inactive
     void CheckAndRemove(CConnman& connman);
@@ -170,16 +303,21 @@ public:
     /// Find a random entry
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
 
-    std::map<COutPoint, CMasternode> GetFullMasternodeMap() { return mapMasternodes; }
+    /// The masternode list as of the last Check, safe to read without holding any lock
+    masternode_snapshot_ptr_t GetMasternodeListSnapshot() const { return std::atomic_load(&pSnapshot); }
 
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
+    /// Number of cached rank tables and how often GetMasternodeRank(s) found the one it needed
+    void GetRankTableStats(size_t& nTablesRet, uint64_t& nHitsRet, uint64_t& nMissesRet);
 
     void ProcessMasternodeConnections(CConnman& connman);
     std::pair<CService, std::set<uint256> > PopScheduledMnbRequestConnection();
     void ProcessPendingMnbRequests(CConnman& connman);
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+    /// Check the signatures of all queued mnb/mnp messages in parallel, then process the messages in order
+    void ProcessPendingMessages(CConnman& connman);
 
     void DoFullVerificationStep(CConnman& connman);
     void CheckSameAddr();
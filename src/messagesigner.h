@@ -7,6 +7,18 @@
 
 #include <key.h>
 
+/** Signing key recovered ahead of time from a compact signature over hash,
+ *  see CRecoverSigKeyCheck. Verifying the same hash and signature again then
+ *  only compares key IDs.
+ */
+struct CRecoveredSigKey
+{
+    uint256 hash;
+    std::vector<unsigned char> vchSig;
+    CKeyID keyID;
+    bool fRecovered{false};
+};
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
@@ -16,10 +28,12 @@ public:
     static bool GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet);
     /// Sign the message, returns true if successful
     static bool SignMessage(const std::string& strMessage, std::vector<unsigned char>& vchSigRet, const CKey& key);
+    /// Hash that SignMessage signs for the message
+    static uint256 GetMessageHash(const std::string& strMessage);
     /// Verify the message signature, returns true if succcessful
-    static bool VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
+    static bool VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigKey* pRecovered = nullptr);
     /// Verify the message signature, returns true if succcessful
-    static bool VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
+    static bool VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet, const CRecoveredSigKey* pRecovered = nullptr);
 };
 
 /** Helper class for signing hashes and checking their signatures
@@ -29,10 +43,39 @@ class CHashSigner
 public:
     /// Sign the hash, returns true if successful
     static bool SignHash(const uint256& hash, const CKey& key, std::vector<unsigned char>& vchSigRet);
+    /// Recover the ID of the key that signed the hash, returns true if successful
+    static bool RecoverKey(const uint256& hash, const std::vector<unsigned char>& vchSig, CKeyID& keyIDRet);
+    /// Verify the hash signature, returns true if succcessful.
+    /// Uses pRecovered instead of recovering the key again if it was recovered from the same hash and signature.
+    static bool VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet, const CRecoveredSigKey* pRecovered = nullptr);
     /// Verify the hash signature, returns true if succcessful
-    static bool VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
-    /// Verify the hash signature, returns true if succcessful
-    static bool VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    static bool VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet, const CRecoveredSigKey* pRecovered = nullptr);
+};
+
+/**
+ * Closure recovering the signing key of one message ahead of time, so that
+ * signatures can be checked in parallel on a CCheckQueue before the messages
+ * are processed in order. Always succeeds; a bad signature leaves fRecovered
+ * unset and is reported when the message is verified.
+ * Note that this stores a reference to the result slot
+ */
+class CRecoverSigKeyCheck
+{
+private:
+    CRecoveredSigKey *pRecovered;
+
+public:
+    CRecoverSigKeyCheck(): pRecovered(nullptr) {}
+    explicit CRecoverSigKeyCheck(CRecoveredSigKey& recoveredIn): pRecovered(&recoveredIn) {}
+
+    bool operator()() {
+        pRecovered->fRecovered = CHashSigner::RecoverKey(pRecovered->hash, pRecovered->vchSig, pRecovered->keyID);
+        return true;
+    }
+
+    void swap(CRecoverSigKeyCheck &check) {
+        std::swap(pRecovered, check.pRecovered);
+    }
 };
 
 #endif
@@ -63,6 +63,26 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
     return nNewTime - nOldTime;
 }
 
+void SetBlockAlgo(CBlock* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev, uint8_t algo)
+{
+    pblock->nVersion &= ~BLOCK_VERSION_ALGO;
+    pblock->SetAlgo(algo);
+
+    arith_uint256 nonce;
+    if (IsHardForkActivated(pblock->nTime) && (algo == ALGO_EQUIHASH || algo == ALGO_ZHASH)) {
+        // Randomise nonce for new block format, as CreateNewBlock does.
+        nonce = UintToArith256(GetRandHash());
+        nonce <<= 32;
+        nonce >>= 16;
+    }
+    pblock->nNonce = 0;
+    pblock->nBigNonce = ArithToUint256(nonce);
+    pblock->nSolution.clear();
+
+    UpdateTime(pblock, consensusParams, pindexPrev, algo);
+    pblock->nBits = GetNextWorkRequired(pindexPrev, pblock, consensusParams, algo);
+}
+
 BlockAssembler::Options::Options() {
     blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
     nBlockMaxWeight = DefaultMaxBlockWeight(CheckCurrentHardforkState());
@@ -98,6 +118,7 @@ BlockAssembler::BlockAssembler(const CChainParams& params) : BlockAssembler(para
 void BlockAssembler::resetBlock()
 {
     inBlock.clear();
+    fSelectionComplete = true;
 
     // Reserve space for coinbase tx
     nBlockWeight = 4000;
@@ -109,7 +130,7 @@ void BlockAssembler::resetBlock()
     nFees = 0;
 }
 
-std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, uint8_t algo, bool fMineWitnessTx)
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, uint8_t algo, bool fMineWitnessTx, CBlockTemplateSelection* pselection)
 {
     int64_t nTimeStart = GetTimeMicros();
 
@@ -177,7 +198,27 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+    bool fIncremental = false;
+    bool fNewTip = true;
+    if (pselection) {
+        LOCK(pselection->cs);
+        fNewTip = pselection->pindexPrev != pindexPrev;
+        fIncremental = updatePackageTxs(*pselection, pindexPrev, nPackagesSelected);
+        if (!fIncremental) {
+            // Drop whatever updatePackageTxs added before giving up
+            bool fWitness = fIncludeWitness;
+            resetBlock();
+            fIncludeWitness = fWitness;
+            pblock->vtx.resize(1);
+            pblocktemplate->vTxFees.resize(1);
+            pblocktemplate->vTxSigOpsCost.resize(1);
+            nPackagesSelected = 0;
+            addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+        }
+        saveSelection(*pselection, pindexPrev, fIncremental);
+    } else {
+        addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+    }
 
     int64_t nTime1 = GetTimeMicros();
 
@@ -234,13 +275,25 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblock->nSolution.clear();
     pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
 
+    // On a new tip the coinbase, its payees, nBits and the time rules all
+    // change, so the block is checked in full. On the same tip an incremental
+    // block only adds transactions whose inputs were checked against the
+    // coins of the selection as they were added, so connecting them again is
+    // skipped, but the header, block and coinbase rules are still checked.
     CValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
-        throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+    if (!fIncremental || fNewTip) {
+        if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
+            if (pselection)
+                pselection->Invalidate();
+            throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+        }
+    } else if (!TestBlockTemplateValidity(state, chainparams, *pblock, pindexPrev, nFees)) {
+        pselection->Invalidate();
+        throw std::runtime_error(strprintf("%s: TestBlockTemplateValidity failed: %s", __func__, FormatStateMessage(state)));
     }
     int64_t nTime2 = GetTimeMicros();
 
-    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+    LogPrint(BCLog::BENCH, "CreateNewBlock() %s packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", fIncremental ? "incremental" : "full", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
 
     return std::move(pblocktemplate);
 }
@@ -440,6 +493,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         }
 
         if (!TestPackage(packageSize, packageSigOpsCost)) {
+            fSelectionComplete = false;
             if (fUsingModified) {
                 // Since we always look at the best entry in mapModifiedTx,
                 // we must erase failed entries so that we can consider the
@@ -468,6 +522,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
 
         // Test if all tx's are Final
         if (!TestPackageTransactions(ancestors)) {
+            fSelectionComplete = false;
             if (fUsingModified) {
                 mapModifiedTx.get<ancestor_score>().erase(modit);
                 failedTx.insert(iter);
@@ -495,7 +550,178 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
-void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
+bool BlockAssembler::CheckSelectedTx(const CTransaction& tx, CCoinsViewCache& view) const
+{
+    if (!IsFinalTx(tx, nHeight, nLockTimeCutoff) || (!fIncludeWitness && tx.HasWitness()))
+        return false;
+    CValidationState state;
+    CAmount txfee;
+    if (!Consensus::CheckTxInputs(tx, state, view, nHeight, txfee))
+        return false;
+    UpdateCoins(tx, view, nHeight);
+    return true;
+}
+
+bool BlockAssembler::updatePackageTxs(CBlockTemplateSelection& selection, const CBlockIndex* pindexPrev, int &nPackagesSelected)
+{
+    AssertLockHeld(selection.cs);
+
+    // Only a selection for the same tip or its parent, made with the same
+    // rules, carries over. Anything else (reorg, deployment or setting
+    // changes, a full block) starts from scratch.
+    if (!selection.pindexPrev || !selection.fComplete ||
+        (selection.pindexPrev != pindexPrev && selection.pindexPrev != pindexPrev->pprev) ||
+        selection.nVersion != (pblock->nVersion & ~BLOCK_VERSION_ALGO) ||
+        selection.fIncludeWitness != fIncludeWitness ||
+        selection.nBlockMaxWeight != nBlockMaxWeight ||
+        selection.blockMinFeeRate != blockMinFeeRate)
+        return false;
+    const bool fNewTip = selection.pindexPrev != pindexPrev;
+
+    // Children of mined transactions no longer pay for their parents and may
+    // now make it on their own.
+    for (const uint256& hash : selection.vMined) {
+        auto it = mempool.mapNextTx.lower_bound(COutPoint(hash, 0));
+        for (; it != mempool.mapNextTx.end() && it->first->hash == hash; ++it)
+            selection.setPending.insert(it->second->GetHash());
+    }
+    selection.vMined.clear();
+
+    // Transactions that left the mempool take their in-mempool descendants
+    // with them, unless they were mined, so what is left is still a valid
+    // order for a block.
+    std::vector<CTxMemPool::txiter> vKept;
+    vKept.reserve(selection.vSelected.size());
+    for (const uint256& hash : selection.vSelected) {
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it != mempool.mapTx.end())
+            vKept.push_back(it);
+    }
+    if (fNewTip || vKept.size() != selection.vSelected.size() || !selection.pcoins) {
+        selection.pcoins.reset(new CCoinsViewCache(pcoinsTip.get()));
+        for (CTxMemPool::txiter it : vKept) {
+            if (!CheckSelectedTx(it->GetTx(), *selection.pcoins))
+                return false;
+        }
+    }
+    for (CTxMemPool::txiter it : vKept)
+        AddToBlock(it);
+
+    // Every package that paid enough was selected before, so only packages
+    // involving the pending transactions can be new. Add them best first.
+    std::vector<CTxMemPool::txiter> vPending;
+    for (const uint256& hash : selection.setPending) {
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it != mempool.mapTx.end() && !inBlock.count(it))
+            vPending.push_back(it);
+    }
+    selection.setPending.clear();
+    std::sort(vPending.begin(), vPending.end(), [](CTxMemPool::txiter a, CTxMemPool::txiter b) {
+        return CompareTxMemPoolEntryByAncestorFee()(*a, *b);
+    });
+
+    for (CTxMemPool::txiter iter : vPending) {
+        // Already in as the ancestor of a better package
+        if (inBlock.count(iter))
+            continue;
+
+        CTxMemPool::setEntries ancestors;
+        uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+        std::string dummy;
+        mempool.CalculateMemPoolAncestors(*iter, ancestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+        onlyUnconfirmed(ancestors);
+        ancestors.insert(iter);
+
+        uint64_t packageSize = 0;
+        CAmount packageFees = 0;
+        int64_t packageSigOpsCost = 0;
+        for (CTxMemPool::txiter it : ancestors) {
+            packageSize += it->GetTxSize();
+            packageFees += it->GetModifiedFee();
+            packageSigOpsCost += it->GetSigOpCost();
+        }
+        if (packageFees < blockMinFeeRate.GetFee(packageSize))
+            continue;
+        if (!TestPackage(packageSize, packageSigOpsCost) || !TestPackageTransactions(ancestors)) {
+            fSelectionComplete = false;
+            continue;
+        }
+
+        std::vector<CTxMemPool::txiter> sortedEntries;
+        SortForBlock(ancestors, iter, sortedEntries);
+        for (CTxMemPool::txiter it : sortedEntries) {
+            if (!CheckSelectedTx(it->GetTx(), *selection.pcoins))
+                return false;
+            AddToBlock(it);
+        }
+        ++nPackagesSelected;
+    }
+    return true;
+}
+
+void BlockAssembler::saveSelection(CBlockTemplateSelection& selection, const CBlockIndex* pindexPrev, bool fIncremental) const
+{
+    AssertLockHeld(selection.cs);
+
+    selection.pindexPrev = pindexPrev;
+    selection.nVersion = pblock->nVersion & ~BLOCK_VERSION_ALGO;
+    selection.fIncludeWitness = fIncludeWitness;
+    selection.nBlockMaxWeight = nBlockMaxWeight;
+    selection.blockMinFeeRate = blockMinFeeRate;
+    selection.fComplete = fSelectionComplete;
+    selection.vSelected.clear();
+    for (size_t i = 1; i < pblock->vtx.size(); i++)
+        selection.vSelected.push_back(pblock->vtx[i]->GetHash());
+    if (!fIncremental) {
+        // The full selection saw the whole mempool
+        selection.pcoins.reset();
+        selection.setPending.clear();
+        selection.vMined.clear();
+    }
+}
+
+CBlockTemplateSelection templateselection;
+
+void CBlockTemplateSelection::Invalidate()
+{
+    LOCK(cs);
+    pindexPrev = nullptr;
+    vSelected.clear();
+    pcoins.reset();
+    setPending.clear();
+    vMined.clear();
+}
+
+void CBlockTemplateSelection::TransactionAddedToMempool(const CTransactionRef& ptx)
+{
+    LOCK(cs);
+    if (pindexPrev)
+        setPending.insert(ptx->GetHash());
+}
+
+void CBlockTemplateSelection::TransactionRemovedFromMempool(const CTransactionRef& ptx)
+{
+    LOCK(cs);
+    setPending.erase(ptx->GetHash());
+}
+
+void CBlockTemplateSelection::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted)
+{
+    LOCK(cs);
+    if (!pindexPrev)
+        return;
+    // The selection only carries over to the next block, drop it when the
+    // chain moved further (notifications may arrive after the template for
+    // the new tip was made)
+    if (pindex != pindexPrev && pindex->pprev != pindexPrev) {
+        Invalidate();
+        return;
+    }
+    for (const CTransactionRef& tx : block->vtx)
+        vMined.push_back(tx->GetHash());
+}
+
+void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce, const std::vector<uint256>* pvCoinbaseBranch)
 {
     // Update nExtraNonce
     static uint256 hashPrevBlock;
@@ -511,5 +737,8 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
     assert(txCoinbase.vin[0].scriptSig.size() <= 100);
 
     pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
-    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
+    if (pvCoinbaseBranch)
+        pblock->hashMerkleRoot = ComputeMerkleRootFromBranch(pblock->vtx[0]->GetHash(), *pvCoinbaseBranch, 0);
+    else
+        pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
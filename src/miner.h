@@ -7,10 +7,13 @@
 #define HUNTCOIN_MINER_H
 
 #include <primitives/block.h>
+#include <sync.h>
 #include <txmempool.h>
+#include <validationinterface.h>
 
 #include <stdint.h>
 #include <memory>
+#include <set>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 
@@ -21,6 +24,8 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -genproclimit, the number of generate threads */
+static const int DEFAULT_GENERATE_THREADS = 1;
 
 struct CBlockTemplate
 {
@@ -119,6 +124,51 @@ struct update_for_parent_inclusion
     CTxMemPool::txiter iter;
 };
 
+/** The transactions picked for the last block template, kept up to date from
+ *  the mempool notifications so the next template for the same or the next
+ *  tip only has to look at what changed (see BlockAssembler::CreateNewBlock).
+ */
+class CBlockTemplateSelection : public CValidationInterface
+{
+private:
+    friend class BlockAssembler;
+
+    CCriticalSection cs;
+
+    // Chain context and assembler settings the selection was made for,
+    // pindexPrev is nullptr when there is no selection to reuse
+    const CBlockIndex* pindexPrev;
+    int32_t nVersion;
+    bool fIncludeWitness;
+    unsigned int nBlockMaxWeight;
+    CFeeRate blockMinFeeRate;
+    // Whether every package paying the minimum fee rate was included. If one
+    // was left out, a new package may have to replace others and the
+    // selection is redone from scratch.
+    bool fComplete;
+    // The selected transactions, in block order
+    std::vector<uint256> vSelected;
+    // The coins of pindexPrev with the selection applied, built on demand
+    std::unique_ptr<CCoinsViewCache> pcoins;
+    // Transactions to consider for the next template
+    std::set<uint256> setPending;
+    // Transactions mined since, whose mempool children are to be considered
+    std::vector<uint256> vMined;
+
+public:
+    CBlockTemplateSelection() : pindexPrev(nullptr) {}
+
+    /** Make the next template select from the whole mempool again, e.g. after
+     *  fees were changed by prioritisetransaction */
+    void Invalidate();
+
+    void TransactionAddedToMempool(const CTransactionRef& ptx) override;
+    void TransactionRemovedFromMempool(const CTransactionRef& ptx) override;
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted) override;
+};
+
+extern CBlockTemplateSelection templateselection;
+
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler
 {
@@ -139,6 +189,8 @@ private:
     uint64_t nBlockSigOpsCost;
     CAmount nFees;
     CTxMemPool::setEntries inBlock;
+    // False if a package paying the minimum fee rate was left out
+    bool fSelectionComplete;
 
     // Chain context for the block
     int nHeight;
@@ -155,8 +207,11 @@ public:
     explicit BlockAssembler(const CChainParams& params);
     BlockAssembler(const CChainParams& params, const Options& options);
 
-    /** Construct a new block template with coinbase to scriptPubKeyIn */
-    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, uint8_t algo, bool fMineWitnessTx=true);
+    /** Construct a new block template with coinbase to scriptPubKeyIn. With
+     *  pselection, the transactions selected for the previous template are
+     *  reused when they still can be and only the mempool changes since are
+     *  considered. */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, uint8_t algo, bool fMineWitnessTx=true, CBlockTemplateSelection* pselection=nullptr);
 
 private:
     // utility functions
@@ -170,6 +225,13 @@ private:
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
       * statistics from the package selection (for logging statistics). */
     void addPackageTxs(int &nPackagesSelected, int &nDescendantsUpdated);
+    /** Start from the transactions of the previous selection and add the
+      * packages of the transactions that entered the mempool since. Returns
+      * false if the selection can't be reused, the block is then to be
+      * assembled with addPackageTxs. */
+    bool updatePackageTxs(CBlockTemplateSelection& selection, const CBlockIndex* pindexPrev, int &nPackagesSelected);
+    /** Record the transactions of the block as the selection for pindexPrev */
+    void saveSelection(CBlockTemplateSelection& selection, const CBlockIndex* pindexPrev, bool fIncremental) const;
 
     // helper functions for addPackageTxs()
     /** Remove confirmed (inBlock) entries from given set */
@@ -181,6 +243,10 @@ private:
       * These checks should always succeed, and they're here
       * only as an extra check in case of suboptimal node configuration */
     bool TestPackageTransactions(const CTxMemPool::setEntries& package);
+    /** Check a transaction of an incrementally built block against the coins
+      * of the block so far and apply it to them. Scripts are not checked
+      * again, the mempool did that against the flags of the next block. */
+    bool CheckSelectedTx(const CTransaction& tx, CCoinsViewCache& view) const;
     /** Return true if given transaction from mapTx has already been evaluated,
       * or if the transaction's cached data in mapTx is incorrect. */
     bool SkipMapTxEntry(CTxMemPool::txiter it, indexed_modified_transaction_set &mapModifiedTx, CTxMemPool::setEntries &failedTx);
@@ -192,8 +258,11 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx);
 };
 
-/** Modify the extranonce in a block */
-void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
+/** Modify the extranonce in a block. pvCoinbaseBranch, the merkle branch of
+ *  the coinbase from BlockMerkleBranch, saves rehashing the other transactions */
+void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce, const std::vector<uint256>* pvCoinbaseBranch = nullptr);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev, uint8_t algo);
+/** Turn a block built by CreateNewBlock into one for algo: the transactions stay, the algo bits, nBits and nonce format of the header change */
+void SetBlockAlgo(CBlock* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev, uint8_t algo);
 
 #endif // HUNTCOIN_MINER_H
@@ -34,6 +34,7 @@
 
 #include <spork.h>
 #include <instantx.h>
+#include <masternode-helper.h>
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
@@ -3027,6 +3028,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             instantsend.ProcessMessage(pfrom, strCommand, vRecv, *connman);
             sporkManager.ProcessSpork(pfrom, strCommand, vRecv, *connman);
             masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
+            RequestMasternodeCleanup();
         }
         else
         {
@@ -37,6 +37,13 @@ public:
         READWRITE(mapFulfilledRequests);
     }
 
+    /// Hand every map that makes up the cache to visitor, see CCacheDB
+    template <typename Visitor>
+    void VisitCacheMaps(Visitor& visitor) {
+        LOCK(cs_mapFulfilledRequests);
+        visitor('f', mapFulfilledRequests);
+    }
+
     void AddFulfilledRequest(const CService& addr, const std::string& strRequest);
     bool HasFulfilledRequest(const CService& addr, const std::string& strRequest);
 
@@ -105,7 +105,7 @@ unsigned int GetNextWorkRequiredV2(const CBlockIndex* pindexLast, const CBlockHe
 			const CBlockIndex* pindex = pindexLastAlgo;
             
 			while (pindex != nullptr && pindex->pprev && pindex->nHeight % params.nInterval != 0 && pindex->nBits == npowWorkLimit)
-				pindex = GetLastBlockIndexForAlgo(pindex->pprev, algo);
+				pindex = pindex->pprevSameAlgo;
             
             if (pindex == nullptr)
                 return npowWorkLimit;
@@ -116,11 +116,7 @@ unsigned int GetNextWorkRequiredV2(const CBlockIndex* pindexLast, const CBlockHe
 
 	// find first block in averaging interval
 	// Go back by what we want to be nAveragingInterval blocks per algo
-	const CBlockIndex* pindexFirst = pindexLast;
-	for (int i = 0; pindexFirst && i < NUM_ALGOS*params.nAveragingInterval; i++)
-	{
-		pindexFirst = pindexFirst->pprev;
-	}
+	const CBlockIndex* pindexFirst = pindexLast->GetAncestor(pindexLast->nHeight - NUM_ALGOS*params.nAveragingInterval);
 
 	const CBlockIndex* pindexPrevAlgo = GetLastBlockIndexForAlgo(pindexLast, algo);
 	if (pindexPrevAlgo == nullptr || pindexFirst == nullptr)
@@ -257,7 +253,7 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
     return CheckProofOfWork(block, params, equihashvalidator);
 }
 
-bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params, bool &ehsolutionvalid)
+bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params, bool &ehsolutionvalid, const uint256* pPoWHash)
 {
     bool hardfork = IsHardForkActivated(block.nTime);
     uint8_t nAlgo = block.GetAlgo();
@@ -306,8 +302,9 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
             else
             {
                 // Check the header
-                if (!CheckProofOfWork(block.GetPoWHash(), block.nBits, params, nAlgo))
-                    return error("%s : non-AUX proof of work failed - hash=%s, algo=%d (%s), nVersion=%d, PoWHash=%s", __func__, block.GetHash().ToString(), nAlgo, GetAlgoName(nAlgo), block.nVersion, block.GetPoWHash().ToString());
+                const uint256 hashPoW = pPoWHash ? *pPoWHash : block.GetPoWHash();
+                if (!CheckProofOfWork(hashPoW, block.nBits, params, nAlgo))
+                    return error("%s : non-AUX proof of work failed - hash=%s, algo=%d (%s), nVersion=%d, PoWHash=%s", __func__, block.GetHash().ToString(), nAlgo, GetAlgoName(nAlgo), block.nVersion, hashPoW.ToString());
             }
         }
         else
@@ -402,10 +399,14 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
 
 const CBlockIndex* GetLastBlockIndexForAlgo(const CBlockIndex* pindex, uint8_t algo)
 {
+    AssertLockHeld(cs_main);
 	for (;;)
 	{
 		if (!pindex)
 			return nullptr;
+        // Once the walk reaches the active chain, its per-algo index has the answer.
+        if (chainActive.Contains(pindex))
+            return chainActive.FindLastForAlgo(pindex, algo);
         if (!IsHardForkActivated(pindex->nTime) && algo != ALGO_SHA256D)
             return nullptr;
 		if (pindex->GetAlgo() == algo)
@@ -418,15 +419,7 @@ const CBlockIndex* GetLastBlockIndexForAlgo(const CBlockIndex* pindex, uint8_t a
 const CBlockIndex* GetNextBlockIndexForAlgo(const CBlockIndex* pindex, uint8_t algo)
 {
     AssertLockHeld(cs_main);
-	for (;;)
-	{
-		if (!pindex)
-			return nullptr;
-		if (pindex->GetAlgo() == algo)
-			return pindex;
-		pindex = chainActive.Next(pindex);
-	}
-	return nullptr;
+    return chainActive.FindNextForAlgo(pindex, algo);
 }
 
 int CalculateDiffRetargetingBlock(const CBlockIndex* pindex, int retargettype, uint8_t algo, const Consensus::Params& params)
@@ -437,10 +430,7 @@ int CalculateDiffRetargetingBlock(const CBlockIndex* pindex, int retargettype, u
 	const CBlockIndex* pindexAlgo = GetLastBlockIndexForAlgo(pindex, algo);
     const CBlockIndex* pindexLastAlgo;
     if(pindexAlgo != nullptr)
-        if(pindexAlgo->pprev)
-            pindexLastAlgo = GetLastBlockIndexForAlgo(pindexAlgo->pprev, algo);
-        else
-            pindexLastAlgo = nullptr;
+        pindexLastAlgo = pindexAlgo->pprevSameAlgo;
     else
         pindexLastAlgo = pindexAlgo;
 	if(retargettype == RETARGETING_LAST)
@@ -457,7 +447,7 @@ int CalculateDiffRetargetingBlock(const CBlockIndex* pindex, int retargettype, u
 				return pindexAlgo->nHeight;	
 		
 			pindexAlgo = pindexLastAlgo;
-			pindexLastAlgo = GetLastBlockIndexForAlgo(pindexAlgo->pprev, algo);
+			pindexLastAlgo = pindexAlgo->pprevSameAlgo;
 		}
 		return -3;
 	}
@@ -521,7 +511,7 @@ int CalculateDiffRetargetingBlock(const CBlockIndex* pindex, int retargettype, u
                     }
 				}
 				pindexAlgo = pindexLastAlgo;
-                pindexLastAlgo = GetLastBlockIndexForAlgo(pindexAlgo->pprev, algo);
+                pindexLastAlgo = pindexAlgo->pprevSameAlgo;
 	    }
 	    return -3;
     }
@@ -41,10 +41,12 @@ const CBlockIndex* GetNextBlockIndexForAlgo(const CBlockIndex* pindex, uint8_t a
  * @param block The block header.
  * @param params Consensus parameters.
  * @param ehsolutionvalid boolean set to false if equihash solution fails
+ * @param pPoWHash optional PoW hash of a header without auxpow, already
+ *                 computed (e.g. by CDefaultBlockHeader::GetPoWHashBatch)
  * @return True iff the PoW is correct.
  */
 bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params);
-bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params, bool &ehsolutionvalid);
+bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params, bool &ehsolutionvalid, const uint256* pPoWHash = nullptr);
 
 /** Calculations */
 int CalculateDiffRetargetingBlock(const CBlockIndex* pindex, int retargettype, uint8_t algo, const Consensus::Params&);
@@ -80,8 +80,78 @@ enum {
     
 const int NUM_ALGOS = 30;
 
+/**
+ * Static description of a PoW algo. ALGO_TABLE is indexed by the ALGO_* id,
+ * so every lookup is a single array access; adding an algo means adding its
+ * ids above and one row below.
+ */
+struct CAlgoInfo
+{
+    /** Canonical lower case name, as shown by the RPCs and -algo. */
+    const char* name;
+    /** BLOCK_VERSION_* bits the algo sets in nVersion. */
+    int32_t nVersionBits;
+    /** Header is serialized as CEquihashBlockHeader (carries a solution). */
+    bool fEquihashHeader;
+};
+
+constexpr CAlgoInfo ALGO_TABLE[] = {
+    {"sha256d",      BLOCK_VERSION_SHA256D,      false},
+    {"scrypt",       BLOCK_VERSION_SCRYPT,       false},
+    {"x11",          BLOCK_VERSION_X11,          false},
+    {"neoscrypt",    BLOCK_VERSION_NEOSCRYPT,    false},
+    {"equihash",     BLOCK_VERSION_EQUIHASH,     true},
+    {"yescrypt",     BLOCK_VERSION_YESCRYPT,     false},
+    {"hmq1725",      BLOCK_VERSION_HMQ1725,      false},
+    {"xevan",        BLOCK_VERSION_XEVAN,        false},
+    {"nist5",        BLOCK_VERSION_NIST5,        false},
+    {"timetravel10", BLOCK_VERSION_TIMETRAVEL10, false},
+    {"pawelhash",    BLOCK_VERSION_PAWELHASH,    false},
+    {"x13",          BLOCK_VERSION_X13,          false},
+    {"x14",          BLOCK_VERSION_X14,          false},
+    {"x15",          BLOCK_VERSION_X15,          false},
+    {"x17",          BLOCK_VERSION_X17,          false},
+    {"lyra2re",      BLOCK_VERSION_LYRA2RE,      false},
+    {"blake2s",      BLOCK_VERSION_BLAKE2S,      false},
+    {"blake2b",      BLOCK_VERSION_BLAKE2B,      false},
+    {"astralhash",   BLOCK_VERSION_ASTRALHASH,   false},
+    {"padihash",     BLOCK_VERSION_PADIHASH,     false},
+    {"jeonghash",    BLOCK_VERSION_JEONGHASH,    false},
+    {"keccak",       BLOCK_VERSION_KECCAK,       false},
+    {"zhash",        BLOCK_VERSION_ZHASH,        true},
+    {"globalhash",   BLOCK_VERSION_GLOBALHASH,   false},
+    {"skein",        BLOCK_VERSION_SKEIN,        false},
+    {"groestl",      BLOCK_VERSION_GROESTL,      false},
+    {"qubit",        BLOCK_VERSION_QUBIT,        false},
+    {"skunkhash",    BLOCK_VERSION_SKUNKHASH,    false},
+    {"quark",        BLOCK_VERSION_QUARK,        false},
+    {"x16r",         BLOCK_VERSION_X16R,         false},
+};
+
+static_assert(sizeof(ALGO_TABLE) / sizeof(ALGO_TABLE[0]) == NUM_ALGOS, "ALGO_TABLE needs one row per algo");
+static_assert(NUM_ALGOS_IMPL == NUM_ALGOS, "NUM_ALGOS does not match the ALGO_* ids");
+
+/** The version bits are (id + 1) << 9, which lets GetAlgo() index the table directly. */
+constexpr bool AlgoVersionBitsInOrder(int algo = 0)
+{
+    return algo == NUM_ALGOS || (ALGO_TABLE[algo].nVersionBits == ((algo + 1) << 9) && AlgoVersionBitsInOrder(algo + 1));
+}
+static_assert(AlgoVersionBitsInOrder(), "ALGO_TABLE rows must be ordered by ALGO_* id and version bits");
+
+inline bool IsEquihashAlgo(uint8_t algo)
+{
+    return algo < NUM_ALGOS && ALGO_TABLE[algo].fEquihashHeader;
+}
+
 std::string GetAlgoName(uint8_t Algo);
 
+/**
+ * Look up an algo by its name or one of the common aliases miners use for it
+ * (e.g. "lyra2rev2", "sia"). The name must be lower case.
+ * @return false if the name is unknown.
+ */
+bool GetAlgoByName(const std::string& strAlgo, uint8_t& algo);
+
 /**
  * Pure Version that will inherit to all other Block classes
  * Includes nVersion and AuxPow stuff.
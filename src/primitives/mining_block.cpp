@@ -19,6 +19,7 @@
 #include <chainparams.h>
 #include <crypto/common.h>
 #include <crypto/algos/hashlib/multihash.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
 #include <crypto/algos/neoscrypt/neoscrypt.h>
 #include <crypto/algos/scrypt/scrypt.h>
 #include <crypto/algos/yescrypt/yescrypt.h>
@@ -35,139 +36,109 @@ uint256 CEquihashBlockHeader::GetHash() const
     return SerializeHash(*this);
 }
 
-uint256 CDefaultBlockHeader::GetPoWHash(uint8_t algo) const
+namespace {
+typedef uint256 (*PoWHashFunction)(const CDefaultBlockHeader& h);
+
+/** PoW hash of each algo, indexed by ALGO_* id (same order as ALGO_TABLE). */
+const PoWHashFunction POW_HASH_TABLE[] = {
+    /* ALGO_SHA256D */      [](const CDefaultBlockHeader& h) { return h.GetHash(); },
+    /* ALGO_SCRYPT */       [](const CDefaultBlockHeader& h) -> uint256 {
+                                uint256 thash;
+                                scrypt_1024_1_1_256(BEGIN(h.nVersion), BEGIN(thash));
+                                return thash;
+                            },
+    /* ALGO_X11 */          [](const CDefaultBlockHeader& h) { return HashX11(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_NEOSCRYPT */    [](const CDefaultBlockHeader& h) -> uint256 {
+                                unsigned int profile = 0x0;
+                                uint256 thash;
+                                neoscrypt((unsigned char *) &h.nVersion, (unsigned char *) &thash, profile);
+                                return thash;
+                            },
+    /* ALGO_EQUIHASH */     [](const CDefaultBlockHeader& h) { return h.GetHash(); },
+    /* ALGO_YESCRYPT */     [](const CDefaultBlockHeader& h) -> uint256 {
+                                uint256 thash;
+                                yescrypt_hash(BEGIN(h.nVersion), BEGIN(thash));
+                                return thash;
+                            },
+    /* ALGO_HMQ1725 */      [](const CDefaultBlockHeader& h) { return HMQ1725(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_XEVAN */        [](const CDefaultBlockHeader& h) { return XEVAN(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_NIST5 */        [](const CDefaultBlockHeader& h) { return NIST5(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_TIMETRAVEL10 */ [](const CDefaultBlockHeader& h) { return HashTimeTravel(BEGIN(h.nVersion), END(h.nNonce), h.nTime); },
+    /* ALGO_PAWELHASH */    [](const CDefaultBlockHeader& h) { return PawelHash(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_X13 */          [](const CDefaultBlockHeader& h) { return HashX13(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_X14 */          [](const CDefaultBlockHeader& h) { return HashX14(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_X15 */          [](const CDefaultBlockHeader& h) { return HashX15(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_X17 */          [](const CDefaultBlockHeader& h) { return HashX17(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_LYRA2RE */      [](const CDefaultBlockHeader& h) -> uint256 {
+                                uint256 thash;
+                                lyra2re2_hash(BEGIN(h.nVersion), BEGIN(thash));
+                                return thash;
+                            },
+    /* ALGO_BLAKE2S */      [](const CDefaultBlockHeader& h) { return HashBlake2S(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_BLAKE2B */      [](const CDefaultBlockHeader& h) { return HashBlake2B(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_ASTRALHASH */   [](const CDefaultBlockHeader& h) { return AstralHash(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_PADIHASH */     [](const CDefaultBlockHeader& h) { return PadiHash(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_JEONGHASH */    [](const CDefaultBlockHeader& h) { return JeongHash(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_KECCAK */       [](const CDefaultBlockHeader& h) { return HashKeccak(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_ZHASH */        [](const CDefaultBlockHeader& h) { return h.GetHash(); },
+    /* ALGO_GLOBALHASH */   [](const CDefaultBlockHeader& h) { return GlobalHash(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_SKEIN */        [](const CDefaultBlockHeader& h) { return HashSkein(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_GROESTL */      [](const CDefaultBlockHeader& h) { return HashGroestl(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_QUBIT */        [](const CDefaultBlockHeader& h) { return HashQubit(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_SKUNKHASH */    [](const CDefaultBlockHeader& h) { return SkunkHash5(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_QUARK */        [](const CDefaultBlockHeader& h) { return QUARK(BEGIN(h.nVersion), END(h.nNonce)); },
+    /* ALGO_X16R */         [](const CDefaultBlockHeader& h) { return HashX16R(BEGIN(h.nVersion), END(h.nNonce), h.hashPrevBlock); },
+};
+
+static_assert(sizeof(POW_HASH_TABLE) / sizeof(POW_HASH_TABLE[0]) == NUM_ALGOS, "POW_HASH_TABLE needs one entry per algo");
+
+typedef void (*PoWHashBatchFunction)(const unsigned char* const in[], uint256 out[], size_t n);
+
+/** Multi-lane PoW hash of the algos that have one, null otherwise. */
+PoWHashBatchFunction GetPoWHashBatchFunction(uint8_t algo)
 {
-    switch (algo)
-    {
-        case ALGO_SHA256D:
-            return GetHash();
-        case ALGO_SCRYPT:
-        {
-            uint256 thash;
-            scrypt_1024_1_1_256(BEGIN(nVersion), BEGIN(thash));
-            return thash;
-        }
-        case ALGO_X11:
-        {
-            return HashX11(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_NEOSCRYPT:
-        {
-            unsigned int profile = 0x0;
-            uint256 thash;
-            neoscrypt((unsigned char *) &nVersion, (unsigned char *) &thash, profile);				
-            return thash;
-        }
-        case ALGO_EQUIHASH:
-            return GetHash();
-        case ALGO_YESCRYPT:
-        {
-            uint256 thash;
-            yescrypt_hash(BEGIN(nVersion), BEGIN(thash));
-            return thash;
-        }
-        case ALGO_HMQ1725:
-        {
-            return HMQ1725(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_XEVAN:
-        {
-            return XEVAN(BEGIN(nVersion), END(nNonce));	    
-        }
-        case ALGO_NIST5:
-        {
-            return NIST5(BEGIN(nVersion), END(nNonce));	    
-        }
-        case ALGO_TIMETRAVEL10:
-        {
-            return HashTimeTravel(BEGIN(nVersion), END(nNonce), nTime);	    
-        }
-        case ALGO_PAWELHASH:
-        {
-            return PawelHash(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_X13:
-        {
-            return HashX13(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_X14:
-        {
-            return HashX14(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_X15:
-        {
-            return HashX15(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_X17:
-        {
-            return HashX17(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_LYRA2RE:
-        {
-            uint256 thash;
-            lyra2re2_hash(BEGIN(nVersion), BEGIN(thash));
-            return thash;
-        }
-        case ALGO_BLAKE2S:
-        {
-            return HashBlake2S(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_BLAKE2B:
-        {
-            return HashBlake2B(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_ASTRALHASH:
-        {
-            return AstralHash(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_PADIHASH:
-        {
-            return PadiHash(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_JEONGHASH:
-        {
-            return JeongHash(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_KECCAK:
-        {
-            return HashKeccak(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_ZHASH:
-        {
-            return GetHash();
-        }
-        case ALGO_GLOBALHASH:
-        {
-            return GlobalHash(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_GROESTL:
-        {
-            return HashGroestl(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_SKEIN:
-        {
-            return HashSkein(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_QUBIT:
-        {
-            return HashQubit(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_SKUNKHASH:
-        {
-            return SkunkHash5(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_QUARK:
-        {
-            return QUARK(BEGIN(nVersion), END(nNonce));
-        }
-        case ALGO_X16R:
-        {
-            return HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock);
-        }
+    switch (algo) {
+    case ALGO_X11: return HashX11Batch;
+    case ALGO_X13: return HashX13Batch;
+    case ALGO_X14: return HashX14Batch;
+    case ALGO_X15: return HashX15Batch;
+    case ALGO_X17: return HashX17Batch;
+    default: return nullptr;
     }
+}
+} // namespace
+
+uint256 CDefaultBlockHeader::GetPoWHash(uint8_t algo) const
+{
+    if (algo < NUM_ALGOS)
+        return POW_HASH_TABLE[algo](*this);
     return GetHash();
 }
 
+bool CDefaultBlockHeader::HasPoWHashBatch(uint8_t algo)
+{
+    return GetPoWHashBatchFunction(algo) != nullptr;
+}
+
+void CDefaultBlockHeader::GetPoWHashBatch(uint8_t algo, const CDefaultBlockHeader* headers, uint256* hashes, size_t n)
+{
+    const PoWHashBatchFunction batch = GetPoWHashBatchFunction(algo);
+    if (!batch) {
+        for (size_t i = 0; i < n; i++)
+            hashes[i] = headers[i].GetPoWHash(algo);
+        return;
+    }
+
+    // The hashed 80 bytes run from nVersion to nNonce, as in POW_HASH_TABLE.
+    const unsigned char* in[16 * MULTIHASH_LANES];
+    for (size_t i = 0; i < n; i += ARRAYLEN(in)) {
+        const size_t count = std::min(n - i, ARRAYLEN(in));
+        for (size_t j = 0; j < count; j++)
+            in[j] = (const unsigned char*)BEGIN(headers[i + j].nVersion);
+        batch(in, hashes + i, count);
+    }
+}
+
 std::string CDefaultBlock::ToString() const
 {
     std::stringstream s;
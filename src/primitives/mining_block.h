@@ -61,6 +61,14 @@ public:
 	
     uint256 GetPoWHash(uint8_t algo) const;
 
+    /** Whether GetPoWHashBatch has multi-lane kernels for algo. */
+    static bool HasPoWHashBatch(uint8_t algo);
+
+    /** GetPoWHash(algo) of n headers at once, so that hashes[i] is
+     *  headers[i].GetPoWHash(algo). Algos without multi-lane kernels fall
+     *  back to hashing one header at a time. */
+    static void GetPoWHashBatch(uint8_t algo, const CDefaultBlockHeader* headers, uint256* hashes, size_t n);
+
     int64_t GetBlockTime() const
     {
         return (int64_t)nTime;
@@ -48,7 +48,7 @@ uint256 CPureBlockHeader::GetPoWHash() const
 
 uint256 CPureBlockHeader::GetPoWHash(uint8_t nAlgo) const
 {
-    if(nAlgo == ALGO_EQUIHASH || nAlgo == ALGO_ZHASH)
+    if(IsEquihashAlgo(nAlgo))
     {
         CEquihashBlockHeader block;
         block = CPureBlockHeader::GetEquihashBlockHeader();
@@ -63,69 +63,9 @@ uint8_t CPureBlockHeader::GetAlgo() const
 {
     if(IsLegacyVersion(nVersion))
         return ALGO_SHA256D;
-    
-    switch (nVersion & BLOCK_VERSION_ALGO)
-    {
-        case BLOCK_VERSION_SHA256D:
-            return ALGO_SHA256D;
-        case BLOCK_VERSION_SCRYPT:
-            return ALGO_SCRYPT;
-        case BLOCK_VERSION_X11:
-            return ALGO_X11;
-        case BLOCK_VERSION_NEOSCRYPT:
-            return ALGO_NEOSCRYPT;
-        case BLOCK_VERSION_EQUIHASH:
-            return ALGO_EQUIHASH;
-        case BLOCK_VERSION_YESCRYPT:
-            return ALGO_YESCRYPT;
-        case BLOCK_VERSION_HMQ1725:
-            return ALGO_HMQ1725;
-        case BLOCK_VERSION_XEVAN:
-            return ALGO_XEVAN;
-        case BLOCK_VERSION_NIST5:
-            return ALGO_NIST5;
-        case BLOCK_VERSION_TIMETRAVEL10:
-            return ALGO_TIMETRAVEL10;
-        case BLOCK_VERSION_PAWELHASH:
-            return ALGO_PAWELHASH;
-        case BLOCK_VERSION_X13:
-            return ALGO_X13;
-        case BLOCK_VERSION_X14:
-            return ALGO_X14;
-        case BLOCK_VERSION_X15:
-            return ALGO_X15;
-        case BLOCK_VERSION_X17:
-            return ALGO_X17;
-        case BLOCK_VERSION_LYRA2RE:
-            return ALGO_LYRA2RE;
-        case BLOCK_VERSION_BLAKE2S:
-            return ALGO_BLAKE2S;
-        case BLOCK_VERSION_BLAKE2B:
-            return ALGO_BLAKE2B;
-        case BLOCK_VERSION_ASTRALHASH:
-            return ALGO_ASTRALHASH;
-        case BLOCK_VERSION_PADIHASH:
-            return ALGO_PADIHASH;
-        case BLOCK_VERSION_JEONGHASH:
-            return ALGO_JEONGHASH;
-        case BLOCK_VERSION_KECCAK:
-            return ALGO_KECCAK;
-        case BLOCK_VERSION_ZHASH:
-            return ALGO_ZHASH;
-        case BLOCK_VERSION_GLOBALHASH:
-            return ALGO_GLOBALHASH;
-        case BLOCK_VERSION_GROESTL:
-            return ALGO_GROESTL;
-        case BLOCK_VERSION_SKEIN:
-            return ALGO_SKEIN;
-        case BLOCK_VERSION_QUBIT:
-            return ALGO_QUBIT;
-        case BLOCK_VERSION_SKUNKHASH:
-            return ALGO_SKUNKHASH;
-        case BLOCK_VERSION_QUARK:
-            return ALGO_QUARK;
-        case BLOCK_VERSION_X16R:
-            return ALGO_X16R;
-    }
-    return ALGO_SHA256D;
+
+    int algo = ((nVersion & BLOCK_VERSION_ALGO) >> 9) - 1;
+    if (algo < 0 || algo >= NUM_ALGOS)
+        return ALGO_SHA256D;
+    return algo;
 }
\ No newline at end of file
@@ -66,7 +66,7 @@ double GetDifficulty(const CChain& chain, const CBlockIndex* blockindex, uint8_t
         else
         {
             //blockindex = chainActive.Tip();
-            blockindex = GetLastBlockIndexForAlgo(chain.Tip(), algo);
+            blockindex = chain.TipForAlgo(algo);
             if (blockindex == nullptr)
                 nBits = powLimit;
             else
@@ -186,7 +186,7 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     CBlockHeader header = blockindex->GetBlockHeader(Params().GetConsensus());
     bool isauxpow = header.auxpow && (header.auxpow != nullptr);
 	CBlockIndex *pnext = chainActive.Next(blockindex);
-	const CBlockIndex* plastAlgo = GetLastBlockIndexForAlgo(blockindex->pprev, algo);
+	const CBlockIndex* plastAlgo = blockindex->pprevSameAlgo;
 	const CBlockIndex* pnextAlgo = GetNextBlockIndexForAlgo(pnext, algo);
     result.pushKV("hash", blockindex->GetBlockHash().GetHex());
 	result.pushKV("algo", GetAlgoName(algo));
@@ -206,9 +206,9 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     result.pushKV("time", (int64_t)blockindex->nTime);
     result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
     result.pushKV("nonce", (uint64_t)blockindex->nNonce);
-    result.pushKV("bignonce", blockindex->nBigNonce.GetHex());
+    result.pushKV("bignonce", header.nBigNonce.GetHex());
     if(!isauxpow)
-        result.pushKV("solution", HexStr(blockindex->nSolution));
+        result.pushKV("solution", HexStr(header.nSolution));
     result.pushKV("bits", strprintf("%08x", blockindex->nBits));
     result.pushKV("difficulty", GetDifficulty(blockindex, algo));
     result.pushKV("chainwork", blockindex->nChainWork.GetHex());
@@ -231,7 +231,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
 	uint8_t algo = block.GetAlgo();
     bool isauxpow = block.auxpow && (block.auxpow != nullptr);
 	CBlockIndex *pnext = chainActive.Next(blockindex);
-	const CBlockIndex* plastAlgo = GetLastBlockIndexForAlgo(blockindex->pprev, algo);
+	const CBlockIndex* plastAlgo = blockindex->pprevSameAlgo;
 	const CBlockIndex* pnextAlgo = GetNextBlockIndexForAlgo(pnext, algo);
     result.pushKV("hash", blockindex->GetBlockHash().GetHex());
     int confirmations = -1;
@@ -268,7 +268,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     result.pushKV("nonce", (uint64_t)block.nNonce);
     result.pushKV("bignonce", block.nBigNonce.GetHex());
     if(!isauxpow)
-        result.pushKV("solution", HexStr(blockindex->nSolution));
+        result.pushKV("solution", HexStr(block.nSolution));
     result.pushKV("bits", strprintf("%08x", block.nBits));
     result.pushKV("difficulty", GetDifficulty(blockindex, algo));
     result.pushKV("chainwork", blockindex->nChainWork.GetHex());
@@ -28,8 +28,50 @@
 #include <iomanip>
 #include <univalue.h>
 
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
 UniValue masternodelist(const JSONRPCRequest& request);
 
+/** Parse a page size given as number or, when forwarded by "masternode list" or "masternode winners", as string. */
+static int ParseListLimit(const UniValue& value)
+{
+    int nLimit;
+    if (value.isNum())
+        nLimit = value.get_int();
+    else if (!ParseInt32(value.get_str(), &nLimit))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid limit, must be a number");
+    if (nLimit < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid limit, must be 0 (no limit) or more");
+    return nLimit;
+}
+
+/** Parse a masternodelist cursor, the "txid-n" outpoint of the last entry of the previous page. */
+static COutPoint ParseListCursor(const std::string& strCursor)
+{
+    size_t nPos = strCursor.rfind('-');
+    uint32_t n;
+    if (nPos != 64 || !IsHex(strCursor.substr(0, nPos)) || !ParseUInt32(strCursor.substr(nPos + 1), &n))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor, must be the 'txid-n' outpoint of a masternode");
+    return COutPoint(uint256S(strCursor.substr(0, nPos)), n);
+}
+
+/** Compact record of one masternode for masternodelist hex mode. */
+static void SerializeMasternodeCompact(CDataStream& ss, const CMasternode& mn)
+{
+    ss << mn.outpoint;
+    ss << mn.addr;
+    ss << mn.pubKeyCollateralAddress;
+    ss << mn.pubKeyMasternode;
+    ss << mn.nActiveState;
+    ss << mn.nProtocolVersion;
+    ss << mn.lastPing.nDaemonVersion;
+    ss << mn.sigTime;
+    ss << mn.lastPing.sigTime;
+    ss << mn.nTimeLastPaid;
+    ss << mn.nBlockLastPaid;
+}
+
 UniValue masternode(const JSONRPCRequest& request)
 {
     std::string strCommand;
@@ -50,7 +92,7 @@ UniValue masternode(const JSONRPCRequest& request)
 #endif // ENABLE_WALLET
          strCommand != "list" && strCommand != "list-conf" && strCommand != "count" &&
          strCommand != "debug" && strCommand != "current" && strCommand != "winner" && strCommand != "winners" && strCommand != "genkey" &&
-         strCommand != "connect" && strCommand != "status"))
+         strCommand != "connect" && strCommand != "status" && strCommand != "rankcache"))
             throw std::runtime_error(
                 "masternode \"command\"...\n"
                 "Set of commands to execute masternode related actions\n"
@@ -69,8 +111,10 @@ UniValue masternode(const JSONRPCRequest& request)
                 "  status           - Print masternode status information\n"
                 "  list             - Print list of all known masternodes (see masternodelist for more info)\n"
                 "  list-conf        - Print masternode.conf in JSON format\n"
+                "  rankcache        - Print hit rate of the cached masternode rank tables\n"
                 "  winner           - Print info on next masternode winner to vote for\n"
-                "  winners          - Print list of masternode winners\n"
+                "  winners          - Print list of masternode winners ( \"count\" \"filter\" \"cursor\" \"limit\" ), with a cursor\n"
+                "                     or limit the result is {\"winners\": {...}, \"next\": cursor of the next page or null}\n"
                 );
 
     if (strCommand == "list")
@@ -112,8 +156,9 @@ UniValue masternode(const JSONRPCRequest& request)
         masternode_info_t mnInfo;
         mnodeman.GetNextMasternodeInQueueForPayment(true, nCount, mnInfo);
 
-        int total = mnodeman.size();
-        int enabled = mnodeman.CountEnabled();
+        masternode_snapshot_ptr_t snapshot = mnodeman.GetMasternodeListSnapshot();
+        int total = snapshot->vecMasternodes.size();
+        int enabled = snapshot->CountEnabled(mnpayments.GetMinMasternodePaymentsProto());
 
         if (request.params.size() == 1) {
             UniValue obj(UniValue::VOBJ);
@@ -287,6 +332,20 @@ UniValue masternode(const JSONRPCRequest& request)
     }
 #endif // ENABLE_WALLET
 
+    if (strCommand == "rankcache")
+    {
+        size_t nTables;
+        uint64_t nHits, nMisses;
+        mnodeman.GetRankTableStats(nTables, nHits, nMisses);
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("tables", (uint64_t)nTables);
+        obj.pushKV("hits", nHits);
+        obj.pushKV("misses", nMisses);
+        obj.pushKV("hitrate", nHits + nMisses > 0 ? (double)nHits / (nHits + nMisses) : 0.0);
+        return obj;
+    }
+
     if (strCommand == "genkey")
     {
         CKey secret;
@@ -415,27 +474,59 @@ UniValue masternode(const JSONRPCRequest& request)
 
         int nLast = 10;
         std::string strFilter = "";
+        std::string strCursor = "";
+        int nLimit = 0;
 
         if (request.params.size() >= 2) {
-            nLast = atoi(request.params[1].get_str());
+            if (!ParseInt32(request.params[1].get_str(), &nLast) || nLast < 0)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid count, must be 0 or more");
         }
 
-        if (request.params.size() == 3) {
+        if (request.params.size() >= 3) {
             strFilter = request.params[2].get_str();
         }
 
-        if (request.params.size() > 3)
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "Correct usage is 'masternode winners ( \"count\" \"filter\" )'");
+        if (request.params.size() >= 4) {
+            strCursor = request.params[3].get_str();
+        }
+
+        if (request.params.size() >= 5) {
+            nLimit = ParseListLimit(request.params[4]);
+        }
+
+        if (request.params.size() > 5)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Correct usage is 'masternode winners ( \"count\" \"filter\" \"cursor\" \"limit\" )'");
+
+        // a page starts right after the cursor, the last height of the previous page
+        int nStart = nHeight - nLast;
+        if (!strCursor.empty()) {
+            int nCursor;
+            if (!ParseInt32(strCursor, &nCursor))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor, must be the block height of the last winner of the previous page");
+            nStart = std::max(nStart, nCursor + 1);
+        }
 
         UniValue obj(UniValue::VOBJ);
+        UniValue next(UniValue::VNULL);
+        int nCount = 0;
 
-        for(int i = nHeight - nLast; i < nHeight + 20; i++) {
+        for(int i = nStart; i < nHeight + 20; i++) {
+            if (nLimit > 0 && nCount == nLimit) {
+                next = strprintf("%d", i - 1);
+                break;
+            }
             std::string strPayment = GetRequiredPaymentsString(i);
             if (strFilter !="" && strPayment.find(strFilter) == std::string::npos) continue;
             obj.pushKV(strprintf("%d", i), strPayment);
+            nCount++;
         }
 
-        return obj;
+        if (strCursor.empty() && nLimit == 0) return obj;
+
+        UniValue page(UniValue::VOBJ);
+        page.pushKV("winners", obj);
+        page.pushKV("next", next);
+        return page;
     }
 
     return NullUniValue;
@@ -445,23 +536,43 @@ UniValue masternodelist(const JSONRPCRequest& request)
 {
     std::string strMode = "json";
     std::string strFilter = "";
+    std::string strCursor = "";
+    int nLimit = 0;
+    std::set<std::string> setFields;
 
     if (request.params.size() >= 1) strMode = request.params[0].get_str();
-    if (request.params.size() == 2) strFilter = request.params[1].get_str();
+    if (request.params.size() >= 2) strFilter = request.params[1].get_str();
+    if (request.params.size() >= 3) strCursor = request.params[2].get_str();
+    if (request.params.size() >= 4) nLimit = ParseListLimit(request.params[3]);
+    if (request.params.size() >= 5) {
+        static const std::set<std::string> setJsonFields = {"address", "payee", "status", "protocol", "daemonversion",
+                                                            "lastseen", "activeseconds", "lastpaidtime", "lastpaidblock"};
+        std::vector<std::string> vecFields;
+        boost::split(vecFields, request.params[4].get_str(), boost::is_any_of(","));
+        for (const std::string& strField : vecFields) {
+            if (strField.empty()) continue;
+            if (!setJsonFields.count(strField))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown field " + strField);
+            setFields.insert(strField);
+        }
+    }
 
-    if (request.fHelp || (
+    if (request.fHelp || request.params.size() > 5 || (
                 strMode != "activeseconds" && strMode != "addr" && strMode != "daemon" && strMode != "full" && strMode != "info" && strMode != "json" &&
-                strMode != "lastseen" && strMode != "lastpaidtime" && strMode != "lastpaidblock" &&
+                strMode != "hex" && strMode != "lastseen" && strMode != "lastpaidtime" && strMode != "lastpaidblock" &&
                 strMode != "protocol" && strMode != "payee" && strMode != "pubkey" &&
                 strMode != "rank" && strMode != "status"))
     {
         throw std::runtime_error(
-                "masternodelist ( \"mode\" \"filter\" )\n"
+                "masternodelist ( \"mode\" \"filter\" \"cursor\" limit \"fields\" )\n"
                 "Get a list of masternodes in different modes\n"
                 "\nArguments:\n"
                 "1. \"mode\"      (string, optional/required to use filter, defaults = json) The mode to run list in\n"
                 "2. \"filter\"    (string, optional) Filter results. Partial match by outpoint by default in all modes,\n"
                 "                                    additional matches in some modes are also available\n"
+                "3. \"cursor\"    (string, optional) Start after this outpoint, the \"next\" value of the previous page\n"
+                "4. limit       (numeric, optional, default=0) Return at most this many masternodes, 0 for all of them\n"
+                "5. \"fields\"    (string, optional) Comma separated fields to return in json mode, e.g. \"address,status\"\n"
                 "\nAvailable modes:\n"
                 "  activeseconds  - Print number of seconds masternode recognized by the network as enabled\n"
                 "                   (since latest issued \"masternode start/start-many/start-alias\")\n"
@@ -469,6 +580,9 @@ UniValue masternodelist(const JSONRPCRequest& request)
                 "  daemon         - Print daemon version of a masternode (can be additionally filtered, exact match)\n"
                 "  full           - Print info in format 'status protocol payee lastseen activeseconds lastpaidtime lastpaidblock IP'\n"
                 "                   (can be additionally filtered, partial match)\n"
+                "  hex            - Print the masternodes as one hex string: their count, then for each one outpoint, addr,\n"
+                "                   collateral and masternode pubkeys, state, protocol, daemon version, sigtime, lastseen,\n"
+                "                   lastpaidtime and lastpaidblock, serialized as in the p2p protocol (filtered by outpoint only)\n"
                 "  info           - Print info in format 'status protocol payee lastseen activeseconds IP'\n"
                 "                   (can be additionally filtered, partial match)\n"
                 "  json           - Print info in JSON format (can be additionally filtered, partial match)\n"
@@ -479,13 +593,37 @@ UniValue masternodelist(const JSONRPCRequest& request)
                 "                   partial match)\n"
                 "  protocol       - Print protocol of a masternode (can be additionally filtered, exact match)\n"
                 "  pubkey         - Print the masternode (not collateral) public key\n"
-                "  rank           - Print rank of a masternode based on current block\n"
+                "  rank           - Print rank of a masternode based on current block (no cursor or limit)\n"
                 "  status         - Print masternode status: PRE_ENABLED / ENABLED / EXPIRED / NEW_START_REQUIRED /\n"
                 "                   UPDATE_REQUIRED / POSE_BAN / OUTPOINT_SPENT (can be additionally filtered, partial match)\n"
+                "\nResult when a cursor or limit is given:\n"
+                "{\n"
+                "  \"masternodes\": ...,    (object or string) The page, as the mode prints it\n"
+                "  \"next\": \"txid-n\"       (string or null) Cursor of the next page, null after the last one\n"
+                "}\n"
+                "\nExamples:\n"
+                + HelpExampleCli("masternodelist", "json \"\" \"\" 100 \"address,status\"")
+                + HelpExampleRpc("masternodelist", "\"json\", \"\", \"\", 100, \"address,status\"")
                 );
     }
 
-    if (strMode == "full" || strMode == "json" || strMode == "lastpaidtime" || strMode == "lastpaidblock") {
+    bool fPaged = !strCursor.empty() || nLimit > 0;
+
+    if (strMode == "rank") {
+        if (fPaged)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "rank mode doesn't support cursor or limit");
+        UniValue obj(UniValue::VOBJ);
+        CMasternodeMan::rank_pair_vec_t vMasternodeRanks;
+        mnodeman.GetMasternodeRanks(vMasternodeRanks);
+        for (const auto& rankpair : vMasternodeRanks) {
+            std::string strOutpoint = rankpair.second.outpoint.ToStringShort();
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, rankpair.first);
+        }
+        return obj;
+    }
+
+    if (strMode == "full" || strMode == "json" || strMode == "hex" || strMode == "lastpaidtime" || strMode == "lastpaidblock") {
         CBlockIndex* pindex = nullptr;
         {
             LOCK(cs_main);
@@ -494,62 +632,74 @@ UniValue masternodelist(const JSONRPCRequest& request)
         mnodeman.UpdateLastPaid(pindex);
     }
 
+    // the snapshot is ordered by outpoint, a page starts right after the cursor
+    masternode_snapshot_ptr_t snapshot = mnodeman.GetMasternodeListSnapshot();
+    auto itBegin = snapshot->vecMasternodes.begin();
+    if (!strCursor.empty()) {
+        COutPoint outpointCursor = ParseListCursor(strCursor);
+        itBegin = std::upper_bound(snapshot->vecMasternodes.begin(), snapshot->vecMasternodes.end(), outpointCursor,
+            [](const COutPoint& outpoint, const std::shared_ptr<const CMasternode>& pmn) { return outpoint < pmn->outpoint; });
+    }
+
     UniValue obj(UniValue::VOBJ);
-    if (strMode == "rank") {
-        CMasternodeMan::rank_pair_vec_t vMasternodeRanks;
-        mnodeman.GetMasternodeRanks(vMasternodeRanks);
-        for (const auto& rankpair : vMasternodeRanks) {
-            std::string strOutpoint = rankpair.second.outpoint.ToStringShort();
-            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-            obj.pushKV(strOutpoint, rankpair.first);
+    std::vector<const CMasternode*> vecCompact;
+    int nCount = 0;
+    UniValue next(UniValue::VNULL);
+    for (auto it = itBegin; it != snapshot->vecMasternodes.end(); ++it) {
+        const CMasternode& mn = **it;
+        std::string strOutpoint = mn.outpoint.ToStringShort();
+        if (nLimit > 0 && nCount == nLimit) {
+            // the previous entry closes this page
+            next = (*std::prev(it))->outpoint.ToStringShort();
+            break;
         }
-    } else {
-        std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-        for (const auto& mnpair : mapMasternodes) {
-            CMasternode mn = mnpair.second;
-            std::string strOutpoint = mnpair.first.ToStringShort();
-            if (strMode == "activeseconds") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, (int64_t)(mn.lastPing.sigTime - mn.sigTime));
-            } else if (strMode == "addr") {
-                std::string strAddress = mn.addr.ToString();
-                if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, strAddress);
-            } else if (strMode == "daemon") {
-                std::string strDaemon = mn.lastPing.nDaemonVersion > DEFAULT_DAEMON_VERSION ? FormatVersion(mn.lastPing.nDaemonVersion) : "Unknown";
-                if (strFilter !="" && strDaemon.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, strDaemon);
-            } else if (strMode == "full") {
-                std::ostringstream streamFull;
-                streamFull << std::setw(18) <<
-                               mn.GetStatus() << " " <<
-                               mn.nProtocolVersion << " " <<
-                               EncodeDestination(mn.pubKeyCollateralAddress.GetID()) << " " <<
-                               (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
-                               (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " << std::setw(10) <<
-                               mn.GetLastPaidTime() << " "  << std::setw(6) <<
-                               mn.GetLastPaidBlock() << " " <<
-                               mn.addr.ToString();
-                std::string strFull = streamFull.str();
-                if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, strFull);
-            } else if (strMode == "info") {
-                std::ostringstream streamInfo;
-                streamInfo << std::setw(18) <<
-                               mn.GetStatus() << " " <<
-                               mn.nProtocolVersion << " " <<
-                               EncodeDestination(mn.pubKeyCollateralAddress.GetID()) << " " <<
-                               (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
-                               (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " <<
-                               mn.addr.ToString();
-                std::string strInfo = streamInfo.str();
-                if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, strInfo);
-            } else if (strMode == "json") {
+        if (strMode == "activeseconds") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, (int64_t)(mn.lastPing.sigTime - mn.sigTime));
+        } else if (strMode == "addr") {
+            std::string strAddress = mn.addr.ToString();
+            if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, strAddress);
+        } else if (strMode == "daemon") {
+            std::string strDaemon = mn.lastPing.nDaemonVersion > DEFAULT_DAEMON_VERSION ? FormatVersion(mn.lastPing.nDaemonVersion) : "Unknown";
+            if (strFilter !="" && strDaemon.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, strDaemon);
+        } else if (strMode == "full") {
+            std::ostringstream streamFull;
+            streamFull << std::setw(18) <<
+                           mn.GetStatus() << " " <<
+                           mn.nProtocolVersion << " " <<
+                           EncodeDestination(mn.pubKeyCollateralAddress.GetID()) << " " <<
+                           (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
+                           (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " << std::setw(10) <<
+                           mn.GetLastPaidTime() << " "  << std::setw(6) <<
+                           mn.GetLastPaidBlock() << " " <<
+                           mn.addr.ToString();
+            std::string strFull = streamFull.str();
+            if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, strFull);
+        } else if (strMode == "hex") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            vecCompact.push_back(&mn);
+        } else if (strMode == "info") {
+            std::ostringstream streamInfo;
+            streamInfo << std::setw(18) <<
+                           mn.GetStatus() << " " <<
+                           mn.nProtocolVersion << " " <<
+                           EncodeDestination(mn.pubKeyCollateralAddress.GetID()) << " " <<
+                           (int64_t)mn.lastPing.sigTime << " " << std::setw(8) <<
+                           (int64_t)(mn.lastPing.sigTime - mn.sigTime) << " " <<
+                           mn.addr.ToString();
+            std::string strInfo = streamInfo.str();
+            if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, strInfo);
+        } else if (strMode == "json") {
+            // the joined string is only needed to apply the filter
+            if (strFilter != "") {
                 std::ostringstream streamInfo;
                 streamInfo <<  mn.addr.ToString() << " " <<
                                EncodeDestination(mn.pubKeyCollateralAddress.GetID()) << " " <<
@@ -561,49 +711,69 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.GetLastPaidTime() << " " <<
                                mn.GetLastPaidBlock();
                 std::string strInfo = streamInfo.str();
-                if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                UniValue objMN(UniValue::VOBJ);
-                objMN.pushKV("address", mn.addr.ToString());
-                objMN.pushKV("payee", EncodeDestination(mn.pubKeyCollateralAddress.GetID()));
-                objMN.pushKV("status", mn.GetStatus());
-                objMN.pushKV("protocol", mn.nProtocolVersion);
-                objMN.pushKV("daemonversion", mn.lastPing.nDaemonVersion > DEFAULT_DAEMON_VERSION ? FormatVersion(mn.lastPing.nDaemonVersion) : "Unknown");
-                objMN.pushKV("lastseen", (int64_t)mn.lastPing.sigTime);
-                objMN.pushKV("activeseconds", (int64_t)(mn.lastPing.sigTime - mn.sigTime));
-                objMN.pushKV("lastpaidtime", mn.GetLastPaidTime());
-                objMN.pushKV("lastpaidblock", mn.GetLastPaidBlock());
-                obj.pushKV(strOutpoint, objMN);
-            } else if (strMode == "lastpaidblock") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, mn.GetLastPaidBlock());
-            } else if (strMode == "lastpaidtime") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, mn.GetLastPaidTime());
-            } else if (strMode == "lastseen") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, (int64_t)mn.lastPing.sigTime);
-            } else if (strMode == "payee") {
-                std::string strPayee = EncodeDestination(mn.pubKeyCollateralAddress.GetID());
-                if (strFilter !="" && strPayee.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, strPayee);
-            } else if (strMode == "protocol") {
-                if (strFilter !="" && strFilter != strprintf("%d", mn.nProtocolVersion) &&
+                if (strInfo.find(strFilter) == std::string::npos &&
                     strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, mn.nProtocolVersion);
-            } else if (strMode == "pubkey") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, HexStr(mn.pubKeyMasternode));
-            } else if (strMode == "status") {
-                std::string strStatus = mn.GetStatus();
-                if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
-                obj.pushKV(strOutpoint, strStatus);
             }
+            auto fField = [&setFields](const char* pszField) { return setFields.empty() || setFields.count(pszField); };
+            UniValue objMN(UniValue::VOBJ);
+            if (fField("address")) objMN.pushKV("address", mn.addr.ToString());
+            if (fField("payee")) objMN.pushKV("payee", EncodeDestination(mn.pubKeyCollateralAddress.GetID()));
+            if (fField("status")) objMN.pushKV("status", mn.GetStatus());
+            if (fField("protocol")) objMN.pushKV("protocol", mn.nProtocolVersion);
+            if (fField("daemonversion")) objMN.pushKV("daemonversion", mn.lastPing.nDaemonVersion > DEFAULT_DAEMON_VERSION ? FormatVersion(mn.lastPing.nDaemonVersion) : "Unknown");
+            if (fField("lastseen")) objMN.pushKV("lastseen", (int64_t)mn.lastPing.sigTime);
+            if (fField("activeseconds")) objMN.pushKV("activeseconds", (int64_t)(mn.lastPing.sigTime - mn.sigTime));
+            if (fField("lastpaidtime")) objMN.pushKV("lastpaidtime", mn.GetLastPaidTime());
+            if (fField("lastpaidblock")) objMN.pushKV("lastpaidblock", mn.GetLastPaidBlock());
+            obj.pushKV(strOutpoint, objMN);
+        } else if (strMode == "lastpaidblock") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, mn.GetLastPaidBlock());
+        } else if (strMode == "lastpaidtime") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, mn.GetLastPaidTime());
+        } else if (strMode == "lastseen") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, (int64_t)mn.lastPing.sigTime);
+        } else if (strMode == "payee") {
+            std::string strPayee = EncodeDestination(mn.pubKeyCollateralAddress.GetID());
+            if (strFilter !="" && strPayee.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, strPayee);
+        } else if (strMode == "protocol") {
+            if (strFilter !="" && strFilter != strprintf("%d", mn.nProtocolVersion) &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, mn.nProtocolVersion);
+        } else if (strMode == "pubkey") {
+            if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, HexStr(mn.pubKeyMasternode));
+        } else if (strMode == "status") {
+            std::string strStatus = mn.GetStatus();
+            if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
+                strOutpoint.find(strFilter) == std::string::npos) continue;
+            obj.pushKV(strOutpoint, strStatus);
         }
+        nCount++;
     }
-    return obj;
+
+    UniValue result(UniValue::VNULL);
+    if (strMode == "hex") {
+        CDataStream ssCompact(SER_NETWORK, PROTOCOL_VERSION);
+        WriteCompactSize(ssCompact, vecCompact.size());
+        for (const CMasternode* pmn : vecCompact) {
+            SerializeMasternodeCompact(ssCompact, *pmn);
+        }
+        result = HexStr(ssCompact.begin(), ssCompact.end());
+    } else {
+        result = obj;
+    }
+
+    if (!fPaged) return result;
+
+    UniValue page(UniValue::VOBJ);
+    page.pushKV("masternodes", result);
+    page.pushKV("next", next);
+    return page;
 }
 
 bool DecodeHexVecMnb(std::vector<CMasternodeBroadcast>& vecMnb, std::string strHexMnb) {
@@ -862,7 +1032,7 @@ static const CRPCCommand commands[] =
 { //  category                     name                      actor (function)         argNames
   //  ---------------------        ------------------------  -----------------------  ----------
     { "huntcoin",               "masternode",             &masternode,             {} },
-    { "huntcoin",               "masternodelist",         &masternodelist,         {} },
+    { "huntcoin",               "masternodelist",         &masternodelist,         {"mode","filter","cursor","limit","fields"} },
     { "huntcoin",               "masternodebroadcast",    &masternodebroadcast,    {} },
 };
 
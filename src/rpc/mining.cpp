@@ -10,14 +10,18 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <base58.h>
+#include <algostats.h>
 #include <amount.h>
+#include <auxworkcache.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <consensus/consensus.h>
+#include <consensus/merkle.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <crypto/algos/equihash/equihash.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
 #include <huntcoin/hardfork.h>
 #include <init.h>
 #include <validation.h>
@@ -39,8 +43,12 @@
 #include <masternode-payments.h>
 #include <masternode-sync.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
+#include <thread>
 
 unsigned int ParseConfirmTarget(const UniValue& value)
 {
@@ -215,16 +223,380 @@ UniValue getnetworkhashps(const JSONRPCRequest& request)
     return GetNetworkHashPS(!request.params[0].isNull() ? request.params[0].get_int() : 120, !request.params[1].isNull() ? request.params[1].get_int() : -1);
 }
 
+/**
+ * Try the nonces of header from its current nNonce up to nEnd, MULTIHASH_LANES
+ * at a time for algos with multi-lane kernels. Leaves nNonce and nMaxTries
+ * where trying them one by one would: on the first nonce with a valid proof of
+ * work, or just past the last nonce tried.
+ */
+static void ScanNonces(CDefaultBlockHeader& header, uint8_t algo, uint32_t nEnd, uint64_t& nMaxTries)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    if (!CDefaultBlockHeader::HasPoWHashBatch(algo)) {
+        while (nMaxTries > 0 && header.nNonce < nEnd && !CheckProofOfWork(header.GetPoWHash(algo), header.nBits, consensusParams, algo)) {
+            ++header.nNonce;
+            --nMaxTries;
+        }
+        return;
+    }
+
+    CDefaultBlockHeader batch[MULTIHASH_LANES];
+    uint256 hashes[MULTIHASH_LANES];
+    while (nMaxTries > 0 && header.nNonce < nEnd) {
+        const size_t count = std::min<uint64_t>({MULTIHASH_LANES, nMaxTries, nEnd - header.nNonce});
+        for (size_t i = 0; i < count; i++) {
+            batch[i] = header;
+            batch[i].nNonce = header.nNonce + i;
+        }
+        CDefaultBlockHeader::GetPoWHashBatch(algo, batch, hashes, count);
+        for (size_t i = 0; i < count; i++) {
+            if (CheckProofOfWork(hashes[i], header.nBits, consensusParams, algo))
+                return;
+            ++header.nNonce;
+            --nMaxTries;
+        }
+    }
+}
+
+/** Nonces a generateBlocks worker claims at a time for the non-Equihash algos. */
+static const uint32_t MINER_NONCE_CHUNK = 64 * MULTIHASH_LANES;
+
+/** Hashes per second of the last generateBlocks run for each algo, for getmininginfo. */
+static std::atomic<int64_t> nMinerHashesPerSec[NUM_ALGOS];
+
+/**
+ * Nonce range of one block template, shared by the generateBlocks worker
+ * threads. Workers claim chunks of the range and of the nMaxTries budget until
+ * one of them finds a proof of work, either runs out, or the template is
+ * stopped because it went stale.
+ */
+class CMinerWork
+{
+private:
+    std::mutex cs;
+    std::condition_variable cond;
+    CBlock* const pblock;
+    uint32_t nNext;
+    const uint32_t nEnd;
+    uint64_t nTriesLeft;
+    int nWorkers;
+    bool fFound;
+    std::atomic<bool> fStop;
+    std::atomic<uint64_t> nHashes;
+
+public:
+    CMinerWork(CBlock* pblockIn, uint32_t nBeginIn, uint32_t nEndIn, uint64_t nMaxTries) :
+        pblock(pblockIn), nNext(nBeginIn), nEnd(nEndIn), nTriesLeft(nMaxTries),
+        nWorkers(0), fFound(false), fStop(false), nHashes(0) {}
+
+    /** Claim up to nWant nonces starting at nBegin. Returns false once there is nothing left to do. */
+    bool Claim(uint32_t nWant, uint32_t& nBegin, uint32_t& nCount)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (fStop || nNext >= nEnd || nTriesLeft == 0)
+            return false;
+        nBegin = nNext;
+        nCount = std::min<uint64_t>({nWant, nEnd - nNext, nTriesLeft});
+        nNext += nCount;
+        nTriesLeft -= nCount;
+        return true;
+    }
+
+    /** Give back the part of a claim that was not tried. */
+    void Unclaimed(uint32_t nCount)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nTriesLeft += nCount;
+    }
+
+    void Found(uint32_t nNonce)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (fFound)
+            return;
+        fFound = true;
+        fStop = true;
+        pblock->nNonce = nNonce;
+    }
+
+    void Found(const CEquihashBlockHeader& header)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (fFound)
+            return;
+        fFound = true;
+        fStop = true;
+        pblock->nBigNonce = header.nNonce;
+        pblock->nSolution = header.nSolution;
+    }
+
+    void Stop() { fStop = true; }
+    bool IsStopped() const { return fStop; }
+    void AddHashes(uint64_t n) { nHashes += n; }
+    uint64_t GetHashes() const { return nHashes; }
+
+    void WorkerStarted()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nWorkers++;
+    }
+
+    void WorkerFinished()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (--nWorkers == 0)
+            cond.notify_all();
+    }
+
+    /** Wait up to nMillis for all workers to finish. Returns true if they have. */
+    bool WaitForWorkers(int64_t nMillis)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        return cond.wait_for(lock, std::chrono::milliseconds(nMillis), [this] { return nWorkers == 0; });
+    }
+
+    bool IsFound()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        return fFound;
+    }
+
+    uint64_t GetTriesLeft()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        return nTriesLeft;
+    }
+};
+
+static void MineNonces(CMinerWork& work, CDefaultBlockHeader header, uint8_t algo)
+{
+    uint32_t nBegin, nCount;
+    while (work.Claim(MINER_NONCE_CHUNK, nBegin, nCount)) {
+        uint64_t nTries = nCount;
+        header.nNonce = nBegin;
+        ScanNonces(header, algo, nBegin + nCount, nTries);
+        work.AddHashes(nCount - nTries);
+        if (nTries > 0) {
+            // Only the winning nonce of the chunk is left untried.
+            work.Unclaimed(nTries - 1);
+            work.AddHashes(1);
+            work.Found(header.nNonce);
+            return;
+        }
+    }
+}
+
+/**
+ * Equihash and Zhash: each claim is one nonce past nBase, solved with the
+ * optimised solver. Workers abandon their solve as soon as the template is
+ * stopped.
+ */
+static void MineEquihash(CMinerWork& work, CEquihashBlockHeader header, unsigned int n, unsigned int k, const eh_HashState& eh_state, uint8_t algo)
+{
+    const arith_uint256 nBase = UintToArith256(header.nNonce);
+    std::function<bool(std::vector<unsigned char>)> validBlock =
+            [&header, algo](std::vector<unsigned char> soln) {
+        header.nSolution = soln;
+        return CheckProofOfWork(header.GetHash(), header.nBits, Params().GetConsensus(), algo);
+    };
+    std::function<bool(EhSolverCancelCheck)> cancelled = [&work](EhSolverCancelCheck pos) {
+        return work.IsStopped();
+    };
+
+    uint32_t nBegin, nCount;
+    while (work.Claim(1, nBegin, nCount)) {
+        // H(I||V||...
+        header.nNonce = ArithToUint256(nBase + nBegin + 1);
+        eh_HashState curr_state = eh_state;
+        crypto_generichash_blake2b_update(&curr_state, header.nNonce.begin(), header.nNonce.size());
+
+        // (x_1, x_2, ...) = A(I, V, n, k)
+        try {
+            bool found = EhOptimisedSolve(n, k, curr_state, validBlock, cancelled);
+            work.AddHashes(1);
+            if (found) {
+                work.Found(header);
+                return;
+            }
+        } catch (const EhSolverCancelledException&) {
+            return;
+        }
+    }
+}
+
+/** Number of generateBlocks worker threads from -genproclimit. */
+static int GetMinerThreads()
+{
+    int nThreads = gArgs.GetArg("-genproclimit", DEFAULT_GENERATE_THREADS);
+    if (nThreads <= 0)
+        nThreads = GetNumCores();
+    return std::max(nThreads, 1);
+}
+
+/**
+ * The generateBlocks worker threads. They are started on first use and kept
+ * across templates and generate calls, so neither the thread startup nor the
+ * per-thread PoW scratch memory is paid for every block. All threads work on
+ * the same template, one template at a time.
+ */
+class CMinerThreads
+{
+private:
+    std::mutex cs;
+    std::condition_variable condWork;
+    std::vector<std::thread> threads;
+    //! what the threads run for the current template, and its generation
+    std::function<void()> func;
+    CMinerWork* pwork;
+    uint64_t nGeneration;
+    //! how many of the threads run the current template, the others sit it out
+    size_t nActive;
+    //! how many threads picked up the current template
+    int nRunning;
+    bool fShutdown;
+
+    //! nDone is the last generation before the thread was started
+    void Thread(size_t nIndex, uint64_t nDone)
+    {
+        RenameThread("huntcoin-miner");
+        while (true) {
+            std::function<void()> funcRun;
+            CMinerWork* pworkRun;
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                condWork.wait(lock, [this, nDone] { return fShutdown || nGeneration != nDone; });
+                // A template handed out before the shutdown is still run,
+                // its caller waits for this thread to finish it.
+                if (nGeneration == nDone)
+                    return;
+                nDone = nGeneration;
+                if (nIndex >= nActive)
+                    continue;
+                funcRun = func;
+                pworkRun = pwork;
+                nRunning++;
+            }
+            try {
+                funcRun();
+            } catch (const std::exception& e) {
+                PrintExceptionContinue(&e, "miner");
+                pworkRun->Stop();
+            }
+            pworkRun->WorkerFinished();
+        }
+    }
+
+public:
+    CMinerThreads() : pwork(nullptr), nGeneration(0), nActive(0), nRunning(0), fShutdown(false) {}
+    ~CMinerThreads() { Stop(); }
+
+    /**
+     * Have nThreads threads run funcIn on work, starting the ones that are
+     * missing. Threads left over from calls that asked for more stay idle.
+     * The caller waits for the workers of work to finish before handing out
+     * the next template.
+     */
+    void Start(CMinerWork& work, const std::function<void()>& funcIn, int nThreads)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (fShutdown) {
+            work.Stop();
+            return;
+        }
+        while ((int)threads.size() < nThreads)
+            threads.emplace_back(&CMinerThreads::Thread, this, threads.size(), nGeneration);
+        for (int i = 0; i < nThreads; i++)
+            work.WorkerStarted();
+        func = funcIn;
+        pwork = &work;
+        nActive = nThreads;
+        nRunning = 0;
+        nGeneration++;
+        condWork.notify_all();
+    }
+
+    /**
+     * Join the threads once they are done with their template. Templates
+     * handed out meanwhile are stopped right away; later ones start the
+     * threads again.
+     */
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            fShutdown = true;
+            condWork.notify_all();
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        std::lock_guard<std::mutex> lock(cs);
+        threads.clear();
+        fShutdown = false;
+    }
+
+    void GetCounts(int& nThreadsRet, int& nRunningRet)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nThreadsRet = threads.size();
+        nRunningRet = nRunning;
+    }
+};
+
+static CMinerThreads minerThreads;
+//! generate calls take turns on the miner threads
+static std::mutex cs_minerThreads;
+
+void StopMinerThreads()
+{
+    minerThreads.Stop();
+}
+
+void GetMinerThreadCounts(int& nThreadsRet, int& nRunningRet)
+{
+    minerThreads.GetCounts(nThreadsRet, nRunningRet);
+}
+
+/**
+ * Run func on the -genproclimit miner threads until they are done with work.
+ * Meanwhile stop them if the tip changes, the mempool has changed for more
+ * than a minute, or the node shuts down, and keep the algo's hash rate up
+ * to date.
+ */
+static void RunMiners(CMinerWork& work, const CBlock& block, uint8_t algo, std::function<void()> func)
+{
+    std::lock_guard<std::mutex> lock(cs_minerThreads);
+    const unsigned int nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
+    const int64_t nStart = GetTimeMicros();
+
+    minerThreads.Start(work, func, GetMinerThreads());
+
+    bool fDone = false;
+    while (!fDone) {
+        fDone = work.WaitForWorkers(100);
+        const int64_t nElapsed = GetTimeMicros() - nStart;
+        if (nElapsed > 0)
+            nMinerHashesPerSec[algo] = (int64_t)(work.GetHashes() * 1000000.0 / nElapsed);
+        if (fDone)
+            break;
+
+        bool fStale = ShutdownRequested();
+        {
+            LOCK(cs_main);
+            fStale |= chainActive.Tip()->GetBlockHash() != block.hashPrevBlock;
+        }
+        fStale |= mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && nElapsed > 60 * 1000000;
+        if (fStale)
+            work.Stop();
+    }
+}
+
 UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGenerate, uint64_t nMaxTries, bool keepScript)
 {
-	static const int nInnerLoopHuntCoinMask = 0x1FFFF;
-    static const int nInnerLoopHuntCoinCount = 0x10000;
+    static const uint32_t nInnerLoopHuntCoinCount = 0x10000;
     static const int nInnerLoopEquihashMask = 0xFFFF;
-	static const int nInnerLoopEquihashCount = 0xFFFF;
+    static const int nInnerLoopEquihashCount = 0xFFFF;
     int nHeightEnd = 0;
     int nHeight = 0;
-	int nInnerLoopCount;
-	int nInnerLoopMask;
 
     {   // Don't keep cs_main locked
         LOCK(cs_main);
@@ -236,7 +608,7 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
 	const CChainParams& params = Params();
 	unsigned int n;
     unsigned int k;
-    while (nHeight < nHeightEnd)
+    while (nHeight < nHeightEnd && !ShutdownRequested())
     {
         std::unique_ptr<CBlockTemplate> pblocktemplate(BlockAssembler(Params()).CreateNewBlock(coinbaseScript->reserveScript, currentAlgo));
         if (!pblocktemplate.get())
@@ -297,94 +669,46 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
             LOCK(cs_main);
             IncrementExtraNonce(pblock, chainActive.Tip(), nExtraNonce);
         }
-		if(IsHardForkActivated(pblock->nTime))
+        uint8_t algo = ALGO_SHA256D;
+        std::unique_ptr<CMinerWork> work;
+		if(IsHardForkActivated(pblock->nTime) && (currentAlgo == ALGO_EQUIHASH || currentAlgo == ALGO_ZHASH))
 		{
-			if(currentAlgo == ALGO_EQUIHASH || currentAlgo == ALGO_ZHASH)
-			{
-                CEquihashBlockHeader equihashblock = pblock->GetEquihashBlockHeader();
-				nInnerLoopMask = nInnerLoopEquihashMask;
-				nInnerLoopCount = nInnerLoopEquihashCount;
-                n = (currentAlgo == ALGO_EQUIHASH) ? params.EquihashN() : params.ZhashN();
-                k = (currentAlgo == ALGO_EQUIHASH) ? params.EquihashK() : params.ZhashK();
-				// Solve Equihash.
-				crypto_generichash_blake2b_state eh_state;
-                EhInitialiseState(n, k, eh_state, currentAlgo == ALGO_ZHASH ? DEFAULT_ZHASH_PERSONALIZE : DEFAULT_EQUIHASH_PERSONALIZE);
-
-				// I = the block header minus nonce and solution.
-				CEquihashInput I{equihashblock};
-				CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-				ss << I;
-
-				// H(I||...
-				crypto_generichash_blake2b_update(&eh_state, (unsigned char*)&ss[0], ss.size());
-
-				while (nMaxTries > 0 &&
-					   ((int)equihashblock.nNonce.GetUint64(0) & nInnerLoopEquihashMask) < nInnerLoopCount) {
-					// Yes, there is a chance every nonce could fail to satisfy the -regtest
-					// target -- 1 in 2^(2^256). That ain't gonna happen
-					equihashblock.nNonce = ArithToUint256(UintToArith256(equihashblock.nNonce) + 1);
-
-					// H(I||V||...
-					crypto_generichash_blake2b_state curr_state;
-					curr_state = eh_state;
-					crypto_generichash_blake2b_update(&curr_state,
-													  equihashblock.nNonce.begin(),
-													  equihashblock.nNonce.size());
-
-					// (x_1, x_2, ...) = A(I, V, n, k)
-					std::function<bool(std::vector<unsigned char>)> validBlock =
-							[&equihashblock](std::vector<unsigned char> soln) {
-						equihashblock.nSolution = soln;
-						return CheckProofOfWork(equihashblock.GetHash(), equihashblock.nBits, Params().GetConsensus(), currentAlgo);
-					};
-					bool found = EhBasicSolveUncancellable(n, k, curr_state, validBlock);
-                    --nMaxTries;
-					if (found) {
-						break;
-					}
-				}
-                
-                // If Block is found convert CEquihashBlockHeader calculated stuff to pblock
-                
-                pblock->nBigNonce = equihashblock.nNonce;
-                pblock->nSolution = equihashblock.nSolution;
-			}
-			else
-			{
-                CDefaultBlockHeader defaultblockheader = pblock->GetDefaultBlockHeader();
-				nInnerLoopMask = nInnerLoopHuntCoinMask;
-				nInnerLoopCount = nInnerLoopHuntCoinCount;
-				while (nMaxTries > 0 && defaultblockheader.nNonce < nInnerLoopCount && !CheckProofOfWork(defaultblockheader.GetPoWHash(currentAlgo), defaultblockheader.nBits, Params().GetConsensus(), currentAlgo)) {
-					++defaultblockheader.nNonce;
-					--nMaxTries;
-				}
-                
-                // If Block is found convert CDefaultBlockHeader calculated stuff to pblock
-                
-                pblock->nNonce = defaultblockheader.nNonce;
-			}
+            algo = currentAlgo;
+            CEquihashBlockHeader equihashblock = pblock->GetEquihashBlockHeader();
+            n = (currentAlgo == ALGO_EQUIHASH) ? params.EquihashN() : params.ZhashN();
+            k = (currentAlgo == ALGO_EQUIHASH) ? params.EquihashK() : params.ZhashK();
+            // Solve Equihash.
+            eh_HashState eh_state;
+            EhInitialiseState(n, k, eh_state, currentAlgo == ALGO_ZHASH ? DEFAULT_ZHASH_PERSONALIZE : DEFAULT_EQUIHASH_PERSONALIZE);
+
+            // I = the block header minus nonce and solution.
+            CEquihashInput I{equihashblock};
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << I;
+
+            // H(I||...
+            crypto_generichash_blake2b_update(&eh_state, (unsigned char*)&ss[0], ss.size());
+
+            // Yes, there is a chance every nonce could fail to satisfy the -regtest
+            // target -- 1 in 2^(2^256). That ain't gonna happen
+            const int nLow = (int)equihashblock.nNonce.GetUint64(0) & nInnerLoopEquihashMask;
+            work.reset(new CMinerWork(pblock, 0, std::max(nInnerLoopEquihashCount - nLow, 0), nMaxTries));
+            RunMiners(*work, *pblock, algo, std::bind(&MineEquihash, std::ref(*work), equihashblock, n, k, eh_state, algo));
 		}
 		else
 		{
+            if (IsHardForkActivated(pblock->nTime))
+                algo = currentAlgo;
             CDefaultBlockHeader defaultblockheader = pblock->GetDefaultBlockHeader();
-			nInnerLoopMask = nInnerLoopHuntCoinMask;
-			nInnerLoopCount = nInnerLoopHuntCoinCount;
-			while (nMaxTries > 0 && defaultblockheader.nNonce < nInnerLoopCount && !CheckProofOfWork(defaultblockheader.GetPoWHash(ALGO_SHA256D), defaultblockheader.nBits, Params().GetConsensus(), ALGO_SHA256D)) {
-				++defaultblockheader.nNonce;
-				--nMaxTries;
-			}
-            
-            // If Block is found convert CDefaultBlockHeader calculated stuff to pblock
-                
-            pblock->nNonce = defaultblockheader.nNonce;
+            work.reset(new CMinerWork(pblock, defaultblockheader.nNonce, nInnerLoopHuntCoinCount, nMaxTries));
+            RunMiners(*work, *pblock, algo, std::bind(&MineNonces, std::ref(*work), defaultblockheader, algo));
 		}
-        if (nMaxTries == 0) {
-            break;
-        }
-        if ((pblock->GetAlgo() == ALGO_EQUIHASH || pblock->GetAlgo() == ALGO_ZHASH) && ((int)pblock->nBigNonce.GetUint64(0) & nInnerLoopMask) == nInnerLoopCount) {
-            continue;
-        }
-        if (!(pblock->GetAlgo() == ALGO_EQUIHASH || pblock->GetAlgo() == ALGO_ZHASH) && (pblock->nNonce & nInnerLoopMask) == nInnerLoopCount) {
+        nMaxTries = work->GetTriesLeft();
+        if (!work->IsFound()) {
+            // Out of tries, or the nonce range is exhausted or the template
+            // went stale: build a new one.
+            if (nMaxTries == 0)
+                break;
             continue;
         }
         std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(*pblock);
@@ -453,6 +777,11 @@ UniValue getmininginfo(const JSONRPCRequest& request)
             "  \"currentblocktx\": nnn,     (numeric) The last block transaction\n"
             "  \"difficulty\": xxx.xxxxx    (numeric) The current difficulty\n"
             "  \"networkhashps\": nnn,      (numeric) The network hashes per second\n"
+            "  \"genproclimit\": n,         (numeric) The number of threads generate and generatetoaddress mine with (see -genproclimit)\n"
+            "  \"hashespersec\": nnn,       (numeric) The hashes per second of the last generate call for the current algo\n"
+            "  \"hashespersec_algos\": {    (object) The same for every algo that has been mined locally\n"
+            "     \"xxxx\": nnn             (numeric) name of the algorithm and its hashes per second\n"
+            "  },\n"
             "  \"pooledtx\": n              (numeric) The size of the mempool\n"
             "  \"chain\": \"xxxx\",           (string) current network name as defined in BIP70 (main, test, regtest)\n"
             "  \"warnings\": \"...\"          (string) any network and blockchain warnings\n"
@@ -503,6 +832,14 @@ UniValue getmininginfo(const JSONRPCRequest& request)
     obj.pushKV("difficulty_QUARK", (double)GetDifficulty(NULL, ALGO_QUARK));
     obj.pushKV("difficulty_X16R", (double)GetDifficulty(NULL, ALGO_X16R));
     obj.pushKV("networkhashps",    getnetworkhashps(request));
+    obj.pushKV("genproclimit",     GetMinerThreads());
+    obj.pushKV("hashespersec",     (int64_t)nMinerHashesPerSec[currentAlgo]);
+    UniValue hashespersec(UniValue::VOBJ);
+    for (uint8_t algo = 0; algo < NUM_ALGOS; algo++) {
+        if (nMinerHashesPerSec[algo] > 0)
+            hashespersec.pushKV(GetAlgoName(algo), (int64_t)nMinerHashesPerSec[algo]);
+    }
+    obj.pushKV("hashespersec_algos", hashespersec);
     obj.pushKV("pooledtx",         (uint64_t)mempool.size());
     obj.pushKV("chain",            Params().NetworkIDString());
     obj.pushKV("warnings",         GetWarnings("statusbar"));
@@ -525,12 +862,16 @@ UniValue getalgoinfo(const JSONRPCRequest& request)
 			"  \"lastblockalgoid\": \"xx\"     (numeric) the ID of the algorithm from the last block that has been mined\n"
 			"  \"localalgo\": \"xxxx\"         (string) the name of the current algorithm that is activated to mine blocks\n"
 			"  \"localalgoid\": \"xx\"         (numeric) the ID of the current algorithm that is activated to mine blocks\n"
+            "  \"window\": xxxx                (numeric) the number of most recent blocks the hashrates and shares are taken over\n"
             "  \"algo_details\": {             (object) details of the algo such like difficulty, last block and so on ..\n"
             "     \"xxxx\" : {                 (string) name of the algorithm\n"
 			"        \"algoid\": xx,           (numeric) the ID of this algo\n"
             "        \"lastblock\": xx,        (numeric) the last block height mined by this algorithm. If it returns (-1) it means algo has not been seen yet.\n"
             "        \"difficulty\": xxxxxx,   (numeric) the current mining difficulty for this algo\n"
-            "        \"nethashrate\": xx       (numeric) total nethashrate of this algo\n"
+            "        \"nethashrate\": xx       (numeric) estimated hashes per second of this algo over the last window blocks\n"
+            "        \"blocks\": xx            (numeric) number of the last window blocks mined with this algo\n"
+            "        \"share\": x.xxx          (numeric) fraction of the last window blocks mined with this algo\n"
+            "        \"target\": \"xxxx\"       (string) compressed target required from the next block of this algo\n"
 			"        \"lastdiffret\": xxxxxx,  (numeric) the last diff retargeting height from this algo\n"
 			"        \"nextdiffret\": xxxxxx,  (numeric) the next diff retargeting height from this algo\n"
             "     }\n"
@@ -541,34 +882,37 @@ UniValue getalgoinfo(const JSONRPCRequest& request)
             + HelpExampleRpc("getalgoinfo", "")
         );
 
-    LOCK(cs_main);
-	
-    CBlockIndex* tip = chainActive.Tip();
+    algo_stats_ptr_t snapshot = algostats.Get();
+    if (!snapshot)
+        throw JSONRPCError(RPC_IN_WARMUP, "No chain loaded yet");
 
     UniValue obj(UniValue::VOBJ);
     UniValue algos(UniValue::VOBJ);
 	
-    obj.pushKV("blocks",                (int)chainActive.Height());
-    obj.pushKV("headers",               pindexBestHeader ? pindexBestHeader->nHeight : -1);
-    obj.pushKV("bestblockhash",         tip->GetBlockHash().GetHex());
+    obj.pushKV("blocks",                snapshot->nHeight);
+    obj.pushKV("headers",               snapshot->nHeaders);
+    obj.pushKV("bestblockhash",         snapshot->hashTip.GetHex());
     obj.pushKV("algos",                 NUM_ALGOS);
-    obj.pushKV("lastblockalgo",         GetAlgoName(tip->GetAlgo()));
-    obj.pushKV("lastblockalgoid",       tip->GetAlgo());
+    obj.pushKV("lastblockalgo",         GetAlgoName(snapshot->nTipAlgo));
+    obj.pushKV("lastblockalgoid",       snapshot->nTipAlgo);
     obj.pushKV("localalgo",             GetAlgoName(currentAlgo));
     obj.pushKV("localalgoid",           currentAlgo);
+    obj.pushKV("window",                snapshot->nWindowBlocks);
 
     for(uint8_t i = 0; i < (uint8_t)NUM_ALGOS; i++)
     {
+        const CAlgoStats& stats = snapshot->algos[i];
 	    UniValue algo_description(UniValue::VOBJ);
-        const CBlockIndex* pindexLastAlgo = GetLastBlockIndexForAlgo(tip, i);
-        int lastblock = (pindexLastAlgo != nullptr) ? pindexLastAlgo->nHeight : -1;
 	
         algo_description.pushKV("algoid",      i);
-        algo_description.pushKV("lastblock",   lastblock);
-        algo_description.pushKV("difficulty",  (double)GetDifficulty(NULL, i));
-        algo_description.pushKV("nethashrate", getnetworkhashps(request));
-        algo_description.pushKV("lastdiffret", CalculateDiffRetargetingBlock(tip, RETARGETING_LAST, i, Params().GetConsensus()));
-        algo_description.pushKV("nextdiffret", CalculateDiffRetargetingBlock(tip, RETARGETING_NEXT, i, Params().GetConsensus()));
+        algo_description.pushKV("lastblock",   stats.nLastBlock);
+        algo_description.pushKV("difficulty",  stats.dDifficulty);
+        algo_description.pushKV("nethashrate", stats.dHashRate);
+        algo_description.pushKV("blocks",      stats.nWindowBlocks);
+        algo_description.pushKV("share",       snapshot->nWindowBlocks > 0 ? (double)stats.nWindowBlocks / snapshot->nWindowBlocks : 0.0);
+        algo_description.pushKV("target",      strprintf("%08x", stats.nNextBits));
+        algo_description.pushKV("lastdiffret", stats.nLastDiffRet);
+        algo_description.pushKV("nextdiffret", stats.nNextDiffRet);
         algos.pushKV(GetAlgoName(i), algo_description);
     }
 	
@@ -608,6 +952,7 @@ UniValue prioritisetransaction(const JSONRPCRequest& request)
     }
 
     mempool.PrioritiseTransaction(hash, nAmount);
+    templateselection.Invalidate();
     return true;
 }
 
@@ -640,6 +985,31 @@ std::string gbt_vb_name(const Consensus::DeploymentPos pos) {
     return s;
 }
 
+/** Parse an algo given by name or by id, as getalgoinfo lists them */
+static uint8_t ParseAlgo(const UniValue& value)
+{
+    uint8_t algo;
+    if (value.isNum()) {
+        int nAlgo = value.get_int();
+        if (nAlgo < 0 || nAlgo >= NUM_ALGOS)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Unknown algo %d", nAlgo));
+        algo = (uint8_t)nAlgo;
+    } else if (!GetAlgoByName(value.get_str(), algo)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown algo " + value.get_str());
+    }
+    return algo;
+}
+
+/** Refuse algos other than sha256d before the hardfork, CreateNewBlock can't build blocks for them yet */
+static void CheckAlgoActive(uint8_t algo)
+{
+    if (algo != ALGO_SHA256D && !IsHardForkActivated((uint32_t)GetAdjustedTime())) {
+        std::stringstream strstream;
+        strstream << "You cannot mine with Algorithm " << GetAlgoName(algo) << ", because Hardfork is not activated yet.";
+        throw JSONRPCError(RPC_INVALID_PARAMS, strstream.str());
+    }
+}
+
 UniValue getblocktemplate(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1)
@@ -664,7 +1034,8 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
             "       \"rules\":[            (array, optional) A list of strings\n"
             "           \"support\"          (string) client side supported softfork deployment\n"
             "           ,...\n"
-            "       ]\n"
+            "       ],\n"
+            "       \"algo\":\"name\"        (string or numeric, optional, default=the -algo of this node) Algo, by name or id, to build the block for\n"
             "     }\n"
             "\n"
 
@@ -741,6 +1112,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     std::set<std::string> setClientRules;
     std::set<std::string> setCapabilitiesRules;
     int64_t nMaxVersionPreVB = -1;
+    uint8_t algo = currentAlgo;
     if (!request.params[0].isNull())
     {
         const UniValue& oparam = request.params[0].get_obj();
@@ -806,6 +1178,10 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
                 setCapabilitiesRules.insert(v.get_str());
             }
         }
+
+        const UniValue& algoval = find_value(oparam, "algo");
+        if (!algoval.isNull())
+            algo = ParseAlgo(algoval);
     }
 
     if (strMode != "template")
@@ -903,10 +1279,18 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         coinbasetxnscript = GetScriptForDestination(destination);
     }
 
+    CheckAlgoActive(algo);
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
     // Update block
     static CBlockIndex* pindexPrev;
     static int64_t nStart;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
+    // One template per algo. The one for nBaseAlgo comes from CreateNewBlock, the
+    // others are copies of it with their own header, so transaction selection,
+    // masternode payment and treasury output are done once per tip and mempool
+    // generation however many algos are mined.
+    static std::map<uint8_t, std::unique_ptr<CBlockTemplate> > mapAlgoTemplates;
+    static uint8_t nBaseAlgo;
     // Cache whether the last invocation was with segwit support, to avoid returning
     // a segwit-block to a non-segwit caller.
     static bool fLastTemplateSupportsSegwit = true;
@@ -916,6 +1300,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     {
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
         pindexPrev = nullptr;
+        mapAlgoTemplates.clear();
 
         // Store the pindexBest used before CreateNewBlock, to avoid races
         nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
@@ -926,36 +1311,27 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         // Create new block
         CScript scriptDummy = CScript() << OP_TRUE;
         CScript createscript = (coinbasetxn) ? coinbasetxnscript : scriptDummy;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(createscript, currentAlgo, fSupportsSegwit);
-        if (!pblocktemplate)
-        {
-            if(IsHardForkActivated(pindexPrevNew->nTime))
-            {
-                throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-            }
-            else
-            {
-                if(currentAlgo == ALGO_SHA256D)
-                {
-                    throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-                }
-                else
-                {
-                    std::stringstream strstream;
-                    strstream << "You cannot mine with Algorithm " << GetAlgoName(currentAlgo) << ", because Hardfork is not activated yet.";
-                    throw JSONRPCError(RPC_INVALID_PARAMS, strstream.str()); 
-                }
-            }
-        }
+        // The shared selection is kept for witness templates as the Stratum
+        // server and createauxblock make them, a caller without segwit
+        // support gets its own so that it doesn't reset the shared one.
+        std::unique_ptr<CBlockTemplate> pbasetemplate = BlockAssembler(Params()).CreateNewBlock(createscript, algo, fSupportsSegwit, fSupportsSegwit ? &templateselection : nullptr);
+        if (!pbasetemplate)
+            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
 
         // Need to update only after we know CreateNewBlock succeeded
+        mapAlgoTemplates[algo] = std::move(pbasetemplate);
+        nBaseAlgo = algo;
         pindexPrev = pindexPrevNew;
     }
+    std::unique_ptr<CBlockTemplate>& pblocktemplate = mapAlgoTemplates[algo];
+    if (!pblocktemplate) {
+        pblocktemplate.reset(new CBlockTemplate(*mapAlgoTemplates[nBaseAlgo]));
+        SetBlockAlgo(&pblocktemplate->block, consensusParams, pindexPrev, algo);
+    }
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
-    const Consensus::Params& consensusParams = Params().GetConsensus();
 
     // Update nTime
-    UpdateTime(pblock, consensusParams, pindexPrev, currentAlgo);
+    UpdateTime(pblock, consensusParams, pindexPrev, algo);
     pblock->nNonce = 0;
     pblock->nBigNonce = uint256();
 	pblock->nSolution.clear();
@@ -1415,13 +1791,11 @@ UniValue estimaterawfee(const JSONRPCRequest& request)
 namespace {
 
 /**
- * The variables below are used to keep track of created and not yet
- * submitted auxpow blocks.  Lock them to be sure even for multiple
- * RPC threads running in parallel.
+ * Serializes building new auxpow blocks and guards the template they are
+ * built from. The blocks handed out are kept in auxworkcache, which
+ * submitauxblock looks them up in without taking this lock.
  */
-CCriticalSection cs_auxblockCache;
-std::map<uint256, CBlock*> mapNewBlock;
-std::vector<std::unique_ptr<CBlockTemplate>> vNewBlockTemplate;
+CCriticalSection cs_auxblockCreate;
 
 void AuxMiningCheck()
 {
@@ -1449,20 +1823,26 @@ void AuxMiningCheck()
 
 } // anonymous namespace
 
-UniValue AuxMiningCreateBlock(const CScript& scriptPubKey)
+UniValue AuxMiningCreateBlock(const CScript& scriptPubKey, uint8_t algo)
 {
     AuxMiningCheck();
+    CheckAlgoActive(algo);
 
-    LOCK(cs_auxblockCache);
+    std::shared_ptr<const CBlock> pblock;
+    int nHeight;
+    {
+    LOCK(cs_auxblockCreate);
 
     static unsigned nTransactionsUpdatedLast;
     static const CBlockIndex* pindexPrev = nullptr;
     static uint64_t nStart;
-    static CBlock* pblock = nullptr;
+    // Block as returned by CreateNewBlock, shared by the algos until the next update
+    static std::unique_ptr<CBlockTemplate> pbaseTemplate;
+    // Merkle branch of its coinbase, the only transaction that differs between the blocks handed out
+    static std::vector<uint256> vCoinbaseBranch;
     static unsigned nExtraNonce = 0;
 
     // Update block
-    {
     LOCK(cs_main);
     if (pindexPrev != chainActive.Tip()
         || (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast
@@ -1471,34 +1851,15 @@ UniValue AuxMiningCreateBlock(const CScript& scriptPubKey)
         if (pindexPrev != chainActive.Tip())
         {
             // Clear old blocks since they're obsolete now.
-            mapNewBlock.clear();
-            vNewBlockTemplate.clear();
-            pblock = nullptr;
+            auxworkcache.Clear();
         }
+        auxworkcache.ResetCurrent();
 
         // Create new block with nonce = 0 and extraNonce = 1
         std::unique_ptr<CBlockTemplate> newBlock
-            = BlockAssembler(Params()).CreateNewBlock(scriptPubKey, currentAlgo);
+            = BlockAssembler(Params()).CreateNewBlock(scriptPubKey, algo, true, &templateselection);
         if (!newBlock)
-        {
-            if(IsHardForkActivated(chainActive.Tip()->nTime))
-            {
-                throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-            }
-            else
-            {
-                if(currentAlgo == ALGO_SHA256D)
-                {
-                    throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-                }
-                else
-                {
-                    std::stringstream strstream;
-                    strstream << "You cannot mine with Algorithm " << GetAlgoName(currentAlgo) << ", because Hardfork is not activated yet.";
-                    throw JSONRPCError(RPC_INVALID_PARAMS, strstream.str()); 
-                }
-            }
-        }
+            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
         
         if(IsHardForkActivated(newBlock->block.nTime) && !gArgs.GetBoolArg("-acceptdividedcoinbase", false))
         {
@@ -1509,29 +1870,34 @@ UniValue AuxMiningCreateBlock(const CScript& scriptPubKey)
         nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
         pindexPrev = chainActive.Tip();
         nStart = GetTime();
-	    
+        pbaseTemplate = std::move(newBlock);
+        vCoinbaseBranch = BlockMerkleBranch(pbaseTemplate->block, 0);
+    }
+    nHeight = pindexPrev->nHeight + 1;
+
+    pblock = auxworkcache.GetCurrent(algo);
+    if (!pblock)
+    {
+        // Every algo reuses the transactions of the base block and only
+        // gets its own header and coinbase.
+        std::shared_ptr<CBlock> newBlock = std::make_shared<CBlock>(pbaseTemplate->block);
+        if (newBlock->GetAlgo() != algo)
+            SetBlockAlgo(newBlock.get(), Params().GetConsensus(), pindexPrev, algo);
+
         // If new block is an Equihash block, set the nNonce to null, because it is randomized by default.
-        if(currentAlgo == ALGO_EQUIHASH || currentAlgo == ALGO_ZHASH)
-            newBlock->block.nBigNonce.SetNull();
+        if(algo == ALGO_EQUIHASH || algo == ALGO_ZHASH)
+            newBlock->nBigNonce.SetNull();
 
         // Finalise it by setting the version and building the merkle root
-        IncrementExtraNonce(&newBlock->block, pindexPrev, nExtraNonce);
-        newBlock->block.SetAuxpowVersion(true);
+        IncrementExtraNonce(newBlock.get(), pindexPrev, nExtraNonce, &vCoinbaseBranch);
+        newBlock->SetAuxpowVersion(true);
 
         // Save
-        pblock = &newBlock->block;
-        mapNewBlock[pblock->GetHash()] = pblock;
-        vNewBlockTemplate.push_back(std::move(newBlock));
+        auxworkcache.Add(newBlock);
+        pblock = newBlock;
     }
     }
 
-    // At this point, pblock is always initialised:  If we make it here
-    // without creating a new block above, it means that, in particular,
-    // pindexPrev == chainActive.Tip().  But for that to happen, we must
-    // already have created a pblock in a previous call, as pindexPrev is
-    // initialised only when pblock is.
-    assert(pblock);
-
     arith_uint256 target;
     bool fNegative, fOverflow;
     target.SetCompact(pblock->nBits, &fNegative, &fOverflow);
@@ -1548,7 +1914,7 @@ UniValue AuxMiningCreateBlock(const CScript& scriptPubKey)
     result.pushKV("previousblockhash", pblock->hashPrevBlock.GetHex());
     result.pushKV("coinbasevalue", (int64_t)pblock->vtx[0]->GetValueOut());
     result.pushKV("bits", strprintf("%08x", pblock->nBits));
-    result.pushKV("height", static_cast<int64_t> (pindexPrev->nHeight + 1));
+    result.pushKV("height", static_cast<int64_t> (nHeight));
     result.pushKV("target", HexStr(BEGIN(target), END(target)));
 
     return result;
@@ -1560,17 +1926,17 @@ bool AuxMiningSubmitBlock(const std::string& hashHex,
 {
     AuxMiningCheck();
 
-    LOCK(cs_auxblockCache);
-
     uint256 hash;
     hash.SetHex(hashHex);
     std::string auxpowstring;
     uint32_t nVersion = CURRENT_AUXPOW_VERSION;
 
-    const std::map<uint256, CBlock*>::iterator mit = mapNewBlock.find(hash);
-    if (mit == mapNewBlock.end())
+    const std::shared_ptr<const CBlock> pcached = auxworkcache.Get(hash);
+    if (!pcached)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "block hash unknown");
-    CBlock& block = *mit->second;
+    // Work on a copy, the cached block may be submitted by others at the same time
+    std::shared_ptr<CBlock> shared_block = std::make_shared<CBlock>(*pcached);
+    CBlock& block = *shared_block;
     
     if(nAuxPoWVersion == 1 && block.GetAlgo() == ALGO_ZHASH)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Zhash is not mineable with Auxpow 1.0, use Auxpow 2.0 for Zhash!");
@@ -1599,8 +1965,6 @@ bool AuxMiningSubmitBlock(const std::string& hashHex,
 
     submitblock_StateCatcher sc(block.GetHash());
     RegisterValidationInterface(&sc);
-    std::shared_ptr<const CBlock> shared_block 
-      = std::make_shared<const CBlock>(block);
     bool fAccepted = ProcessNewBlock(Params(), shared_block, true, nullptr);
     UnregisterValidationInterface(&sc);
 
@@ -1609,12 +1973,13 @@ bool AuxMiningSubmitBlock(const std::string& hashHex,
 
 UniValue createauxblock(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 1)
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
         throw std::runtime_error(
-            "createauxblock <address>\n"
+            "createauxblock <address> ( algo )\n"
             "\ncreate a new block and return information required to merge-mine it.\n"
             "\nArguments:\n"
             "1. address      (string, required) specify coinbase transaction payout address\n"
+            "2. algo         (string or numeric, optional) algo name or id to mine with, defaults to -algo\n"
             "\nResult:\n"
             "{\n"
             "  \"hash\"               (string) hash of the created block\n"
@@ -1627,6 +1992,7 @@ UniValue createauxblock(const JSONRPCRequest& request)
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("createauxblock", "\"address\"")
+            + HelpExampleCli("createauxblock", "\"address\" \"x11\"")
             + HelpExampleRpc("createauxblock", "\"address\"")
             );
 
@@ -1639,7 +2005,11 @@ UniValue createauxblock(const JSONRPCRequest& request)
     }
     const CScript scriptPubKey = GetScriptForDestination(coinbaseScript);
 
-    return AuxMiningCreateBlock(scriptPubKey);
+    uint8_t algo = currentAlgo;
+    if (!request.params[1].isNull())
+        algo = ParseAlgo(request.params[1]);
+
+    return AuxMiningCreateBlock(scriptPubKey, algo);
 }
 
 UniValue submitauxblock(const JSONRPCRequest& request)
@@ -1683,7 +2053,7 @@ static const CRPCCommand commands[] =
     { "mining",             "prioritisetransaction",  &prioritisetransaction,  {"txid","dummy","fee_delta"} },
     { "mining",             "getblocktemplate",       &getblocktemplate,       {"template_request"} },
     { "mining",             "submitblock",            &submitblock,            {"hexdata","dummy"} },
-    { "mining",             "createauxblock",         &createauxblock,         {"address"} },
+    { "mining",             "createauxblock",         &createauxblock,         {"address","algo"} },
     { "mining",             "submitauxblock",         &submitauxblock,         {"hash", "auxpow", "auxpowversion"} },
 
 
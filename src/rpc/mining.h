@@ -13,12 +13,16 @@
 
 /** Generate blocks (mine) */
 UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGenerate, uint64_t nMaxTries, bool keepScript);
+/** Stop the generateBlocks worker threads */
+void StopMinerThreads();
+/** Number of generateBlocks worker threads, and how many of them ran the last template */
+void GetMinerThreadCounts(int& nThreadsRet, int& nRunningRet);
 
 /** Check bounds on a command line confirm target */
 unsigned int ParseConfirmTarget(const UniValue& value);
 
 /* Creation and submission of auxpow blocks.  */
-UniValue AuxMiningCreateBlock(const CScript& scriptPubKey);
+UniValue AuxMiningCreateBlock(const CScript& scriptPubKey, uint8_t algo);
 bool AuxMiningSubmitBlock(const std::string& hashHex,
                           const std::string& auxpowHex,
                           const int nAuxPoWVersion);
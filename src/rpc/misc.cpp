@@ -4,12 +4,15 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <auxpowcache.h>
+#include <auxworkcache.h>
 #include <base58.h>
 #include <chain.h>
 #include <clientversion.h>
 #include <core_io.h>
 #include <crypto/ripemd160.h>
 #include <init.h>
+#include <instantx.h>
 #include <validation.h>
 #include <httpserver.h>
 #include <net.h>
@@ -18,6 +21,7 @@
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <timedata.h>
+#include <txdb.h>
 #include <util.h>
 #include <utilstrencodings.h>
 #ifdef ENABLE_WALLET
@@ -287,6 +291,61 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockIndexMemoryInfo()
+{
+    LOCK(cs_main);
+    CBlockTreeDB::SolutionStats stats = pblocktree->GetSolutionStats();
+    // Every index entry used to carry the Equihash fields, the solution vector only when set.
+    size_t nSaved = mapBlockIndex.size() * sizeof(CBlockSolution) + stats.storedbytes;
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(mapBlockIndex.size()));
+    obj.pushKV("solutions_stored", uint64_t(stats.stored));
+    obj.pushKV("solutions_pending", uint64_t(stats.pending));
+    obj.pushKV("pending_bytes", uint64_t(stats.pendingbytes));
+    obj.pushKV("saved_bytes", uint64_t(nSaved));
+    return obj;
+}
+
+static UniValue RPCAuxpowCacheInfo()
+{
+    CAuxPowCache::Stats stats = auxpowcache.GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.entries));
+    obj.pushKV("usage", uint64_t(stats.usage));
+    obj.pushKV("limit", uint64_t(stats.limit));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    return obj;
+}
+
+static UniValue RPCAuxWorkCacheInfo()
+{
+    CAuxWorkCache::Stats stats = auxworkcache.GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.entries));
+    obj.pushKV("current", uint64_t(stats.current));
+    obj.pushKV("usage", uint64_t(stats.usage));
+    obj.pushKV("limit", uint64_t(stats.limit));
+    obj.pushKV("evicted", stats.evicted);
+    return obj;
+}
+
+static UniValue RPCInstantSendMemoryInfo()
+{
+    CInstantSend::Stats stats = instantsend.GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("candidates", uint64_t(stats.candidates));
+    obj.pushKV("votes", uint64_t(stats.votes));
+    obj.pushKV("orphans", uint64_t(stats.orphans));
+    obj.pushKV("usage", uint64_t(stats.usage));
+    obj.pushKV("limit", uint64_t(stats.limit));
+    obj.pushKV("votes_verified", stats.verified);
+    obj.pushKV("locks_finalized", stats.finalized);
+    obj.pushKV("lock_contended", stats.contended);
+    obj.pushKV("lock_wait_us", stats.waited);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -328,6 +387,38 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"blockindex\": {           (json object) Information about the in-memory block index\n"
+            "    \"entries\": xxxxx,           (numeric) Number of block index entries\n"
+            "    \"solutions_stored\": xxxxx,  (numeric) Number of Equihash solutions read from the block tree DB on demand\n"
+            "    \"solutions_pending\": xxxxx, (numeric) Number of Equihash solutions held in memory until the next index write\n"
+            "    \"pending_bytes\": xxxxx,     (numeric) Number of bytes used by the pending solutions\n"
+            "    \"saved_bytes\": xxxxx,       (numeric) Number of bytes the index entries no longer keep resident\n"
+            "  },\n"
+            "  \"auxpowcache\": {          (json object) Information about the cache of merge-mined header auxpows\n"
+            "    \"entries\": xxxxx,       (numeric) Number of cached auxpows\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated number of bytes used\n"
+            "    \"limit\": xxxxx,         (numeric) Number of bytes the cache may use (-auxpowcache)\n"
+            "    \"hits\": xxxxx,          (numeric) Number of headers served from the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Number of headers read from disk\n"
+            "  },\n"
+            "  \"auxwork\": {              (json object) Information about the blocks handed out by createauxblock\n"
+            "    \"entries\": xxxxx,       (numeric) Number of blocks that can be submitted\n"
+            "    \"current\": xxxxx,       (numeric) Number of algos with a block currently handed out\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated number of bytes used, shared transactions counted once\n"
+            "    \"limit\": xxxxx,         (numeric) Number of bytes above which older blocks are dropped (-auxworkcache)\n"
+            "    \"evicted\": xxxxx,       (numeric) Number of blocks dropped before they were submitted\n"
+            "  },\n"
+            "  \"instantsend\": {          (json object) Information about InstantSend lock requests and votes\n"
+            "    \"candidates\": xxxxx,    (numeric) Number of transaction lock candidates\n"
+            "    \"votes\": xxxxx,         (numeric) Number of known lock votes, orphans included\n"
+            "    \"orphans\": xxxxx,       (numeric) Number of lock votes waiting for their lock request\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated number of bytes used\n"
+            "    \"limit\": xxxxx,         (numeric) Number of bytes above which new lock requests and votes are refused (-instantsendmemory)\n"
+            "    \"votes_verified\": xxxxx,  (numeric) Number of lock votes that passed signature and rank checks\n"
+            "    \"locks_finalized\": xxxxx, (numeric) Number of transaction locks completed\n"
+            "    \"lock_contended\": xxxxx,  (numeric) Number of times InstantSend found cs_main or its own lock held by another thread\n"
+            "    \"lock_wait_us\": xxxxx,    (numeric) Microseconds InstantSend spent waiting for those locks\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -341,6 +432,10 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("blockindex", RPCBlockIndexMemoryInfo());
+        obj.pushKV("auxpowcache", RPCAuxpowCacheInfo());
+        obj.pushKV("auxwork", RPCAuxWorkCacheInfo());
+        obj.pushKV("instantsend", RPCInstantSendMemoryInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
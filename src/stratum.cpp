@@ -0,0 +1,698 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <stratum.h>
+
+#include <base58.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <hash.h>
+#include <huntcoin/hardfork.h>
+#include <miner.h>
+#include <netbase.h>
+#include <pow.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <timedata.h>
+#include <txmempool.h>
+#include <ui_interface.h>
+#include <util.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <univalue.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <event2/listener.h>
+#include <event2/thread.h>
+#include <event2/util.h>
+
+/** Error codes of Stratum replies, as pools use them */
+enum StratumErrorCode
+{
+    STRATUM_ERR_OTHER = 20,
+    STRATUM_ERR_JOB_NOT_FOUND = 21,
+    STRATUM_ERR_DUPLICATE_SHARE = 22,
+    STRATUM_ERR_LOW_DIFFICULTY = 23,
+    STRATUM_ERR_UNAUTHORIZED = 24,
+    STRATUM_ERR_NOT_SUBSCRIBED = 25,
+};
+
+/** Maximum length of a line from a miner, requests are short */
+static const size_t MAX_STRATUM_LINE_LENGTH = 16384;
+
+/** Hashes are sent as their eight 32 bit words, each byte-swapped */
+static std::string StratumHashHex(const uint256& hash)
+{
+    std::vector<unsigned char> vch(hash.begin(), hash.end());
+    for (size_t i = 0; i < vch.size(); i += 4)
+        std::reverse(vch.begin() + i, vch.begin() + i + 4);
+    return HexStr(vch);
+}
+
+static bool ParseUInt32Hex(const UniValue& value, uint32_t& n)
+{
+    if (!value.isStr() || value.get_str().size() != 8 || !IsHex(value.get_str()))
+        return false;
+    n = strtoul(value.get_str().c_str(), nullptr, 16);
+    return true;
+}
+
+static UniValue StratumNotification(const std::string& strMethod, const UniValue& params)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("id", NullUniValue);
+    obj.pushKV("method", strMethod);
+    obj.pushKV("params", params);
+    return obj;
+}
+
+CStratumServer::CStratumServer(double dDefaultDifficultyIn) : dDefaultDifficulty(dDefaultDifficultyIn), nLastSession(0), nLastJob(0)
+{
+}
+
+arith_uint256 CStratumServer::DifficultyToTarget(double dDifficulty)
+{
+    // Difficulty 1 is 0xffff << 208, keep 53 bits of the quotient
+    double dTarget = 65535.0 / dDifficulty;
+    if (!(dDifficulty > 0) || !std::isfinite(dTarget))
+        return ~arith_uint256();
+    int nShift = 208;
+    while (dTarget < 9007199254740992.0 && nShift > 0) {
+        dTarget *= 2;
+        nShift--;
+    }
+    while (dTarget >= 18446744073709551616.0) {
+        dTarget /= 2;
+        nShift++;
+    }
+    if (nShift > 192)
+        return ~arith_uint256();
+    return arith_uint256((uint64_t)dTarget) << nShift;
+}
+
+double CStratumServer::TargetToDifficulty(const arith_uint256& target)
+{
+    if (target == 0)
+        return std::numeric_limits<double>::max();
+    return 65535.0 * std::ldexp(1.0, 208) / target.getdouble();
+}
+
+int64_t CStratumServer::Connect(const SendLineFn& send)
+{
+    LOCK(cs);
+    const int64_t id = ++nLastSession;
+    Session& session = mapSessions[id];
+    session.send = send;
+    session.vchExtraNonce1 = ParseHex(strprintf("%08x", (uint32_t)id));
+    session.fSubscribed = false;
+    session.fAuthorized = false;
+    session.algo = currentAlgo;
+    session.dDifficulty = dDefaultDifficulty;
+    session.dDifficultySent = 0;
+    return id;
+}
+
+void CStratumServer::Disconnect(int64_t id)
+{
+    LOCK(cs);
+    mapSessions.erase(id);
+}
+
+void CStratumServer::Send(const Session& session, const UniValue& obj)
+{
+    session.send(obj.write() + "\n");
+}
+
+void CStratumServer::Reply(const Session& session, const UniValue& id, const UniValue& result)
+{
+    UniValue reply(UniValue::VOBJ);
+    reply.pushKV("id", id);
+    reply.pushKV("result", result);
+    reply.pushKV("error", NullUniValue);
+    Send(session, reply);
+}
+
+void CStratumServer::ReplyError(const Session& session, const UniValue& id, int code, const std::string& strMessage)
+{
+    UniValue error(UniValue::VARR);
+    error.push_back(code);
+    error.push_back(strMessage);
+    error.push_back(NullUniValue);
+    UniValue reply(UniValue::VOBJ);
+    reply.pushKV("id", id);
+    reply.pushKV("result", NullUniValue);
+    reply.pushKV("error", error);
+    Send(session, reply);
+}
+
+const CStratumServer::Template* CStratumServer::GetTemplate(uint8_t algo)
+{
+    LOCK(cs_main);
+    const CBlockIndex* pindexPrev = chainActive.Tip();
+    if (!templateBase.block || templateBase.block->hashPrevBlock != pindexPrev->GetBlockHash() ||
+        (templateBase.nTransactionsUpdated != mempool.GetTransactionsUpdated() &&
+         GetTime() - templateBase.nTimeCreated >= STRATUM_JOB_REFRESH_INTERVAL)) {
+        if (IsInitialBlockDownload())
+            return nullptr;
+
+        const unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+        // The coinbase output is replaced by the payout of each session
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(Params()).CreateNewBlock(CScript() << OP_TRUE, algo, true, &templateselection);
+        if (!pblocktemplate)
+            return nullptr;
+
+        mapTemplates.clear();
+        templateBase.block = std::make_shared<const CBlock>(std::move(pblocktemplate->block));
+        templateBase.vCoinbaseBranch = BlockMerkleBranch(*templateBase.block, 0);
+        templateBase.nHeight = pindexPrev->nHeight + 1;
+        templateBase.nTransactionsUpdated = nTransactionsUpdated;
+        templateBase.nTimeCreated = GetTime();
+        mapTemplates[templateBase.block->GetAlgo()] = templateBase;
+    }
+
+    auto it = mapTemplates.find(algo);
+    if (it != mapTemplates.end())
+        return &it->second;
+
+    // Other algos only get their own header, the transactions and coinbase
+    // (and so the merkle branch) stay those of the base template
+    if (!IsHardForkActivated(templateBase.block->nTime))
+        return nullptr;
+    std::shared_ptr<CBlock> block = std::make_shared<CBlock>(*templateBase.block);
+    SetBlockAlgo(block.get(), Params().GetConsensus(), pindexPrev, algo);
+    Template& tmpl = mapTemplates[algo];
+    tmpl = templateBase;
+    tmpl.block = block;
+    return &tmpl;
+}
+
+bool CStratumServer::SendJob(Session& session, bool fForce)
+{
+    const Template* ptemplate;
+    try {
+        ptemplate = GetTemplate(session.algo);
+    } catch (const std::exception& e) {
+        LogPrintf("stratum: unable to create a %s block: %s\n", GetAlgoName(session.algo), e.what());
+        return false;
+    }
+    if (!ptemplate)
+        return false;
+    if (!fForce && !session.mapJobs.empty() && session.mapJobs.rbegin()->second.block == ptemplate->block)
+        return false;
+
+    const CBlock& block = *ptemplate->block;
+    const bool fClean = session.mapJobs.empty() || session.mapJobs.rbegin()->second.block->hashPrevBlock != block.hashPrevBlock;
+    if (fClean)
+        session.mapJobs.clear();
+
+    const uint64_t nJob = ++nLastJob;
+    Job& job = session.mapJobs[nJob];
+    job.block = ptemplate->block;
+    job.vCoinbaseBranch = ptemplate->vCoinbaseBranch;
+
+    // Height first as BIP34 requires, then extranonce1 and extranonce2 in a
+    // single push the miner fills in
+    const CScript scriptHeight = CScript() << ptemplate->nHeight;
+    const size_t nExtraNonceSize = session.vchExtraNonce1.size() + STRATUM_EXTRANONCE2_SIZE;
+    job.txCoinbase = CMutableTransaction(*block.vtx[0]);
+    job.txCoinbase.vout[0].scriptPubKey = session.scriptPayout;
+    job.txCoinbase.vin[0].scriptSig = (CScript(scriptHeight) << std::vector<unsigned char>(nExtraNonceSize)) + COINBASE_FLAGS;
+    assert(job.txCoinbase.vin[0].scriptSig.size() <= 100);
+
+    // The extranonce starts after version, input count, prevout, script
+    // length, height and the push opcode
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS);
+    ss << job.txCoinbase;
+    const size_t nOffset = 4 + 1 + 36 + 1 + scriptHeight.size() + 1;
+    job.vchCoinb1.assign(ss.begin(), ss.begin() + nOffset);
+    job.vchCoinb2.assign(ss.begin() + nOffset + nExtraNonceSize, ss.end());
+
+    // Shares are never harder than the block
+    arith_uint256 targetBlock;
+    targetBlock.SetCompact(block.nBits);
+    job.targetShare = DifficultyToTarget(session.dDifficulty);
+    if (job.targetShare < targetBlock)
+        job.targetShare = targetBlock;
+
+    const double dDifficulty = TargetToDifficulty(job.targetShare);
+    if (dDifficulty != session.dDifficultySent) {
+        UniValue params(UniValue::VARR);
+        params.push_back(dDifficulty);
+        Send(session, StratumNotification("mining.set_difficulty", params));
+        session.dDifficultySent = dDifficulty;
+    }
+
+    UniValue branch(UniValue::VARR);
+    for (const uint256& hash : job.vCoinbaseBranch)
+        branch.push_back(HexStr(hash.begin(), hash.end()));
+    UniValue params(UniValue::VARR);
+    params.push_back(strprintf("%x", nJob));
+    params.push_back(StratumHashHex(block.hashPrevBlock));
+    params.push_back(HexStr(job.vchCoinb1));
+    params.push_back(HexStr(job.vchCoinb2));
+    params.push_back(branch);
+    params.push_back(strprintf("%08x", (uint32_t)block.nVersion));
+    params.push_back(strprintf("%08x", block.nBits));
+    params.push_back(strprintf("%08x", block.nTime));
+    params.push_back(fClean);
+    Send(session, StratumNotification("mining.notify", params));
+
+    while (session.mapJobs.size() > MAX_STRATUM_JOBS)
+        session.mapJobs.erase(session.mapJobs.begin());
+    return true;
+}
+
+void CStratumServer::UpdateJobs()
+{
+    LOCK(cs);
+    for (auto& entry : mapSessions) {
+        if (entry.second.fAuthorized)
+            SendJob(entry.second, false);
+    }
+}
+
+bool CStratumServer::Authorize(Session& session, const UniValue& id, const UniValue& params)
+{
+    if (!session.fSubscribed) {
+        ReplyError(session, id, STRATUM_ERR_NOT_SUBSCRIBED, "Not subscribed");
+        return false;
+    }
+    if (!params.isArray() || params.size() < 1 || !params[0].isStr()) {
+        ReplyError(session, id, STRATUM_ERR_OTHER, "Invalid parameters");
+        return false;
+    }
+    const std::string& strUser = params[0].get_str();
+    const std::string strPassword = params.size() > 1 && params[1].isStr() ? params[1].get_str() : "";
+
+    // Options in the password, anything else is the placeholder miners send
+    uint8_t algo = currentAlgo;
+    double dDifficulty = dDefaultDifficulty;
+    std::vector<std::string> vOptions;
+    boost::split(vOptions, strPassword, boost::is_any_of(","));
+    for (const std::string& strOption : vOptions) {
+        const size_t nPos = strOption.find('=');
+        if (nPos == std::string::npos)
+            continue;
+        const std::string strKey = strOption.substr(0, nPos);
+        const std::string strValue = strOption.substr(nPos + 1);
+        if (strKey == "algo" || strKey == "a") {
+            if (!GetAlgoByName(strValue, algo)) {
+                ReplyError(session, id, STRATUM_ERR_OTHER, strprintf("Unknown algo %s", strValue));
+                return false;
+            }
+        } else if (strKey == "d") {
+            if (!ParseDouble(strValue, &dDifficulty) || !(dDifficulty > 0)) {
+                ReplyError(session, id, STRATUM_ERR_OTHER, strprintf("Invalid difficulty %s", strValue));
+                return false;
+            }
+        }
+    }
+    // Equihash headers carry a solution instead of a nonce, which Stratum v1 has no place for
+    if (algo == ALGO_EQUIHASH || algo == ALGO_ZHASH) {
+        ReplyError(session, id, STRATUM_ERR_OTHER, strprintf("Algo %s cannot be mined over Stratum", GetAlgoName(algo)));
+        return false;
+    }
+    if (algo != ALGO_SHA256D && !IsHardForkActivated((uint32_t)GetAdjustedTime())) {
+        ReplyError(session, id, STRATUM_ERR_OTHER, strprintf("Algo %s is not activated yet", GetAlgoName(algo)));
+        return false;
+    }
+
+    // The username is the address to mine to, a worker name may follow the first dot
+    CTxDestination dest = DecodeDestination(strUser.substr(0, strUser.find('.')));
+    if (!IsValidDestination(dest))
+        dest = DecodeDestination(gArgs.GetArg("-coinbasetxnaddress", ""));
+    if (!IsValidDestination(dest)) {
+        ReplyError(session, id, STRATUM_ERR_UNAUTHORIZED, "Username is not an address to mine to");
+        return false;
+    }
+
+    session.fAuthorized = true;
+    session.strWorker = strUser;
+    session.scriptPayout = GetScriptForDestination(dest);
+    session.algo = algo;
+    session.dDifficulty = dDifficulty;
+    session.mapJobs.clear();
+    Reply(session, id, true);
+    LogPrint(BCLog::STRATUM, "stratum: %s mining %s to %s\n", strUser, GetAlgoName(algo), EncodeDestination(dest));
+    return true;
+}
+
+void CStratumServer::Submit(Session& session, const UniValue& id, const UniValue& params)
+{
+    if (!session.fAuthorized) {
+        ReplyError(session, id, STRATUM_ERR_UNAUTHORIZED, "Unauthorized worker");
+        return;
+    }
+    uint32_t nTime, nNonce;
+    if (!params.isArray() || params.size() < 5 || !params[1].isStr() || !params[2].isStr() ||
+        !ParseUInt32Hex(params[3], nTime) || !ParseUInt32Hex(params[4], nNonce)) {
+        ReplyError(session, id, STRATUM_ERR_OTHER, "Invalid parameters");
+        return;
+    }
+    const std::string& strExtraNonce2 = params[2].get_str();
+    if (strExtraNonce2.size() != 2 * STRATUM_EXTRANONCE2_SIZE || !IsHex(strExtraNonce2)) {
+        ReplyError(session, id, STRATUM_ERR_OTHER, "Invalid extranonce2");
+        return;
+    }
+
+    const std::string& strJob = params[1].get_str();
+    char* pend = nullptr;
+    const uint64_t nJob = strtoull(strJob.c_str(), &pend, 16);
+    auto itJob = strJob.empty() || *pend ? session.mapJobs.end() : session.mapJobs.find(nJob);
+    if (itJob == session.mapJobs.end()) {
+        ReplyError(session, id, STRATUM_ERR_JOB_NOT_FOUND, "Job not found");
+        return;
+    }
+    Job& job = itJob->second;
+    const CBlock& block = *job.block;
+    if (nTime < block.nTime || nTime > GetAdjustedTime() + MAX_FUTURE_BLOCK_TIME) {
+        ReplyError(session, id, STRATUM_ERR_OTHER, "Time out of range");
+        return;
+    }
+
+    // The coinbase as the miner hashed it
+    std::vector<unsigned char> vchCoinbase(job.vchCoinb1);
+    const std::vector<unsigned char> vchExtraNonce2 = ParseHex(strExtraNonce2);
+    vchCoinbase.insert(vchCoinbase.end(), session.vchExtraNonce1.begin(), session.vchExtraNonce1.end());
+    vchCoinbase.insert(vchCoinbase.end(), vchExtraNonce2.begin(), vchExtraNonce2.end());
+    vchCoinbase.insert(vchCoinbase.end(), job.vchCoinb2.begin(), job.vchCoinb2.end());
+
+    CBlockHeader header = block.GetBlockHeader();
+    header.hashMerkleRoot = ComputeMerkleRootFromBranch(Hash(vchCoinbase.begin(), vchCoinbase.end()), job.vCoinbaseBranch, 0);
+    header.nTime = nTime;
+    header.nNonce = nNonce;
+
+    const uint256 hashPoW = header.GetPoWHash();
+    if (UintToArith256(hashPoW) > job.targetShare) {
+        ReplyError(session, id, STRATUM_ERR_LOW_DIFFICULTY, "Low difficulty share");
+        return;
+    }
+    if (!job.setShares.insert(hashPoW).second) {
+        ReplyError(session, id, STRATUM_ERR_DUPLICATE_SHARE, "Duplicate share");
+        return;
+    }
+
+    if (CheckProofOfWork(hashPoW, block.nBits, Params().GetConsensus(), session.algo)) {
+        CMutableTransaction txCoinbase;
+        CDataStream ss(vchCoinbase, SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS);
+        ss >> txCoinbase;
+        txCoinbase.vin[0].scriptWitness = job.txCoinbase.vin[0].scriptWitness;
+
+        std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>(block);
+        pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
+        pblock->hashMerkleRoot = header.hashMerkleRoot;
+        pblock->nTime = nTime;
+        pblock->nNonce = nNonce;
+        const bool fAccepted = ProcessNewBlock(Params(), pblock, true, nullptr);
+        LogPrintf("stratum: %s found %s block %s, %s\n", session.strWorker, GetAlgoName(session.algo),
+                  pblock->GetHash().ToString(), fAccepted ? "accepted" : "rejected");
+    }
+    Reply(session, id, true);
+}
+
+bool CStratumServer::ProcessLine(int64_t id, const std::string& line)
+{
+    LOCK(cs);
+    auto it = mapSessions.find(id);
+    if (it == mapSessions.end())
+        return false;
+    Session& session = it->second;
+
+    UniValue request;
+    if (!request.read(line) || !request.isObject()) {
+        LogPrint(BCLog::STRATUM, "stratum: session %d sent invalid JSON\n", id);
+        return false;
+    }
+    const UniValue& idRequest = find_value(request, "id");
+    const UniValue& method = find_value(request, "method");
+    const UniValue& params = find_value(request, "params");
+    if (!method.isStr()) {
+        ReplyError(session, idRequest, STRATUM_ERR_OTHER, "Missing method");
+        return true;
+    }
+
+    const std::string& strMethod = method.get_str();
+    if (strMethod == "mining.subscribe") {
+        const std::string strSubscription = HexStr(session.vchExtraNonce1);
+        UniValue subscriptions(UniValue::VARR);
+        for (const char* strNotification : {"mining.set_difficulty", "mining.notify"}) {
+            UniValue subscription(UniValue::VARR);
+            subscription.push_back(strNotification);
+            subscription.push_back(strSubscription);
+            subscriptions.push_back(subscription);
+        }
+        UniValue result(UniValue::VARR);
+        result.push_back(subscriptions);
+        result.push_back(HexStr(session.vchExtraNonce1));
+        result.push_back(STRATUM_EXTRANONCE2_SIZE);
+        session.fSubscribed = true;
+        Reply(session, idRequest, result);
+    } else if (strMethod == "mining.authorize") {
+        if (Authorize(session, idRequest, params))
+            SendJob(session, true);
+    } else if (strMethod == "mining.submit") {
+        Submit(session, idRequest, params);
+    } else if (strMethod == "mining.extranonce.subscribe") {
+        // The extranonce of a session never changes
+        Reply(session, idRequest, true);
+    } else {
+        ReplyError(session, idRequest, STRATUM_ERR_OTHER, "Method not found");
+    }
+    return true;
+}
+
+/****** Transport ********/
+
+struct StratumConnection
+{
+    int64_t id;
+    struct bufferevent* bev;
+};
+
+static struct event_base* eventBase = nullptr;
+static std::thread threadStratum;
+static std::unique_ptr<CStratumServer> stratumServer;
+static std::vector<struct evconnlistener*> vListeners;
+static std::set<StratumConnection*> setConnections;
+static std::vector<CSubNet> vAllowedSubnets;
+//! fired on a new tip and every STRATUM_JOB_REFRESH_INTERVAL seconds
+static struct event* eventUpdateJobs = nullptr;
+static std::mutex cs_eventUpdateJobs;
+
+/** Wakes up the Stratum thread when the tip changes */
+class CStratumNotifier : public CValidationInterface
+{
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override
+    {
+        if (fInitialDownload)
+            return;
+        std::lock_guard<std::mutex> lock(cs_eventUpdateJobs);
+        if (eventUpdateJobs)
+            event_active(eventUpdateJobs, EV_TIMEOUT, 0);
+    }
+};
+
+static CStratumNotifier stratumNotifier;
+
+static bool ClientAllowed(const CNetAddr& netaddr)
+{
+    if (!netaddr.IsValid())
+        return false;
+    for (const CSubNet& subnet : vAllowedSubnets)
+        if (subnet.Match(netaddr))
+            return true;
+    return false;
+}
+
+static void CloseConnection(StratumConnection* conn)
+{
+    stratumServer->Disconnect(conn->id);
+    bufferevent_free(conn->bev);
+    setConnections.erase(conn);
+    delete conn;
+}
+
+static void StratumReadCallback(struct bufferevent* bev, void* ctx)
+{
+    StratumConnection* conn = static_cast<StratumConnection*>(ctx);
+    struct evbuffer* input = bufferevent_get_input(bev);
+    size_t n_read_out = 0;
+    char* line;
+    while ((line = evbuffer_readln(input, &n_read_out, EVBUFFER_EOL_CRLF)) != nullptr) {
+        std::string s(line, n_read_out);
+        free(line);
+        if (!s.empty() && !stratumServer->ProcessLine(conn->id, s)) {
+            CloseConnection(conn);
+            return;
+        }
+    }
+    if (evbuffer_get_length(input) > MAX_STRATUM_LINE_LENGTH) {
+        LogPrint(BCLog::STRATUM, "stratum: session %d sent a line that is too long, disconnecting\n", conn->id);
+        CloseConnection(conn);
+    }
+}
+
+static void StratumEventCallback(struct bufferevent* bev, short what, void* ctx)
+{
+    StratumConnection* conn = static_cast<StratumConnection*>(ctx);
+    if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
+        LogPrint(BCLog::STRATUM, "stratum: session %d disconnected\n", conn->id);
+        CloseConnection(conn);
+    }
+}
+
+static void StratumAcceptCallback(struct evconnlistener* listener, evutil_socket_t fd, struct sockaddr* addr, int socklen, void* ctx)
+{
+    CService peer;
+    peer.SetSockAddr(addr);
+    if (!ClientAllowed(peer)) {
+        LogPrint(BCLog::STRATUM, "stratum: connection from %s not allowed\n", peer.ToString());
+        evutil_closesocket(fd);
+        return;
+    }
+
+    struct bufferevent* bev = bufferevent_socket_new(eventBase, fd, BEV_OPT_CLOSE_ON_FREE);
+    if (!bev) {
+        evutil_closesocket(fd);
+        return;
+    }
+    StratumConnection* conn = new StratumConnection();
+    conn->bev = bev;
+    conn->id = stratumServer->Connect([bev](const std::string& line) {
+        evbuffer_add(bufferevent_get_output(bev), line.data(), line.size());
+    });
+    setConnections.insert(conn);
+    bufferevent_setcb(bev, StratumReadCallback, nullptr, StratumEventCallback, conn);
+    bufferevent_enable(bev, EV_READ | EV_WRITE);
+    LogPrint(BCLog::STRATUM, "stratum: session %d from %s\n", conn->id, peer.ToString());
+}
+
+static void StratumUpdateJobsCallback(evutil_socket_t fd, short what, void* ctx)
+{
+    stratumServer->UpdateJobs();
+}
+
+static void StratumThread()
+{
+    event_base_dispatch(eventBase);
+}
+
+bool StartStratumServer()
+{
+    assert(!eventBase);
+
+    vAllowedSubnets.clear();
+    CNetAddr localv4;
+    CNetAddr localv6;
+    LookupHost("127.0.0.1", localv4, false);
+    LookupHost("::1", localv6, false);
+    vAllowedSubnets.push_back(CSubNet(localv4, 8));
+    vAllowedSubnets.push_back(CSubNet(localv6));
+    for (const std::string& strAllow : gArgs.GetArgs("-stratumallowip")) {
+        CSubNet subnet;
+        LookupSubNet(strAllow.c_str(), subnet);
+        if (!subnet.IsValid())
+            return InitError(strprintf(_("Invalid -stratumallowip subnet specification: %s"), strAllow));
+        vAllowedSubnets.push_back(subnet);
+    }
+
+    double dDifficulty = DEFAULT_STRATUM_DIFFICULTY;
+    if (gArgs.IsArgSet("-stratumdifficulty") &&
+        (!ParseDouble(gArgs.GetArg("-stratumdifficulty", ""), &dDifficulty) || !(dDifficulty > 0)))
+        return InitError(strprintf(_("Invalid -stratumdifficulty: %s"), gArgs.GetArg("-stratumdifficulty", "")));
+
+#ifdef WIN32
+    evthread_use_windows_threads();
+#else
+    evthread_use_pthreads();
+#endif
+    eventBase = event_base_new();
+    if (!eventBase) {
+        LogPrintf("stratum: Unable to create event_base\n");
+        return false;
+    }
+    stratumServer.reset(new CStratumServer(dDifficulty));
+
+    const int nPort = gArgs.GetArg("-stratumport", DEFAULT_STRATUM_PORT);
+    for (const std::string& strBind : gArgs.GetArgs("-stratumbind")) {
+        CService addrBind;
+        struct sockaddr_storage sockaddr;
+        socklen_t len = sizeof(sockaddr);
+        if (!Lookup(strBind.c_str(), addrBind, nPort, false) || !addrBind.GetSockAddr((struct sockaddr*)&sockaddr, &len)) {
+            LogPrintf("stratum: Cannot resolve -stratumbind address: '%s'\n", strBind);
+            continue;
+        }
+        struct evconnlistener* listener = evconnlistener_new_bind(eventBase, StratumAcceptCallback, nullptr,
+                                                                  LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, -1,
+                                                                  (struct sockaddr*)&sockaddr, len);
+        if (!listener) {
+            LogPrintf("stratum: Binding on %s failed\n", addrBind.ToString());
+            continue;
+        }
+        LogPrintf("stratum: Listening on %s\n", addrBind.ToString());
+        vListeners.push_back(listener);
+    }
+    if (vListeners.empty()) {
+        event_base_free(eventBase);
+        eventBase = nullptr;
+        stratumServer.reset();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cs_eventUpdateJobs);
+        eventUpdateJobs = event_new(eventBase, -1, EV_PERSIST, StratumUpdateJobsCallback, nullptr);
+        struct timeval tv = {STRATUM_JOB_REFRESH_INTERVAL, 0};
+        event_add(eventUpdateJobs, &tv);
+    }
+    RegisterValidationInterface(&stratumNotifier);
+
+    threadStratum = std::thread(std::bind(&TraceThread<void (*)()>, "stratum", &StratumThread));
+    return true;
+}
+
+void InterruptStratumServer()
+{
+    if (eventBase) {
+        LogPrintf("stratum: Thread interrupt\n");
+        event_base_loopbreak(eventBase);
+    }
+}
+
+void StopStratumServer()
+{
+    if (!eventBase)
+        return;
+
+    UnregisterValidationInterface(&stratumNotifier);
+    threadStratum.join();
+    while (!setConnections.empty())
+        CloseConnection(*setConnections.begin());
+    for (struct evconnlistener* listener : vListeners)
+        evconnlistener_free(listener);
+    vListeners.clear();
+    {
+        std::lock_guard<std::mutex> lock(cs_eventUpdateJobs);
+        event_free(eventUpdateJobs);
+        eventUpdateJobs = nullptr;
+    }
+    event_base_free(eventBase);
+    eventBase = nullptr;
+    stratumServer.reset();
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HUNTCOIN_STRATUM_H
+#define HUNTCOIN_STRATUM_H
+
+#include <arith_uint256.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class UniValue;
+
+/** Default port the Stratum server listens on */
+static const int DEFAULT_STRATUM_PORT = 3333;
+/** Default share difficulty, 1 being a target of 0x00000000ffff0000...0000 */
+static const double DEFAULT_STRATUM_DIFFICULTY = 1.0;
+/** Seconds after which jobs are replaced to pick up new mempool transactions */
+static const int64_t STRATUM_JOB_REFRESH_INTERVAL = 30;
+/** Jobs a session keeps for late shares until the next tip */
+static const size_t MAX_STRATUM_JOBS = 8;
+/** Size of the extranonce2 the miner rolls */
+static const int STRATUM_EXTRANONCE2_SIZE = 4;
+
+/** Start the Stratum server on the -stratumbind addresses */
+bool StartStratumServer();
+/** Stop accepting connections and handing out jobs */
+void InterruptStratumServer();
+/** Close the connections and stop the Stratum thread */
+void StopStratumServer();
+
+/**
+ * The Stratum v1 protocol, apart from the transport. Every connection is a
+ * session handing the JSON lines it receives to ProcessLine, the lines for
+ * the miner are passed to the send function of the session.
+ *
+ * The miner picks the algo when authorizing, by a password of the form
+ * "algo=<name>[,d=<difficulty>]". The username is the address mined to,
+ * optionally followed by ".<worker>"; -coinbasetxnaddress is used when it is
+ * not a valid address. The transactions are selected once per tip and mempool
+ * generation, every algo gets a copy of that template with its own header,
+ * and jobs only get their own coinbase. A share meeting the target of the block is
+ * submitted to ProcessNewBlock right away.
+ */
+class CStratumServer
+{
+public:
+    typedef std::function<void(const std::string&)> SendLineFn;
+
+    explicit CStratumServer(double dDefaultDifficultyIn = DEFAULT_STRATUM_DIFFICULTY);
+
+    /** Start a session, returns its id */
+    int64_t Connect(const SendLineFn& send);
+    void Disconnect(int64_t id);
+    /** Handle a line from the miner, false if the session should be closed */
+    bool ProcessLine(int64_t id, const std::string& line);
+    /** Hand out new jobs to the sessions whose template is outdated */
+    void UpdateJobs();
+
+    static arith_uint256 DifficultyToTarget(double dDifficulty);
+    static double TargetToDifficulty(const arith_uint256& target);
+
+private:
+    struct Template
+    {
+        std::shared_ptr<const CBlock> block;
+        //! merkle branch of the coinbase, the only transaction jobs change
+        std::vector<uint256> vCoinbaseBranch;
+        int nHeight;
+        unsigned int nTransactionsUpdated;
+        int64_t nTimeCreated;
+    };
+
+    struct Job
+    {
+        std::shared_ptr<const CBlock> block;
+        std::vector<uint256> vCoinbaseBranch;
+        //! coinbase paying the session, with a zero extranonce
+        CMutableTransaction txCoinbase;
+        //! the serialized coinbase before and after the extranonce
+        std::vector<unsigned char> vchCoinb1;
+        std::vector<unsigned char> vchCoinb2;
+        arith_uint256 targetShare;
+        //! hashes of the shares submitted for this job
+        std::set<uint256> setShares;
+    };
+
+    struct Session
+    {
+        SendLineFn send;
+        std::vector<unsigned char> vchExtraNonce1;
+        bool fSubscribed;
+        bool fAuthorized;
+        std::string strWorker;
+        CScript scriptPayout;
+        uint8_t algo;
+        double dDifficulty;
+        //! difficulty last sent with mining.set_difficulty, 0 if none
+        double dDifficultySent;
+        std::map<uint64_t, Job> mapJobs;
+    };
+
+    CCriticalSection cs;
+    double dDefaultDifficulty;
+    int64_t nLastSession;
+    uint64_t nLastJob;
+    std::map<int64_t, Session> mapSessions;
+    //! the template from CreateNewBlock, renewed on a new tip or mempool changes
+    Template templateBase;
+    //! the base template and its copies for the other algos
+    std::map<uint8_t, Template> mapTemplates;
+
+    const Template* GetTemplate(uint8_t algo);
+    bool SendJob(Session& session, bool fForce);
+    void Send(const Session& session, const UniValue& obj);
+    void Reply(const Session& session, const UniValue& id, const UniValue& result);
+    void ReplyError(const Session& session, const UniValue& id, int code, const std::string& strMessage);
+
+    bool Authorize(Session& session, const UniValue& id, const UniValue& params);
+    void Submit(Session& session, const UniValue& id, const UniValue& params);
+};
+
+#endif // HUNTCOIN_STRATUM_H
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <auxpow.h>
+#include <auxpowcache.h>
+#include <auxworkcache.h>
 #include <chainparams.h>
 #include <coins.h>
 #include <consensus/merkle.h>
@@ -450,4 +452,171 @@ BOOST_AUTO_TEST_CASE (auxpow_pow)
 
 /* ************************************************************************** */
 
+BOOST_AUTO_TEST_CASE (auxpow_cache)
+{
+  CAuxpowBuilder builder(5, 42);
+  std::vector<uint256> hashes;
+  std::vector<boost::shared_ptr<CAuxPow> > auxpows;
+  for (int i = 0; i < 4; ++i)
+    {
+      builder.setCoinbase (CScript () << i);
+      hashes.push_back (ArithToUint256 (arith_uint256 (i + 1)));
+      auxpows.push_back (boost::shared_ptr<CAuxPow> (new CAuxPow (builder.get ())));
+    }
+
+  /* Size the cache to hold exactly three entries.  */
+  CAuxPowCache cache;
+  cache.Insert (hashes[0], auxpows[0]);
+  const size_t entryUsage = cache.GetStats ().usage;
+  BOOST_CHECK (entryUsage > 0);
+  cache.SetMaxUsage (3 * entryUsage);
+
+  cache.Insert (hashes[1], auxpows[1]);
+  cache.Insert (hashes[2], auxpows[2]);
+  BOOST_CHECK_EQUAL (cache.GetStats ().entries, 3U);
+
+  /* Touch the oldest entry, so that the second one is evicted next.  */
+  boost::shared_ptr<CAuxPow> result;
+  BOOST_CHECK (cache.Get (hashes[0], result));
+  BOOST_CHECK (result == auxpows[0]);
+
+  cache.Insert (hashes[3], auxpows[3]);
+  BOOST_CHECK_EQUAL (cache.GetStats ().entries, 3U);
+  BOOST_CHECK (!cache.Get (hashes[1], result));
+  BOOST_CHECK (cache.Get (hashes[0], result));
+  BOOST_CHECK (cache.Get (hashes[2], result));
+  BOOST_CHECK (cache.Get (hashes[3], result));
+  BOOST_CHECK (result == auxpows[3]);
+
+  CAuxPowCache::Stats stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.hits, 4U);
+  BOOST_CHECK_EQUAL (stats.misses, 1U);
+  BOOST_CHECK (stats.usage <= stats.limit);
+
+  /* A zero budget disables the cache.  */
+  cache.SetMaxUsage (0);
+  BOOST_CHECK_EQUAL (cache.GetStats ().entries, 0U);
+  cache.Insert (hashes[0], auxpows[0]);
+  BOOST_CHECK (!cache.Get (hashes[0], result));
+}
+
+/* ************************************************************************** */
+
+/**
+ * Build a block as createauxblock hands it out.
+ * @param algo The algo of the block.
+ * @param n Makes the block and its coinbase unique.
+ * @param txs The transactions after the coinbase.
+ * @return The block.
+ */
+static std::shared_ptr<const CBlock>
+makeWorkBlock (uint8_t algo, uint32_t n, const std::vector<CTransactionRef>& txs)
+{
+  CMutableTransaction coinbase;
+  coinbase.vin.resize (1);
+  coinbase.vin[0].prevout.SetNull ();
+  coinbase.vin[0].scriptSig = CScript () << n;
+  coinbase.vout.resize (1);
+
+  CBlock block;
+  block.SetAlgo (algo);
+  block.hashMerkleRoot = ArithToUint256 (arith_uint256 (n));
+  block.vtx.push_back (MakeTransactionRef (coinbase));
+  block.vtx.insert (block.vtx.end (), txs.begin (), txs.end ());
+  return std::make_shared<const CBlock> (block);
+}
+
+BOOST_AUTO_TEST_CASE (auxwork_cache)
+{
+  std::vector<CTransactionRef> txs, txsCopy;
+  for (int i = 0; i < 3; ++i)
+    {
+      CMutableTransaction mtx;
+      mtx.vin.resize (1);
+      mtx.vin[0].prevout = COutPoint (ArithToUint256 (arith_uint256 (i + 1)), 0);
+      mtx.vout.resize (1);
+      txs.push_back (MakeTransactionRef (mtx));
+      txsCopy.push_back (MakeTransactionRef (mtx));
+    }
+  const auto blockA = makeWorkBlock (ALGO_SHA256D, 1, txs);
+  const auto blockA2 = makeWorkBlock (ALGO_SHA256D, 2, txs);
+  const auto blockB = makeWorkBlock (ALGO_SCRYPT, 3, txs);
+  const auto blockBCopy = makeWorkBlock (ALGO_SCRYPT, 3, txsCopy);
+
+  /* Usage of each block on its own.  */
+  CAuxWorkCache cache;
+  cache.Add (blockA);
+  const size_t usageA = cache.GetStats ().usage;
+  cache.Clear ();
+  cache.Add (blockB);
+  const size_t usageB = cache.GetStats ().usage;
+  BOOST_CHECK (usageA > 0 && usageB > 0);
+
+  /* Clearing releases everything.  */
+  cache.Clear ();
+  CAuxWorkCache::Stats stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.entries, 0U);
+  BOOST_CHECK_EQUAL (stats.current, 0U);
+  BOOST_CHECK_EQUAL (stats.usage, 0U);
+  BOOST_CHECK (!cache.GetCurrent (ALGO_SCRYPT));
+
+  /* Transactions shared by two blocks are accounted for once...  */
+  cache.Add (blockA);
+  cache.Add (blockBCopy);
+  const size_t usageUnshared = cache.GetStats ().usage;
+  BOOST_CHECK_EQUAL (usageUnshared, usageA + usageB);
+  cache.Clear ();
+  cache.Add (blockA);
+  cache.Add (blockB);
+  BOOST_CHECK (cache.GetStats ().usage < usageUnshared);
+
+  /* ...and released with the last block using them.  */
+  cache.ResetCurrent ();
+  BOOST_CHECK (cache.Get (blockB->GetHash ()) == blockB);
+  cache.SetMaxUsage (cache.GetStats ().usage - 1);
+  stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.entries, 1U);
+  BOOST_CHECK_EQUAL (stats.usage, usageB);
+  BOOST_CHECK_EQUAL (stats.evicted, 1U);
+  BOOST_CHECK (!cache.Get (blockA->GetHash ()));
+  cache.SetMaxUsage (usageB - 1);
+  stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.entries, 0U);
+  BOOST_CHECK_EQUAL (stats.usage, 0U);
+  BOOST_CHECK_EQUAL (stats.evicted, 2U);
+
+  /* The current block of each algo is never evicted.  */
+  cache.SetMaxUsage (1);
+  cache.Add (blockA);
+  cache.Add (blockB);
+  BOOST_CHECK_EQUAL (cache.GetStats ().entries, 2U);
+  cache.Add (blockA2);
+  stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.entries, 2U);
+  BOOST_CHECK_EQUAL (stats.current, 2U);
+  BOOST_CHECK (cache.GetCurrent (ALGO_SHA256D) == blockA2);
+  BOOST_CHECK (cache.GetCurrent (ALGO_SCRYPT) == blockB);
+  BOOST_CHECK (!cache.Get (blockA->GetHash ()));
+
+  /* A zero budget keeps only the current blocks.  */
+  cache.SetMaxUsage (usageA + usageA + usageB);
+  cache.Add (blockA);
+  cache.Add (blockA2);
+  BOOST_CHECK_EQUAL (cache.GetStats ().entries, 3U);
+  cache.SetMaxUsage (0);
+  stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.entries, 2U);
+  BOOST_CHECK (!cache.Get (blockA->GetHash ()));
+  BOOST_CHECK (cache.Get (blockA2->GetHash ()) == blockA2);
+  BOOST_CHECK (cache.Get (blockB->GetHash ()) == blockB);
+
+  /* Once they are no longer current, nothing is left.  */
+  cache.ResetCurrent ();
+  stats = cache.GetStats ();
+  BOOST_CHECK_EQUAL (stats.entries, 0U);
+  BOOST_CHECK_EQUAL (stats.usage, 0U);
+}
+
+/* ************************************************************************** */
+
 BOOST_AUTO_TEST_SUITE_END ()
@@ -124,3 +124,50 @@ BOOST_AUTO_TEST_CASE(get_difficulty_for_block_index_overrides_tip)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(blockindex_solution_tests, TestingSetup)
+
+/* The Equihash fields are not part of CBlockIndex, GetBlockHeader() must
+ * return them both before and after the index entry was written.
+ */
+BOOST_AUTO_TEST_CASE(equihash_solution_roundtrip)
+{
+    CBlockHeader header;
+    header.SetNull();
+    header.SetAlgo(ALGO_EQUIHASH);
+    header.nTime = 1269211443;
+    header.hashReserved = uint256S("01");
+    header.nBigNonce = uint256S("02");
+    header.nSolution.assign(1344, 0x5a);
+    const uint256 hash = header.GetHash();
+
+    CBlockIndex index(header);
+    index.phashBlock = &hash;
+    BOOST_CHECK(index.HasSolution());
+
+    CBlockTreeDB::SolutionStats before = pblocktree->GetSolutionStats();
+    CBlockSolution solution;
+    solution.hashReserved = header.hashReserved;
+    solution.nBigNonce = header.nBigNonce;
+    solution.nSolution = header.nSolution;
+    pblocktree->AddBlockSolution(hash, solution);
+    BOOST_CHECK_EQUAL(pblocktree->GetSolutionStats().pending, before.pending + 1);
+
+    CBlockHeader loaded = index.GetBlockHeader(Params().GetConsensus());
+    BOOST_CHECK(loaded.nSolution == header.nSolution);
+    BOOST_CHECK(loaded.GetHash() == hash);
+
+    std::vector<std::pair<int, const CBlockFileInfo*> > vFiles;
+    BOOST_CHECK(pblocktree->WriteBatchSync(vFiles, 0, {&index}));
+    CBlockTreeDB::SolutionStats after = pblocktree->GetSolutionStats();
+    BOOST_CHECK_EQUAL(after.pending, before.pending);
+    BOOST_CHECK_EQUAL(after.stored, before.stored + 1);
+
+    loaded = index.GetBlockHeader(Params().GetConsensus());
+    BOOST_CHECK(loaded.hashReserved == header.hashReserved);
+    BOOST_CHECK(loaded.nBigNonce == header.nBigNonce);
+    BOOST_CHECK(loaded.nSolution == header.nSolution);
+    BOOST_CHECK(loaded.GetHash() == hash);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <cache-database.h>
+
+#include <test/test_huntcoin.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+// A cache of two maps, like CMasternodeMan hands to CCacheDB
+struct CTestCache
+{
+    std::map<int, std::string> mapNames;
+    std::map<uint256, int64_t> mapTimes;
+    int nChecked = 0;
+
+    template <typename Visitor>
+    void VisitCacheMaps(Visitor& visitor) {
+        visitor('n', mapNames);
+        visitor('t', mapTimes);
+    }
+
+    void CheckAndRemove() { nChecked++; }
+    void Clear() { mapNames.clear(); mapTimes.clear(); }
+    std::string ToString() const { return strprintf("names: %d, times: %d", mapNames.size(), mapTimes.size()); }
+};
+
+static const std::string strTestMagic = "magicTestCache-1";
+
+// Open the DB, load it into a fresh cache and close it again
+static CTestCache Reload(const std::string& strMagic = strTestMagic)
+{
+    CTestCache cache;
+    CCacheDB<CTestCache> db("testcache", strMagic);
+    BOOST_CHECK(db.Load(cache));
+    BOOST_CHECK_EQUAL(cache.nChecked, 1);
+    return cache;
+}
+
+static void CheckEqual(const CTestCache& a, const CTestCache& b)
+{
+    BOOST_CHECK(a.mapNames == b.mapNames);
+    BOOST_CHECK(a.mapTimes == b.mapTimes);
+}
+
+BOOST_FIXTURE_TEST_SUITE(cache_database_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(cachedb_flush_load)
+{
+    // Nothing there yet
+    BOOST_CHECK(Reload().mapNames.empty());
+
+    CTestCache cache;
+    for (int i = 0; i < 10; i++) {
+        cache.mapNames[i] = strprintf("name%d", i);
+        cache.mapTimes[InsecureRand256()] = i;
+    }
+    {
+        CCacheDB<CTestCache> db("testcache", strTestMagic);
+        BOOST_CHECK(db.Flush(cache));
+    }
+    CheckEqual(Reload(), cache);
+}
+
+BOOST_AUTO_TEST_CASE(cachedb_update_erase)
+{
+    CTestCache cache;
+    for (int i = 0; i < 10; i++)
+        cache.mapNames[i] = strprintf("name%d", i);
+    const uint256 hash = InsecureRand256();
+    cache.mapTimes[hash] = 1;
+
+    {
+        CCacheDB<CTestCache> db("testcache", strTestMagic);
+        BOOST_CHECK(db.Flush(cache));
+
+        // A changed entry is written again, an entry gone from the map is
+        // erased, by the same DB as it was flushed with
+        cache.mapNames[3] = "renamed";
+        cache.mapNames.erase(5);
+        cache.mapTimes[hash] = 2;
+        BOOST_CHECK(db.Flush(cache));
+    }
+    CTestCache loaded = Reload();
+    CheckEqual(loaded, cache);
+    BOOST_CHECK_EQUAL(loaded.mapNames.at(3), "renamed");
+    BOOST_CHECK(!loaded.mapNames.count(5));
+    BOOST_CHECK_EQUAL(loaded.mapTimes.at(hash), 2);
+
+    // And by one that only knows the entries from Load
+    {
+        CCacheDB<CTestCache> db("testcache", strTestMagic);
+        CTestCache cacheLoaded;
+        BOOST_CHECK(db.Load(cacheLoaded));
+        cacheLoaded.mapNames[4] = "renamed too";
+        cacheLoaded.mapNames.erase(6);
+        cacheLoaded.mapTimes.clear();
+        BOOST_CHECK(db.Flush(cacheLoaded));
+        cache = cacheLoaded;
+    }
+    loaded = Reload();
+    CheckEqual(loaded, cache);
+    BOOST_CHECK_EQUAL(loaded.mapNames.size(), 8U);
+    BOOST_CHECK(loaded.mapTimes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(cachedb_wrong_magic)
+{
+    CTestCache cache;
+    cache.mapNames[1] = "name1";
+    cache.mapTimes[InsecureRand256()] = 1;
+    {
+        CCacheDB<CTestCache> db("testcache", strTestMagic);
+        BOOST_CHECK(db.Flush(cache));
+    }
+
+    // Written by another version, the entries are dropped rather than read
+    CTestCache loaded = Reload("magicTestCache-2");
+    BOOST_CHECK(loaded.mapNames.empty());
+    BOOST_CHECK(loaded.mapTimes.empty());
+
+    // and wiped, not found again by the version that wrote them
+    loaded = Reload();
+    BOOST_CHECK(loaded.mapNames.empty());
+    BOOST_CHECK(loaded.mapTimes.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
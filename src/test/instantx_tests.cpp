@@ -0,0 +1,280 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <instantx.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <masternode-sync.h>
+#include <utiltime.h>
+
+#include <test/test_huntcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct CInstantSendTest
+{
+    // A lock request as ProcessTxLockRequest accepts it, picking up its orphan votes
+    static void AddLockRequest(CInstantSend& is, const CTxLockRequest& txLockRequest)
+    {
+        LOCK(is.cs_instantsend);
+        BOOST_CHECK(is.CreateTxLockCandidate(txLockRequest));
+        is.ProcessOrphanTxLockVotes(txLockRequest.GetHash());
+    }
+
+    // A vote as the TXLOCKVOTE handler stores it before it is verified
+    static void AddVote(CInstantSend& is, const CTxLockVote& vote)
+    {
+        {
+            LOCK(is.cs_instantsend);
+            BOOST_REQUIRE(!is.mapTxLockVotes.count(vote.GetHash()));
+            is.AddTxLockVote(vote.GetHash(), vote);
+        }
+        BOOST_CHECK(is.AddVerifiedTxLockVote(vote));
+    }
+
+    static bool IsMemoryLimitReached(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        return is.IsMemoryLimitReached();
+    }
+
+    static size_t DynamicMemoryUsage(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        return is.DynamicMemoryUsage();
+    }
+
+    static bool HasVote(CInstantSend& is, const CTxLockVote& vote)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapTxLockVotes.count(vote.GetHash()) || is.mapTxLockVotesOrphan.count(vote.GetHash());
+    }
+
+    static int CountVotes(CInstantSend& is, const uint256& txHash)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapTxLockCandidates.at(txHash).CountVotes();
+    }
+
+    static void CheckOrphansEmpty(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        BOOST_CHECK(is.mapTxLockVotesOrphan.empty());
+        BOOST_CHECK(is.mapTxLockVotesOrphanByTx.empty());
+        BOOST_CHECK(is.setTxLockVotesOrphanByTime.empty());
+    }
+
+    static void CheckVotesEmpty(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        BOOST_CHECK(is.mapTxLockVotes.empty());
+        BOOST_CHECK(is.setTxLockVotesByHeight.empty());
+        BOOST_CHECK(is.setTxLockVotesByTime.empty());
+    }
+
+    static void CheckEmpty(CInstantSend& is)
+    {
+        CheckOrphansEmpty(is);
+        CheckVotesEmpty(is);
+        LOCK(is.cs_instantsend);
+        BOOST_CHECK(is.mapTxLockCandidates.empty());
+        BOOST_CHECK(is.setTxLockCandidatesByHeight.empty());
+        BOOST_CHECK(is.mapVotedOutpoints.empty());
+        BOOST_CHECK(is.mapLockedOutpoints.empty());
+        BOOST_CHECK(is.mapLockRequestAccepted.empty());
+        BOOST_CHECK(is.mapLockRequestRejected.empty());
+    }
+};
+
+struct InstantSendTestingSetup : public TestingSetup {
+    int64_t nTime;
+
+    InstantSendTestingSetup() : nTime(GetTime())
+    {
+        SetMockTime(nTime);
+        // CheckAndRemove waits for the masternode list
+        masternodeSync.Reset();
+        while (!masternodeSync.IsMasternodeListSynced())
+            masternodeSync.SwitchToNextAsset(*connman);
+    }
+
+    ~InstantSendTestingSetup()
+    {
+        masternodeSync.Reset();
+        SetMockTime(0);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(instantx_tests, InstantSendTestingSetup)
+
+static CTransactionRef MakeLockTx(int nInputs)
+{
+    CMutableTransaction tx;
+    for (int i = 0; i < nInputs; i++)
+        tx.vin.emplace_back(COutPoint(InsecureRand256(), i));
+    tx.vout.emplace_back(1 * COIN, CScript() << OP_TRUE);
+    return MakeTransactionRef(tx);
+}
+
+// Votes of nMasternodes masternodes for every input of tx, too few to lock it
+static std::vector<CTxLockVote> MakeVotes(const CTransaction& tx, int nMasternodes)
+{
+    std::vector<CTxLockVote> vVotes;
+    for (int i = 0; i < nMasternodes; i++) {
+        COutPoint outpointMasternode(InsecureRand256(), 0);
+        for (const CTxIn& txin : tx.vin)
+            vVotes.emplace_back(tx.GetHash(), txin.prevout, outpointMasternode);
+    }
+    return vVotes;
+}
+
+static void SetTip(CInstantSend& is, int nHeight)
+{
+    CBlockIndex index;
+    index.nHeight = nHeight;
+    is.UpdatedBlockTip(&index);
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_expire_by_height)
+{
+    CInstantSend is;
+    const int nKeepLock = Params().GetConsensus().nInstantSendKeepLock;
+
+    CTransactionRef tx = MakeLockTx(2);
+    CInstantSendTest::AddLockRequest(is, CTxLockRequest(*tx));
+    for (const CTxLockVote& vote : MakeVotes(*tx, 3))
+        CInstantSendTest::AddVote(is, vote);
+    BOOST_CHECK_EQUAL(is.GetStats().candidates, 1U);
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 6U);
+
+    // Mined at height 100, the candidate and its votes are kept for nKeepLock blocks
+    CBlockIndex index;
+    index.nHeight = 100;
+    is.SyncTransaction(tx, &index, 1);
+    SetTip(is, 100 + nKeepLock);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().candidates, 1U);
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 6U);
+
+    // Back in the mempool after a reorg it does not expire by height
+    is.SyncTransaction(tx, nullptr, 0);
+    SetTip(is, 101 + nKeepLock);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().candidates, 1U);
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 6U);
+
+    // Mined again, it goes one block after the last one it was kept for
+    index.nHeight = 102;
+    is.SyncTransaction(tx, &index, 1);
+    SetTip(is, 102 + nKeepLock);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().candidates, 1U);
+    SetTip(is, 103 + nKeepLock);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().candidates, 0U);
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 0U);
+    CInstantSendTest::CheckEmpty(is);
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_expire_by_time)
+{
+    CInstantSend is;
+    CTransactionRef tx = MakeLockTx(1);
+    CInstantSendTest::AddLockRequest(is, CTxLockRequest(*tx));
+    std::vector<CTxLockVote> vVotes = MakeVotes(*tx, 2);
+    CInstantSendTest::AddVote(is, vVotes[0]);
+    SetMockTime(nTime + 10);
+    CInstantSendTest::AddVote(is, vVotes[1]);
+
+    // Votes of a lock that did not complete go once it has failed
+    SetMockTime(nTime + INSTANTSEND_FAILED_TIMEOUT_SECONDS);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 2U);
+    SetMockTime(nTime + INSTANTSEND_FAILED_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK(!CInstantSendTest::HasVote(is, vVotes[0]));
+    BOOST_CHECK(CInstantSendTest::HasVote(is, vVotes[1]));
+    SetMockTime(nTime + 10 + INSTANTSEND_FAILED_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 0U);
+    CInstantSendTest::CheckVotesEmpty(is);
+
+    // The candidate stays until its transaction is mined and expires
+    BOOST_CHECK_EQUAL(is.GetStats().candidates, 1U);
+    CBlockIndex index;
+    index.nHeight = 100;
+    is.SyncTransaction(tx, &index, 1);
+    SetTip(is, 101 + Params().GetConsensus().nInstantSendKeepLock);
+    is.CheckAndRemove();
+    CInstantSendTest::CheckEmpty(is);
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_orphan_votes)
+{
+    CInstantSend is;
+    CTransactionRef txA = MakeLockTx(2);
+    CTransactionRef txB = MakeLockTx(1);
+    CTransactionRef txC = MakeLockTx(1);
+    std::vector<CTxLockVote> vVotesA = MakeVotes(*txA, 1);
+    for (const CTxLockVote& vote : vVotesA)
+        CInstantSendTest::AddVote(is, vote);
+    SetMockTime(nTime + 10);
+    std::vector<CTxLockVote> vVotesB = MakeVotes(*txB, 2);
+    for (const CTxLockVote& vote : vVotesB)
+        CInstantSendTest::AddVote(is, vote);
+    std::vector<CTxLockVote> vVotesC = MakeVotes(*txC, 1);
+    CInstantSendTest::AddVote(is, vVotesC[0]);
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 5U);
+
+    // The lock request turns its orphans into regular votes
+    CInstantSendTest::AddLockRequest(is, CTxLockRequest(*txC));
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 4U);
+    BOOST_CHECK(CInstantSendTest::HasVote(is, vVotesC[0]));
+    BOOST_CHECK_EQUAL(CInstantSendTest::CountVotes(is, txC->GetHash()), 1);
+
+    // Orphans time out oldest first
+    SetMockTime(nTime + INSTANTSEND_LOCK_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 2U);
+    for (const CTxLockVote& vote : vVotesA)
+        BOOST_CHECK(!CInstantSendTest::HasVote(is, vote));
+    for (const CTxLockVote& vote : vVotesB)
+        BOOST_CHECK(CInstantSendTest::HasVote(is, vote));
+
+    SetMockTime(nTime + 10 + INSTANTSEND_LOCK_TIMEOUT_SECONDS + 1);
+    is.CheckAndRemove();
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 0U);
+    CInstantSendTest::CheckOrphansEmpty(is);
+    BOOST_CHECK_EQUAL(is.GetStats().votes, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_memory_limit)
+{
+    CInstantSend is;
+    std::vector<CTxLockVote> vVotes;
+    for (int i = 0; i < 10; i++) {
+        SetMockTime(nTime + i);
+        vVotes.push_back(MakeVotes(*MakeLockTx(1), 1)[0]);
+        CInstantSendTest::AddVote(is, vVotes.back());
+    }
+    BOOST_CHECK(!CInstantSendTest::IsMemoryLimitReached(is));
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 10U);
+
+    // Just over the cap the oldest orphan makes room
+    is.SetMaxUsage(CInstantSendTest::DynamicMemoryUsage(is) - 1);
+    BOOST_CHECK(!CInstantSendTest::IsMemoryLimitReached(is));
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 9U);
+    BOOST_CHECK(!CInstantSendTest::HasVote(is, vVotes[0]));
+    BOOST_CHECK(CInstantSendTest::HasVote(is, vVotes[1]));
+
+    // With no room at all every orphan goes, and is still not enough
+    is.SetMaxUsage(0);
+    BOOST_CHECK(CInstantSendTest::IsMemoryLimitReached(is));
+    BOOST_CHECK_EQUAL(is.GetStats().orphans, 0U);
+    CInstantSendTest::CheckOrphansEmpty(is);
+    CInstantSendTest::CheckVotesEmpty(is);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,128 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-collateral.h>
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <validation.h>
+
+#include <test/test_huntcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(masternode_collateral_tests, TestChain100Setup)
+
+static CMutableTransaction Spend(const COutPoint& outpoint)
+{
+    CMutableTransaction tx;
+    tx.vin.emplace_back(outpoint);
+    tx.vout.emplace_back(1 * COIN, CScript() << OP_TRUE);
+    return tx;
+}
+
+static CBlock BlockOf(const std::vector<CMutableTransaction>& txns)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.emplace_back(1 * COIN, CScript() << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    for (const CMutableTransaction& tx : txns)
+        block.vtx.push_back(MakeTransactionRef(tx));
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(collateral_connect_disconnect)
+{
+    CCollateralWatch watch;
+    const COutPoint outpoint(coinbaseTxns[0].GetHash(), 0);
+
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 1);
+    BOOST_CHECK_EQUAL(watch.size(), 1U);
+
+    const CBlock blockSpend = BlockOf({Spend(outpoint)});
+    watch.BlockConnected(blockSpend, 101);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+    watch.BlockDisconnected(blockSpend);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 1);
+
+    // Notifications lagging behind the read set what was read already
+    watch.BlockConnected(BlockOf({}), 101);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 1);
+
+    watch.Unwatch(outpoint);
+    BOOST_CHECK_EQUAL(watch.size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(collateral_reorg)
+{
+    CCollateralWatch watch;
+    CMutableTransaction txCollateral = Spend(COutPoint(InsecureRand256(), 0));
+    const COutPoint outpoint(txCollateral.GetHash(), 0);
+
+    // Not in the chain yet
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+
+    const CBlock blockA = BlockOf({txCollateral});
+    watch.BlockConnected(blockA, 101);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 101);
+
+    // Reorged out and mined again in a block of the other branch
+    const CBlock blockB = BlockOf({txCollateral});
+    watch.BlockDisconnected(blockA);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+    watch.BlockConnected(BlockOf({}), 101);
+    watch.BlockConnected(blockB, 102);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 102);
+
+    // Created and spent in the same block, which then is disconnected
+    watch.BlockDisconnected(blockB);
+    const CBlock blockC = BlockOf({txCollateral, Spend(outpoint)});
+    watch.BlockConnected(blockC, 102);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+    watch.BlockDisconnected(blockC);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+    watch.BlockConnected(blockA, 102);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 102);
+}
+
+BOOST_AUTO_TEST_CASE(collateral_first_seen_after_spend)
+{
+    CCollateralWatch watch;
+    const COutPoint outpoint(coinbaseTxns[0].GetHash(), 0);
+    const CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    CMutableTransaction txSpend = Spend(outpoint);
+    std::vector<unsigned char> vchSig;
+    const uint256 hash = SignatureHash(scriptPubKey, txSpend, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    txSpend.vin[0].scriptSig << vchSig;
+
+    const CBlock block = CreateAndProcessBlock({txSpend}, scriptPubKey);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+
+    // Asked for only once the spend is in the UTXO set
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+
+    // Undoing the spend brings the coin back at the height it was created
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, Params(), chainActive.Tip()));
+    }
+    watch.BlockDisconnected(block);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), 1);
+
+    // And spending it again takes it out
+    watch.BlockConnected(block, 101);
+    BOOST_CHECK_EQUAL(watch.GetHeight(outpoint), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
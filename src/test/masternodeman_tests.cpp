@@ -0,0 +1,303 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternodeman.h>
+
+#include <masternode-collateral.h>
+#include <masternode-payments.h>
+#include <masternode-sync.h>
+#include <netbase.h>
+#include <timedata.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <test/test_huntcoin.h>
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+struct CMasternodeManTest
+{
+    // Change the list behind the back of the payment queue
+    static void EraseUnqueued(CMasternodeMan& man, const COutPoint& outpoint)
+    {
+        LOCK(man.cs);
+        man.mapMasternodes.erase(outpoint);
+    }
+
+    static void AddUnqueued(CMasternodeMan& man, const CMasternode& mn)
+    {
+        LOCK(man.cs);
+        man.mapMasternodes[mn.outpoint] = mn;
+    }
+
+    // When outpoint is next due for a check, -1 if it isn't scheduled
+    static int64_t GetCheckDeadline(CMasternodeMan& man, const COutPoint& outpoint)
+    {
+        LOCK(man.cs);
+        auto it = man.mapCheckDeadlines.find(outpoint);
+        return it == man.mapCheckDeadlines.end() ? -1 : it->second;
+    }
+
+    static size_t CountCheckDeadlines(CMasternodeMan& man, bool fHeap)
+    {
+        LOCK(man.cs);
+        return fHeap ? man.heapCheckDeadlines.size() : man.mapCheckDeadlines.size();
+    }
+
+    // Drop the deadlines and schedule them again, as loading the cache does
+    static void RebuildCheckDeadlines(CMasternodeMan& man)
+    {
+        LOCK(man.cs);
+        man.heapCheckDeadlines = decltype(man.heapCheckDeadlines)();
+        man.mapCheckDeadlines.clear();
+        man.RebuildCheckDeadlines();
+    }
+};
+
+struct MasternodeManTestingSetup : public TestChain100Setup {
+    int64_t nTime;
+
+    MasternodeManTestingSetup() : nTime(GetTime())
+    {
+        SetMockTime(nTime);
+        // the payment queue is only used once the winners list is synced
+        masternodeSync.Reset();
+        while (!masternodeSync.IsWinnersListSynced())
+            masternodeSync.SwitchToNextAsset(*connman);
+    }
+
+    ~MasternodeManTestingSetup()
+    {
+        masternodeSync.Reset();
+        collateralwatch.Clear();
+        SetMockTime(0);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(masternodeman_tests, MasternodeManTestingSetup)
+
+/** A masternode with one of the coinbase outputs of the test chain as collateral */
+static CMasternode MakeMasternode(const CTransaction& txCollateral, const CPubKey& pubKey, int nProtocolVersion)
+{
+    CMasternode mn(LookupNumeric("127.0.0.1", 9999), COutPoint(txCollateral.GetHash(), 0), pubKey, pubKey, nProtocolVersion);
+    mn.fUnitTest = true;
+    mn.nActiveState = CMasternode::MASTERNODE_ENABLED;
+    return mn;
+}
+
+/**
+ * The winner as GetNextMasternodeInQueueForPayment picked it before the
+ * payment queue: filter every masternode of the list, sort what is left by
+ * last paid block and score the oldest tenth.
+ */
+static bool GetNextMasternodeFullScan(CMasternodeMan& man, const std::vector<CMasternode>& vecMasternodes, int nBlockHeight, bool fFilterSigTime, int& nCountRet, COutPoint& outpointRet)
+{
+    LOCK(cs_main);
+    outpointRet.SetNull();
+    int nMnCount = man.CountMasternodes();
+
+    std::vector<std::pair<int, const CMasternode*> > vecMasternodeLastPaid;
+    for (const CMasternode& mn : vecMasternodes) {
+        if(!mn.IsValidForPayment()) continue;
+        if(mn.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
+        if(mnpayments.IsScheduled(mn, nBlockHeight)) continue;
+        if(fFilterSigTime && mn.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
+        int nCollateralHeight = collateralwatch.GetHeight(mn.outpoint);
+        if(nCollateralHeight < 0 || chainActive.Height() - nCollateralHeight + 1 < nMnCount) continue;
+        vecMasternodeLastPaid.push_back(std::make_pair(mn.GetLastPaidBlock(), &mn));
+    }
+
+    nCountRet = (int)vecMasternodeLastPaid.size();
+    if(fFilterSigTime && nCountRet < nMnCount/3)
+        return GetNextMasternodeFullScan(man, vecMasternodes, nBlockHeight, false, nCountRet, outpointRet);
+
+    std::sort(vecMasternodeLastPaid.begin(), vecMasternodeLastPaid.end(),
+              [](const std::pair<int, const CMasternode*>& a, const std::pair<int, const CMasternode*>& b) {
+                  return a.first != b.first ? a.first < b.first : a.second->outpoint < b.second->outpoint;
+              });
+
+    const uint256 blockHash = chainActive[nBlockHeight - 101]->GetBlockHash();
+    int nTenthNetwork = nMnCount/10;
+    int nCountTenth = 0;
+    arith_uint256 nHighest = 0;
+    for (const auto& s : vecMasternodeLastPaid) {
+        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+        if(nScore > nHighest) {
+            nHighest = nScore;
+            outpointRet = s.second->outpoint;
+        }
+        nCountTenth++;
+        if(nCountTenth >= nTenthNetwork) break;
+    }
+    return !outpointRet.IsNull();
+}
+
+static void CheckSameWinners(CMasternodeMan& man, const std::vector<CMasternode>& vecMasternodes)
+{
+    for (int nBlockHeight = 101; nBlockHeight <= 150; nBlockHeight++) {
+        for (bool fFilterSigTime : {true, false}) {
+            int nCount, nCountExpected;
+            masternode_info_t mnInfo;
+            COutPoint outpointExpected;
+            bool fFound = man.GetNextMasternodeInQueueForPayment(nBlockHeight, fFilterSigTime, nCount, mnInfo);
+            BOOST_CHECK_EQUAL(fFound, GetNextMasternodeFullScan(man, vecMasternodes, nBlockHeight, fFilterSigTime, nCountExpected, outpointExpected));
+            BOOST_CHECK_EQUAL(nCount, nCountExpected);
+            BOOST_CHECK(mnInfo.outpoint == outpointExpected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(payment_queue_same_winner)
+{
+    const int nMinProtocol = mnpayments.GetMinMasternodePaymentsProto();
+    const CPubKey pubKey = coinbaseKey.GetPubKey();
+
+    for (int nRecentEvery : {5, 1}) {
+        CMasternodeMan man;
+        std::vector<CMasternode> vecMasternodes;
+
+        // The oldest coinbases have the confirmations, the newest ones not
+        std::vector<int> vecCollaterals;
+        for (int i = 0; i < 30; i++)
+            vecCollaterals.push_back(i);
+        for (int i = 95; i < 100; i++)
+            vecCollaterals.push_back(i);
+
+        for (int i : vecCollaterals) {
+            CMasternode mn = MakeMasternode(coinbaseTxns[i], pubKey, i % 11 == 3 ? nMinProtocol - 1 : nMinProtocol);
+            if (i % 7 == 2)
+                mn.nActiveState = CMasternode::MASTERNODE_EXPIRED;
+            // ties in the last paid block are broken by outpoint
+            mn.nBlockLastPaid = InsecureRandRange(20);
+            // with every masternode recent, the sigTime filter is dropped
+            mn.sigTime = i % nRecentEvery == 0 ? nTime - 100 : nTime - 100000;
+            BOOST_CHECK(man.Add(mn));
+            vecMasternodes.push_back(mn);
+        }
+        CheckSameWinners(man, vecMasternodes);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(payment_queue_out_of_step)
+{
+    const CPubKey pubKey = coinbaseKey.GetPubKey();
+    CMasternodeMan man;
+    std::vector<CMasternode> vecMasternodes;
+    for (int i = 0; i < 20; i++) {
+        CMasternode mn = MakeMasternode(coinbaseTxns[i], pubKey, mnpayments.GetMinMasternodePaymentsProto());
+        mn.nBlockLastPaid = i;
+        mn.sigTime = nTime - 100000;
+        BOOST_CHECK(man.Add(mn));
+        vecMasternodes.push_back(mn);
+    }
+
+    // A queued masternode that is gone from the list is not looked up, the
+    // queue is rebuilt instead
+    CMasternodeManTest::EraseUnqueued(man, vecMasternodes[0].outpoint);
+    vecMasternodes.erase(vecMasternodes.begin());
+    CheckSameWinners(man, vecMasternodes);
+
+    // And so is one that is missing from the queue
+    CMasternode mn = MakeMasternode(coinbaseTxns[20], pubKey, mnpayments.GetMinMasternodePaymentsProto());
+    mn.sigTime = nTime - 100000;
+    CMasternodeManTest::AddUnqueued(man, mn);
+    vecMasternodes.push_back(mn);
+    CheckSameWinners(man, vecMasternodes);
+}
+
+static int64_t GetTimeLastChecked(CMasternodeMan& man, const COutPoint& outpoint)
+{
+    masternode_info_t mnInfo;
+    BOOST_REQUIRE(man.GetMasternodeInfo(outpoint, mnInfo));
+    return mnInfo.nTimeLastChecked;
+}
+
+BOOST_AUTO_TEST_CASE(check_deadlines)
+{
+    // CheckAndRemove only needs the list, and without the full sync it
+    // doesn't ask peers to recover the masternodes that never pinged
+    masternodeSync.Reset();
+    while (!masternodeSync.IsMasternodeListSynced())
+        masternodeSync.SwitchToNextAsset(*connman);
+
+    const CPubKey pubKey = coinbaseKey.GetPubKey();
+    CMasternodeMan man;
+    std::vector<COutPoint> vecOutpoints;
+    for (int i = 0; i < 3; i++) {
+        CMasternode mn = MakeMasternode(coinbaseTxns[i], pubKey, PROTOCOL_VERSION);
+        BOOST_CHECK(man.Add(mn));
+        vecOutpoints.push_back(mn.outpoint);
+    }
+    // Checked just before it was added, it is only due MASTERNODE_CHECK_SECONDS later
+    CMasternode mnLate = MakeMasternode(coinbaseTxns[3], pubKey, PROTOCOL_VERSION);
+    mnLate.nTimeLastChecked = nTime;
+    BOOST_CHECK(man.Add(mnLate));
+    // Its collateral isn't in the chain, the first check finds it spent
+    CMasternode mnSpent(LookupNumeric("127.0.0.1", 9999), COutPoint(InsecureRand256(), 0), pubKey, pubKey, PROTOCOL_VERSION);
+    BOOST_CHECK(man.Add(mnSpent));
+
+    // New masternodes are due a second from now, not right away
+    man.CheckDue();
+    for (const COutPoint& outpoint : vecOutpoints) {
+        BOOST_CHECK_EQUAL(GetTimeLastChecked(man, outpoint), 0);
+        BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckDeadline(man, outpoint), nTime + 1);
+    }
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckDeadline(man, mnLate.outpoint), nTime + MASTERNODE_CHECK_SECONDS);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckDeadline(man, mnSpent.outpoint), nTime + 1);
+
+    // Then once every MASTERNODE_CHECK_SECONDS
+    for (int64_t nCheck = nTime + 1; nCheck <= nTime + 1 + 3 * MASTERNODE_CHECK_SECONDS; nCheck += MASTERNODE_CHECK_SECONDS) {
+        SetMockTime(nCheck);
+        man.CheckDue();
+        for (const COutPoint& outpoint : vecOutpoints)
+            BOOST_CHECK_EQUAL(GetTimeLastChecked(man, outpoint), nCheck);
+        BOOST_CHECK_EQUAL(GetTimeLastChecked(man, mnSpent.outpoint), nCheck);
+        BOOST_CHECK_EQUAL(GetTimeLastChecked(man, mnLate.outpoint), nCheck - 1);
+
+        // and not in between, when only the late one is due
+        SetMockTime(nCheck + MASTERNODE_CHECK_SECONDS - 1);
+        man.CheckDue();
+        for (const COutPoint& outpoint : vecOutpoints)
+            BOOST_CHECK_EQUAL(GetTimeLastChecked(man, outpoint), nCheck);
+        BOOST_CHECK_EQUAL(GetTimeLastChecked(man, mnLate.outpoint), nCheck + MASTERNODE_CHECK_SECONDS - 1);
+    }
+
+    masternode_info_t mnInfo;
+    BOOST_REQUIRE(man.GetMasternodeInfo(mnSpent.outpoint, mnInfo));
+    BOOST_CHECK_EQUAL(mnInfo.nActiveState, CMasternode::MASTERNODE_OUTPOINT_SPENT);
+
+    // A removed masternode drops out of the deadlines, its entry in the heap
+    // is skipped once it comes due
+    man.CheckAndRemove(*connman);
+    BOOST_CHECK(!man.Has(mnSpent.outpoint));
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckDeadline(man, mnSpent.outpoint), -1);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::CountCheckDeadlines(man, false), 4U);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::CountCheckDeadlines(man, true), 5U);
+
+    int64_t nCheck = CMasternodeManTest::GetCheckDeadline(man, vecOutpoints[0]);
+    SetMockTime(nCheck);
+    man.CheckDue();
+    for (const COutPoint& outpoint : vecOutpoints)
+        BOOST_CHECK_EQUAL(GetTimeLastChecked(man, outpoint), nCheck);
+    BOOST_CHECK(!man.Has(mnSpent.outpoint));
+    BOOST_CHECK_EQUAL(CMasternodeManTest::CountCheckDeadlines(man, true), 4U);
+
+    // Rebuilt, as after loading the cache, every masternode is due
+    // MASTERNODE_CHECK_SECONDS after its last check again
+    CMasternodeManTest::RebuildCheckDeadlines(man);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::CountCheckDeadlines(man, false), 4U);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::CountCheckDeadlines(man, true), 4U);
+    for (const COutPoint& outpoint : vecOutpoints)
+        BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckDeadline(man, outpoint), nCheck + MASTERNODE_CHECK_SECONDS);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckDeadline(man, mnLate.outpoint), GetTimeLastChecked(man, mnLate.outpoint) + MASTERNODE_CHECK_SECONDS);
+
+    SetMockTime(nCheck + MASTERNODE_CHECK_SECONDS);
+    man.CheckDue();
+    for (const COutPoint& outpoint : vecOutpoints)
+        BOOST_CHECK_EQUAL(GetTimeLastChecked(man, outpoint), nCheck + MASTERNODE_CHECK_SECONDS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,10 +8,16 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <key.h>
 #include <validation.h>
+#include <huntcoin/hardfork.h>
 #include <miner.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <pubkey.h>
+#include <rpc/mining.h>
+#include <rpc/server.h>
+#include <script/sign.h>
 #include <script/standard.h>
 #include <txmempool.h>
 #include <uint256.h>
@@ -520,4 +526,237 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+
+// A spend of outpoints to an OP_TRUE output, which needs no signature
+static CMutableTransaction SpendForSelection(const std::vector<COutPoint>& vOutpoints, CAmount nValue)
+{
+    CMutableTransaction tx;
+    for (const COutPoint& outpoint : vOutpoints)
+        tx.vin.emplace_back(outpoint);
+    tx.vout.emplace_back(nValue, CScript() << OP_TRUE);
+    return tx;
+}
+
+// Add tx to the mempool, telling the selection as the notification would
+static uint256 AddForSelection(const CMutableTransaction& tx, CAmount nFee)
+{
+    TestMemPoolEntryHelper entry;
+    {
+        LOCK(mempool.cs);
+        mempool.addUnchecked(tx.GetHash(), entry.Fee(nFee).Time(GetTime()).FromTx(tx));
+    }
+    templateselection.TransactionAddedToMempool(MakeTransactionRef(tx));
+    return tx.GetHash();
+}
+
+static void RemoveForSelection(const CMutableTransaction& tx)
+{
+    const CTransactionRef ptx = MakeTransactionRef(tx);
+    {
+        LOCK(mempool.cs);
+        mempool.removeRecursive(*ptx);
+    }
+    templateselection.TransactionRemovedFromMempool(ptx);
+}
+
+// The transactions of a template updated from the selection, checked to be
+// the ones a template selected from the whole mempool has, with the same fees
+static std::set<uint256> CheckSelection(const CScript& scriptPubKey, unsigned int nBlockMaxWeight = MaxBlockWeight(true))
+{
+    BlockAssembler::Options options;
+    options.nBlockMaxWeight = nBlockMaxWeight;
+    options.blockMinFeeRate = blockMinFeeRate;
+
+    std::unique_ptr<CBlockTemplate> pfull = BlockAssembler(Params(), options).CreateNewBlock(scriptPubKey, 0);
+    std::unique_ptr<CBlockTemplate> pincremental = BlockAssembler(Params(), options).CreateNewBlock(scriptPubKey, 0, true, &templateselection);
+    BOOST_REQUIRE(pfull && pincremental);
+
+    std::set<uint256> setFull, setIncremental;
+    for (size_t i = 1; i < pfull->block.vtx.size(); i++)
+        setFull.insert(pfull->block.vtx[i]->GetHash());
+    for (size_t i = 1; i < pincremental->block.vtx.size(); i++)
+        setIncremental.insert(pincremental->block.vtx[i]->GetHash());
+    BOOST_CHECK(setFull == setIncremental);
+    BOOST_CHECK_EQUAL(pfull->vTxFees[0], pincremental->vTxFees[0]);
+    return setIncremental;
+}
+
+BOOST_FIXTURE_TEST_CASE(CreateNewBlock_incremental, TestChain100Setup)
+{
+    const CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    templateselection.Invalidate();
+
+    // Split the mature coinbase into outputs the mempool transactions spend
+    const int nFanOut = 8;
+    const CAmount nFanValue = coinbaseTxns[0].vout[0].nValue / nFanOut - 1000;
+    CMutableTransaction txFan = SpendForSelection({COutPoint(coinbaseTxns[0].GetHash(), 0)}, nFanValue);
+    txFan.vout.resize(nFanOut, txFan.vout[0]);
+    std::vector<unsigned char> vchSig;
+    const uint256 hashSig = SignatureHash(scriptPubKey, txFan, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hashSig, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    txFan.vin[0].scriptSig << vchSig;
+    CreateAndProcessBlock({txFan}, scriptPubKey);
+    BOOST_REQUIRE_EQUAL(pcoinsTip->AccessCoin(COutPoint(txFan.GetHash(), 0)).out.nValue, nFanValue);
+    auto fan = [&txFan](uint32_t n) { return COutPoint(txFan.GetHash(), n); };
+
+    // Added transactions
+    const CMutableTransaction txA = SpendForSelection({fan(0)}, nFanValue - 10000);
+    const uint256 hashA = AddForSelection(txA, 10000);
+    BOOST_CHECK(CheckSelection(scriptPubKey).count(hashA));
+    const CMutableTransaction txB = SpendForSelection({fan(1)}, nFanValue - 20000);
+    const uint256 hashB = AddForSelection(txB, 20000);
+    BOOST_CHECK(CheckSelection(scriptPubKey).count(hashB));
+
+    // A replaced and a removed transaction
+    RemoveForSelection(txB);
+    const uint256 hashB2 = AddForSelection(SpendForSelection({fan(1)}, nFanValue - 30000), 30000);
+    RemoveForSelection(txA);
+    std::set<uint256> setSelected = CheckSelection(scriptPubKey);
+    BOOST_CHECK(!setSelected.count(hashA) && !setSelected.count(hashB) && setSelected.count(hashB2));
+
+    // A parent below the minimum fee rate, then its child paying for both
+    const CMutableTransaction txParent = SpendForSelection({fan(2)}, nFanValue);
+    const uint256 hashParent = AddForSelection(txParent, 0);
+    BOOST_CHECK(!CheckSelection(scriptPubKey).count(hashParent));
+    const uint256 hashChild = AddForSelection(SpendForSelection({COutPoint(hashParent, 0)}, nFanValue - 50000), 50000);
+    setSelected = CheckSelection(scriptPubKey);
+    BOOST_CHECK(setSelected.count(hashParent) && setSelected.count(hashChild));
+
+    // A child paying enough for itself but not for its parent makes it on its
+    // own once the parent is mined
+    const CMutableTransaction txMined = SpendForSelection({fan(3)}, nFanValue);
+    AddForSelection(txMined, 0);
+    const uint256 hashOrphaned = AddForSelection(SpendForSelection({COutPoint(txMined.GetHash(), 0)}, nFanValue - 100), 100);
+    BOOST_CHECK(!CheckSelection(scriptPubKey).count(hashOrphaned));
+    const CBlock block = CreateAndProcessBlock({txMined}, scriptPubKey);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    templateselection.BlockConnected(std::make_shared<const CBlock>(block), chainActive.Tip(), {});
+    setSelected = CheckSelection(scriptPubKey);
+    BOOST_CHECK(setSelected.count(hashOrphaned) && setSelected.count(hashB2) && setSelected.count(hashChild));
+
+    // When the block is full, a better transaction has to push others out
+    const unsigned int nSmallWeight = 4000 + 4 * 2 * ::GetSerializeSize(txA, SER_NETWORK, PROTOCOL_VERSION) + 100;
+    setSelected = CheckSelection(scriptPubKey, nSmallWeight);
+    BOOST_CHECK_EQUAL(setSelected.size(), 2U);
+    const uint256 hashBest = AddForSelection(SpendForSelection({fan(4)}, nFanValue - 1000000), 1000000);
+    setSelected = CheckSelection(scriptPubKey, nSmallWeight);
+    BOOST_CHECK_EQUAL(setSelected.size(), 2U);
+    BOOST_CHECK(setSelected.count(hashBest));
+
+    // prioritisetransaction changes fees without a mempool notification, the
+    // selection has to start over
+    CheckSelection(scriptPubKey);
+    const uint256 hashPrioritised = AddForSelection(SpendForSelection({fan(5)}, nFanValue), 0);
+    BOOST_CHECK(!CheckSelection(scriptPubKey).count(hashPrioritised));
+    JSONRPCRequest request;
+    request.params.setArray();
+    request.params.push_back(hashPrioritised.GetHex());
+    request.params.push_back(0);
+    request.params.push_back(1000000);
+    BOOST_CHECK(tableRPC["prioritisetransaction"]->actor(request).get_bool());
+    BOOST_CHECK(CheckSelection(scriptPubKey).count(hashPrioritised));
+
+    templateselection.Invalidate();
+    mempool.clear();
+}
+
+BOOST_FIXTURE_TEST_CASE(SetBlockAlgo_template_copy, TestChain100Setup)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    std::unique_ptr<CBlockTemplate> pbase = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, ALGO_SHA256D);
+    BOOST_REQUIRE(pbase);
+    const CBlock& blockBase = pbase->block;
+    BOOST_REQUIRE(IsHardForkActivated(blockBase.nTime));
+
+    for (uint8_t algo : {ALGO_SCRYPT, ALGO_EQUIHASH}) {
+        CBlockTemplate copy(*pbase);
+        CBlock& block = copy.block;
+        SetBlockAlgo(&block, consensusParams, chainActive.Tip(), algo);
+
+        // The header is the one of algo...
+        BOOST_CHECK_EQUAL(block.GetAlgo(), algo);
+        BOOST_CHECK_EQUAL(block.nVersion & ~BLOCK_VERSION_ALGO, blockBase.nVersion & ~BLOCK_VERSION_ALGO);
+        BOOST_CHECK_EQUAL(block.nBits, GetNextWorkRequired(chainActive.Tip(), &block, consensusParams, algo));
+        BOOST_CHECK_EQUAL(block.nNonce, 0U);
+        BOOST_CHECK(block.nSolution.empty());
+        if (algo == ALGO_EQUIHASH) {
+            // Random, with the top and bottom 16 bits left for the miner
+            BOOST_CHECK(!block.nBigNonce.IsNull());
+            BOOST_CHECK_EQUAL(UintToArith256(block.nBigNonce).GetLow64() & 0xffff, 0U);
+            BOOST_CHECK((UintToArith256(block.nBigNonce) >> 240) == 0);
+        } else {
+            BOOST_CHECK(block.nBigNonce.IsNull());
+        }
+
+        // ...the rest is shared with the base template
+        BOOST_CHECK(block.hashPrevBlock == blockBase.hashPrevBlock);
+        BOOST_CHECK(block.hashMerkleRoot == blockBase.hashMerkleRoot);
+        BOOST_REQUIRE_EQUAL(block.vtx.size(), blockBase.vtx.size());
+        for (size_t i = 0; i < block.vtx.size(); i++)
+            BOOST_CHECK(block.vtx[i] == blockBase.vtx[i]);
+        BOOST_CHECK(block.vtx[0]->vout == blockBase.vtx[0]->vout);
+        BOOST_CHECK(copy.vTxFees == pbase->vTxFees);
+    }
+}
+
+static UniValue GenerateForTest(int nGenerate, uint64_t nMaxTries)
+{
+    std::shared_ptr<CReserveScript> coinbaseScript = std::make_shared<CReserveScript>();
+    coinbaseScript->reserveScript = CScript() << OP_TRUE;
+    return generateBlocks(coinbaseScript, nGenerate, nMaxTries, false);
+}
+
+BOOST_FIXTURE_TEST_CASE(GenerateBlocks_threads, TestChain100Setup)
+{
+    gArgs.ForceSetArg("-acceptdividedcoinbase", "1");
+
+    // Several threads mine each template. Asked for fewer threads, a later
+    // call keeps the threads but only that many of them mine
+    int nThreads, nRunning;
+    gArgs.ForceSetArg("-genproclimit", "4");
+    UniValue hashes = GenerateForTest(5, 1000000);
+    BOOST_CHECK_EQUAL(hashes.size(), 5U);
+    GetMinerThreadCounts(nThreads, nRunning);
+    BOOST_CHECK_EQUAL(nThreads, 4);
+    BOOST_CHECK_EQUAL(nRunning, 4);
+    gArgs.ForceSetArg("-genproclimit", "2");
+    hashes = GenerateForTest(3, 1000000);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 3U);
+    GetMinerThreadCounts(nThreads, nRunning);
+    BOOST_CHECK_EQUAL(nThreads, 4);
+    BOOST_CHECK_EQUAL(nRunning, 2);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainActive.Height(), 108);
+        BOOST_CHECK_EQUAL(chainActive.Tip()->GetBlockHash().GetHex(), hashes[2].get_str());
+    }
+
+    // Running out of tries gives up without a block
+    hashes = GenerateForTest(1, 0);
+    BOOST_CHECK(hashes.empty());
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainActive.Height(), 108);
+    }
+
+    // Stopping the threads is clean, and they are started again when needed
+    StopMinerThreads();
+    StopMinerThreads();
+    hashes = GenerateForTest(2, 1000000);
+    BOOST_CHECK_EQUAL(hashes.size(), 2U);
+    GetMinerThreadCounts(nThreads, nRunning);
+    BOOST_CHECK_EQUAL(nThreads, 2);
+    BOOST_CHECK_EQUAL(nRunning, 2);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainActive.Height(), 110);
+    }
+
+    StopMinerThreads();
+    gArgs.ForceSetArg("-genproclimit", std::to_string(DEFAULT_GENERATE_THREADS));
+    gArgs.ForceSetArg("-acceptdividedcoinbase", "0");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
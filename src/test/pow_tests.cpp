@@ -4,9 +4,12 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <huntcoin/hardfork.h>
+#include <checkqueue.h>
 #include <pow.h>
 #include <random.h>
 #include <util.h>
+#include <validation.h>
 #include <test/test_huntcoin.h>
 
 #include <boost/test/unit_test.hpp>
@@ -83,4 +86,100 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+/* Check that each CPowCheck reports its own header's result */
+BOOST_AUTO_TEST_CASE(pow_check_queue)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    std::vector<CBlockHeader> headers(4, Params().GenesisBlock().GetBlockHeader());
+    headers[1].nNonce++;
+    headers[3].nBits = 0;
+
+    std::vector<char> vPowValid(headers.size(), 0);
+    std::vector<CPowCheck> vChecks;
+    for (size_t i = 0; i < headers.size(); i++)
+        vChecks.emplace_back(headers[i], params, &vPowValid[i]);
+
+    CCheckQueue<CPowCheck> queue(8);
+    {
+        CCheckQueueControl<CPowCheck> control(&queue);
+        control.Add(vChecks);
+        BOOST_CHECK(!control.Wait());
+    }
+    // Checks queued after a failure may be skipped, but never reported valid.
+    BOOST_CHECK(!vPowValid[1]);
+    BOOST_CHECK(!vPowValid[3]);
+
+    for (size_t i = 0; i < headers.size(); i++) {
+        CPowCheck check(headers[i], params, &vPowValid[i]);
+        BOOST_CHECK_EQUAL(check(), i == 0 || i == 2);
+        BOOST_CHECK_EQUAL(vPowValid[i], i == 0 || i == 2);
+    }
+
+    // A shared check holds up to MULTIHASH_LANES headers and reports each one.
+    static_assert(MULTIHASH_LANES == 4, "test fills exactly one shared check");
+    std::fill(vPowValid.begin(), vPowValid.end(), 0);
+    CPowCheck shared(headers[0], params, &vPowValid[0]);
+    for (size_t i = 1; i < headers.size(); i++)
+        BOOST_CHECK(shared.Add(headers[i], &vPowValid[i]));
+    BOOST_CHECK(!shared.Add(headers[0], &vPowValid[0]));
+    BOOST_CHECK(!shared());
+    for (size_t i = 0; i < headers.size(); i++)
+        BOOST_CHECK_EQUAL(vPowValid[i], i == 0 || i == 2);
+}
+
+/* Check that the algo tables agree with the per-algo fields they replaced */
+BOOST_AUTO_TEST_CASE(algo_table)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    BOOST_CHECK_EQUAL(params.vAlgoPowLimit.size(), (size_t)NUM_ALGOS);
+
+    for (uint8_t algo = 0; algo < NUM_ALGOS; algo++) {
+        CBlockHeader header;
+        header.SetNull();
+        header.nVersion = 4;
+        header.SetAlgo(algo);
+        BOOST_CHECK_EQUAL(header.GetAlgo(), algo);
+
+        uint8_t byName = NUM_ALGOS;
+        BOOST_CHECK(GetAlgoByName(GetAlgoName(algo), byName));
+        BOOST_CHECK_EQUAL(byName, algo);
+
+        Consensus::Params unconverted = params;
+        unconverted.vAlgoPowLimit.clear();
+        BOOST_CHECK(GetAlgoPowLimit(algo, params) == GetAlgoPowLimit(algo, unconverted));
+    }
+    BOOST_CHECK(GetAlgoPowLimit(ALGO_X16R, params) == UintToArith256(params.powLimit_X16R));
+    BOOST_CHECK(GetAlgoPowLimit(NUM_ALGOS, params) == UintToArith256(params.powLimit_SHA256));
+
+    uint8_t algo;
+    BOOST_CHECK(GetAlgoByName("lyra2rev2", algo) && algo == ALGO_LYRA2RE);
+    BOOST_CHECK(GetAlgoByName("equihash144.5", algo) && algo == ALGO_ZHASH);
+    BOOST_CHECK(!GetAlgoByName("unknown", algo));
+    BOOST_CHECK(IsEquihashAlgo(ALGO_EQUIHASH) && IsEquihashAlgo(ALGO_ZHASH) && !IsEquihashAlgo(ALGO_SHA256D));
+}
+
+/* Check that batched PoW hashes match the one-at-a-time path bit for bit */
+BOOST_AUTO_TEST_CASE(pow_hash_batch)
+{
+    // Sizes that are not a multiple of MULTIHASH_LANES leave lanes unused.
+    for (size_t n : {1, 3, 4, 9}) {
+        std::vector<CDefaultBlockHeader> headers(n);
+        for (CDefaultBlockHeader& header : headers) {
+            header.nVersion = InsecureRand32();
+            header.hashPrevBlock = InsecureRand256();
+            header.hashMerkleRoot = InsecureRand256();
+            header.nTime = InsecureRand32();
+            header.nBits = InsecureRand32();
+            header.nNonce = InsecureRand32();
+        }
+        for (uint8_t algo : {ALGO_SHA256D, ALGO_X11, ALGO_X13, ALGO_X14, ALGO_X15, ALGO_X17}) {
+            BOOST_CHECK_EQUAL(CDefaultBlockHeader::HasPoWHashBatch(algo), algo != ALGO_SHA256D);
+            std::vector<uint256> hashes(n);
+            CDefaultBlockHeader::GetPoWHashBatch(algo, headers.data(), hashes.data(), n);
+            for (size_t i = 0; i < n; i++)
+                BOOST_CHECK(hashes[i] == headers[i].GetPoWHash(algo));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chain.h>
+#include <chainparams.h>
+#include <huntcoin/hardfork.h>
 #include <util.h>
 #include <test/test_huntcoin.h>
 
@@ -177,4 +179,74 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_edge_test)
     BOOST_CHECK(!chain.FindEarliestAtLeast(int64_t(std::numeric_limits<unsigned int>::max()) + 1));
 }
 
+/** The plain pprev walk that CChain's per-algo index replaces. */
+static const CBlockIndex* WalkLastForAlgo(const CBlockIndex* pindex, uint8_t algo)
+{
+    for (; pindex; pindex = pindex->pprev) {
+        if (!IsHardForkActivated(pindex->nTime) && algo != ALGO_SHA256D)
+            return nullptr;
+        if (pindex->GetAlgo() == algo)
+            return pindex;
+    }
+    return nullptr;
+}
+
+static void BuildAlgoChain(std::vector<CBlockIndex>& vBlocks, CBlockIndex* pindexFork, uint32_t nHardforkTime)
+{
+    for (unsigned int i = 0; i < vBlocks.size(); i++) {
+        CBlockIndex* prev = (i == 0) ? pindexFork : &vBlocks[i - 1];
+        vBlocks[i].nHeight = prev ? prev->nHeight + 1 : 0;
+        vBlocks[i].pprev = prev;
+        // Pre-hardfork blocks first, with a few non-legacy versions among them, then
+        // a mix where the low algo ids are common and the high ones rare.
+        vBlocks[i].nTime = nHardforkTime - 500 + vBlocks[i].nHeight;
+        uint8_t algo = InsecureRandRange(2) ? InsecureRandRange(4) : InsecureRandRange(NUM_ALGOS);
+        vBlocks[i].nVersion = (vBlocks[i].nTime < nHardforkTime && InsecureRandRange(4)) ? 1 : (algo + 1) << 9;
+        vBlocks[i].BuildSkip();
+        vBlocks[i].BuildSameAlgo();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(findforalgo_test)
+{
+    const uint32_t nHardforkTime = Params().GetConsensus().HardforkTime;
+    std::vector<CBlockIndex> vBlocksMain(5000);
+    BuildAlgoChain(vBlocksMain, nullptr, nHardforkTime);
+    std::vector<CBlockIndex> vBlocksSide(300);
+    BuildAlgoChain(vBlocksSide, &vBlocksMain[4000], nHardforkTime);
+
+    CChain chain;
+    chain.SetTip(&vBlocksMain.back());
+
+    for (int n = 0; n < 2; n++) {
+        const std::vector<CBlockIndex>& vActive = n == 0 ? vBlocksMain : vBlocksSide;
+        for (const CBlockIndex& index : vActive) {
+            BOOST_CHECK(index.pprevSameAlgo == WalkLastForAlgo(index.pprev, index.GetAlgo()));
+        }
+        for (int i = 0; i < 2000; i++) {
+            const CBlockIndex* pindex = chain[InsecureRandRange(chain.Height() + 1)];
+            uint8_t algo = InsecureRandRange(NUM_ALGOS);
+            BOOST_CHECK(chain.FindLastForAlgo(pindex, algo) == WalkLastForAlgo(pindex, algo));
+
+            const CBlockIndex* pnext = pindex;
+            while (pnext && pnext->GetAlgo() != algo)
+                pnext = chain.Next(pnext);
+            BOOST_CHECK(chain.FindNextForAlgo(pindex, algo) == pnext);
+        }
+        for (uint8_t algo = 0; algo < NUM_ALGOS; algo++) {
+            BOOST_CHECK(chain.TipForAlgo(algo) == WalkLastForAlgo(chain.Tip(), algo));
+        }
+
+        // Reorganize to the side chain and check again.
+        chain.SetTip(&vBlocksSide.back());
+    }
+
+    // Blocks off the active chain only match themselves.
+    BOOST_CHECK(chain.FindNextForAlgo(&vBlocksMain.back(), vBlocksMain.back().GetAlgo()) == &vBlocksMain.back());
+    BOOST_CHECK(chain.FindNextForAlgo(&vBlocksMain.back(), (vBlocksMain.back().GetAlgo() + 1) % NUM_ALGOS) == nullptr);
+
+    chain.SetTip(nullptr);
+    BOOST_CHECK(chain.TipForAlgo(ALGO_SHA256D) == nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
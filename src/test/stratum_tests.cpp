@@ -0,0 +1,242 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <stratum.h>
+
+#include <base58.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <hash.h>
+#include <pow.h>
+#include <script/standard.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+
+#include <test/test_huntcoin.h>
+
+#include <univalue.h>
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(stratum_tests, TestChain100Setup)
+
+// A miner as the server sees it: sends requests, keeps whatever comes back
+// and solves jobs the way mining software does.
+class StratumClientStub
+{
+public:
+    CStratumServer& server;
+    int64_t id;
+    int nLastRequest;
+    std::vector<UniValue> vReceived;
+
+    explicit StratumClientStub(CStratumServer& serverIn) : server(serverIn), nLastRequest(0)
+    {
+        id = server.Connect([this](const std::string& line) {
+            BOOST_CHECK(!line.empty() && line.back() == '\n');
+            UniValue obj;
+            BOOST_CHECK(obj.read(line));
+            vReceived.push_back(obj);
+        });
+    }
+
+    ~StratumClientStub()
+    {
+        server.Disconnect(id);
+    }
+
+    UniValue Call(const std::string& strMethod, const UniValue& params)
+    {
+        UniValue request(UniValue::VOBJ);
+        request.pushKV("id", ++nLastRequest);
+        request.pushKV("method", strMethod);
+        request.pushKV("params", params);
+        BOOST_CHECK(server.ProcessLine(id, request.write()));
+        for (const UniValue& obj : vReceived) {
+            const UniValue& idReply = find_value(obj, "id");
+            if (idReply.isNum() && idReply.get_int() == nLastRequest)
+                return obj;
+        }
+        BOOST_ERROR("No reply to " + strMethod);
+        return NullUniValue;
+    }
+
+    // The params of the last notification of strMethod, null if there was none
+    UniValue LastNotification(const std::string& strMethod) const
+    {
+        for (auto it = vReceived.rbegin(); it != vReceived.rend(); ++it) {
+            const UniValue& method = find_value(*it, "method");
+            if (method.isStr() && method.get_str() == strMethod)
+                return find_value(*it, "params");
+        }
+        return NullUniValue;
+    }
+};
+
+static int ErrorCode(const UniValue& reply)
+{
+    const UniValue& error = find_value(reply, "error");
+    return error.isArray() ? error[0].get_int() : 0;
+}
+
+static UniValue StratumParams(const std::vector<std::string>& vParams)
+{
+    UniValue params(UniValue::VARR);
+    for (const std::string& strParam : vParams)
+        params.push_back(strParam);
+    return params;
+}
+
+// The header of a job, assembled from the notification as a miner does
+static CBlockHeader BuildHeader(const UniValue& job, const std::string& strExtraNonce1, const std::string& strExtraNonce2, uint32_t nNonce)
+{
+    const std::vector<unsigned char> vchCoinbase = ParseHex(job[2].get_str() + strExtraNonce1 + strExtraNonce2 + job[3].get_str());
+    uint256 hashMerkleRoot = Hash(vchCoinbase.begin(), vchCoinbase.end());
+    for (size_t i = 0; i < job[4].size(); i++) {
+        const uint256 hash(ParseHex(job[4][i].get_str()));
+        hashMerkleRoot = Hash(hashMerkleRoot.begin(), hashMerkleRoot.end(), hash.begin(), hash.end());
+    }
+    std::vector<unsigned char> vchPrev = ParseHex(job[1].get_str());
+    for (size_t i = 0; i < vchPrev.size(); i += 4)
+        std::reverse(vchPrev.begin() + i, vchPrev.begin() + i + 4);
+
+    CBlockHeader header;
+    header.nVersion = strtoul(job[5].get_str().c_str(), nullptr, 16);
+    header.hashPrevBlock = uint256(vchPrev);
+    header.hashMerkleRoot = hashMerkleRoot;
+    header.nBits = strtoul(job[6].get_str().c_str(), nullptr, 16);
+    header.nTime = strtoul(job[7].get_str().c_str(), nullptr, 16);
+    header.nNonce = nNonce;
+    return header;
+}
+
+// The first nonce whose header does (fBlock) or does not meet the target of the block
+static uint32_t Solve(const UniValue& job, const std::string& strExtraNonce1, const std::string& strExtraNonce2, bool fBlock)
+{
+    for (uint32_t nNonce = 0;; nNonce++) {
+        const CBlockHeader header = BuildHeader(job, strExtraNonce1, strExtraNonce2, nNonce);
+        if (CheckProofOfWork(header.GetPoWHash(), header.nBits, ::Params().GetConsensus(), ALGO_SHA256D) == fBlock)
+            return nNonce;
+    }
+}
+
+static UniValue SubmitParams(const UniValue& job, const std::string& strExtraNonce2, uint32_t nNonce)
+{
+    return StratumParams({"worker", job[0].get_str(), strExtraNonce2, job[7].get_str(), strprintf("%08x", nNonce)});
+}
+
+BOOST_AUTO_TEST_CASE(stratum_difficulty)
+{
+    const arith_uint256 targetDiff1("00000000ffff0000000000000000000000000000000000000000000000000000");
+    BOOST_CHECK(CStratumServer::DifficultyToTarget(1) == targetDiff1);
+    BOOST_CHECK(CStratumServer::DifficultyToTarget(16) == targetDiff1 >> 4);
+    BOOST_CHECK(CStratumServer::DifficultyToTarget(1.0 / 256) == targetDiff1 << 8);
+    BOOST_CHECK_EQUAL(CStratumServer::TargetToDifficulty(targetDiff1), 1.0);
+    BOOST_CHECK_EQUAL(CStratumServer::TargetToDifficulty(targetDiff1 >> 4), 16.0);
+    // Targets beyond 256 bits saturate
+    BOOST_CHECK(CStratumServer::DifficultyToTarget(1e-30) == ~arith_uint256());
+    BOOST_CHECK(CStratumServer::DifficultyToTarget(0) == ~arith_uint256());
+}
+
+BOOST_AUTO_TEST_CASE(stratum_protocol_errors)
+{
+    const std::string strAddress = EncodeDestination(coinbaseKey.GetPubKey().GetID());
+    CStratumServer server;
+    StratumClientStub client(server);
+
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.authorize", StratumParams({strAddress, "x"}))), 25);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.submit", StratumParams({"worker", "1", "00000000", "00000000", "00000000"}))), 24);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.nosuchmethod", StratumParams({}))), 20);
+
+    const UniValue result = find_value(client.Call("mining.subscribe", StratumParams({"stub/1.0"})), "result");
+    BOOST_CHECK_EQUAL(result[1].get_str().size(), 8U);
+    BOOST_CHECK_EQUAL(result[2].get_int(), STRATUM_EXTRANONCE2_SIZE);
+
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.authorize", StratumParams({"notanaddress", "x"}))), 24);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.authorize", StratumParams({strAddress, "algo=nosuchalgo"}))), 20);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.authorize", StratumParams({strAddress, "algo=equihash"}))), 20);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.authorize", StratumParams({strAddress, "algo=sha256d,d=-1"}))), 20);
+    BOOST_CHECK(client.LastNotification("mining.notify").isNull());
+
+    // Garbage asks for the session to be closed, as does an unknown session
+    BOOST_CHECK(!server.ProcessLine(client.id, "{\"id\": 1, \"method\""));
+    BOOST_CHECK(!server.ProcessLine(client.id + 1, "{}"));
+}
+
+BOOST_AUTO_TEST_CASE(stratum_mine_block)
+{
+    const CTxDestination dest = coinbaseKey.GetPubKey().GetID();
+    CStratumServer server;
+    StratumClientStub client(server);
+
+    const UniValue result = find_value(client.Call("mining.subscribe", StratumParams({})), "result");
+    const std::string strExtraNonce1 = result[1].get_str();
+    BOOST_CHECK(find_value(client.Call("mining.authorize", StratumParams({EncodeDestination(dest) + ".rig1", "algo=sha256d,d=0.001"})), "result").get_bool());
+
+    // Authorizing hands out a first job; the share target never is harder than the block
+    const UniValue job = client.LastNotification("mining.notify");
+    BOOST_REQUIRE(job.isArray() && job.size() == 9);
+    BOOST_CHECK(job[8].get_bool());
+    BOOST_REQUIRE(client.LastNotification("mining.set_difficulty").isArray());
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(BuildHeader(job, strExtraNonce1, "00000000", 0).hashPrevBlock == chainActive.Tip()->GetBlockHash());
+    }
+
+    uint32_t nNonce = Solve(job, strExtraNonce1, "00000000", false);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.submit", SubmitParams(job, "00000000", nNonce))), 23);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.submit", SubmitParams(job, "0000", nNonce))), 20);
+
+    nNonce = Solve(job, strExtraNonce1, "00000001", true);
+    BOOST_CHECK(find_value(client.Call("mining.submit", SubmitParams(job, "00000001", nNonce)), "result").get_bool());
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(chainActive.Height(), 101);
+        BOOST_CHECK(chainActive.Tip()->GetBlockHash() == BuildHeader(job, strExtraNonce1, "00000001", nNonce).GetHash());
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, chainActive.Tip(), ::Params().GetConsensus()));
+        BOOST_CHECK(block.vtx[0]->vout[0].scriptPubKey == GetScriptForDestination(dest));
+    }
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.submit", SubmitParams(job, "00000001", nNonce))), 22);
+
+    // The new tip replaces the jobs of the session
+    server.UpdateJobs();
+    const UniValue jobNext = client.LastNotification("mining.notify");
+    BOOST_CHECK(jobNext[0].get_str() != job[0].get_str());
+    BOOST_CHECK(jobNext[8].get_bool());
+    nNonce = Solve(job, strExtraNonce1, "00000002", true);
+    BOOST_CHECK_EQUAL(ErrorCode(client.Call("mining.submit", SubmitParams(job, "00000002", nNonce))), 21);
+}
+
+BOOST_AUTO_TEST_CASE(stratum_algo_templates)
+{
+    const std::string strAddress = EncodeDestination(coinbaseKey.GetPubKey().GetID());
+    CStratumServer server;
+    StratumClientStub clientSha(server), clientScrypt(server);
+    clientSha.Call("mining.subscribe", StratumParams({}));
+    clientScrypt.Call("mining.subscribe", StratumParams({}));
+    BOOST_CHECK(find_value(clientSha.Call("mining.authorize", StratumParams({strAddress, "algo=sha256d"})), "result").get_bool());
+    BOOST_CHECK(find_value(clientScrypt.Call("mining.authorize", StratumParams({strAddress, "algo=scrypt"})), "result").get_bool());
+
+    // Both algos mine the same transactions and coinbase, only the header differs
+    const UniValue jobSha = clientSha.LastNotification("mining.notify");
+    const UniValue jobScrypt = clientScrypt.LastNotification("mining.notify");
+    BOOST_REQUIRE(jobSha.isArray() && jobScrypt.isArray());
+    BOOST_CHECK_EQUAL(jobSha[1].get_str(), jobScrypt[1].get_str());
+    BOOST_CHECK_EQUAL(jobSha[2].get_str(), jobScrypt[2].get_str());
+    BOOST_CHECK_EQUAL(jobSha[3].get_str(), jobScrypt[3].get_str());
+    BOOST_CHECK_EQUAL(jobSha[4].write(), jobScrypt[4].write());
+    const CBlockHeader headerSha = BuildHeader(jobSha, "00000000", "00000000", 0);
+    const CBlockHeader headerScrypt = BuildHeader(jobScrypt, "00000000", "00000000", 0);
+    BOOST_CHECK_EQUAL(headerSha.GetAlgo(), ALGO_SHA256D);
+    BOOST_CHECK_EQUAL(headerScrypt.GetAlgo(), ALGO_SCRYPT);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(headerScrypt.nBits, GetNextWorkRequired(chainActive.Tip(), &headerScrypt, ::Params().GetConsensus(), ALGO_SCRYPT));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
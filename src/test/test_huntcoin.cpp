@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
 #include <crypto/sha256.h>
 #include <validation.h>
 #include <miner.h>
@@ -43,6 +44,7 @@ extern void noui_connect();
 BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
 {
         SHA256AutoDetect();
+        MultihashAutoDetect();
         RandomInit();
         ECC_Start();
         SetupEnvironment();
@@ -0,0 +1,174 @@
+// Copyright (c) 2019 The Huntcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txdb.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <huntcoin/hardfork.h>
+#include <pow.h>
+
+#include <test/test_huntcoin.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+struct TxdbTestingSetup : public BasicTestingSetup {
+    TxdbTestingSetup() : BasicTestingSetup(CBaseChainParams::REGTEST) {}
+    ~TxdbTestingSetup() { nPowLoadCheck = POW_LOAD_CHECK_SAMPLE; }
+};
+
+BOOST_FIXTURE_TEST_SUITE(txdb_tests, TxdbTestingSetup)
+
+// A block index as LoadBlockIndex keeps it
+class TestBlockIndex
+{
+public:
+    std::map<uint256, CBlockIndex> mapIndex;
+    std::set<const CBlockIndex*> setDirty;
+
+    CBlockIndex* Insert(const uint256& hash)
+    {
+        if (hash.IsNull())
+            return nullptr;
+        auto it = mapIndex.emplace(hash, CBlockIndex()).first;
+        it->second.phashBlock = &it->first;
+        return &it->second;
+    }
+
+    bool Load(CBlockTreeDB& db)
+    {
+        return db.LoadBlockIndexGuts(Params().GetConsensus(),
+                                     [this](const uint256& hash) { return Insert(hash); },
+                                     [this](CBlockIndex* pindex) { setDirty.insert(pindex); });
+    }
+
+    // Append a header whose proof of work is (fValid) or is not valid, with nStatus
+    CBlockIndex* Add(bool fValid, uint32_t nStatus)
+    {
+        CBlockIndex* pindexPrev = vChain.empty() ? nullptr : vChain.back();
+        CBlockHeader header;
+        header.nVersion = 1;
+        header.hashPrevBlock = pindexPrev ? pindexPrev->GetBlockHash() : uint256();
+        header.nTime = Params().GenesisBlock().nTime + vChain.size() + 1;
+        header.nBits = GetAlgoPowLimit(ALGO_SHA256D, Params().GetConsensus()).GetCompact();
+        while (CheckProofOfWork(header, Params().GetConsensus()) != fValid)
+            header.nNonce++;
+
+        CBlockIndex* pindex = Insert(header.GetHash());
+        *pindex = CBlockIndex(header);
+        pindex->phashBlock = &mapIndex.find(header.GetHash())->first;
+        pindex->pprev = pindexPrev;
+        pindex->nHeight = pindexPrev ? pindexPrev->nHeight + 1 : 0;
+        pindex->nStatus = BLOCK_VALID_TREE | nStatus;
+        vChain.push_back(pindex);
+        return pindex;
+    }
+
+    bool Write(CBlockTreeDB& db, const CBlockIndex* pindexCheckpoint)
+    {
+        std::vector<const CBlockIndex*> vIndex(vChain.begin(), vChain.end());
+        return db.WriteBatchSync({}, 0, vIndex, pindexCheckpoint);
+    }
+
+private:
+    std::vector<CBlockIndex*> vChain;
+};
+
+// A DB with nTrusted flagged entries of invalid proof of work below a valid
+// checkpoint, followed by nAbove flagged entries
+static void WriteTrustedIndex(CBlockTreeDB& db, int nTrusted, bool fValidAbove, int nAbove = 1)
+{
+    TestBlockIndex index;
+    for (int i = 0; i < nTrusted; i++)
+        index.Add(false, BLOCK_POW_VERIFIED);
+    const CBlockIndex* pindexCheckpoint = index.Add(true, BLOCK_POW_VERIFIED);
+    for (int i = 0; i < nAbove; i++)
+        index.Add(fValidAbove, BLOCK_POW_VERIFIED);
+    BOOST_REQUIRE(index.Write(db, pindexCheckpoint));
+}
+
+BOOST_AUTO_TEST_CASE(checkpowonload_parse)
+{
+    PowLoadCheck mode;
+    BOOST_CHECK(ParsePowLoadCheck("none", mode) && mode == POW_LOAD_CHECK_NONE);
+    BOOST_CHECK(ParsePowLoadCheck("sample", mode) && mode == POW_LOAD_CHECK_SAMPLE);
+    BOOST_CHECK(ParsePowLoadCheck("all", mode) && mode == POW_LOAD_CHECK_ALL);
+    BOOST_CHECK(ParsePowLoadCheck(DEFAULT_CHECKPOWONLOAD, mode) && mode == POW_LOAD_CHECK_SAMPLE);
+    BOOST_CHECK(!ParsePowLoadCheck("some", mode));
+}
+
+BOOST_AUTO_TEST_CASE(pow_checkpoint_roundtrip)
+{
+    CBlockTreeDB db(1 << 20, true);
+    int nHeight;
+    uint256 hash;
+    BOOST_CHECK(!db.ReadPowCheckpoint(nHeight, hash));
+
+    // A checkpoint on an entry that isn't flagged is not written
+    TestBlockIndex index;
+    const CBlockIndex* pindexUnverified = index.Add(true, 0);
+    BOOST_CHECK(index.Write(db, pindexUnverified));
+    BOOST_CHECK(!db.ReadPowCheckpoint(nHeight, hash));
+
+    const CBlockIndex* pindexVerified = index.Add(true, BLOCK_POW_VERIFIED);
+    BOOST_CHECK(index.Write(db, pindexVerified));
+    BOOST_CHECK(db.ReadPowCheckpoint(nHeight, hash));
+    BOOST_CHECK_EQUAL(nHeight, 1);
+    BOOST_CHECK(hash == pindexVerified->GetBlockHash());
+
+    // The flag survives the DB, and checked entries that lacked it get it and
+    // are written again
+    nPowLoadCheck = POW_LOAD_CHECK_ALL;
+    TestBlockIndex loaded;
+    BOOST_REQUIRE(loaded.Load(db));
+    BOOST_REQUIRE_EQUAL(loaded.mapIndex.size(), 2U);
+    const CBlockIndex& indexUnverified = loaded.mapIndex.at(pindexUnverified->GetBlockHash());
+    const CBlockIndex& indexVerified = loaded.mapIndex.at(pindexVerified->GetBlockHash());
+    BOOST_CHECK(indexUnverified.nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK(indexVerified.nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK_EQUAL(indexVerified.nHeight, 1);
+    BOOST_CHECK(indexVerified.pprev == &indexUnverified);
+    BOOST_CHECK_EQUAL(loaded.setDirty.size(), 1U);
+    BOOST_CHECK(loaded.setDirty.count(&indexUnverified));
+}
+
+BOOST_AUTO_TEST_CASE(checkpowonload_modes)
+{
+    // The trusted entries have invalid proof of work, so a load fails exactly
+    // when one of them is checked again
+    CBlockTreeDB db(1 << 20, true);
+    WriteTrustedIndex(db, 2000, true);
+
+    nPowLoadCheck = POW_LOAD_CHECK_NONE;
+    BOOST_CHECK(TestBlockIndex().Load(db));
+    nPowLoadCheck = POW_LOAD_CHECK_ALL;
+    BOOST_CHECK(!TestBlockIndex().Load(db));
+    // One in POW_LOAD_SAMPLE_RATE is checked, missing all of 2000 is as good as impossible
+    nPowLoadCheck = POW_LOAD_CHECK_SAMPLE;
+    BOOST_CHECK(!TestBlockIndex().Load(db));
+
+    // Flagged entries above the checkpoint are always checked
+    CBlockTreeDB dbAbove(1 << 20, true);
+    WriteTrustedIndex(dbAbove, 1, false);
+    nPowLoadCheck = POW_LOAD_CHECK_NONE;
+    BOOST_CHECK(!TestBlockIndex().Load(dbAbove));
+
+    // A checkpoint that is not in the index vouches for nothing
+    CBlockTreeDB dbMissing(1 << 20, true);
+    WriteTrustedIndex(dbMissing, 1, true);
+    {
+        TestBlockIndex other;
+        other.Add(true, BLOCK_POW_VERIFIED);
+        const CBlockIndex* pindexOther = other.Add(true, BLOCK_POW_VERIFIED);
+        std::vector<const CBlockIndex*> vNone;
+        BOOST_REQUIRE(dbMissing.WriteBatchSync({}, 0, vNone, pindexOther));
+    }
+    BOOST_CHECK(!TestBlockIndex().Load(dbMissing));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 #include <chainparams.h>
 #include <huntcoin/hardfork.h>
 #include <hash.h>
+#include <memusage.h>
 #include <random.h>
 #include <pow.h>
 #include <uint256.h>
@@ -30,6 +31,22 @@ static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_POW_CHECKPOINT = 'P';
+
+PowLoadCheck nPowLoadCheck = POW_LOAD_CHECK_SAMPLE;
+
+bool ParsePowLoadCheck(const std::string& strMode, PowLoadCheck& mode)
+{
+    if (strMode == "none")
+        mode = POW_LOAD_CHECK_NONE;
+    else if (strMode == "sample")
+        mode = POW_LOAD_CHECK_SAMPLE;
+    else if (strMode == "all")
+        mode = POW_LOAD_CHECK_ALL;
+    else
+        return false;
+    return true;
+}
 
 namespace {
 
@@ -225,16 +242,85 @@ void CCoinsViewDBCursor::Next()
     }
 }
 
-bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
+bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo, const CBlockIndex* pindexPowCheckpoint) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_FILES, it->first), *it->second);
     }
     batch.Write(DB_LAST_BLOCK, nLastFile);
+    std::vector<uint256> vWrittenSolutions;
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
-        batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
+        CDiskBlockIndex diskindex(*it);
+        if ((*it)->HasSolution()) {
+            CBlockSolution solution;
+            if (!ReadBlockSolution((*it)->GetBlockHash(), solution))
+                return error("%s: no %s solution for %s", __func__, GetAlgoName((*it)->GetAlgo()), (*it)->GetBlockHash().ToString());
+            diskindex.SetSolution(solution);
+            vWrittenSolutions.push_back((*it)->GetBlockHash());
+        }
+        batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), diskindex);
+    }
+    // Written in the same batch as the index entries, so the checkpoint never
+    // refers to an entry whose BLOCK_POW_VERIFIED flag did not reach the disk.
+    if (pindexPowCheckpoint && (pindexPowCheckpoint->nStatus & BLOCK_POW_VERIFIED))
+        batch.Write(DB_POW_CHECKPOINT, std::make_pair(pindexPowCheckpoint->nHeight, pindexPowCheckpoint->GetBlockHash()));
+    if (!WriteBatch(batch, true))
+        return false;
+
+    // The solutions are on disk now, drop the in-memory copies.
+    LOCK(cs_solutions);
+    for (const uint256& hash : vWrittenSolutions) {
+        std::map<uint256, CBlockSolution>::iterator mi = mapPendingSolutions.find(hash);
+        if (mi == mapPendingSolutions.end())
+            continue;
+        size_t nUsage = memusage::DynamicUsage(mi->second.nSolution);
+        nPendingSolutionUsage -= nUsage;
+        nStoredSolutionUsage += nUsage;
+        nStoredSolutions++;
+        mapPendingSolutions.erase(mi);
+    }
+    return true;
+}
+
+void CBlockTreeDB::AddBlockSolution(const uint256& hash, const CBlockSolution& solution) {
+    LOCK(cs_solutions);
+    if (mapPendingSolutions.emplace(hash, solution).second)
+        nPendingSolutionUsage += memusage::DynamicUsage(solution.nSolution);
+}
+
+bool CBlockTreeDB::ReadBlockSolution(const uint256& hash, CBlockSolution& solution) {
+    {
+        LOCK(cs_solutions);
+        std::map<uint256, CBlockSolution>::const_iterator mi = mapPendingSolutions.find(hash);
+        if (mi != mapPendingSolutions.end()) {
+            solution = mi->second;
+            return true;
+        }
     }
-    return WriteBatch(batch, true);
+    CDiskBlockIndex diskindex;
+    if (!Read(std::make_pair(DB_BLOCK_INDEX, hash), diskindex) || !diskindex.HasSolution())
+        return false;
+    solution = diskindex.GetSolution();
+    return true;
+}
+
+CBlockTreeDB::SolutionStats CBlockTreeDB::GetSolutionStats() {
+    LOCK(cs_solutions);
+    SolutionStats stats;
+    stats.stored = nStoredSolutions;
+    stats.storedbytes = nStoredSolutionUsage;
+    stats.pending = mapPendingSolutions.size();
+    stats.pendingbytes = nPendingSolutionUsage;
+    return stats;
+}
+
+bool CBlockTreeDB::ReadPowCheckpoint(int &nHeight, uint256 &hash) {
+    std::pair<int, uint256> checkpoint;
+    if (!Read(DB_POW_CHECKPOINT, checkpoint))
+        return false;
+    nHeight = checkpoint.first;
+    hash = checkpoint.second;
+    return true;
 }
 
 bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
@@ -260,10 +346,34 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+static bool CheckIndexProofOfWork(const CBlockIndex* pindex, const CBlockHeader& header, const Consensus::Params& consensusParams)
+{
+    bool equihashvalidator;
+    bool checkresult = CheckProofOfWork(header, consensusParams, equihashvalidator);
+
+    if ((pindex->GetAlgo() == ALGO_EQUIHASH || pindex->GetAlgo() == ALGO_ZHASH) && !equihashvalidator) {
+        return error("%s: %s solution invalid at: %s", __func__, GetAlgoName(pindex->GetAlgo()), pindex->ToString());
+    }
+
+    if (!checkresult)
+        return error("%s: CheckProofOfWork failed: %s", __func__, pindex->ToString());
+
+    return true;
+}
+
+bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, std::function<void(CBlockIndex*)> markDirty)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
+    // Entries flagged BLOCK_POW_VERIFIED at or below the checkpoint were checked
+    // when they were accepted and need not be hashed again.
+    int nCheckpointHeight = -1;
+    uint256 hashCheckpoint;
+    bool fHaveCheckpoint = ReadPowCheckpoint(nCheckpointHeight, hashCheckpoint);
+    bool fCheckpointFound = false;
+    std::vector<const CBlockIndex*> vSkipped;
+    FastRandomContext rng;
+
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
     // Load mapBlockIndex
@@ -282,15 +392,22 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nUndoPos       = diskindex.nUndoPos;
                 pindexNew->nVersion       = diskindex.nVersion;
                 pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->hashReserved   = diskindex.hashReserved;
                 pindexNew->nTime          = diskindex.nTime;
                 pindexNew->nBits          = diskindex.nBits;
                 pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nBigNonce      = diskindex.nBigNonce;
-                pindexNew->nSolution      = diskindex.nSolution;
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
-                
+
+                // The Equihash fields stay in the DB, GetBlockHeader() reads them back.
+                if (diskindex.HasSolution()) {
+                    LOCK(cs_solutions);
+                    nStoredSolutions++;
+                    nStoredSolutionUsage += memusage::DynamicUsage(diskindex.nSolution);
+                }
+
+                if (fHaveCheckpoint && pindexNew->nHeight == nCheckpointHeight && pindexNew->GetBlockHash() == hashCheckpoint)
+                    fCheckpointFound = true;
+
                 CPureBlockVersion versionverify = pindexNew->nVersion;
 
                 // We may not have enough data, to validate auxpow, if the block header was saved, but not the full block.
@@ -302,16 +419,23 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                     pcursor->Next();
                     continue;
                 }
-				
-                bool equihashvalidator;
-                bool checkresult = CheckProofOfWork(pindexNew->GetBlockHeader(consensusParams), consensusParams, equihashvalidator);
-                
-                if ((pindexNew->GetAlgo() == ALGO_EQUIHASH || pindexNew->GetAlgo() == ALGO_ZHASH) && !equihashvalidator) {
-                    return error("%s: %s solution invalid at: %s", __func__, GetAlgoName(pindexNew->GetAlgo()), pindexNew->ToString());
+
+                bool fVerified = fHaveCheckpoint && (pindexNew->nStatus & BLOCK_POW_VERIFIED) && pindexNew->nHeight <= nCheckpointHeight;
+                if (fVerified && (nPowLoadCheck == POW_LOAD_CHECK_NONE ||
+                                  (nPowLoadCheck == POW_LOAD_CHECK_SAMPLE && rng.randrange(POW_LOAD_SAMPLE_RATE) != 0))) {
+                    vSkipped.push_back(pindexNew);
+                    pcursor->Next();
+                    continue;
                 }
 
-                if (!checkresult)
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                // Only auxpow headers need a read from the block files, the rest is in diskindex.
+                if (!CheckIndexProofOfWork(pindexNew, versionverify.IsAuxpow() ? pindexNew->GetBlockHeader(consensusParams) : diskindex.GetHeader(), consensusParams))
+                    return false;
+
+                if (!(pindexNew->nStatus & BLOCK_POW_VERIFIED)) {
+                    pindexNew->nStatus |= BLOCK_POW_VERIFIED;
+                    markDirty(pindexNew);
+                }
 
                 pcursor->Next();
             } else {
@@ -322,6 +446,19 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         }
     }
 
+    // The checkpoint vouches for the flagged entries only if it is part of the
+    // index we just loaded. Otherwise fall back to checking everything.
+    if (!vSkipped.empty() && !fCheckpointFound) {
+        LogPrintf("%s: proof of work checkpoint %s at height %d not found, verifying %u skipped headers\n", __func__, hashCheckpoint.ToString(), nCheckpointHeight, vSkipped.size());
+        for (const CBlockIndex* pindex : vSkipped) {
+            boost::this_thread::interruption_point();
+            if (!CheckIndexProofOfWork(pindex, pindex->GetBlockHeader(consensusParams), consensusParams))
+                return false;
+        }
+    } else if (!vSkipped.empty()) {
+        LogPrintf("%s: skipped proof of work check for %u headers verified up to %s (height %d)\n", __func__, vSkipped.size(), hashCheckpoint.ToString(), nCheckpointHeight);
+    }
+
     return true;
 }
 
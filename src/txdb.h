@@ -9,6 +9,7 @@
 #include <coins.h>
 #include <dbwrapper.h>
 #include <chain.h>
+#include <sync.h>
 
 #include <map>
 #include <string>
@@ -37,6 +38,25 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -checkpowonload default
+static const char* const DEFAULT_CHECKPOWONLOAD = "sample";
+//! In -checkpowonload=sample mode, re-verify one out of this many already verified headers
+static const unsigned int POW_LOAD_SAMPLE_RATE = 64;
+
+//! Flush the block index once the Equihash solutions waiting to be written use this much memory
+static const size_t MAX_PENDING_SOLUTION_USAGE = 32 << 20;
+
+/** How much of the stored block index gets its proof of work re-checked at startup */
+enum PowLoadCheck {
+    POW_LOAD_CHECK_NONE,   //!< trust entries flagged BLOCK_POW_VERIFIED below the checkpoint
+    POW_LOAD_CHECK_SAMPLE, //!< like NONE, but re-verify a random sample of them
+    POW_LOAD_CHECK_ALL,    //!< re-verify every stored header
+};
+
+extern PowLoadCheck nPowLoadCheck;
+
+/** Parse a -checkpowonload value. Returns false if the mode is unknown. */
+bool ParsePowLoadCheck(const std::string& strMode, PowLoadCheck& mode);
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -114,7 +134,7 @@ public:
     CBlockTreeDB(const CBlockTreeDB&) = delete;
     CBlockTreeDB& operator=(const CBlockTreeDB&) = delete;
 
-    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
+    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo, const CBlockIndex* pindexPowCheckpoint = nullptr);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &info);
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindexing);
@@ -123,7 +143,30 @@ public:
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    bool ReadPowCheckpoint(int &nHeight, uint256 &hash);
+    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, std::function<void(CBlockIndex*)> markDirty);
+
+    /** Keep the Equihash fields of a new index entry until WriteBatchSync() stores it. */
+    void AddBlockSolution(const uint256& hash, const CBlockSolution& solution);
+    /** Look up the Equihash fields of an index entry, from memory if not written yet. */
+    bool ReadBlockSolution(const uint256& hash, CBlockSolution& solution);
+
+    /** Memory kept out of the in-memory block index by storing the Equihash fields in the DB */
+    struct SolutionStats
+    {
+        size_t stored;        //!< entries with their solution in the DB
+        size_t storedbytes;   //!< dynamic memory those solutions would use in CBlockIndex
+        size_t pending;       //!< entries waiting for the next WriteBatchSync()
+        size_t pendingbytes;  //!< dynamic memory used by the pending entries
+    };
+    SolutionStats GetSolutionStats();
+
+private:
+    CCriticalSection cs_solutions;
+    std::map<uint256, CBlockSolution> mapPendingSolutions;
+    size_t nPendingSolutionUsage = 0;
+    size_t nStoredSolutions = 0;
+    size_t nStoredSolutionUsage = 0;
 };
 
 #endif // HUNTCOIN_TXDB_H
@@ -162,7 +162,7 @@ public:
 
     bool ActivateBestChain(CValidationState &state, const CChainParams& chainparams, std::shared_ptr<const CBlock> pblock);
 
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fPowChecked = false);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock);
 
     // Block (dis)connection on a given view:
@@ -216,6 +216,7 @@ CBlockIndex *pindexBestHeader = nullptr;
 CWaitableCriticalSection csBestBlock;
 CConditionVariable cvBlockChange;
 int nScriptCheckThreads = 0;
+int nPowCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fTxIndex = false;
@@ -1407,6 +1408,33 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
 }
 
+bool CPowCheck::Add(const CBlockHeader& headerIn, char* pfValidIn) {
+    if (nHeaders == MULTIHASH_LANES)
+        return false;
+    pheaders[nHeaders] = &headerIn;
+    pfValid[nHeaders] = pfValidIn;
+    nHeaders++;
+    return true;
+}
+
+bool CPowCheck::operator()() {
+    uint256 hashes[MULTIHASH_LANES];
+    if (nHeaders > 1) {
+        CDefaultBlockHeader headers[MULTIHASH_LANES];
+        for (size_t i = 0; i < nHeaders; i++)
+            headers[i] = pheaders[i]->GetDefaultBlockHeader();
+        CDefaultBlockHeader::GetPoWHashBatch(pheaders[0]->GetAlgo(), headers, hashes, nHeaders);
+    }
+
+    bool fAllValid = true;
+    for (size_t i = 0; i < nHeaders; i++) {
+        bool ehsolutionvalid;
+        *pfValid[i] = CheckProofOfWork(*pheaders[i], *pparams, ehsolutionvalid, nHeaders > 1 ? &hashes[i] : nullptr);
+        fAllValid = fAllValid && *pfValid[i];
+    }
+    return fAllValid;
+}
+
 int GetSpendHeight(const CCoinsViewCache& inputs)
 {
     LOCK(cs_main);
@@ -1768,6 +1796,13 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CPowCheck> powcheckqueue(8);
+
+void ThreadPowCheck() {
+    RenameThread("huntcoin-powchk");
+    powcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -1886,6 +1921,41 @@ static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 static int64_t nBlocksTotal = 0;
 
+/** Check the treasury and masternode payments and the amount of the coinbase of a block paying blockReward at nHeight */
+static bool CheckCoinbasePayments(const CBlock& block, CValidationState& state, int nHeight, CAmount blockReward)
+{
+    if(IsHardForkActivated(block.nTime))
+    {
+        // Coinbase transaction must include the Treasury amount to the given Reward address, if Hardfork is activated.
+        bool found = false;
+
+        for(const CTxOut& output : block.vtx[0]->vout) {
+            if (output.scriptPubKey == Params().GetFoundersRewardScriptAtHeight(nHeight)) {
+                if (output.nValue == Params().GetTreasuryAmount(blockReward)) {
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if (!found) {
+            return state.DoS(100, error("ConnectBlock(): couldn't find treasury payment"), REJECT_INVALID, "bad-cb-treasury");
+        }
+        
+        if (!IsBlockPayeeValid(*block.vtx[0], nHeight, blockReward)) {
+            return state.DoS(0, error("ConnectBlock(): couldn't find masternode payment"),
+                                    REJECT_INVALID, "bad-cb-payee");
+        }
+    }
+
+    if (block.vtx[0]->GetValueOut() > blockReward)
+        return state.DoS(100,
+                         error("ConnectBlock(): coinbase pays too much (actual=%d vs limit=%d)",
+                               block.vtx[0]->GetValueOut(), blockReward),
+                               REJECT_INVALID, "bad-cb-amount");
+    return true;
+}
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
@@ -2090,38 +2160,13 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // TODO: resync data (both ways?) and try to reprocess this block later.
     CAmount blockReward = nFees + GetBlockSubsidy(pindex->nHeight, chainparams.GetConsensus());
 
-    if(IsHardForkActivated(block.nTime))
-    {
-        // Coinbase transaction must include the Treasury amount to the given Reward address, if Hardfork is activated.
-        bool found = false;
-
-        for(const CTxOut& output : block.vtx[0]->vout) {
-            if (output.scriptPubKey == Params().GetFoundersRewardScriptAtHeight(pindex->nHeight)) {
-                if (output.nValue == Params().GetTreasuryAmount(blockReward)) {
-                    found = true;
-                    break;
-                }
-            }
-        }
-
-        if (!found) {
-            return state.DoS(100, error("ConnectBlock(): couldn't find treasury payment"), REJECT_INVALID, "bad-cb-treasury");
-        }
-        
-        if (!IsBlockPayeeValid(*block.vtx[0], pindex->nHeight, blockReward)) {
+    if (!CheckCoinbasePayments(block, state, pindex->nHeight, blockReward)) {
+        if (state.GetRejectReason() == "bad-cb-payee")
             mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
-            return state.DoS(0, error("ConnectBlock(): couldn't find masternode payment"),
-                                    REJECT_INVALID, "bad-cb-payee");
-        }
+        return false;
     }
     // END HUNTCOIN
 
-    if (block.vtx[0]->GetValueOut() > blockReward)
-        return state.DoS(100,
-                         error("ConnectBlock(): coinbase pays too much (actual=%d vs limit=%d)",
-                               block.vtx[0]->GetValueOut(), blockReward),
-                               REJECT_INVALID, "bad-cb-amount");
-
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
@@ -2212,8 +2257,10 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
         bool fPeriodicFlush = mode == FLUSH_STATE_PERIODIC && nNow > nLastFlush + (int64_t)DATABASE_FLUSH_INTERVAL * 1000000;
         // Combine all conditions that result in a full cache flush.
         fDoFullFlush = (mode == FLUSH_STATE_ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
+        // The Equihash solutions of new headers are held in memory until the block index is written.
+        bool fSolutionsLarge = mode != FLUSH_STATE_NONE && pblocktree->GetSolutionStats().pendingbytes > MAX_PENDING_SOLUTION_USAGE;
         // Write blocks and block index to disk.
-        if (fDoFullFlush || fPeriodicWrite) {
+        if (fDoFullFlush || fPeriodicWrite || fSolutionsLarge) {
             // Depend on nMinDiskSpace to ensure we can write block index
             if (!CheckDiskSpace(0))
                 return state.Error("out of disk space");
@@ -2233,7 +2280,7 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
                     vBlocks.push_back(*it);
                     setDirtyBlockIndex.erase(it++);
                 }
-                if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
+                if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks, pindexBestHeader)) {
                     return AbortNode(state, "Failed to write to block index database");
                 }
             }
@@ -3001,6 +3048,14 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
 
     // Construct new block index object
     CBlockIndex* pindexNew = new CBlockIndex(block);
+    // The index entry does not keep the Equihash fields, hand them to the block tree DB.
+    if (pindexNew->HasSolution() && pblocktree) {
+        CBlockSolution solution;
+        solution.hashReserved = block.hashReserved;
+        solution.nBigNonce    = block.nBigNonce;
+        solution.nSolution    = block.nSolution;
+        pblocktree->AddBlockSolution(hash, solution);
+    }
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -3013,6 +3068,7 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
         pindexNew->pprev = (*miPrev).second;
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
         pindexNew->BuildSkip();
+        pindexNew->BuildSameAlgo();
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
@@ -3478,7 +3534,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fPowChecked)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3497,7 +3553,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), !fPowChecked))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3526,8 +3582,12 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             }
         }
     }
-    if (pindex == nullptr)
+    if (pindex == nullptr) {
         pindex = AddToBlockIndex(block);
+        // CheckBlockHeader passed above (the genesis block is hardcoded), so
+        // LoadBlockIndexGuts does not need to redo the proof of work check.
+        pindex->nStatus |= BLOCK_POW_VERIFIED;
+    }
 
     if (ppindex)
         *ppindex = pindex;
@@ -3540,15 +3600,60 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
     return true;
 }
 
+/**
+ * Check the proof of work of a headers batch on the PoW verification threads,
+ * without holding cs_main. Headers already in the index are skipped.
+ * Returns one flag per header, set if its proof of work is known to be valid.
+ * Headers that were not checked (or failed) are left to AcceptBlockHeader.
+ */
+static std::vector<char> CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+{
+    std::vector<char> vPowValid(headers.size(), 0);
+    if (nPowCheckThreads == 0 || headers.size() < 2)
+        return vPowValid;
+
+    std::vector<uint256> vHashes;
+    vHashes.reserve(headers.size());
+    for (const CBlockHeader& header : headers)
+        vHashes.push_back(header.GetHash());
+
+    // Headers of an algo with multi-lane kernels are grouped per algo into
+    // shared checks, so their PoW hashes are computed side by side.
+    std::vector<CPowCheck> vChecks;
+    vChecks.reserve(headers.size());
+    std::vector<size_t> vOpenCheck(NUM_ALGOS, std::numeric_limits<size_t>::max());
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < headers.size(); i++) {
+            if (mapBlockIndex.count(vHashes[i]))
+                continue;
+            const uint8_t nAlgo = headers[i].GetAlgo();
+            if (!headers[i].auxpow && CDefaultBlockHeader::HasPoWHashBatch(nAlgo)) {
+                if (vOpenCheck[nAlgo] < vChecks.size() && vChecks[vOpenCheck[nAlgo]].Add(headers[i], &vPowValid[i]))
+                    continue;
+                vOpenCheck[nAlgo] = vChecks.size();
+            }
+            vChecks.emplace_back(headers[i], consensusParams, &vPowValid[i]);
+        }
+    }
+
+    CCheckQueueControl<CPowCheck> control(&powcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+    return vPowValid;
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+    std::vector<char> vPowValid = CheckHeadersProofOfWork(headers, chainparams.GetConsensus());
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, vPowValid[i])) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -3718,6 +3823,24 @@ bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams,
     return true;
 }
 
+bool TestBlockTemplateValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, CAmount nFees)
+{
+    AssertLockHeld(cs_main);
+    assert(pindexPrev && pindexPrev == chainActive.Tip());
+    const int nHeight = pindexPrev->nHeight + 1;
+
+    if (!ContextualCheckBlockHeader(block, state, chainparams, pindexPrev, GetAdjustedTime()))
+        return error("%s: Consensus::ContextualCheckBlockHeader: %s", __func__, FormatStateMessage(state));
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), false, false))
+        return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
+    if (!ContextualCheckBlock(block, state, chainparams.GetConsensus(), pindexPrev))
+        return error("%s: Consensus::ContextualCheckBlock: %s", __func__, FormatStateMessage(state));
+    if (!CheckCoinbasePayments(block, state, nHeight, nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus())))
+        return error("%s: %s", __func__, FormatStateMessage(state));
+
+    return true;
+}
+
 /**
  * BLOCK PRUNING CODE
  */
@@ -3939,7 +4062,8 @@ CBlockIndex * CChainState::InsertBlockIndex(const uint256& hash)
 
 bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlockTreeDB& blocktree)
 {
-    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash){ return this->InsertBlockIndex(hash); }))
+    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash){ return this->InsertBlockIndex(hash); },
+                                      [](CBlockIndex* pindex){ setDirtyBlockIndex.insert(pindex); }))
         return false;
 
     boost::this_thread::interruption_point();
@@ -3980,8 +4104,10 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
             setBlockIndexCandidates.insert(pindex);
         if (pindex->nStatus & BLOCK_FAILED_MASK && (!pindexBestInvalid || pindex->nChainWork > pindexBestInvalid->nChainWork))
             pindexBestInvalid = pindex;
-        if (pindex->pprev)
+        if (pindex->pprev) {
             pindex->BuildSkip();
+            pindex->BuildSameAlgo();
+        }
         if (pindex->IsValid(BLOCK_VALID_TREE) && (pindexBestHeader == nullptr || CBlockIndexWorkComparator()(pindexBestHeader, pindex)))
             pindexBestHeader = pindex;
     }
@@ -13,6 +13,7 @@
 
 #include <amount.h>
 #include <coins.h>
+#include <crypto/algos/hashlib/multihash_batch.h>
 #include <fs.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <policy/feerate.h>
@@ -81,6 +82,10 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of header proof of work checking threads allowed */
+static const int MAX_POWCHECK_THREADS = 16;
+/** -powverifythreads default (number of proof of work checking threads, 0 = auto) */
+static const int DEFAULT_POWCHECK_THREADS = 0;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -169,6 +174,7 @@ extern CConditionVariable cvBlockChange;
 extern std::atomic_bool fImporting;
 extern std::atomic_bool fReindex;
 extern int nScriptCheckThreads;
+extern int nPowCheckThreads;
 extern bool fTxIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
@@ -278,6 +284,8 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the header proof of work checking thread */
+void ThreadPowCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -400,6 +408,41 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure representing the proof of work checks of up to MULTIHASH_LANES
+ * headers of one algo, whose PoW hashes are computed side by side when the
+ * algo has multi-lane kernels
+ * Note that this stores references to the headers and to their result slots
+ */
+class CPowCheck
+{
+private:
+    const CBlockHeader *pheaders[MULTIHASH_LANES];
+    char *pfValid[MULTIHASH_LANES];
+    size_t nHeaders;
+    const Consensus::Params *pparams;
+
+public:
+    CPowCheck(): pheaders(), pfValid(), nHeaders(0), pparams(nullptr) {}
+    CPowCheck(const CBlockHeader& headerIn, const Consensus::Params& paramsIn, char* pfValidIn) :
+        pheaders(), pfValid(), nHeaders(1), pparams(&paramsIn) {
+        pheaders[0] = &headerIn;
+        pfValid[0] = pfValidIn;
+    }
+
+    /** Add another header of the same algo. Returns false if the check is full. */
+    bool Add(const CBlockHeader& headerIn, char* pfValidIn);
+
+    bool operator()();
+
+    void swap(CPowCheck &check) {
+        std::swap(pheaders, check.pheaders);
+        std::swap(pfValid, check.pfValid);
+        std::swap(nHeaders, check.nHeaders);
+        std::swap(pparams, check.pparams);
+    }
+};
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
@@ -421,6 +464,9 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
 /** Check a block is completely valid from start to finish (only works on top of our current best block, with cs_main held) */
 bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
+/** Check a block template like TestBlockValidity, except for connecting its transactions, whose inputs the caller already checked; nFees is what they pay (with cs_main held) */
+bool TestBlockTemplateValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, CAmount nFees);
+
 /** Check whether witness commitments are required for block. */
 bool IsWitnessEnabled(const CBlockIndex* pindexPrev, const Consensus::Params& params);
 
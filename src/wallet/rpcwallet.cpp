@@ -3988,7 +3988,7 @@ UniValue getauxblock(const JSONRPCRequest& request)
 
     /* Create a new block */
     if (request.params.size() == 0)
-        return AuxMiningCreateBlock(coinbaseScript->reserveScript);
+        return AuxMiningCreateBlock(coinbaseScript->reserveScript, currentAlgo);
 
     /* Submit a block instead.  Note that this need not lock cs_main,
        since ProcessNewBlock below locks it instead.  */